@@ -0,0 +1,55 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       trace.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Timestamped probes along the sensor to actuator path
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+/**
+ * The probe points, in the same order as the elements of TraceStats.
+ * Each one must only ever be hit from a single task.
+ */
+enum trace_probe {
+	TRACE_GYRO,			//!< A gyro sample was published
+	TRACE_ATTITUDE,			//!< The attitude was updated from it
+	TRACE_STABILIZATION_START,	//!< Stabilization read the gyros
+	TRACE_STABILIZATION_DONE,	//!< Stabilization updated ActuatorDesired
+	TRACE_ACTUATOR,			//!< The actuator outputs were updated
+	TRACE_NUM_PROBES
+};
+
+#if defined(TRACE_DIAGNOSTICS)
+#define TRACE_PROBE(probe) TraceProbe(probe)
+#else
+#define TRACE_PROBE(probe) do { } while (0)
+#endif
+
+void TraceProbe(enum trace_probe probe);
+void TraceUpdateStats(void);
+
+#endif // TRACE_H
+
+/**
+ * @}
+ */
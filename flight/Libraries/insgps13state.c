@@ -39,16 +39,47 @@
 #define NUMU 6			// number of deterministic inputs, U is the input vector
 
 #if defined(GENERAL_COV)
-// This might trick people so I have a note here.  There is a slower but bigger version of the 
-// code here but won't fit when debugging disabled (requires -Os)
+// This might trick people so I have a note here.  The symbolic expansion of the
+// covariance prediction is too big for debug builds, which use a slower but
+// smaller version instead (the symbolic one requires -Os)
 #define COVARIANCE_PREDICTION_GENERAL
 #endif
 
+// P is symmetric so only its upper triangle is kept, packed row by row.
+// Element (i,j) with i <= j is P[PROW(i) + j], PIDX() handles either order.
+#define NUMP (NUMX * (NUMX + 1) / 2)
+#define PROW(i) ((i) * (2 * NUMX - (i) - 1) / 2)
+#define PIDX(i, j) ((i) <= (j) ? PROW(i) + (j) : PROW(j) + (i))
+
+// Nonzero columns [first, last) of each row of F, G and H as filled in by
+// LinearizeFG and LinearizeH. The rows of F past NUMF are all zero.
+#ifdef COVARIANCE_PREDICTION_GENERAL
+#define NUMF 10
+static const uint8_t FCols[NUMX][2] = {
+	{3, 4}, {4, 5}, {5, 6},			// dPdot/dV
+	{6, 10}, {6, 10}, {6, 10},		// dVdot/dq
+	{6, 13}, {6, 13}, {6, 13}, {6, 13},	// dqdot/dq and dqdot/dwbias
+	{0, 0}, {0, 0}, {0, 0},
+};
+static const uint8_t GCols[NUMX][2] = {
+	{0, 0}, {0, 0}, {0, 0},
+	{3, 6}, {3, 6}, {3, 6},			// dVdot/dna
+	{0, 3}, {0, 3}, {0, 3}, {0, 3},		// dqdot/dnw
+	{6, 9}, {6, 9}, {6, 9},			// dwbias = random walk noise
+};
+#endif
+static const uint8_t HCols[NUMV][2] = {
+	{0, 1}, {1, 2}, {2, 3},			// dP/dP
+	{3, 4}, {4, 5}, {5, 6},			// dV/dV
+	{6, 10}, {6, 10}, {6, 10},		// dBb/dq
+	{2, 3},					// dAlt/dPz
+};
+
 // Private functions
 static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
-			  float Q[NUMW], float dT, float P[NUMX][NUMX]);
+			  float Q[NUMW], float dT, float P[NUMP]);
 static void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
-		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
+		  float Y[NUMV], float P[NUMP], float X[NUMX],
 		  uint16_t SensorsUsed);
 static void RungeKutta(float X[NUMX], float U[NUMU], float dT);
 static void StateEq(float X[NUMX], float U[NUMU], float Xdot[NUMX]);
@@ -60,7 +91,7 @@ static void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
 // Private variables
 static float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
 static float Be[3];	                    // local magnetic unit vector in NED frame
-static float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
+static float P[NUMP], X[NUMX];	// covariance matrix (upper triangle) and state vector
 static float Q[NUMW], R[NUMV];   // input noise and measurement noise variances
 static float K[NUMX][NUMV];	     // feedback gain matrix
 
@@ -78,11 +109,12 @@ void INSGPSInit()		//pretty much just a place holder for now
 	Be[1] = 0.0f;
 	Be[2] = 0.0f;		// local magnetic unit vector
 
+	for (int i = 0; i < NUMP; i++)
+		P[i] = 0.0f; // zero all terms
+
 	for (int i = 0; i < NUMX; i++) {
-		for (int j = 0; j < NUMX; j++) {
-			P[i][j] = 0.0f; // zero all terms
+		for (int j = 0; j < NUMX; j++)
 			F[i][j] = 0.0f;
-		}
 		
 		for (int j = 0; j < NUMW; j++)
 			G[i][j] = 0.0f;
@@ -100,10 +132,10 @@ void INSGPSInit()		//pretty much just a place holder for now
 		R[i] = 0.0f;
 
 	
-	P[0][0] = P[1][1] = P[2][2] = 25.0f;            // initial position variance (m^2)
-	P[3][3] = P[4][4] = P[5][5] = 5.0f;             // initial velocity variance (m/s)^2
-	P[6][6] = P[7][7] = P[8][8] = P[9][9] = 1e-5f;  // initial quaternion variance
-	P[10][10] = P[11][11] = P[12][12] = 1e-9f;      // initial gyro bias variance (rad/s)^2
+	P[PIDX(0, 0)] = P[PIDX(1, 1)] = P[PIDX(2, 2)] = 25.0f;	// initial position variance (m^2)
+	P[PIDX(3, 3)] = P[PIDX(4, 4)] = P[PIDX(5, 5)] = 5.0f;	// initial velocity variance (m/s)^2
+	P[PIDX(6, 6)] = P[PIDX(7, 7)] = P[PIDX(8, 8)] = P[PIDX(9, 9)] = 1e-5f;	// initial quaternion variance
+	P[PIDX(10, 10)] = P[PIDX(11, 11)] = P[PIDX(12, 12)] = 1e-9f;	// initial gyro bias variance (rad/s)^2
 
 	X[0] = X[1] = X[2] = X[3] = X[4] = X[5] = 0.0f;	// initial pos and vel (m)
 	X[6] = 1.0f;
@@ -164,7 +196,7 @@ void INSGetState(float *pos, float *vel, float *attitude, float *gyro_bias)
 void INSGetVariance(float *var_out)
 {
 	for (uint32_t i = 0; i < NUMX; i++)
-		var_out[i] = P[i][i];
+		var_out[i] = P[PIDX(i, i)];
 }
 
 void INSResetP(const float PDiag[NUMX])
@@ -175,8 +207,8 @@ void INSResetP(const float PDiag[NUMX])
 	for (i=0;i<NUMX;i++){
 		if (PDiag != 0){
 			for (j=0;j<NUMX;j++)
-				P[i][j]=P[j][i]=0.0f;
-			P[i][i]=PDiag[i];
+				P[PIDX(i, j)]=0.0f;
+			P[PIDX(i, i)]=PDiag[i];
 		}
 	}
 }
@@ -203,13 +235,12 @@ void INSPosVelReset(const float pos[3], const float vel[3])
 {
 	for (int i = 0; i < 6; i++) {
 		for(int j = i; j < NUMX; j++) {
-			P[i][j] = 0;  // zero the first 6 rows and columns
-			P[j][i] = 0; 
+			P[PIDX(i, j)] = 0;  // zero the first 6 rows and columns
 		}
 	}
 	
-	P[0][0] = P[1][1] = P[2][2] = 25;	// initial position variance (m^2)
-	P[3][3] = P[4][4] = P[5][5] = 5;	// initial velocity variance (m/s)^2
+	P[PIDX(0, 0)] = P[PIDX(1, 1)] = P[PIDX(2, 2)] = 25;	// initial position variance (m^2)
+	P[PIDX(3, 3)] = P[PIDX(4, 4)] = P[PIDX(5, 5)] = 5;	// initial velocity variance (m/s)^2
 	
 	X[0] = pos[0];
 	X[1] = pos[1];
@@ -346,974 +377,1011 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 //  Q is the discrete time covariance of process noise
 //  Q is vector of the diagonal for a square matrix with
 //    dimensions equal to the number of disturbance noise variables
-//  The General Method is very inefficient,not taking advantage of the sparse F and G
-//  The first Method is very specific to this implementation
+//  Both methods only work out the upper triangle of P and skip the blocks
+//    of F and G that are always zero
+//  The General Method loops over the nonzero blocks, see FCols and GCols
+//  The second Method is a symbolic expansion that is faster but much bigger
 //  ************************************************
 
 #ifdef COVARIANCE_PREDICTION_GENERAL
 
 static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
-			  float Q[NUMW], float dT, float P[NUMX][NUMX])
+			  float Q[NUMW], float dT, float P[NUMP])
 {
-	float Dummy[NUMX][NUMX], dTsq;
-	uint8_t i, j, k;
+	float PF[NUMX - 3][NUMX];	// rows of P that F picks up, P is only stored as a triangle
+	float FP[NUMF][NUMX];
+	float T, Tsq;
+	int i, j, k;
 
-	//  Pnew = (I+F*T)*P*(I+F*T)' + T^2*G*Q*G' = T^2[(P/T + F*P)*(I/T + F') + G*Q*G')]
+	T = dT;
+	Tsq = dT * dT;
 
-	dTsq = dT * dT;
+	for (i = 3; i < NUMX; i++) {	// Unpack rows 3 to 12 of P
+		for (j = 0; j < i; j++)
+			PF[i - 3][j] = P[PROW(j) + i];
+		for (j = i; j < NUMX; j++)
+			PF[i - 3][j] = P[PROW(i) + j];
+	}
 
-	for (i = 0; i < NUMX; i++)	// Calculate Dummy = (P/T +F*P)
-		for (j = 0; j < NUMX; j++) {
-			Dummy[i][j] = P[i][j] / dT;
-			for (k = 0; k < NUMX; k++)
-				Dummy[i][j] += F[i][k] * P[k][j];
+	for (i = 0; i < 3; i++)	// Calculate FP = F*P, dPdot/dV
+		for (j = 0; j < NUMX; j++)
+			FP[i][j] = F[i][i + 3] * PF[i][j];
+	for (i = 3; i < NUMF; i++) {	// dVdot/dq, dqdot/dq and dqdot/dwbias
+		for (j = 0; j < NUMX; j++)
+			FP[i][j] = 0;
+		for (k = FCols[i][0]; k < FCols[i][1]; k++) {
+			const float Fik = F[i][k];
+			for (j = 0; j < NUMX; j++)
+				FP[i][j] += Fik * PF[k - 3][j];
 		}
-	for (i = 0; i < NUMX; i++)	// Calculate Pnew = Dummy/T + Dummy*F' + G*Qw*G'
-		for (j = i; j < NUMX; j++) {	// Use symmetry, ie only find upper triangular
-			P[i][j] = Dummy[i][j] / dT;
-			for (k = 0; k < NUMX; k++)
-				P[i][j] += Dummy[i][k] * F[j][k];	// P = Dummy/T + Dummy*F'
-			for (k = 0; k < NUMW; k++)
-				P[i][j] += Q[k] * G[i][k] * G[j][k];	// P = Dummy/T + Dummy*F' + G*Q*G'
-			P[j][i] = P[i][j] = P[i][j] * dTsq;	// Pnew = T^2*P and fill in lower triangular;
+	}
+
+	//  Pnew = P + (F*P + (F*P)')*T + (F*P*F' + G*Q*G')*T^2
+	for (i = 0; i < NUMF; i++) {	// Add the F terms
+		float *Pi = &P[PROW(i)];
+		for (j = i; j < 3; j++)
+			Pi[j] += (FP[i][j] + FP[j][i]) * T + FP[i][j + 3] * F[j][j + 3] * Tsq;
+		for (j = (i > 3 ? i : 3); j < 6; j++) {
+			float FPF = 0;
+			for (k = 6; k < 10; k++)
+				FPF += FP[i][k] * F[j][k];
+			Pi[j] += (FP[i][j] + FP[j][i]) * T + FPF * Tsq;
 		}
+		for (j = (i > 6 ? i : 6); j < NUMF; j++) {
+			float FPF = 0;
+			for (k = 6; k < NUMX; k++)
+				FPF += FP[i][k] * F[j][k];
+			Pi[j] += (FP[i][j] + FP[j][i]) * T + FPF * Tsq;
+		}
+		for (j = NUMF; j < NUMX; j++)
+			Pi[j] += FP[i][j] * T;
+	}
+
+	for (i = 3; i < NUMX; i++) {	// Add G*Q*G'*T^2, G only couples states driven by the same noise
+		float *Pi = &P[PROW(i)];
+		for (j = i; j < NUMX && GCols[j][0] == GCols[i][0]; j++) {
+			float GQG = 0;
+			for (k = GCols[i][0]; k < GCols[i][1]; k++)
+				GQG += Q[k] * G[i][k] * G[j][k];
+			Pi[j] += GQG * Tsq;
+		}
+	}
 }
 
 #else
 
 static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
-			  float Q[NUMW], float dT, float P[NUMX][NUMX])
+			  float Q[NUMW], float dT, float P[NUMP])
 {
-	float D[NUMX][NUMX], T, Tsq;
-	uint8_t i, j;
+	float D[NUMP], T, Tsq;
+	uint8_t i;
 
 	//  Pnew = (I+F*T)*P*(I+F*T)' + T^2*G*Q*G' = scalar expansion from symbolic manipulator
 
 	T = dT;
 	Tsq = dT * dT;
 
-	for (i = 0; i < NUMX; i++)	// Create a copy of the upper triangular of P
-		for (j = i; j < NUMX; j++)
-			D[i][j] = P[i][j];
+	for (i = 0; i < NUMP; i++)	// Create a copy of P
+		D[i] = P[i];
 
 	// Brute force calculation of the elements of P
-	P[0][0] = D[3][3] * Tsq + (2 * D[0][3]) * T + D[0][0];
-	P[0][1] = P[1][0] =
-	    D[3][4] * Tsq + (D[0][4] + D[1][3]) * T + D[0][1];
-	P[0][2] = P[2][0] =
-	    D[3][5] * Tsq + (D[0][5] + D[2][3]) * T + D[0][2];
-	P[0][3] = P[3][0] =
-	    (F[3][6] * D[3][6] + F[3][7] * D[3][7] + F[3][8] * D[3][8] +
-	     F[3][9] * D[3][9]) * Tsq + (D[3][3] + F[3][6] * D[0][6] +
-					 F[3][7] * D[0][7] +
-					 F[3][8] * D[0][8] +
-					 F[3][9] * D[0][9]) * T + D[0][3];
-	P[0][4] = P[4][0] =
-	    (F[4][6] * D[3][6] + F[4][7] * D[3][7] + F[4][8] * D[3][8] +
-	     F[4][9] * D[3][9]) * Tsq + (D[3][4] + F[4][6] * D[0][6] +
-					 F[4][7] * D[0][7] +
-					 F[4][8] * D[0][8] +
-					 F[4][9] * D[0][9]) * T + D[0][4];
-	P[0][5] = P[5][0] =
-	    (F[5][6] * D[3][6] + F[5][7] * D[3][7] + F[5][8] * D[3][8] +
-	     F[5][9] * D[3][9]) * Tsq + (D[3][5] + F[5][6] * D[0][6] +
-					 F[5][7] * D[0][7] +
-					 F[5][8] * D[0][8] +
-					 F[5][9] * D[0][9]) * T + D[0][5];
-	P[0][6] = P[6][0] =
-	    (F[6][7] * D[3][7] + F[6][8] * D[3][8] + F[6][9] * D[3][9] +
-	     F[6][10] * D[3][10] + F[6][11] * D[3][11] +
-	     F[6][12] * D[3][12]) * Tsq + (D[3][6] + F[6][7] * D[0][7] +
-					   F[6][8] * D[0][8] +
-					   F[6][9] * D[0][9] +
-					   F[6][10] * D[0][10] +
-					   F[6][11] * D[0][11] +
-					   F[6][12] * D[0][12]) * T +
-	    D[0][6];
-	P[0][7] = P[7][0] =
-	    (F[7][6] * D[3][6] + F[7][8] * D[3][8] + F[7][9] * D[3][9] +
-	     F[7][10] * D[3][10] + F[7][11] * D[3][11] +
-	     F[7][12] * D[3][12]) * Tsq + (D[3][7] + F[7][6] * D[0][6] +
-					   F[7][8] * D[0][8] +
-					   F[7][9] * D[0][9] +
-					   F[7][10] * D[0][10] +
-					   F[7][11] * D[0][11] +
-					   F[7][12] * D[0][12]) * T +
-	    D[0][7];
-	P[0][8] = P[8][0] =
-	    (F[8][6] * D[3][6] + F[8][7] * D[3][7] + F[8][9] * D[3][9] +
-	     F[8][10] * D[3][10] + F[8][11] * D[3][11] +
-	     F[8][12] * D[3][12]) * Tsq + (D[3][8] + F[8][6] * D[0][6] +
-					   F[8][7] * D[0][7] +
-					   F[8][9] * D[0][9] +
-					   F[8][10] * D[0][10] +
-					   F[8][11] * D[0][11] +
-					   F[8][12] * D[0][12]) * T +
-	    D[0][8];
-	P[0][9] = P[9][0] =
-	    (F[9][6] * D[3][6] + F[9][7] * D[3][7] + F[9][8] * D[3][8] +
-	     F[9][10] * D[3][10] + F[9][11] * D[3][11] +
-	     F[9][12] * D[3][12]) * Tsq + (D[3][9] + F[9][6] * D[0][6] +
-					   F[9][7] * D[0][7] +
-					   F[9][8] * D[0][8] +
-					   F[9][10] * D[0][10] +
-					   F[9][11] * D[0][11] +
-					   F[9][12] * D[0][12]) * T +
-	    D[0][9];
-	P[0][10] = P[10][0] = D[3][10] * T + D[0][10];
-	P[0][11] = P[11][0] = D[3][11] * T + D[0][11];
-	P[0][12] = P[12][0] = D[3][12] * T + D[0][12];
-	P[1][1] = D[4][4] * Tsq + (2 * D[1][4]) * T + D[1][1];
-	P[1][2] = P[2][1] =
-	    D[4][5] * Tsq + (D[1][5] + D[2][4]) * T + D[1][2];
-	P[1][3] = P[3][1] =
-	    (F[3][6] * D[4][6] + F[3][7] * D[4][7] + F[3][8] * D[4][8] +
-	     F[3][9] * D[4][9]) * Tsq + (D[3][4] + F[3][6] * D[1][6] +
-					 F[3][7] * D[1][7] +
-					 F[3][8] * D[1][8] +
-					 F[3][9] * D[1][9]) * T + D[1][3];
-	P[1][4] = P[4][1] =
-	    (F[4][6] * D[4][6] + F[4][7] * D[4][7] + F[4][8] * D[4][8] +
-	     F[4][9] * D[4][9]) * Tsq + (D[4][4] + F[4][6] * D[1][6] +
-					 F[4][7] * D[1][7] +
-					 F[4][8] * D[1][8] +
-					 F[4][9] * D[1][9]) * T + D[1][4];
-	P[1][5] = P[5][1] =
-	    (F[5][6] * D[4][6] + F[5][7] * D[4][7] + F[5][8] * D[4][8] +
-	     F[5][9] * D[4][9]) * Tsq + (D[4][5] + F[5][6] * D[1][6] +
-					 F[5][7] * D[1][7] +
-					 F[5][8] * D[1][8] +
-					 F[5][9] * D[1][9]) * T + D[1][5];
-	P[1][6] = P[6][1] =
-	    (F[6][7] * D[4][7] + F[6][8] * D[4][8] + F[6][9] * D[4][9] +
-	     F[6][10] * D[4][10] + F[6][11] * D[4][11] +
-	     F[6][12] * D[4][12]) * Tsq + (D[4][6] + F[6][7] * D[1][7] +
-					   F[6][8] * D[1][8] +
-					   F[6][9] * D[1][9] +
-					   F[6][10] * D[1][10] +
-					   F[6][11] * D[1][11] +
-					   F[6][12] * D[1][12]) * T +
-	    D[1][6];
-	P[1][7] = P[7][1] =
-	    (F[7][6] * D[4][6] + F[7][8] * D[4][8] + F[7][9] * D[4][9] +
-	     F[7][10] * D[4][10] + F[7][11] * D[4][11] +
-	     F[7][12] * D[4][12]) * Tsq + (D[4][7] + F[7][6] * D[1][6] +
-					   F[7][8] * D[1][8] +
-					   F[7][9] * D[1][9] +
-					   F[7][10] * D[1][10] +
-					   F[7][11] * D[1][11] +
-					   F[7][12] * D[1][12]) * T +
-	    D[1][7];
-	P[1][8] = P[8][1] =
-	    (F[8][6] * D[4][6] + F[8][7] * D[4][7] + F[8][9] * D[4][9] +
-	     F[8][10] * D[4][10] + F[8][11] * D[4][11] +
-	     F[8][12] * D[4][12]) * Tsq + (D[4][8] + F[8][6] * D[1][6] +
-					   F[8][7] * D[1][7] +
-					   F[8][9] * D[1][9] +
-					   F[8][10] * D[1][10] +
-					   F[8][11] * D[1][11] +
-					   F[8][12] * D[1][12]) * T +
-	    D[1][8];
-	P[1][9] = P[9][1] =
-	    (F[9][6] * D[4][6] + F[9][7] * D[4][7] + F[9][8] * D[4][8] +
-	     F[9][10] * D[4][10] + F[9][11] * D[4][11] +
-	     F[9][12] * D[4][12]) * Tsq + (D[4][9] + F[9][6] * D[1][6] +
-					   F[9][7] * D[1][7] +
-					   F[9][8] * D[1][8] +
-					   F[9][10] * D[1][10] +
-					   F[9][11] * D[1][11] +
-					   F[9][12] * D[1][12]) * T +
-	    D[1][9];
-	P[1][10] = P[10][1] = D[4][10] * T + D[1][10];
-	P[1][11] = P[11][1] = D[4][11] * T + D[1][11];
-	P[1][12] = P[12][1] = D[4][12] * T + D[1][12];
-	P[2][2] = D[5][5] * Tsq + (2 * D[2][5]) * T + D[2][2];
-	P[2][3] = P[3][2] =
-	    (F[3][6] * D[5][6] + F[3][7] * D[5][7] + F[3][8] * D[5][8] +
-	     F[3][9] * D[5][9]) * Tsq + (D[3][5] + F[3][6] * D[2][6] +
-					 F[3][7] * D[2][7] +
-					 F[3][8] * D[2][8] +
-					 F[3][9] * D[2][9]) * T + D[2][3];
-	P[2][4] = P[4][2] =
-	    (F[4][6] * D[5][6] + F[4][7] * D[5][7] + F[4][8] * D[5][8] +
-	     F[4][9] * D[5][9]) * Tsq + (D[4][5] + F[4][6] * D[2][6] +
-					 F[4][7] * D[2][7] +
-					 F[4][8] * D[2][8] +
-					 F[4][9] * D[2][9]) * T + D[2][4];
-	P[2][5] = P[5][2] =
-	    (F[5][6] * D[5][6] + F[5][7] * D[5][7] + F[5][8] * D[5][8] +
-	     F[5][9] * D[5][9]) * Tsq + (D[5][5] + F[5][6] * D[2][6] +
-					 F[5][7] * D[2][7] +
-					 F[5][8] * D[2][8] +
-					 F[5][9] * D[2][9]) * T + D[2][5];
-	P[2][6] = P[6][2] =
-	    (F[6][7] * D[5][7] + F[6][8] * D[5][8] + F[6][9] * D[5][9] +
-	     F[6][10] * D[5][10] + F[6][11] * D[5][11] +
-	     F[6][12] * D[5][12]) * Tsq + (D[5][6] + F[6][7] * D[2][7] +
-					   F[6][8] * D[2][8] +
-					   F[6][9] * D[2][9] +
-					   F[6][10] * D[2][10] +
-					   F[6][11] * D[2][11] +
-					   F[6][12] * D[2][12]) * T +
-	    D[2][6];
-	P[2][7] = P[7][2] =
-	    (F[7][6] * D[5][6] + F[7][8] * D[5][8] + F[7][9] * D[5][9] +
-	     F[7][10] * D[5][10] + F[7][11] * D[5][11] +
-	     F[7][12] * D[5][12]) * Tsq + (D[5][7] + F[7][6] * D[2][6] +
-					   F[7][8] * D[2][8] +
-					   F[7][9] * D[2][9] +
-					   F[7][10] * D[2][10] +
-					   F[7][11] * D[2][11] +
-					   F[7][12] * D[2][12]) * T +
-	    D[2][7];
-	P[2][8] = P[8][2] =
-	    (F[8][6] * D[5][6] + F[8][7] * D[5][7] + F[8][9] * D[5][9] +
-	     F[8][10] * D[5][10] + F[8][11] * D[5][11] +
-	     F[8][12] * D[5][12]) * Tsq + (D[5][8] + F[8][6] * D[2][6] +
-					   F[8][7] * D[2][7] +
-					   F[8][9] * D[2][9] +
-					   F[8][10] * D[2][10] +
-					   F[8][11] * D[2][11] +
-					   F[8][12] * D[2][12]) * T +
-	    D[2][8];
-	P[2][9] = P[9][2] =
-	    (F[9][6] * D[5][6] + F[9][7] * D[5][7] + F[9][8] * D[5][8] +
-	     F[9][10] * D[5][10] + F[9][11] * D[5][11] +
-	     F[9][12] * D[5][12]) * Tsq + (D[5][9] + F[9][6] * D[2][6] +
-					   F[9][7] * D[2][7] +
-					   F[9][8] * D[2][8] +
-					   F[9][10] * D[2][10] +
-					   F[9][11] * D[2][11] +
-					   F[9][12] * D[2][12]) * T +
-	    D[2][9];
-	P[2][10] = P[10][2] = D[5][10] * T + D[2][10];
-	P[2][11] = P[11][2] = D[5][11] * T + D[2][11];
-	P[2][12] = P[12][2] = D[5][12] * T + D[2][12];
-	P[3][3] =
+	P[PIDX(0, 0)] = D[PIDX(3, 3)] * Tsq + (2 * D[PIDX(0, 3)]) * T + D[PIDX(0, 0)];
+	P[PIDX(0, 1)] =
+	    D[PIDX(3, 4)] * Tsq + (D[PIDX(0, 4)] + D[PIDX(1, 3)]) * T + D[PIDX(0, 1)];
+	P[PIDX(0, 2)] =
+	    D[PIDX(3, 5)] * Tsq + (D[PIDX(0, 5)] + D[PIDX(2, 3)]) * T + D[PIDX(0, 2)];
+	P[PIDX(0, 3)] =
+	    (F[3][6] * D[PIDX(3, 6)] + F[3][7] * D[PIDX(3, 7)] + F[3][8] * D[PIDX(3, 8)] +
+	     F[3][9] * D[PIDX(3, 9)]) * Tsq + (D[PIDX(3, 3)] + F[3][6] * D[PIDX(0, 6)] +
+					 F[3][7] * D[PIDX(0, 7)] +
+					 F[3][8] * D[PIDX(0, 8)] +
+					 F[3][9] * D[PIDX(0, 9)]) * T + D[PIDX(0, 3)];
+	P[PIDX(0, 4)] =
+	    (F[4][6] * D[PIDX(3, 6)] + F[4][7] * D[PIDX(3, 7)] + F[4][8] * D[PIDX(3, 8)] +
+	     F[4][9] * D[PIDX(3, 9)]) * Tsq + (D[PIDX(3, 4)] + F[4][6] * D[PIDX(0, 6)] +
+					 F[4][7] * D[PIDX(0, 7)] +
+					 F[4][8] * D[PIDX(0, 8)] +
+					 F[4][9] * D[PIDX(0, 9)]) * T + D[PIDX(0, 4)];
+	P[PIDX(0, 5)] =
+	    (F[5][6] * D[PIDX(3, 6)] + F[5][7] * D[PIDX(3, 7)] + F[5][8] * D[PIDX(3, 8)] +
+	     F[5][9] * D[PIDX(3, 9)]) * Tsq + (D[PIDX(3, 5)] + F[5][6] * D[PIDX(0, 6)] +
+					 F[5][7] * D[PIDX(0, 7)] +
+					 F[5][8] * D[PIDX(0, 8)] +
+					 F[5][9] * D[PIDX(0, 9)]) * T + D[PIDX(0, 5)];
+	P[PIDX(0, 6)] =
+	    (F[6][7] * D[PIDX(3, 7)] + F[6][8] * D[PIDX(3, 8)] + F[6][9] * D[PIDX(3, 9)] +
+	     F[6][10] * D[PIDX(3, 10)] + F[6][11] * D[PIDX(3, 11)] +
+	     F[6][12] * D[PIDX(3, 12)]) * Tsq + (D[PIDX(3, 6)] + F[6][7] * D[PIDX(0, 7)] +
+					   F[6][8] * D[PIDX(0, 8)] +
+					   F[6][9] * D[PIDX(0, 9)] +
+					   F[6][10] * D[PIDX(0, 10)] +
+					   F[6][11] * D[PIDX(0, 11)] +
+					   F[6][12] * D[PIDX(0, 12)]) * T +
+	    D[PIDX(0, 6)];
+	P[PIDX(0, 7)] =
+	    (F[7][6] * D[PIDX(3, 6)] + F[7][8] * D[PIDX(3, 8)] + F[7][9] * D[PIDX(3, 9)] +
+	     F[7][10] * D[PIDX(3, 10)] + F[7][11] * D[PIDX(3, 11)] +
+	     F[7][12] * D[PIDX(3, 12)]) * Tsq + (D[PIDX(3, 7)] + F[7][6] * D[PIDX(0, 6)] +
+					   F[7][8] * D[PIDX(0, 8)] +
+					   F[7][9] * D[PIDX(0, 9)] +
+					   F[7][10] * D[PIDX(0, 10)] +
+					   F[7][11] * D[PIDX(0, 11)] +
+					   F[7][12] * D[PIDX(0, 12)]) * T +
+	    D[PIDX(0, 7)];
+	P[PIDX(0, 8)] =
+	    (F[8][6] * D[PIDX(3, 6)] + F[8][7] * D[PIDX(3, 7)] + F[8][9] * D[PIDX(3, 9)] +
+	     F[8][10] * D[PIDX(3, 10)] + F[8][11] * D[PIDX(3, 11)] +
+	     F[8][12] * D[PIDX(3, 12)]) * Tsq + (D[PIDX(3, 8)] + F[8][6] * D[PIDX(0, 6)] +
+					   F[8][7] * D[PIDX(0, 7)] +
+					   F[8][9] * D[PIDX(0, 9)] +
+					   F[8][10] * D[PIDX(0, 10)] +
+					   F[8][11] * D[PIDX(0, 11)] +
+					   F[8][12] * D[PIDX(0, 12)]) * T +
+	    D[PIDX(0, 8)];
+	P[PIDX(0, 9)] =
+	    (F[9][6] * D[PIDX(3, 6)] + F[9][7] * D[PIDX(3, 7)] + F[9][8] * D[PIDX(3, 8)] +
+	     F[9][10] * D[PIDX(3, 10)] + F[9][11] * D[PIDX(3, 11)] +
+	     F[9][12] * D[PIDX(3, 12)]) * Tsq + (D[PIDX(3, 9)] + F[9][6] * D[PIDX(0, 6)] +
+					   F[9][7] * D[PIDX(0, 7)] +
+					   F[9][8] * D[PIDX(0, 8)] +
+					   F[9][10] * D[PIDX(0, 10)] +
+					   F[9][11] * D[PIDX(0, 11)] +
+					   F[9][12] * D[PIDX(0, 12)]) * T +
+	    D[PIDX(0, 9)];
+	P[PIDX(0, 10)] = D[PIDX(3, 10)] * T + D[PIDX(0, 10)];
+	P[PIDX(0, 11)] = D[PIDX(3, 11)] * T + D[PIDX(0, 11)];
+	P[PIDX(0, 12)] = D[PIDX(3, 12)] * T + D[PIDX(0, 12)];
+	P[PIDX(1, 1)] = D[PIDX(4, 4)] * Tsq + (2 * D[PIDX(1, 4)]) * T + D[PIDX(1, 1)];
+	P[PIDX(1, 2)] =
+	    D[PIDX(4, 5)] * Tsq + (D[PIDX(1, 5)] + D[PIDX(2, 4)]) * T + D[PIDX(1, 2)];
+	P[PIDX(1, 3)] =
+	    (F[3][6] * D[PIDX(4, 6)] + F[3][7] * D[PIDX(4, 7)] + F[3][8] * D[PIDX(4, 8)] +
+	     F[3][9] * D[PIDX(4, 9)]) * Tsq + (D[PIDX(3, 4)] + F[3][6] * D[PIDX(1, 6)] +
+					 F[3][7] * D[PIDX(1, 7)] +
+					 F[3][8] * D[PIDX(1, 8)] +
+					 F[3][9] * D[PIDX(1, 9)]) * T + D[PIDX(1, 3)];
+	P[PIDX(1, 4)] =
+	    (F[4][6] * D[PIDX(4, 6)] + F[4][7] * D[PIDX(4, 7)] + F[4][8] * D[PIDX(4, 8)] +
+	     F[4][9] * D[PIDX(4, 9)]) * Tsq + (D[PIDX(4, 4)] + F[4][6] * D[PIDX(1, 6)] +
+					 F[4][7] * D[PIDX(1, 7)] +
+					 F[4][8] * D[PIDX(1, 8)] +
+					 F[4][9] * D[PIDX(1, 9)]) * T + D[PIDX(1, 4)];
+	P[PIDX(1, 5)] =
+	    (F[5][6] * D[PIDX(4, 6)] + F[5][7] * D[PIDX(4, 7)] + F[5][8] * D[PIDX(4, 8)] +
+	     F[5][9] * D[PIDX(4, 9)]) * Tsq + (D[PIDX(4, 5)] + F[5][6] * D[PIDX(1, 6)] +
+					 F[5][7] * D[PIDX(1, 7)] +
+					 F[5][8] * D[PIDX(1, 8)] +
+					 F[5][9] * D[PIDX(1, 9)]) * T + D[PIDX(1, 5)];
+	P[PIDX(1, 6)] =
+	    (F[6][7] * D[PIDX(4, 7)] + F[6][8] * D[PIDX(4, 8)] + F[6][9] * D[PIDX(4, 9)] +
+	     F[6][10] * D[PIDX(4, 10)] + F[6][11] * D[PIDX(4, 11)] +
+	     F[6][12] * D[PIDX(4, 12)]) * Tsq + (D[PIDX(4, 6)] + F[6][7] * D[PIDX(1, 7)] +
+					   F[6][8] * D[PIDX(1, 8)] +
+					   F[6][9] * D[PIDX(1, 9)] +
+					   F[6][10] * D[PIDX(1, 10)] +
+					   F[6][11] * D[PIDX(1, 11)] +
+					   F[6][12] * D[PIDX(1, 12)]) * T +
+	    D[PIDX(1, 6)];
+	P[PIDX(1, 7)] =
+	    (F[7][6] * D[PIDX(4, 6)] + F[7][8] * D[PIDX(4, 8)] + F[7][9] * D[PIDX(4, 9)] +
+	     F[7][10] * D[PIDX(4, 10)] + F[7][11] * D[PIDX(4, 11)] +
+	     F[7][12] * D[PIDX(4, 12)]) * Tsq + (D[PIDX(4, 7)] + F[7][6] * D[PIDX(1, 6)] +
+					   F[7][8] * D[PIDX(1, 8)] +
+					   F[7][9] * D[PIDX(1, 9)] +
+					   F[7][10] * D[PIDX(1, 10)] +
+					   F[7][11] * D[PIDX(1, 11)] +
+					   F[7][12] * D[PIDX(1, 12)]) * T +
+	    D[PIDX(1, 7)];
+	P[PIDX(1, 8)] =
+	    (F[8][6] * D[PIDX(4, 6)] + F[8][7] * D[PIDX(4, 7)] + F[8][9] * D[PIDX(4, 9)] +
+	     F[8][10] * D[PIDX(4, 10)] + F[8][11] * D[PIDX(4, 11)] +
+	     F[8][12] * D[PIDX(4, 12)]) * Tsq + (D[PIDX(4, 8)] + F[8][6] * D[PIDX(1, 6)] +
+					   F[8][7] * D[PIDX(1, 7)] +
+					   F[8][9] * D[PIDX(1, 9)] +
+					   F[8][10] * D[PIDX(1, 10)] +
+					   F[8][11] * D[PIDX(1, 11)] +
+					   F[8][12] * D[PIDX(1, 12)]) * T +
+	    D[PIDX(1, 8)];
+	P[PIDX(1, 9)] =
+	    (F[9][6] * D[PIDX(4, 6)] + F[9][7] * D[PIDX(4, 7)] + F[9][8] * D[PIDX(4, 8)] +
+	     F[9][10] * D[PIDX(4, 10)] + F[9][11] * D[PIDX(4, 11)] +
+	     F[9][12] * D[PIDX(4, 12)]) * Tsq + (D[PIDX(4, 9)] + F[9][6] * D[PIDX(1, 6)] +
+					   F[9][7] * D[PIDX(1, 7)] +
+					   F[9][8] * D[PIDX(1, 8)] +
+					   F[9][10] * D[PIDX(1, 10)] +
+					   F[9][11] * D[PIDX(1, 11)] +
+					   F[9][12] * D[PIDX(1, 12)]) * T +
+	    D[PIDX(1, 9)];
+	P[PIDX(1, 10)] = D[PIDX(4, 10)] * T + D[PIDX(1, 10)];
+	P[PIDX(1, 11)] = D[PIDX(4, 11)] * T + D[PIDX(1, 11)];
+	P[PIDX(1, 12)] = D[PIDX(4, 12)] * T + D[PIDX(1, 12)];
+	P[PIDX(2, 2)] = D[PIDX(5, 5)] * Tsq + (2 * D[PIDX(2, 5)]) * T + D[PIDX(2, 2)];
+	P[PIDX(2, 3)] =
+	    (F[3][6] * D[PIDX(5, 6)] + F[3][7] * D[PIDX(5, 7)] + F[3][8] * D[PIDX(5, 8)] +
+	     F[3][9] * D[PIDX(5, 9)]) * Tsq + (D[PIDX(3, 5)] + F[3][6] * D[PIDX(2, 6)] +
+					 F[3][7] * D[PIDX(2, 7)] +
+					 F[3][8] * D[PIDX(2, 8)] +
+					 F[3][9] * D[PIDX(2, 9)]) * T + D[PIDX(2, 3)];
+	P[PIDX(2, 4)] =
+	    (F[4][6] * D[PIDX(5, 6)] + F[4][7] * D[PIDX(5, 7)] + F[4][8] * D[PIDX(5, 8)] +
+	     F[4][9] * D[PIDX(5, 9)]) * Tsq + (D[PIDX(4, 5)] + F[4][6] * D[PIDX(2, 6)] +
+					 F[4][7] * D[PIDX(2, 7)] +
+					 F[4][8] * D[PIDX(2, 8)] +
+					 F[4][9] * D[PIDX(2, 9)]) * T + D[PIDX(2, 4)];
+	P[PIDX(2, 5)] =
+	    (F[5][6] * D[PIDX(5, 6)] + F[5][7] * D[PIDX(5, 7)] + F[5][8] * D[PIDX(5, 8)] +
+	     F[5][9] * D[PIDX(5, 9)]) * Tsq + (D[PIDX(5, 5)] + F[5][6] * D[PIDX(2, 6)] +
+					 F[5][7] * D[PIDX(2, 7)] +
+					 F[5][8] * D[PIDX(2, 8)] +
+					 F[5][9] * D[PIDX(2, 9)]) * T + D[PIDX(2, 5)];
+	P[PIDX(2, 6)] =
+	    (F[6][7] * D[PIDX(5, 7)] + F[6][8] * D[PIDX(5, 8)] + F[6][9] * D[PIDX(5, 9)] +
+	     F[6][10] * D[PIDX(5, 10)] + F[6][11] * D[PIDX(5, 11)] +
+	     F[6][12] * D[PIDX(5, 12)]) * Tsq + (D[PIDX(5, 6)] + F[6][7] * D[PIDX(2, 7)] +
+					   F[6][8] * D[PIDX(2, 8)] +
+					   F[6][9] * D[PIDX(2, 9)] +
+					   F[6][10] * D[PIDX(2, 10)] +
+					   F[6][11] * D[PIDX(2, 11)] +
+					   F[6][12] * D[PIDX(2, 12)]) * T +
+	    D[PIDX(2, 6)];
+	P[PIDX(2, 7)] =
+	    (F[7][6] * D[PIDX(5, 6)] + F[7][8] * D[PIDX(5, 8)] + F[7][9] * D[PIDX(5, 9)] +
+	     F[7][10] * D[PIDX(5, 10)] + F[7][11] * D[PIDX(5, 11)] +
+	     F[7][12] * D[PIDX(5, 12)]) * Tsq + (D[PIDX(5, 7)] + F[7][6] * D[PIDX(2, 6)] +
+					   F[7][8] * D[PIDX(2, 8)] +
+					   F[7][9] * D[PIDX(2, 9)] +
+					   F[7][10] * D[PIDX(2, 10)] +
+					   F[7][11] * D[PIDX(2, 11)] +
+					   F[7][12] * D[PIDX(2, 12)]) * T +
+	    D[PIDX(2, 7)];
+	P[PIDX(2, 8)] =
+	    (F[8][6] * D[PIDX(5, 6)] + F[8][7] * D[PIDX(5, 7)] + F[8][9] * D[PIDX(5, 9)] +
+	     F[8][10] * D[PIDX(5, 10)] + F[8][11] * D[PIDX(5, 11)] +
+	     F[8][12] * D[PIDX(5, 12)]) * Tsq + (D[PIDX(5, 8)] + F[8][6] * D[PIDX(2, 6)] +
+					   F[8][7] * D[PIDX(2, 7)] +
+					   F[8][9] * D[PIDX(2, 9)] +
+					   F[8][10] * D[PIDX(2, 10)] +
+					   F[8][11] * D[PIDX(2, 11)] +
+					   F[8][12] * D[PIDX(2, 12)]) * T +
+	    D[PIDX(2, 8)];
+	P[PIDX(2, 9)] =
+	    (F[9][6] * D[PIDX(5, 6)] + F[9][7] * D[PIDX(5, 7)] + F[9][8] * D[PIDX(5, 8)] +
+	     F[9][10] * D[PIDX(5, 10)] + F[9][11] * D[PIDX(5, 11)] +
+	     F[9][12] * D[PIDX(5, 12)]) * Tsq + (D[PIDX(5, 9)] + F[9][6] * D[PIDX(2, 6)] +
+					   F[9][7] * D[PIDX(2, 7)] +
+					   F[9][8] * D[PIDX(2, 8)] +
+					   F[9][10] * D[PIDX(2, 10)] +
+					   F[9][11] * D[PIDX(2, 11)] +
+					   F[9][12] * D[PIDX(2, 12)]) * T +
+	    D[PIDX(2, 9)];
+	P[PIDX(2, 10)] = D[PIDX(5, 10)] * T + D[PIDX(2, 10)];
+	P[PIDX(2, 11)] = D[PIDX(5, 11)] * T + D[PIDX(2, 11)];
+	P[PIDX(2, 12)] = D[PIDX(5, 12)] * T + D[PIDX(2, 12)];
+	P[PIDX(3, 3)] =
 	    (Q[3] * G[3][3] * G[3][3] + Q[4] * G[3][4] * G[3][4] +
-	     Q[5] * G[3][5] * G[3][5] + F[3][9] * (F[3][9] * D[9][9] +
-						   F[3][6] * D[6][9] +
-						   F[3][7] * D[7][9] +
-						   F[3][8] * D[8][9]) +
-	     F[3][6] * (F[3][6] * D[6][6] + F[3][7] * D[6][7] +
-			F[3][8] * D[6][8] + F[3][9] * D[6][9]) +
-	     F[3][7] * (F[3][6] * D[6][7] + F[3][7] * D[7][7] +
-			F[3][8] * D[7][8] + F[3][9] * D[7][9]) +
-	     F[3][8] * (F[3][6] * D[6][8] + F[3][7] * D[7][8] +
-			F[3][8] * D[8][8] + F[3][9] * D[8][9])) * Tsq +
-	    (2 * F[3][6] * D[3][6] + 2 * F[3][7] * D[3][7] +
-	     2 * F[3][8] * D[3][8] + 2 * F[3][9] * D[3][9]) * T + D[3][3];
-	P[3][4] = P[4][3] =
+	     Q[5] * G[3][5] * G[3][5] + F[3][9] * (F[3][9] * D[PIDX(9, 9)] +
+						   F[3][6] * D[PIDX(6, 9)] +
+						   F[3][7] * D[PIDX(7, 9)] +
+						   F[3][8] * D[PIDX(8, 9)]) +
+	     F[3][6] * (F[3][6] * D[PIDX(6, 6)] + F[3][7] * D[PIDX(6, 7)] +
+			F[3][8] * D[PIDX(6, 8)] + F[3][9] * D[PIDX(6, 9)]) +
+	     F[3][7] * (F[3][6] * D[PIDX(6, 7)] + F[3][7] * D[PIDX(7, 7)] +
+			F[3][8] * D[PIDX(7, 8)] + F[3][9] * D[PIDX(7, 9)]) +
+	     F[3][8] * (F[3][6] * D[PIDX(6, 8)] + F[3][7] * D[PIDX(7, 8)] +
+			F[3][8] * D[PIDX(8, 8)] + F[3][9] * D[PIDX(8, 9)])) * Tsq +
+	    (2 * F[3][6] * D[PIDX(3, 6)] + 2 * F[3][7] * D[PIDX(3, 7)] +
+	     2 * F[3][8] * D[PIDX(3, 8)] + 2 * F[3][9] * D[PIDX(3, 9)]) * T + D[PIDX(3, 3)];
+	P[PIDX(3, 4)] =
 	    (F[4][9] *
-	     (F[3][9] * D[9][9] + F[3][6] * D[6][9] + F[3][7] * D[7][9] +
-	      F[3][8] * D[8][9]) + F[4][6] * (F[3][6] * D[6][6] +
-					      F[3][7] * D[6][7] +
-					      F[3][8] * D[6][8] +
-					      F[3][9] * D[6][9]) +
-	     F[4][7] * (F[3][6] * D[6][7] + F[3][7] * D[7][7] +
-			F[3][8] * D[7][8] + F[3][9] * D[7][9]) +
-	     F[4][8] * (F[3][6] * D[6][8] + F[3][7] * D[7][8] +
-			F[3][8] * D[8][8] + F[3][9] * D[8][9]) +
+	     (F[3][9] * D[PIDX(9, 9)] + F[3][6] * D[PIDX(6, 9)] + F[3][7] * D[PIDX(7, 9)] +
+	      F[3][8] * D[PIDX(8, 9)]) + F[4][6] * (F[3][6] * D[PIDX(6, 6)] +
+					      F[3][7] * D[PIDX(6, 7)] +
+					      F[3][8] * D[PIDX(6, 8)] +
+					      F[3][9] * D[PIDX(6, 9)]) +
+	     F[4][7] * (F[3][6] * D[PIDX(6, 7)] + F[3][7] * D[PIDX(7, 7)] +
+			F[3][8] * D[PIDX(7, 8)] + F[3][9] * D[PIDX(7, 9)]) +
+	     F[4][8] * (F[3][6] * D[PIDX(6, 8)] + F[3][7] * D[PIDX(7, 8)] +
+			F[3][8] * D[PIDX(8, 8)] + F[3][9] * D[PIDX(8, 9)]) +
 	     G[3][3] * G[4][3] * Q[3] + G[3][4] * G[4][4] * Q[4] +
-	     G[3][5] * G[4][5] * Q[5]) * Tsq + (F[3][6] * D[4][6] +
-						F[4][6] * D[3][6] +
-						F[3][7] * D[4][7] +
-						F[4][7] * D[3][7] +
-						F[3][8] * D[4][8] +
-						F[4][8] * D[3][8] +
-						F[3][9] * D[4][9] +
-						F[4][9] * D[3][9]) * T +
-	    D[3][4];
-	P[3][5] = P[5][3] =
+	     G[3][5] * G[4][5] * Q[5]) * Tsq + (F[3][6] * D[PIDX(4, 6)] +
+						F[4][6] * D[PIDX(3, 6)] +
+						F[3][7] * D[PIDX(4, 7)] +
+						F[4][7] * D[PIDX(3, 7)] +
+						F[3][8] * D[PIDX(4, 8)] +
+						F[4][8] * D[PIDX(3, 8)] +
+						F[3][9] * D[PIDX(4, 9)] +
+						F[4][9] * D[PIDX(3, 9)]) * T +
+	    D[PIDX(3, 4)];
+	P[PIDX(3, 5)] =
 	    (F[5][9] *
-	     (F[3][9] * D[9][9] + F[3][6] * D[6][9] + F[3][7] * D[7][9] +
-	      F[3][8] * D[8][9]) + F[5][6] * (F[3][6] * D[6][6] +
-					      F[3][7] * D[6][7] +
-					      F[3][8] * D[6][8] +
-					      F[3][9] * D[6][9]) +
-	     F[5][7] * (F[3][6] * D[6][7] + F[3][7] * D[7][7] +
-			F[3][8] * D[7][8] + F[3][9] * D[7][9]) +
-	     F[5][8] * (F[3][6] * D[6][8] + F[3][7] * D[7][8] +
-			F[3][8] * D[8][8] + F[3][9] * D[8][9]) +
+	     (F[3][9] * D[PIDX(9, 9)] + F[3][6] * D[PIDX(6, 9)] + F[3][7] * D[PIDX(7, 9)] +
+	      F[3][8] * D[PIDX(8, 9)]) + F[5][6] * (F[3][6] * D[PIDX(6, 6)] +
+					      F[3][7] * D[PIDX(6, 7)] +
+					      F[3][8] * D[PIDX(6, 8)] +
+					      F[3][9] * D[PIDX(6, 9)]) +
+	     F[5][7] * (F[3][6] * D[PIDX(6, 7)] + F[3][7] * D[PIDX(7, 7)] +
+			F[3][8] * D[PIDX(7, 8)] + F[3][9] * D[PIDX(7, 9)]) +
+	     F[5][8] * (F[3][6] * D[PIDX(6, 8)] + F[3][7] * D[PIDX(7, 8)] +
+			F[3][8] * D[PIDX(8, 8)] + F[3][9] * D[PIDX(8, 9)]) +
 	     G[3][3] * G[5][3] * Q[3] + G[3][4] * G[5][4] * Q[4] +
-	     G[3][5] * G[5][5] * Q[5]) * Tsq + (F[3][6] * D[5][6] +
-						F[5][6] * D[3][6] +
-						F[3][7] * D[5][7] +
-						F[5][7] * D[3][7] +
-						F[3][8] * D[5][8] +
-						F[5][8] * D[3][8] +
-						F[3][9] * D[5][9] +
-						F[5][9] * D[3][9]) * T +
-	    D[3][5];
-	P[3][6] = P[6][3] =
+	     G[3][5] * G[5][5] * Q[5]) * Tsq + (F[3][6] * D[PIDX(5, 6)] +
+						F[5][6] * D[PIDX(3, 6)] +
+						F[3][7] * D[PIDX(5, 7)] +
+						F[5][7] * D[PIDX(3, 7)] +
+						F[3][8] * D[PIDX(5, 8)] +
+						F[5][8] * D[PIDX(3, 8)] +
+						F[3][9] * D[PIDX(5, 9)] +
+						F[5][9] * D[PIDX(3, 9)]) * T +
+	    D[PIDX(3, 5)];
+	P[PIDX(3, 6)] =
 	    (F[6][9] *
-	     (F[3][9] * D[9][9] + F[3][6] * D[6][9] + F[3][7] * D[7][9] +
-	      F[3][8] * D[8][9]) + F[6][10] * (F[3][9] * D[9][10] +
-					       F[3][6] * D[6][10] +
-					       F[3][7] * D[7][10] +
-					       F[3][8] * D[8][10]) +
-	     F[6][11] * (F[3][9] * D[9][11] + F[3][6] * D[6][11] +
-			 F[3][7] * D[7][11] + F[3][8] * D[8][11]) +
-	     F[6][12] * (F[3][9] * D[9][12] + F[3][6] * D[6][12] +
-			 F[3][7] * D[7][12] + F[3][8] * D[8][12]) +
-	     F[6][7] * (F[3][6] * D[6][7] + F[3][7] * D[7][7] +
-			F[3][8] * D[7][8] + F[3][9] * D[7][9]) +
-	     F[6][8] * (F[3][6] * D[6][8] + F[3][7] * D[7][8] +
-			F[3][8] * D[8][8] + F[3][9] * D[8][9])) * Tsq +
-	    (F[3][6] * D[6][6] + F[3][7] * D[6][7] + F[6][7] * D[3][7] +
-	     F[3][8] * D[6][8] + F[6][8] * D[3][8] + F[3][9] * D[6][9] +
-	     F[6][9] * D[3][9] + F[6][10] * D[3][10] +
-	     F[6][11] * D[3][11] + F[6][12] * D[3][12]) * T + D[3][6];
-	P[3][7] = P[7][3] =
+	     (F[3][9] * D[PIDX(9, 9)] + F[3][6] * D[PIDX(6, 9)] + F[3][7] * D[PIDX(7, 9)] +
+	      F[3][8] * D[PIDX(8, 9)]) + F[6][10] * (F[3][9] * D[PIDX(9, 10)] +
+					       F[3][6] * D[PIDX(6, 10)] +
+					       F[3][7] * D[PIDX(7, 10)] +
+					       F[3][8] * D[PIDX(8, 10)]) +
+	     F[6][11] * (F[3][9] * D[PIDX(9, 11)] + F[3][6] * D[PIDX(6, 11)] +
+			 F[3][7] * D[PIDX(7, 11)] + F[3][8] * D[PIDX(8, 11)]) +
+	     F[6][12] * (F[3][9] * D[PIDX(9, 12)] + F[3][6] * D[PIDX(6, 12)] +
+			 F[3][7] * D[PIDX(7, 12)] + F[3][8] * D[PIDX(8, 12)]) +
+	     F[6][7] * (F[3][6] * D[PIDX(6, 7)] + F[3][7] * D[PIDX(7, 7)] +
+			F[3][8] * D[PIDX(7, 8)] + F[3][9] * D[PIDX(7, 9)]) +
+	     F[6][8] * (F[3][6] * D[PIDX(6, 8)] + F[3][7] * D[PIDX(7, 8)] +
+			F[3][8] * D[PIDX(8, 8)] + F[3][9] * D[PIDX(8, 9)])) * Tsq +
+	    (F[3][6] * D[PIDX(6, 6)] + F[3][7] * D[PIDX(6, 7)] + F[6][7] * D[PIDX(3, 7)] +
+	     F[3][8] * D[PIDX(6, 8)] + F[6][8] * D[PIDX(3, 8)] + F[3][9] * D[PIDX(6, 9)] +
+	     F[6][9] * D[PIDX(3, 9)] + F[6][10] * D[PIDX(3, 10)] +
+	     F[6][11] * D[PIDX(3, 11)] + F[6][12] * D[PIDX(3, 12)]) * T + D[PIDX(3, 6)];
+	P[PIDX(3, 7)] =
 	    (F[7][9] *
-	     (F[3][9] * D[9][9] + F[3][6] * D[6][9] + F[3][7] * D[7][9] +
-	      F[3][8] * D[8][9]) + F[7][10] * (F[3][9] * D[9][10] +
-					       F[3][6] * D[6][10] +
-					       F[3][7] * D[7][10] +
-					       F[3][8] * D[8][10]) +
-	     F[7][11] * (F[3][9] * D[9][11] + F[3][6] * D[6][11] +
-			 F[3][7] * D[7][11] + F[3][8] * D[8][11]) +
-	     F[7][12] * (F[3][9] * D[9][12] + F[3][6] * D[6][12] +
-			 F[3][7] * D[7][12] + F[3][8] * D[8][12]) +
-	     F[7][6] * (F[3][6] * D[6][6] + F[3][7] * D[6][7] +
-			F[3][8] * D[6][8] + F[3][9] * D[6][9]) +
-	     F[7][8] * (F[3][6] * D[6][8] + F[3][7] * D[7][8] +
-			F[3][8] * D[8][8] + F[3][9] * D[8][9])) * Tsq +
-	    (F[3][6] * D[6][7] + F[7][6] * D[3][6] + F[3][7] * D[7][7] +
-	     F[3][8] * D[7][8] + F[7][8] * D[3][8] + F[3][9] * D[7][9] +
-	     F[7][9] * D[3][9] + F[7][10] * D[3][10] +
-	     F[7][11] * D[3][11] + F[7][12] * D[3][12]) * T + D[3][7];
-	P[3][8] = P[8][3] =
+	     (F[3][9] * D[PIDX(9, 9)] + F[3][6] * D[PIDX(6, 9)] + F[3][7] * D[PIDX(7, 9)] +
+	      F[3][8] * D[PIDX(8, 9)]) + F[7][10] * (F[3][9] * D[PIDX(9, 10)] +
+					       F[3][6] * D[PIDX(6, 10)] +
+					       F[3][7] * D[PIDX(7, 10)] +
+					       F[3][8] * D[PIDX(8, 10)]) +
+	     F[7][11] * (F[3][9] * D[PIDX(9, 11)] + F[3][6] * D[PIDX(6, 11)] +
+			 F[3][7] * D[PIDX(7, 11)] + F[3][8] * D[PIDX(8, 11)]) +
+	     F[7][12] * (F[3][9] * D[PIDX(9, 12)] + F[3][6] * D[PIDX(6, 12)] +
+			 F[3][7] * D[PIDX(7, 12)] + F[3][8] * D[PIDX(8, 12)]) +
+	     F[7][6] * (F[3][6] * D[PIDX(6, 6)] + F[3][7] * D[PIDX(6, 7)] +
+			F[3][8] * D[PIDX(6, 8)] + F[3][9] * D[PIDX(6, 9)]) +
+	     F[7][8] * (F[3][6] * D[PIDX(6, 8)] + F[3][7] * D[PIDX(7, 8)] +
+			F[3][8] * D[PIDX(8, 8)] + F[3][9] * D[PIDX(8, 9)])) * Tsq +
+	    (F[3][6] * D[PIDX(6, 7)] + F[7][6] * D[PIDX(3, 6)] + F[3][7] * D[PIDX(7, 7)] +
+	     F[3][8] * D[PIDX(7, 8)] + F[7][8] * D[PIDX(3, 8)] + F[3][9] * D[PIDX(7, 9)] +
+	     F[7][9] * D[PIDX(3, 9)] + F[7][10] * D[PIDX(3, 10)] +
+	     F[7][11] * D[PIDX(3, 11)] + F[7][12] * D[PIDX(3, 12)]) * T + D[PIDX(3, 7)];
+	P[PIDX(3, 8)] =
 	    (F[8][9] *
-	     (F[3][9] * D[9][9] + F[3][6] * D[6][9] + F[3][7] * D[7][9] +
-	      F[3][8] * D[8][9]) + F[8][10] * (F[3][9] * D[9][10] +
-					       F[3][6] * D[6][10] +
-					       F[3][7] * D[7][10] +
-					       F[3][8] * D[8][10]) +
-	     F[8][11] * (F[3][9] * D[9][11] + F[3][6] * D[6][11] +
-			 F[3][7] * D[7][11] + F[3][8] * D[8][11]) +
-	     F[8][12] * (F[3][9] * D[9][12] + F[3][6] * D[6][12] +
-			 F[3][7] * D[7][12] + F[3][8] * D[8][12]) +
-	     F[8][6] * (F[3][6] * D[6][6] + F[3][7] * D[6][7] +
-			F[3][8] * D[6][8] + F[3][9] * D[6][9]) +
-	     F[8][7] * (F[3][6] * D[6][7] + F[3][7] * D[7][7] +
-			F[3][8] * D[7][8] + F[3][9] * D[7][9])) * Tsq +
-	    (F[3][6] * D[6][8] + F[3][7] * D[7][8] + F[8][6] * D[3][6] +
-	     F[8][7] * D[3][7] + F[3][8] * D[8][8] + F[3][9] * D[8][9] +
-	     F[8][9] * D[3][9] + F[8][10] * D[3][10] +
-	     F[8][11] * D[3][11] + F[8][12] * D[3][12]) * T + D[3][8];
-	P[3][9] = P[9][3] =
+	     (F[3][9] * D[PIDX(9, 9)] + F[3][6] * D[PIDX(6, 9)] + F[3][7] * D[PIDX(7, 9)] +
+	      F[3][8] * D[PIDX(8, 9)]) + F[8][10] * (F[3][9] * D[PIDX(9, 10)] +
+					       F[3][6] * D[PIDX(6, 10)] +
+					       F[3][7] * D[PIDX(7, 10)] +
+					       F[3][8] * D[PIDX(8, 10)]) +
+	     F[8][11] * (F[3][9] * D[PIDX(9, 11)] + F[3][6] * D[PIDX(6, 11)] +
+			 F[3][7] * D[PIDX(7, 11)] + F[3][8] * D[PIDX(8, 11)]) +
+	     F[8][12] * (F[3][9] * D[PIDX(9, 12)] + F[3][6] * D[PIDX(6, 12)] +
+			 F[3][7] * D[PIDX(7, 12)] + F[3][8] * D[PIDX(8, 12)]) +
+	     F[8][6] * (F[3][6] * D[PIDX(6, 6)] + F[3][7] * D[PIDX(6, 7)] +
+			F[3][8] * D[PIDX(6, 8)] + F[3][9] * D[PIDX(6, 9)]) +
+	     F[8][7] * (F[3][6] * D[PIDX(6, 7)] + F[3][7] * D[PIDX(7, 7)] +
+			F[3][8] * D[PIDX(7, 8)] + F[3][9] * D[PIDX(7, 9)])) * Tsq +
+	    (F[3][6] * D[PIDX(6, 8)] + F[3][7] * D[PIDX(7, 8)] + F[8][6] * D[PIDX(3, 6)] +
+	     F[8][7] * D[PIDX(3, 7)] + F[3][8] * D[PIDX(8, 8)] + F[3][9] * D[PIDX(8, 9)] +
+	     F[8][9] * D[PIDX(3, 9)] + F[8][10] * D[PIDX(3, 10)] +
+	     F[8][11] * D[PIDX(3, 11)] + F[8][12] * D[PIDX(3, 12)]) * T + D[PIDX(3, 8)];
+	P[PIDX(3, 9)] =
 	    (F[9][10] *
-	     (F[3][9] * D[9][10] + F[3][6] * D[6][10] +
-	      F[3][7] * D[7][10] + F[3][8] * D[8][10]) +
-	     F[9][11] * (F[3][9] * D[9][11] + F[3][6] * D[6][11] +
-			 F[3][7] * D[7][11] + F[3][8] * D[8][11]) +
-	     F[9][12] * (F[3][9] * D[9][12] + F[3][6] * D[6][12] +
-			 F[3][7] * D[7][12] + F[3][8] * D[8][12]) +
-	     F[9][6] * (F[3][6] * D[6][6] + F[3][7] * D[6][7] +
-			F[3][8] * D[6][8] + F[3][9] * D[6][9]) +
-	     F[9][7] * (F[3][6] * D[6][7] + F[3][7] * D[7][7] +
-			F[3][8] * D[7][8] + F[3][9] * D[7][9]) +
-	     F[9][8] * (F[3][6] * D[6][8] + F[3][7] * D[7][8] +
-			F[3][8] * D[8][8] + F[3][9] * D[8][9])) * Tsq +
-	    (F[9][6] * D[3][6] + F[9][7] * D[3][7] + F[9][8] * D[3][8] +
-	     F[3][9] * D[9][9] + F[9][10] * D[3][10] +
-	     F[9][11] * D[3][11] + F[9][12] * D[3][12] +
-	     F[3][6] * D[6][9] + F[3][7] * D[7][9] +
-	     F[3][8] * D[8][9]) * T + D[3][9];
-	P[3][10] = P[10][3] =
-	    (F[3][9] * D[9][10] + F[3][6] * D[6][10] + F[3][7] * D[7][10] +
-	     F[3][8] * D[8][10]) * T + D[3][10];
-	P[3][11] = P[11][3] =
-	    (F[3][9] * D[9][11] + F[3][6] * D[6][11] + F[3][7] * D[7][11] +
-	     F[3][8] * D[8][11]) * T + D[3][11];
-	P[3][12] = P[12][3] =
-	    (F[3][9] * D[9][12] + F[3][6] * D[6][12] + F[3][7] * D[7][12] +
-	     F[3][8] * D[8][12]) * T + D[3][12];
-	P[4][4] =
+	     (F[3][9] * D[PIDX(9, 10)] + F[3][6] * D[PIDX(6, 10)] +
+	      F[3][7] * D[PIDX(7, 10)] + F[3][8] * D[PIDX(8, 10)]) +
+	     F[9][11] * (F[3][9] * D[PIDX(9, 11)] + F[3][6] * D[PIDX(6, 11)] +
+			 F[3][7] * D[PIDX(7, 11)] + F[3][8] * D[PIDX(8, 11)]) +
+	     F[9][12] * (F[3][9] * D[PIDX(9, 12)] + F[3][6] * D[PIDX(6, 12)] +
+			 F[3][7] * D[PIDX(7, 12)] + F[3][8] * D[PIDX(8, 12)]) +
+	     F[9][6] * (F[3][6] * D[PIDX(6, 6)] + F[3][7] * D[PIDX(6, 7)] +
+			F[3][8] * D[PIDX(6, 8)] + F[3][9] * D[PIDX(6, 9)]) +
+	     F[9][7] * (F[3][6] * D[PIDX(6, 7)] + F[3][7] * D[PIDX(7, 7)] +
+			F[3][8] * D[PIDX(7, 8)] + F[3][9] * D[PIDX(7, 9)]) +
+	     F[9][8] * (F[3][6] * D[PIDX(6, 8)] + F[3][7] * D[PIDX(7, 8)] +
+			F[3][8] * D[PIDX(8, 8)] + F[3][9] * D[PIDX(8, 9)])) * Tsq +
+	    (F[9][6] * D[PIDX(3, 6)] + F[9][7] * D[PIDX(3, 7)] + F[9][8] * D[PIDX(3, 8)] +
+	     F[3][9] * D[PIDX(9, 9)] + F[9][10] * D[PIDX(3, 10)] +
+	     F[9][11] * D[PIDX(3, 11)] + F[9][12] * D[PIDX(3, 12)] +
+	     F[3][6] * D[PIDX(6, 9)] + F[3][7] * D[PIDX(7, 9)] +
+	     F[3][8] * D[PIDX(8, 9)]) * T + D[PIDX(3, 9)];
+	P[PIDX(3, 10)] =
+	    (F[3][9] * D[PIDX(9, 10)] + F[3][6] * D[PIDX(6, 10)] + F[3][7] * D[PIDX(7, 10)] +
+	     F[3][8] * D[PIDX(8, 10)]) * T + D[PIDX(3, 10)];
+	P[PIDX(3, 11)] =
+	    (F[3][9] * D[PIDX(9, 11)] + F[3][6] * D[PIDX(6, 11)] + F[3][7] * D[PIDX(7, 11)] +
+	     F[3][8] * D[PIDX(8, 11)]) * T + D[PIDX(3, 11)];
+	P[PIDX(3, 12)] =
+	    (F[3][9] * D[PIDX(9, 12)] + F[3][6] * D[PIDX(6, 12)] + F[3][7] * D[PIDX(7, 12)] +
+	     F[3][8] * D[PIDX(8, 12)]) * T + D[PIDX(3, 12)];
+	P[PIDX(4, 4)] =
 	    (Q[3] * G[4][3] * G[4][3] + Q[4] * G[4][4] * G[4][4] +
-	     Q[5] * G[4][5] * G[4][5] + F[4][9] * (F[4][9] * D[9][9] +
-						   F[4][6] * D[6][9] +
-						   F[4][7] * D[7][9] +
-						   F[4][8] * D[8][9]) +
-	     F[4][6] * (F[4][6] * D[6][6] + F[4][7] * D[6][7] +
-			F[4][8] * D[6][8] + F[4][9] * D[6][9]) +
-	     F[4][7] * (F[4][6] * D[6][7] + F[4][7] * D[7][7] +
-			F[4][8] * D[7][8] + F[4][9] * D[7][9]) +
-	     F[4][8] * (F[4][6] * D[6][8] + F[4][7] * D[7][8] +
-			F[4][8] * D[8][8] + F[4][9] * D[8][9])) * Tsq +
-	    (2 * F[4][6] * D[4][6] + 2 * F[4][7] * D[4][7] +
-	     2 * F[4][8] * D[4][8] + 2 * F[4][9] * D[4][9]) * T + D[4][4];
-	P[4][5] = P[5][4] =
+	     Q[5] * G[4][5] * G[4][5] + F[4][9] * (F[4][9] * D[PIDX(9, 9)] +
+						   F[4][6] * D[PIDX(6, 9)] +
+						   F[4][7] * D[PIDX(7, 9)] +
+						   F[4][8] * D[PIDX(8, 9)]) +
+	     F[4][6] * (F[4][6] * D[PIDX(6, 6)] + F[4][7] * D[PIDX(6, 7)] +
+			F[4][8] * D[PIDX(6, 8)] + F[4][9] * D[PIDX(6, 9)]) +
+	     F[4][7] * (F[4][6] * D[PIDX(6, 7)] + F[4][7] * D[PIDX(7, 7)] +
+			F[4][8] * D[PIDX(7, 8)] + F[4][9] * D[PIDX(7, 9)]) +
+	     F[4][8] * (F[4][6] * D[PIDX(6, 8)] + F[4][7] * D[PIDX(7, 8)] +
+			F[4][8] * D[PIDX(8, 8)] + F[4][9] * D[PIDX(8, 9)])) * Tsq +
+	    (2 * F[4][6] * D[PIDX(4, 6)] + 2 * F[4][7] * D[PIDX(4, 7)] +
+	     2 * F[4][8] * D[PIDX(4, 8)] + 2 * F[4][9] * D[PIDX(4, 9)]) * T + D[PIDX(4, 4)];
+	P[PIDX(4, 5)] =
 	    (F[5][9] *
-	     (F[4][9] * D[9][9] + F[4][6] * D[6][9] + F[4][7] * D[7][9] +
-	      F[4][8] * D[8][9]) + F[5][6] * (F[4][6] * D[6][6] +
-					      F[4][7] * D[6][7] +
-					      F[4][8] * D[6][8] +
-					      F[4][9] * D[6][9]) +
-	     F[5][7] * (F[4][6] * D[6][7] + F[4][7] * D[7][7] +
-			F[4][8] * D[7][8] + F[4][9] * D[7][9]) +
-	     F[5][8] * (F[4][6] * D[6][8] + F[4][7] * D[7][8] +
-			F[4][8] * D[8][8] + F[4][9] * D[8][9]) +
+	     (F[4][9] * D[PIDX(9, 9)] + F[4][6] * D[PIDX(6, 9)] + F[4][7] * D[PIDX(7, 9)] +
+	      F[4][8] * D[PIDX(8, 9)]) + F[5][6] * (F[4][6] * D[PIDX(6, 6)] +
+					      F[4][7] * D[PIDX(6, 7)] +
+					      F[4][8] * D[PIDX(6, 8)] +
+					      F[4][9] * D[PIDX(6, 9)]) +
+	     F[5][7] * (F[4][6] * D[PIDX(6, 7)] + F[4][7] * D[PIDX(7, 7)] +
+			F[4][8] * D[PIDX(7, 8)] + F[4][9] * D[PIDX(7, 9)]) +
+	     F[5][8] * (F[4][6] * D[PIDX(6, 8)] + F[4][7] * D[PIDX(7, 8)] +
+			F[4][8] * D[PIDX(8, 8)] + F[4][9] * D[PIDX(8, 9)]) +
 	     G[4][3] * G[5][3] * Q[3] + G[4][4] * G[5][4] * Q[4] +
-	     G[4][5] * G[5][5] * Q[5]) * Tsq + (F[4][6] * D[5][6] +
-						F[5][6] * D[4][6] +
-						F[4][7] * D[5][7] +
-						F[5][7] * D[4][7] +
-						F[4][8] * D[5][8] +
-						F[5][8] * D[4][8] +
-						F[4][9] * D[5][9] +
-						F[5][9] * D[4][9]) * T +
-	    D[4][5];
-	P[4][6] = P[6][4] =
+	     G[4][5] * G[5][5] * Q[5]) * Tsq + (F[4][6] * D[PIDX(5, 6)] +
+						F[5][6] * D[PIDX(4, 6)] +
+						F[4][7] * D[PIDX(5, 7)] +
+						F[5][7] * D[PIDX(4, 7)] +
+						F[4][8] * D[PIDX(5, 8)] +
+						F[5][8] * D[PIDX(4, 8)] +
+						F[4][9] * D[PIDX(5, 9)] +
+						F[5][9] * D[PIDX(4, 9)]) * T +
+	    D[PIDX(4, 5)];
+	P[PIDX(4, 6)] =
 	    (F[6][9] *
-	     (F[4][9] * D[9][9] + F[4][6] * D[6][9] + F[4][7] * D[7][9] +
-	      F[4][8] * D[8][9]) + F[6][10] * (F[4][9] * D[9][10] +
-					       F[4][6] * D[6][10] +
-					       F[4][7] * D[7][10] +
-					       F[4][8] * D[8][10]) +
-	     F[6][11] * (F[4][9] * D[9][11] + F[4][6] * D[6][11] +
-			 F[4][7] * D[7][11] + F[4][8] * D[8][11]) +
-	     F[6][12] * (F[4][9] * D[9][12] + F[4][6] * D[6][12] +
-			 F[4][7] * D[7][12] + F[4][8] * D[8][12]) +
-	     F[6][7] * (F[4][6] * D[6][7] + F[4][7] * D[7][7] +
-			F[4][8] * D[7][8] + F[4][9] * D[7][9]) +
-	     F[6][8] * (F[4][6] * D[6][8] + F[4][7] * D[7][8] +
-			F[4][8] * D[8][8] + F[4][9] * D[8][9])) * Tsq +
-	    (F[4][6] * D[6][6] + F[4][7] * D[6][7] + F[6][7] * D[4][7] +
-	     F[4][8] * D[6][8] + F[6][8] * D[4][8] + F[4][9] * D[6][9] +
-	     F[6][9] * D[4][9] + F[6][10] * D[4][10] +
-	     F[6][11] * D[4][11] + F[6][12] * D[4][12]) * T + D[4][6];
-	P[4][7] = P[7][4] =
+	     (F[4][9] * D[PIDX(9, 9)] + F[4][6] * D[PIDX(6, 9)] + F[4][7] * D[PIDX(7, 9)] +
+	      F[4][8] * D[PIDX(8, 9)]) + F[6][10] * (F[4][9] * D[PIDX(9, 10)] +
+					       F[4][6] * D[PIDX(6, 10)] +
+					       F[4][7] * D[PIDX(7, 10)] +
+					       F[4][8] * D[PIDX(8, 10)]) +
+	     F[6][11] * (F[4][9] * D[PIDX(9, 11)] + F[4][6] * D[PIDX(6, 11)] +
+			 F[4][7] * D[PIDX(7, 11)] + F[4][8] * D[PIDX(8, 11)]) +
+	     F[6][12] * (F[4][9] * D[PIDX(9, 12)] + F[4][6] * D[PIDX(6, 12)] +
+			 F[4][7] * D[PIDX(7, 12)] + F[4][8] * D[PIDX(8, 12)]) +
+	     F[6][7] * (F[4][6] * D[PIDX(6, 7)] + F[4][7] * D[PIDX(7, 7)] +
+			F[4][8] * D[PIDX(7, 8)] + F[4][9] * D[PIDX(7, 9)]) +
+	     F[6][8] * (F[4][6] * D[PIDX(6, 8)] + F[4][7] * D[PIDX(7, 8)] +
+			F[4][8] * D[PIDX(8, 8)] + F[4][9] * D[PIDX(8, 9)])) * Tsq +
+	    (F[4][6] * D[PIDX(6, 6)] + F[4][7] * D[PIDX(6, 7)] + F[6][7] * D[PIDX(4, 7)] +
+	     F[4][8] * D[PIDX(6, 8)] + F[6][8] * D[PIDX(4, 8)] + F[4][9] * D[PIDX(6, 9)] +
+	     F[6][9] * D[PIDX(4, 9)] + F[6][10] * D[PIDX(4, 10)] +
+	     F[6][11] * D[PIDX(4, 11)] + F[6][12] * D[PIDX(4, 12)]) * T + D[PIDX(4, 6)];
+	P[PIDX(4, 7)] =
 	    (F[7][9] *
-	     (F[4][9] * D[9][9] + F[4][6] * D[6][9] + F[4][7] * D[7][9] +
-	      F[4][8] * D[8][9]) + F[7][10] * (F[4][9] * D[9][10] +
-					       F[4][6] * D[6][10] +
-					       F[4][7] * D[7][10] +
-					       F[4][8] * D[8][10]) +
-	     F[7][11] * (F[4][9] * D[9][11] + F[4][6] * D[6][11] +
-			 F[4][7] * D[7][11] + F[4][8] * D[8][11]) +
-	     F[7][12] * (F[4][9] * D[9][12] + F[4][6] * D[6][12] +
-			 F[4][7] * D[7][12] + F[4][8] * D[8][12]) +
-	     F[7][6] * (F[4][6] * D[6][6] + F[4][7] * D[6][7] +
-			F[4][8] * D[6][8] + F[4][9] * D[6][9]) +
-	     F[7][8] * (F[4][6] * D[6][8] + F[4][7] * D[7][8] +
-			F[4][8] * D[8][8] + F[4][9] * D[8][9])) * Tsq +
-	    (F[4][6] * D[6][7] + F[7][6] * D[4][6] + F[4][7] * D[7][7] +
-	     F[4][8] * D[7][8] + F[7][8] * D[4][8] + F[4][9] * D[7][9] +
-	     F[7][9] * D[4][9] + F[7][10] * D[4][10] +
-	     F[7][11] * D[4][11] + F[7][12] * D[4][12]) * T + D[4][7];
-	P[4][8] = P[8][4] =
+	     (F[4][9] * D[PIDX(9, 9)] + F[4][6] * D[PIDX(6, 9)] + F[4][7] * D[PIDX(7, 9)] +
+	      F[4][8] * D[PIDX(8, 9)]) + F[7][10] * (F[4][9] * D[PIDX(9, 10)] +
+					       F[4][6] * D[PIDX(6, 10)] +
+					       F[4][7] * D[PIDX(7, 10)] +
+					       F[4][8] * D[PIDX(8, 10)]) +
+	     F[7][11] * (F[4][9] * D[PIDX(9, 11)] + F[4][6] * D[PIDX(6, 11)] +
+			 F[4][7] * D[PIDX(7, 11)] + F[4][8] * D[PIDX(8, 11)]) +
+	     F[7][12] * (F[4][9] * D[PIDX(9, 12)] + F[4][6] * D[PIDX(6, 12)] +
+			 F[4][7] * D[PIDX(7, 12)] + F[4][8] * D[PIDX(8, 12)]) +
+	     F[7][6] * (F[4][6] * D[PIDX(6, 6)] + F[4][7] * D[PIDX(6, 7)] +
+			F[4][8] * D[PIDX(6, 8)] + F[4][9] * D[PIDX(6, 9)]) +
+	     F[7][8] * (F[4][6] * D[PIDX(6, 8)] + F[4][7] * D[PIDX(7, 8)] +
+			F[4][8] * D[PIDX(8, 8)] + F[4][9] * D[PIDX(8, 9)])) * Tsq +
+	    (F[4][6] * D[PIDX(6, 7)] + F[7][6] * D[PIDX(4, 6)] + F[4][7] * D[PIDX(7, 7)] +
+	     F[4][8] * D[PIDX(7, 8)] + F[7][8] * D[PIDX(4, 8)] + F[4][9] * D[PIDX(7, 9)] +
+	     F[7][9] * D[PIDX(4, 9)] + F[7][10] * D[PIDX(4, 10)] +
+	     F[7][11] * D[PIDX(4, 11)] + F[7][12] * D[PIDX(4, 12)]) * T + D[PIDX(4, 7)];
+	P[PIDX(4, 8)] =
 	    (F[8][9] *
-	     (F[4][9] * D[9][9] + F[4][6] * D[6][9] + F[4][7] * D[7][9] +
-	      F[4][8] * D[8][9]) + F[8][10] * (F[4][9] * D[9][10] +
-					       F[4][6] * D[6][10] +
-					       F[4][7] * D[7][10] +
-					       F[4][8] * D[8][10]) +
-	     F[8][11] * (F[4][9] * D[9][11] + F[4][6] * D[6][11] +
-			 F[4][7] * D[7][11] + F[4][8] * D[8][11]) +
-	     F[8][12] * (F[4][9] * D[9][12] + F[4][6] * D[6][12] +
-			 F[4][7] * D[7][12] + F[4][8] * D[8][12]) +
-	     F[8][6] * (F[4][6] * D[6][6] + F[4][7] * D[6][7] +
-			F[4][8] * D[6][8] + F[4][9] * D[6][9]) +
-	     F[8][7] * (F[4][6] * D[6][7] + F[4][7] * D[7][7] +
-			F[4][8] * D[7][8] + F[4][9] * D[7][9])) * Tsq +
-	    (F[4][6] * D[6][8] + F[4][7] * D[7][8] + F[8][6] * D[4][6] +
-	     F[8][7] * D[4][7] + F[4][8] * D[8][8] + F[4][9] * D[8][9] +
-	     F[8][9] * D[4][9] + F[8][10] * D[4][10] +
-	     F[8][11] * D[4][11] + F[8][12] * D[4][12]) * T + D[4][8];
-	P[4][9] = P[9][4] =
+	     (F[4][9] * D[PIDX(9, 9)] + F[4][6] * D[PIDX(6, 9)] + F[4][7] * D[PIDX(7, 9)] +
+	      F[4][8] * D[PIDX(8, 9)]) + F[8][10] * (F[4][9] * D[PIDX(9, 10)] +
+					       F[4][6] * D[PIDX(6, 10)] +
+					       F[4][7] * D[PIDX(7, 10)] +
+					       F[4][8] * D[PIDX(8, 10)]) +
+	     F[8][11] * (F[4][9] * D[PIDX(9, 11)] + F[4][6] * D[PIDX(6, 11)] +
+			 F[4][7] * D[PIDX(7, 11)] + F[4][8] * D[PIDX(8, 11)]) +
+	     F[8][12] * (F[4][9] * D[PIDX(9, 12)] + F[4][6] * D[PIDX(6, 12)] +
+			 F[4][7] * D[PIDX(7, 12)] + F[4][8] * D[PIDX(8, 12)]) +
+	     F[8][6] * (F[4][6] * D[PIDX(6, 6)] + F[4][7] * D[PIDX(6, 7)] +
+			F[4][8] * D[PIDX(6, 8)] + F[4][9] * D[PIDX(6, 9)]) +
+	     F[8][7] * (F[4][6] * D[PIDX(6, 7)] + F[4][7] * D[PIDX(7, 7)] +
+			F[4][8] * D[PIDX(7, 8)] + F[4][9] * D[PIDX(7, 9)])) * Tsq +
+	    (F[4][6] * D[PIDX(6, 8)] + F[4][7] * D[PIDX(7, 8)] + F[8][6] * D[PIDX(4, 6)] +
+	     F[8][7] * D[PIDX(4, 7)] + F[4][8] * D[PIDX(8, 8)] + F[4][9] * D[PIDX(8, 9)] +
+	     F[8][9] * D[PIDX(4, 9)] + F[8][10] * D[PIDX(4, 10)] +
+	     F[8][11] * D[PIDX(4, 11)] + F[8][12] * D[PIDX(4, 12)]) * T + D[PIDX(4, 8)];
+	P[PIDX(4, 9)] =
 	    (F[9][10] *
-	     (F[4][9] * D[9][10] + F[4][6] * D[6][10] +
-	      F[4][7] * D[7][10] + F[4][8] * D[8][10]) +
-	     F[9][11] * (F[4][9] * D[9][11] + F[4][6] * D[6][11] +
-			 F[4][7] * D[7][11] + F[4][8] * D[8][11]) +
-	     F[9][12] * (F[4][9] * D[9][12] + F[4][6] * D[6][12] +
-			 F[4][7] * D[7][12] + F[4][8] * D[8][12]) +
-	     F[9][6] * (F[4][6] * D[6][6] + F[4][7] * D[6][7] +
-			F[4][8] * D[6][8] + F[4][9] * D[6][9]) +
-	     F[9][7] * (F[4][6] * D[6][7] + F[4][7] * D[7][7] +
-			F[4][8] * D[7][8] + F[4][9] * D[7][9]) +
-	     F[9][8] * (F[4][6] * D[6][8] + F[4][7] * D[7][8] +
-			F[4][8] * D[8][8] + F[4][9] * D[8][9])) * Tsq +
-	    (F[9][6] * D[4][6] + F[9][7] * D[4][7] + F[9][8] * D[4][8] +
-	     F[4][9] * D[9][9] + F[9][10] * D[4][10] +
-	     F[9][11] * D[4][11] + F[9][12] * D[4][12] +
-	     F[4][6] * D[6][9] + F[4][7] * D[7][9] +
-	     F[4][8] * D[8][9]) * T + D[4][9];
-	P[4][10] = P[10][4] =
-	    (F[4][9] * D[9][10] + F[4][6] * D[6][10] + F[4][7] * D[7][10] +
-	     F[4][8] * D[8][10]) * T + D[4][10];
-	P[4][11] = P[11][4] =
-	    (F[4][9] * D[9][11] + F[4][6] * D[6][11] + F[4][7] * D[7][11] +
-	     F[4][8] * D[8][11]) * T + D[4][11];
-	P[4][12] = P[12][4] =
-	    (F[4][9] * D[9][12] + F[4][6] * D[6][12] + F[4][7] * D[7][12] +
-	     F[4][8] * D[8][12]) * T + D[4][12];
-	P[5][5] =
+	     (F[4][9] * D[PIDX(9, 10)] + F[4][6] * D[PIDX(6, 10)] +
+	      F[4][7] * D[PIDX(7, 10)] + F[4][8] * D[PIDX(8, 10)]) +
+	     F[9][11] * (F[4][9] * D[PIDX(9, 11)] + F[4][6] * D[PIDX(6, 11)] +
+			 F[4][7] * D[PIDX(7, 11)] + F[4][8] * D[PIDX(8, 11)]) +
+	     F[9][12] * (F[4][9] * D[PIDX(9, 12)] + F[4][6] * D[PIDX(6, 12)] +
+			 F[4][7] * D[PIDX(7, 12)] + F[4][8] * D[PIDX(8, 12)]) +
+	     F[9][6] * (F[4][6] * D[PIDX(6, 6)] + F[4][7] * D[PIDX(6, 7)] +
+			F[4][8] * D[PIDX(6, 8)] + F[4][9] * D[PIDX(6, 9)]) +
+	     F[9][7] * (F[4][6] * D[PIDX(6, 7)] + F[4][7] * D[PIDX(7, 7)] +
+			F[4][8] * D[PIDX(7, 8)] + F[4][9] * D[PIDX(7, 9)]) +
+	     F[9][8] * (F[4][6] * D[PIDX(6, 8)] + F[4][7] * D[PIDX(7, 8)] +
+			F[4][8] * D[PIDX(8, 8)] + F[4][9] * D[PIDX(8, 9)])) * Tsq +
+	    (F[9][6] * D[PIDX(4, 6)] + F[9][7] * D[PIDX(4, 7)] + F[9][8] * D[PIDX(4, 8)] +
+	     F[4][9] * D[PIDX(9, 9)] + F[9][10] * D[PIDX(4, 10)] +
+	     F[9][11] * D[PIDX(4, 11)] + F[9][12] * D[PIDX(4, 12)] +
+	     F[4][6] * D[PIDX(6, 9)] + F[4][7] * D[PIDX(7, 9)] +
+	     F[4][8] * D[PIDX(8, 9)]) * T + D[PIDX(4, 9)];
+	P[PIDX(4, 10)] =
+	    (F[4][9] * D[PIDX(9, 10)] + F[4][6] * D[PIDX(6, 10)] + F[4][7] * D[PIDX(7, 10)] +
+	     F[4][8] * D[PIDX(8, 10)]) * T + D[PIDX(4, 10)];
+	P[PIDX(4, 11)] =
+	    (F[4][9] * D[PIDX(9, 11)] + F[4][6] * D[PIDX(6, 11)] + F[4][7] * D[PIDX(7, 11)] +
+	     F[4][8] * D[PIDX(8, 11)]) * T + D[PIDX(4, 11)];
+	P[PIDX(4, 12)] =
+	    (F[4][9] * D[PIDX(9, 12)] + F[4][6] * D[PIDX(6, 12)] + F[4][7] * D[PIDX(7, 12)] +
+	     F[4][8] * D[PIDX(8, 12)]) * T + D[PIDX(4, 12)];
+	P[PIDX(5, 5)] =
 	    (Q[3] * G[5][3] * G[5][3] + Q[4] * G[5][4] * G[5][4] +
-	     Q[5] * G[5][5] * G[5][5] + F[5][9] * (F[5][9] * D[9][9] +
-						   F[5][6] * D[6][9] +
-						   F[5][7] * D[7][9] +
-						   F[5][8] * D[8][9]) +
-	     F[5][6] * (F[5][6] * D[6][6] + F[5][7] * D[6][7] +
-			F[5][8] * D[6][8] + F[5][9] * D[6][9]) +
-	     F[5][7] * (F[5][6] * D[6][7] + F[5][7] * D[7][7] +
-			F[5][8] * D[7][8] + F[5][9] * D[7][9]) +
-	     F[5][8] * (F[5][6] * D[6][8] + F[5][7] * D[7][8] +
-			F[5][8] * D[8][8] + F[5][9] * D[8][9])) * Tsq +
-	    (2 * F[5][6] * D[5][6] + 2 * F[5][7] * D[5][7] +
-	     2 * F[5][8] * D[5][8] + 2 * F[5][9] * D[5][9]) * T + D[5][5];
-	P[5][6] = P[6][5] =
+	     Q[5] * G[5][5] * G[5][5] + F[5][9] * (F[5][9] * D[PIDX(9, 9)] +
+						   F[5][6] * D[PIDX(6, 9)] +
+						   F[5][7] * D[PIDX(7, 9)] +
+						   F[5][8] * D[PIDX(8, 9)]) +
+	     F[5][6] * (F[5][6] * D[PIDX(6, 6)] + F[5][7] * D[PIDX(6, 7)] +
+			F[5][8] * D[PIDX(6, 8)] + F[5][9] * D[PIDX(6, 9)]) +
+	     F[5][7] * (F[5][6] * D[PIDX(6, 7)] + F[5][7] * D[PIDX(7, 7)] +
+			F[5][8] * D[PIDX(7, 8)] + F[5][9] * D[PIDX(7, 9)]) +
+	     F[5][8] * (F[5][6] * D[PIDX(6, 8)] + F[5][7] * D[PIDX(7, 8)] +
+			F[5][8] * D[PIDX(8, 8)] + F[5][9] * D[PIDX(8, 9)])) * Tsq +
+	    (2 * F[5][6] * D[PIDX(5, 6)] + 2 * F[5][7] * D[PIDX(5, 7)] +
+	     2 * F[5][8] * D[PIDX(5, 8)] + 2 * F[5][9] * D[PIDX(5, 9)]) * T + D[PIDX(5, 5)];
+	P[PIDX(5, 6)] =
 	    (F[6][9] *
-	     (F[5][9] * D[9][9] + F[5][6] * D[6][9] + F[5][7] * D[7][9] +
-	      F[5][8] * D[8][9]) + F[6][10] * (F[5][9] * D[9][10] +
-					       F[5][6] * D[6][10] +
-					       F[5][7] * D[7][10] +
-					       F[5][8] * D[8][10]) +
-	     F[6][11] * (F[5][9] * D[9][11] + F[5][6] * D[6][11] +
-			 F[5][7] * D[7][11] + F[5][8] * D[8][11]) +
-	     F[6][12] * (F[5][9] * D[9][12] + F[5][6] * D[6][12] +
-			 F[5][7] * D[7][12] + F[5][8] * D[8][12]) +
-	     F[6][7] * (F[5][6] * D[6][7] + F[5][7] * D[7][7] +
-			F[5][8] * D[7][8] + F[5][9] * D[7][9]) +
-	     F[6][8] * (F[5][6] * D[6][8] + F[5][7] * D[7][8] +
-			F[5][8] * D[8][8] + F[5][9] * D[8][9])) * Tsq +
-	    (F[5][6] * D[6][6] + F[5][7] * D[6][7] + F[6][7] * D[5][7] +
-	     F[5][8] * D[6][8] + F[6][8] * D[5][8] + F[5][9] * D[6][9] +
-	     F[6][9] * D[5][9] + F[6][10] * D[5][10] +
-	     F[6][11] * D[5][11] + F[6][12] * D[5][12]) * T + D[5][6];
-	P[5][7] = P[7][5] =
+	     (F[5][9] * D[PIDX(9, 9)] + F[5][6] * D[PIDX(6, 9)] + F[5][7] * D[PIDX(7, 9)] +
+	      F[5][8] * D[PIDX(8, 9)]) + F[6][10] * (F[5][9] * D[PIDX(9, 10)] +
+					       F[5][6] * D[PIDX(6, 10)] +
+					       F[5][7] * D[PIDX(7, 10)] +
+					       F[5][8] * D[PIDX(8, 10)]) +
+	     F[6][11] * (F[5][9] * D[PIDX(9, 11)] + F[5][6] * D[PIDX(6, 11)] +
+			 F[5][7] * D[PIDX(7, 11)] + F[5][8] * D[PIDX(8, 11)]) +
+	     F[6][12] * (F[5][9] * D[PIDX(9, 12)] + F[5][6] * D[PIDX(6, 12)] +
+			 F[5][7] * D[PIDX(7, 12)] + F[5][8] * D[PIDX(8, 12)]) +
+	     F[6][7] * (F[5][6] * D[PIDX(6, 7)] + F[5][7] * D[PIDX(7, 7)] +
+			F[5][8] * D[PIDX(7, 8)] + F[5][9] * D[PIDX(7, 9)]) +
+	     F[6][8] * (F[5][6] * D[PIDX(6, 8)] + F[5][7] * D[PIDX(7, 8)] +
+			F[5][8] * D[PIDX(8, 8)] + F[5][9] * D[PIDX(8, 9)])) * Tsq +
+	    (F[5][6] * D[PIDX(6, 6)] + F[5][7] * D[PIDX(6, 7)] + F[6][7] * D[PIDX(5, 7)] +
+	     F[5][8] * D[PIDX(6, 8)] + F[6][8] * D[PIDX(5, 8)] + F[5][9] * D[PIDX(6, 9)] +
+	     F[6][9] * D[PIDX(5, 9)] + F[6][10] * D[PIDX(5, 10)] +
+	     F[6][11] * D[PIDX(5, 11)] + F[6][12] * D[PIDX(5, 12)]) * T + D[PIDX(5, 6)];
+	P[PIDX(5, 7)] =
 	    (F[7][9] *
-	     (F[5][9] * D[9][9] + F[5][6] * D[6][9] + F[5][7] * D[7][9] +
-	      F[5][8] * D[8][9]) + F[7][10] * (F[5][9] * D[9][10] +
-					       F[5][6] * D[6][10] +
-					       F[5][7] * D[7][10] +
-					       F[5][8] * D[8][10]) +
-	     F[7][11] * (F[5][9] * D[9][11] + F[5][6] * D[6][11] +
-			 F[5][7] * D[7][11] + F[5][8] * D[8][11]) +
-	     F[7][12] * (F[5][9] * D[9][12] + F[5][6] * D[6][12] +
-			 F[5][7] * D[7][12] + F[5][8] * D[8][12]) +
-	     F[7][6] * (F[5][6] * D[6][6] + F[5][7] * D[6][7] +
-			F[5][8] * D[6][8] + F[5][9] * D[6][9]) +
-	     F[7][8] * (F[5][6] * D[6][8] + F[5][7] * D[7][8] +
-			F[5][8] * D[8][8] + F[5][9] * D[8][9])) * Tsq +
-	    (F[5][6] * D[6][7] + F[7][6] * D[5][6] + F[5][7] * D[7][7] +
-	     F[5][8] * D[7][8] + F[7][8] * D[5][8] + F[5][9] * D[7][9] +
-	     F[7][9] * D[5][9] + F[7][10] * D[5][10] +
-	     F[7][11] * D[5][11] + F[7][12] * D[5][12]) * T + D[5][7];
-	P[5][8] = P[8][5] =
+	     (F[5][9] * D[PIDX(9, 9)] + F[5][6] * D[PIDX(6, 9)] + F[5][7] * D[PIDX(7, 9)] +
+	      F[5][8] * D[PIDX(8, 9)]) + F[7][10] * (F[5][9] * D[PIDX(9, 10)] +
+					       F[5][6] * D[PIDX(6, 10)] +
+					       F[5][7] * D[PIDX(7, 10)] +
+					       F[5][8] * D[PIDX(8, 10)]) +
+	     F[7][11] * (F[5][9] * D[PIDX(9, 11)] + F[5][6] * D[PIDX(6, 11)] +
+			 F[5][7] * D[PIDX(7, 11)] + F[5][8] * D[PIDX(8, 11)]) +
+	     F[7][12] * (F[5][9] * D[PIDX(9, 12)] + F[5][6] * D[PIDX(6, 12)] +
+			 F[5][7] * D[PIDX(7, 12)] + F[5][8] * D[PIDX(8, 12)]) +
+	     F[7][6] * (F[5][6] * D[PIDX(6, 6)] + F[5][7] * D[PIDX(6, 7)] +
+			F[5][8] * D[PIDX(6, 8)] + F[5][9] * D[PIDX(6, 9)]) +
+	     F[7][8] * (F[5][6] * D[PIDX(6, 8)] + F[5][7] * D[PIDX(7, 8)] +
+			F[5][8] * D[PIDX(8, 8)] + F[5][9] * D[PIDX(8, 9)])) * Tsq +
+	    (F[5][6] * D[PIDX(6, 7)] + F[7][6] * D[PIDX(5, 6)] + F[5][7] * D[PIDX(7, 7)] +
+	     F[5][8] * D[PIDX(7, 8)] + F[7][8] * D[PIDX(5, 8)] + F[5][9] * D[PIDX(7, 9)] +
+	     F[7][9] * D[PIDX(5, 9)] + F[7][10] * D[PIDX(5, 10)] +
+	     F[7][11] * D[PIDX(5, 11)] + F[7][12] * D[PIDX(5, 12)]) * T + D[PIDX(5, 7)];
+	P[PIDX(5, 8)] =
 	    (F[8][9] *
-	     (F[5][9] * D[9][9] + F[5][6] * D[6][9] + F[5][7] * D[7][9] +
-	      F[5][8] * D[8][9]) + F[8][10] * (F[5][9] * D[9][10] +
-					       F[5][6] * D[6][10] +
-					       F[5][7] * D[7][10] +
-					       F[5][8] * D[8][10]) +
-	     F[8][11] * (F[5][9] * D[9][11] + F[5][6] * D[6][11] +
-			 F[5][7] * D[7][11] + F[5][8] * D[8][11]) +
-	     F[8][12] * (F[5][9] * D[9][12] + F[5][6] * D[6][12] +
-			 F[5][7] * D[7][12] + F[5][8] * D[8][12]) +
-	     F[8][6] * (F[5][6] * D[6][6] + F[5][7] * D[6][7] +
-			F[5][8] * D[6][8] + F[5][9] * D[6][9]) +
-	     F[8][7] * (F[5][6] * D[6][7] + F[5][7] * D[7][7] +
-			F[5][8] * D[7][8] + F[5][9] * D[7][9])) * Tsq +
-	    (F[5][6] * D[6][8] + F[5][7] * D[7][8] + F[8][6] * D[5][6] +
-	     F[8][7] * D[5][7] + F[5][8] * D[8][8] + F[5][9] * D[8][9] +
-	     F[8][9] * D[5][9] + F[8][10] * D[5][10] +
-	     F[8][11] * D[5][11] + F[8][12] * D[5][12]) * T + D[5][8];
-	P[5][9] = P[9][5] =
+	     (F[5][9] * D[PIDX(9, 9)] + F[5][6] * D[PIDX(6, 9)] + F[5][7] * D[PIDX(7, 9)] +
+	      F[5][8] * D[PIDX(8, 9)]) + F[8][10] * (F[5][9] * D[PIDX(9, 10)] +
+					       F[5][6] * D[PIDX(6, 10)] +
+					       F[5][7] * D[PIDX(7, 10)] +
+					       F[5][8] * D[PIDX(8, 10)]) +
+	     F[8][11] * (F[5][9] * D[PIDX(9, 11)] + F[5][6] * D[PIDX(6, 11)] +
+			 F[5][7] * D[PIDX(7, 11)] + F[5][8] * D[PIDX(8, 11)]) +
+	     F[8][12] * (F[5][9] * D[PIDX(9, 12)] + F[5][6] * D[PIDX(6, 12)] +
+			 F[5][7] * D[PIDX(7, 12)] + F[5][8] * D[PIDX(8, 12)]) +
+	     F[8][6] * (F[5][6] * D[PIDX(6, 6)] + F[5][7] * D[PIDX(6, 7)] +
+			F[5][8] * D[PIDX(6, 8)] + F[5][9] * D[PIDX(6, 9)]) +
+	     F[8][7] * (F[5][6] * D[PIDX(6, 7)] + F[5][7] * D[PIDX(7, 7)] +
+			F[5][8] * D[PIDX(7, 8)] + F[5][9] * D[PIDX(7, 9)])) * Tsq +
+	    (F[5][6] * D[PIDX(6, 8)] + F[5][7] * D[PIDX(7, 8)] + F[8][6] * D[PIDX(5, 6)] +
+	     F[8][7] * D[PIDX(5, 7)] + F[5][8] * D[PIDX(8, 8)] + F[5][9] * D[PIDX(8, 9)] +
+	     F[8][9] * D[PIDX(5, 9)] + F[8][10] * D[PIDX(5, 10)] +
+	     F[8][11] * D[PIDX(5, 11)] + F[8][12] * D[PIDX(5, 12)]) * T + D[PIDX(5, 8)];
+	P[PIDX(5, 9)] =
 	    (F[9][10] *
-	     (F[5][9] * D[9][10] + F[5][6] * D[6][10] +
-	      F[5][7] * D[7][10] + F[5][8] * D[8][10]) +
-	     F[9][11] * (F[5][9] * D[9][11] + F[5][6] * D[6][11] +
-			 F[5][7] * D[7][11] + F[5][8] * D[8][11]) +
-	     F[9][12] * (F[5][9] * D[9][12] + F[5][6] * D[6][12] +
-			 F[5][7] * D[7][12] + F[5][8] * D[8][12]) +
-	     F[9][6] * (F[5][6] * D[6][6] + F[5][7] * D[6][7] +
-			F[5][8] * D[6][8] + F[5][9] * D[6][9]) +
-	     F[9][7] * (F[5][6] * D[6][7] + F[5][7] * D[7][7] +
-			F[5][8] * D[7][8] + F[5][9] * D[7][9]) +
-	     F[9][8] * (F[5][6] * D[6][8] + F[5][7] * D[7][8] +
-			F[5][8] * D[8][8] + F[5][9] * D[8][9])) * Tsq +
-	    (F[9][6] * D[5][6] + F[9][7] * D[5][7] + F[9][8] * D[5][8] +
-	     F[5][9] * D[9][9] + F[9][10] * D[5][10] +
-	     F[9][11] * D[5][11] + F[9][12] * D[5][12] +
-	     F[5][6] * D[6][9] + F[5][7] * D[7][9] +
-	     F[5][8] * D[8][9]) * T + D[5][9];
-	P[5][10] = P[10][5] =
-	    (F[5][9] * D[9][10] + F[5][6] * D[6][10] + F[5][7] * D[7][10] +
-	     F[5][8] * D[8][10]) * T + D[5][10];
-	P[5][11] = P[11][5] =
-	    (F[5][9] * D[9][11] + F[5][6] * D[6][11] + F[5][7] * D[7][11] +
-	     F[5][8] * D[8][11]) * T + D[5][11];
-	P[5][12] = P[12][5] =
-	    (F[5][9] * D[9][12] + F[5][6] * D[6][12] + F[5][7] * D[7][12] +
-	     F[5][8] * D[8][12]) * T + D[5][12];
-	P[6][6] =
+	     (F[5][9] * D[PIDX(9, 10)] + F[5][6] * D[PIDX(6, 10)] +
+	      F[5][7] * D[PIDX(7, 10)] + F[5][8] * D[PIDX(8, 10)]) +
+	     F[9][11] * (F[5][9] * D[PIDX(9, 11)] + F[5][6] * D[PIDX(6, 11)] +
+			 F[5][7] * D[PIDX(7, 11)] + F[5][8] * D[PIDX(8, 11)]) +
+	     F[9][12] * (F[5][9] * D[PIDX(9, 12)] + F[5][6] * D[PIDX(6, 12)] +
+			 F[5][7] * D[PIDX(7, 12)] + F[5][8] * D[PIDX(8, 12)]) +
+	     F[9][6] * (F[5][6] * D[PIDX(6, 6)] + F[5][7] * D[PIDX(6, 7)] +
+			F[5][8] * D[PIDX(6, 8)] + F[5][9] * D[PIDX(6, 9)]) +
+	     F[9][7] * (F[5][6] * D[PIDX(6, 7)] + F[5][7] * D[PIDX(7, 7)] +
+			F[5][8] * D[PIDX(7, 8)] + F[5][9] * D[PIDX(7, 9)]) +
+	     F[9][8] * (F[5][6] * D[PIDX(6, 8)] + F[5][7] * D[PIDX(7, 8)] +
+			F[5][8] * D[PIDX(8, 8)] + F[5][9] * D[PIDX(8, 9)])) * Tsq +
+	    (F[9][6] * D[PIDX(5, 6)] + F[9][7] * D[PIDX(5, 7)] + F[9][8] * D[PIDX(5, 8)] +
+	     F[5][9] * D[PIDX(9, 9)] + F[9][10] * D[PIDX(5, 10)] +
+	     F[9][11] * D[PIDX(5, 11)] + F[9][12] * D[PIDX(5, 12)] +
+	     F[5][6] * D[PIDX(6, 9)] + F[5][7] * D[PIDX(7, 9)] +
+	     F[5][8] * D[PIDX(8, 9)]) * T + D[PIDX(5, 9)];
+	P[PIDX(5, 10)] =
+	    (F[5][9] * D[PIDX(9, 10)] + F[5][6] * D[PIDX(6, 10)] + F[5][7] * D[PIDX(7, 10)] +
+	     F[5][8] * D[PIDX(8, 10)]) * T + D[PIDX(5, 10)];
+	P[PIDX(5, 11)] =
+	    (F[5][9] * D[PIDX(9, 11)] + F[5][6] * D[PIDX(6, 11)] + F[5][7] * D[PIDX(7, 11)] +
+	     F[5][8] * D[PIDX(8, 11)]) * T + D[PIDX(5, 11)];
+	P[PIDX(5, 12)] =
+	    (F[5][9] * D[PIDX(9, 12)] + F[5][6] * D[PIDX(6, 12)] + F[5][7] * D[PIDX(7, 12)] +
+	     F[5][8] * D[PIDX(8, 12)]) * T + D[PIDX(5, 12)];
+	P[PIDX(6, 6)] =
 	    (Q[0] * G[6][0] * G[6][0] + Q[1] * G[6][1] * G[6][1] +
-	     Q[2] * G[6][2] * G[6][2] + F[6][9] * (F[6][9] * D[9][9] +
-						   F[6][10] * D[9][10] +
-						   F[6][11] * D[9][11] +
-						   F[6][12] * D[9][12] +
-						   F[6][7] * D[7][9] +
-						   F[6][8] * D[8][9]) +
-	     F[6][10] * (F[6][9] * D[9][10] + F[6][10] * D[10][10] +
-			 F[6][11] * D[10][11] + F[6][12] * D[10][12] +
-			 F[6][7] * D[7][10] + F[6][8] * D[8][10]) +
-	     F[6][11] * (F[6][9] * D[9][11] + F[6][10] * D[10][11] +
-			 F[6][11] * D[11][11] + F[6][12] * D[11][12] +
-			 F[6][7] * D[7][11] + F[6][8] * D[8][11]) +
-	     F[6][12] * (F[6][9] * D[9][12] + F[6][10] * D[10][12] +
-			 F[6][11] * D[11][12] + F[6][12] * D[12][12] +
-			 F[6][7] * D[7][12] + F[6][8] * D[8][12]) +
-	     F[6][7] * (F[6][7] * D[7][7] + F[6][8] * D[7][8] +
-			F[6][9] * D[7][9] + F[6][10] * D[7][10] +
-			F[6][11] * D[7][11] + F[6][12] * D[7][12]) +
-	     F[6][8] * (F[6][7] * D[7][8] + F[6][8] * D[8][8] +
-			F[6][9] * D[8][9] + F[6][10] * D[8][10] +
-			F[6][11] * D[8][11] + F[6][12] * D[8][12])) * Tsq +
-	    (2 * F[6][7] * D[6][7] + 2 * F[6][8] * D[6][8] +
-	     2 * F[6][9] * D[6][9] + 2 * F[6][10] * D[6][10] +
-	     2 * F[6][11] * D[6][11] + 2 * F[6][12] * D[6][12]) * T +
-	    D[6][6];
-	P[6][7] = P[7][6] =
+	     Q[2] * G[6][2] * G[6][2] + F[6][9] * (F[6][9] * D[PIDX(9, 9)] +
+						   F[6][10] * D[PIDX(9, 10)] +
+						   F[6][11] * D[PIDX(9, 11)] +
+						   F[6][12] * D[PIDX(9, 12)] +
+						   F[6][7] * D[PIDX(7, 9)] +
+						   F[6][8] * D[PIDX(8, 9)]) +
+	     F[6][10] * (F[6][9] * D[PIDX(9, 10)] + F[6][10] * D[PIDX(10, 10)] +
+			 F[6][11] * D[PIDX(10, 11)] + F[6][12] * D[PIDX(10, 12)] +
+			 F[6][7] * D[PIDX(7, 10)] + F[6][8] * D[PIDX(8, 10)]) +
+	     F[6][11] * (F[6][9] * D[PIDX(9, 11)] + F[6][10] * D[PIDX(10, 11)] +
+			 F[6][11] * D[PIDX(11, 11)] + F[6][12] * D[PIDX(11, 12)] +
+			 F[6][7] * D[PIDX(7, 11)] + F[6][8] * D[PIDX(8, 11)]) +
+	     F[6][12] * (F[6][9] * D[PIDX(9, 12)] + F[6][10] * D[PIDX(10, 12)] +
+			 F[6][11] * D[PIDX(11, 12)] + F[6][12] * D[PIDX(12, 12)] +
+			 F[6][7] * D[PIDX(7, 12)] + F[6][8] * D[PIDX(8, 12)]) +
+	     F[6][7] * (F[6][7] * D[PIDX(7, 7)] + F[6][8] * D[PIDX(7, 8)] +
+			F[6][9] * D[PIDX(7, 9)] + F[6][10] * D[PIDX(7, 10)] +
+			F[6][11] * D[PIDX(7, 11)] + F[6][12] * D[PIDX(7, 12)]) +
+	     F[6][8] * (F[6][7] * D[PIDX(7, 8)] + F[6][8] * D[PIDX(8, 8)] +
+			F[6][9] * D[PIDX(8, 9)] + F[6][10] * D[PIDX(8, 10)] +
+			F[6][11] * D[PIDX(8, 11)] + F[6][12] * D[PIDX(8, 12)])) * Tsq +
+	    (2 * F[6][7] * D[PIDX(6, 7)] + 2 * F[6][8] * D[PIDX(6, 8)] +
+	     2 * F[6][9] * D[PIDX(6, 9)] + 2 * F[6][10] * D[PIDX(6, 10)] +
+	     2 * F[6][11] * D[PIDX(6, 11)] + 2 * F[6][12] * D[PIDX(6, 12)]) * T +
+	    D[PIDX(6, 6)];
+	P[PIDX(6, 7)] =
 	    (F[7][9] *
-	     (F[6][9] * D[9][9] + F[6][10] * D[9][10] +
-	      F[6][11] * D[9][11] + F[6][12] * D[9][12] +
-	      F[6][7] * D[7][9] + F[6][8] * D[8][9]) +
-	     F[7][10] * (F[6][9] * D[9][10] + F[6][10] * D[10][10] +
-			 F[6][11] * D[10][11] + F[6][12] * D[10][12] +
-			 F[6][7] * D[7][10] + F[6][8] * D[8][10]) +
-	     F[7][11] * (F[6][9] * D[9][11] + F[6][10] * D[10][11] +
-			 F[6][11] * D[11][11] + F[6][12] * D[11][12] +
-			 F[6][7] * D[7][11] + F[6][8] * D[8][11]) +
-	     F[7][12] * (F[6][9] * D[9][12] + F[6][10] * D[10][12] +
-			 F[6][11] * D[11][12] + F[6][12] * D[12][12] +
-			 F[6][7] * D[7][12] + F[6][8] * D[8][12]) +
-	     F[7][6] * (F[6][7] * D[6][7] + F[6][8] * D[6][8] +
-			F[6][9] * D[6][9] + F[6][10] * D[6][10] +
-			F[6][11] * D[6][11] + F[6][12] * D[6][12]) +
-	     F[7][8] * (F[6][7] * D[7][8] + F[6][8] * D[8][8] +
-			F[6][9] * D[8][9] + F[6][10] * D[8][10] +
-			F[6][11] * D[8][11] + F[6][12] * D[8][12]) +
+	     (F[6][9] * D[PIDX(9, 9)] + F[6][10] * D[PIDX(9, 10)] +
+	      F[6][11] * D[PIDX(9, 11)] + F[6][12] * D[PIDX(9, 12)] +
+	      F[6][7] * D[PIDX(7, 9)] + F[6][8] * D[PIDX(8, 9)]) +
+	     F[7][10] * (F[6][9] * D[PIDX(9, 10)] + F[6][10] * D[PIDX(10, 10)] +
+			 F[6][11] * D[PIDX(10, 11)] + F[6][12] * D[PIDX(10, 12)] +
+			 F[6][7] * D[PIDX(7, 10)] + F[6][8] * D[PIDX(8, 10)]) +
+	     F[7][11] * (F[6][9] * D[PIDX(9, 11)] + F[6][10] * D[PIDX(10, 11)] +
+			 F[6][11] * D[PIDX(11, 11)] + F[6][12] * D[PIDX(11, 12)] +
+			 F[6][7] * D[PIDX(7, 11)] + F[6][8] * D[PIDX(8, 11)]) +
+	     F[7][12] * (F[6][9] * D[PIDX(9, 12)] + F[6][10] * D[PIDX(10, 12)] +
+			 F[6][11] * D[PIDX(11, 12)] + F[6][12] * D[PIDX(12, 12)] +
+			 F[6][7] * D[PIDX(7, 12)] + F[6][8] * D[PIDX(8, 12)]) +
+	     F[7][6] * (F[6][7] * D[PIDX(6, 7)] + F[6][8] * D[PIDX(6, 8)] +
+			F[6][9] * D[PIDX(6, 9)] + F[6][10] * D[PIDX(6, 10)] +
+			F[6][11] * D[PIDX(6, 11)] + F[6][12] * D[PIDX(6, 12)]) +
+	     F[7][8] * (F[6][7] * D[PIDX(7, 8)] + F[6][8] * D[PIDX(8, 8)] +
+			F[6][9] * D[PIDX(8, 9)] + F[6][10] * D[PIDX(8, 10)] +
+			F[6][11] * D[PIDX(8, 11)] + F[6][12] * D[PIDX(8, 12)]) +
 	     G[6][0] * G[7][0] * Q[0] + G[6][1] * G[7][1] * Q[1] +
-	     G[6][2] * G[7][2] * Q[2]) * Tsq + (F[7][6] * D[6][6] +
-						F[6][7] * D[7][7] +
-						F[6][8] * D[7][8] +
-						F[7][8] * D[6][8] +
-						F[6][9] * D[7][9] +
-						F[7][9] * D[6][9] +
-						F[6][10] * D[7][10] +
-						F[7][10] * D[6][10] +
-						F[6][11] * D[7][11] +
-						F[7][11] * D[6][11] +
-						F[6][12] * D[7][12] +
-						F[7][12] * D[6][12]) * T +
-	    D[6][7];
-	P[6][8] = P[8][6] =
+	     G[6][2] * G[7][2] * Q[2]) * Tsq + (F[7][6] * D[PIDX(6, 6)] +
+						F[6][7] * D[PIDX(7, 7)] +
+						F[6][8] * D[PIDX(7, 8)] +
+						F[7][8] * D[PIDX(6, 8)] +
+						F[6][9] * D[PIDX(7, 9)] +
+						F[7][9] * D[PIDX(6, 9)] +
+						F[6][10] * D[PIDX(7, 10)] +
+						F[7][10] * D[PIDX(6, 10)] +
+						F[6][11] * D[PIDX(7, 11)] +
+						F[7][11] * D[PIDX(6, 11)] +
+						F[6][12] * D[PIDX(7, 12)] +
+						F[7][12] * D[PIDX(6, 12)]) * T +
+	    D[PIDX(6, 7)];
+	P[PIDX(6, 8)] =
 	    (F[8][9] *
-	     (F[6][9] * D[9][9] + F[6][10] * D[9][10] +
-	      F[6][11] * D[9][11] + F[6][12] * D[9][12] +
-	      F[6][7] * D[7][9] + F[6][8] * D[8][9]) +
-	     F[8][10] * (F[6][9] * D[9][10] + F[6][10] * D[10][10] +
-			 F[6][11] * D[10][11] + F[6][12] * D[10][12] +
-			 F[6][7] * D[7][10] + F[6][8] * D[8][10]) +
-	     F[8][11] * (F[6][9] * D[9][11] + F[6][10] * D[10][11] +
-			 F[6][11] * D[11][11] + F[6][12] * D[11][12] +
-			 F[6][7] * D[7][11] + F[6][8] * D[8][11]) +
-	     F[8][12] * (F[6][9] * D[9][12] + F[6][10] * D[10][12] +
-			 F[6][11] * D[11][12] + F[6][12] * D[12][12] +
-			 F[6][7] * D[7][12] + F[6][8] * D[8][12]) +
-	     F[8][6] * (F[6][7] * D[6][7] + F[6][8] * D[6][8] +
-			F[6][9] * D[6][9] + F[6][10] * D[6][10] +
-			F[6][11] * D[6][11] + F[6][12] * D[6][12]) +
-	     F[8][7] * (F[6][7] * D[7][7] + F[6][8] * D[7][8] +
-			F[6][9] * D[7][9] + F[6][10] * D[7][10] +
-			F[6][11] * D[7][11] + F[6][12] * D[7][12]) +
+	     (F[6][9] * D[PIDX(9, 9)] + F[6][10] * D[PIDX(9, 10)] +
+	      F[6][11] * D[PIDX(9, 11)] + F[6][12] * D[PIDX(9, 12)] +
+	      F[6][7] * D[PIDX(7, 9)] + F[6][8] * D[PIDX(8, 9)]) +
+	     F[8][10] * (F[6][9] * D[PIDX(9, 10)] + F[6][10] * D[PIDX(10, 10)] +
+			 F[6][11] * D[PIDX(10, 11)] + F[6][12] * D[PIDX(10, 12)] +
+			 F[6][7] * D[PIDX(7, 10)] + F[6][8] * D[PIDX(8, 10)]) +
+	     F[8][11] * (F[6][9] * D[PIDX(9, 11)] + F[6][10] * D[PIDX(10, 11)] +
+			 F[6][11] * D[PIDX(11, 11)] + F[6][12] * D[PIDX(11, 12)] +
+			 F[6][7] * D[PIDX(7, 11)] + F[6][8] * D[PIDX(8, 11)]) +
+	     F[8][12] * (F[6][9] * D[PIDX(9, 12)] + F[6][10] * D[PIDX(10, 12)] +
+			 F[6][11] * D[PIDX(11, 12)] + F[6][12] * D[PIDX(12, 12)] +
+			 F[6][7] * D[PIDX(7, 12)] + F[6][8] * D[PIDX(8, 12)]) +
+	     F[8][6] * (F[6][7] * D[PIDX(6, 7)] + F[6][8] * D[PIDX(6, 8)] +
+			F[6][9] * D[PIDX(6, 9)] + F[6][10] * D[PIDX(6, 10)] +
+			F[6][11] * D[PIDX(6, 11)] + F[6][12] * D[PIDX(6, 12)]) +
+	     F[8][7] * (F[6][7] * D[PIDX(7, 7)] + F[6][8] * D[PIDX(7, 8)] +
+			F[6][9] * D[PIDX(7, 9)] + F[6][10] * D[PIDX(7, 10)] +
+			F[6][11] * D[PIDX(7, 11)] + F[6][12] * D[PIDX(7, 12)]) +
 	     G[6][0] * G[8][0] * Q[0] + G[6][1] * G[8][1] * Q[1] +
-	     G[6][2] * G[8][2] * Q[2]) * Tsq + (F[6][7] * D[7][8] +
-						F[8][6] * D[6][6] +
-						F[8][7] * D[6][7] +
-						F[6][8] * D[8][8] +
-						F[6][9] * D[8][9] +
-						F[8][9] * D[6][9] +
-						F[6][10] * D[8][10] +
-						F[8][10] * D[6][10] +
-						F[6][11] * D[8][11] +
-						F[8][11] * D[6][11] +
-						F[6][12] * D[8][12] +
-						F[8][12] * D[6][12]) * T +
-	    D[6][8];
-	P[6][9] = P[9][6] =
+	     G[6][2] * G[8][2] * Q[2]) * Tsq + (F[6][7] * D[PIDX(7, 8)] +
+						F[8][6] * D[PIDX(6, 6)] +
+						F[8][7] * D[PIDX(6, 7)] +
+						F[6][8] * D[PIDX(8, 8)] +
+						F[6][9] * D[PIDX(8, 9)] +
+						F[8][9] * D[PIDX(6, 9)] +
+						F[6][10] * D[PIDX(8, 10)] +
+						F[8][10] * D[PIDX(6, 10)] +
+						F[6][11] * D[PIDX(8, 11)] +
+						F[8][11] * D[PIDX(6, 11)] +
+						F[6][12] * D[PIDX(8, 12)] +
+						F[8][12] * D[PIDX(6, 12)]) * T +
+	    D[PIDX(6, 8)];
+	P[PIDX(6, 9)] =
 	    (F[9][10] *
-	     (F[6][9] * D[9][10] + F[6][10] * D[10][10] +
-	      F[6][11] * D[10][11] + F[6][12] * D[10][12] +
-	      F[6][7] * D[7][10] + F[6][8] * D[8][10]) +
-	     F[9][11] * (F[6][9] * D[9][11] + F[6][10] * D[10][11] +
-			 F[6][11] * D[11][11] + F[6][12] * D[11][12] +
-			 F[6][7] * D[7][11] + F[6][8] * D[8][11]) +
-	     F[9][12] * (F[6][9] * D[9][12] + F[6][10] * D[10][12] +
-			 F[6][11] * D[11][12] + F[6][12] * D[12][12] +
-			 F[6][7] * D[7][12] + F[6][8] * D[8][12]) +
-	     F[9][6] * (F[6][7] * D[6][7] + F[6][8] * D[6][8] +
-			F[6][9] * D[6][9] + F[6][10] * D[6][10] +
-			F[6][11] * D[6][11] + F[6][12] * D[6][12]) +
-	     F[9][7] * (F[6][7] * D[7][7] + F[6][8] * D[7][8] +
-			F[6][9] * D[7][9] + F[6][10] * D[7][10] +
-			F[6][11] * D[7][11] + F[6][12] * D[7][12]) +
-	     F[9][8] * (F[6][7] * D[7][8] + F[6][8] * D[8][8] +
-			F[6][9] * D[8][9] + F[6][10] * D[8][10] +
-			F[6][11] * D[8][11] + F[6][12] * D[8][12]) +
+	     (F[6][9] * D[PIDX(9, 10)] + F[6][10] * D[PIDX(10, 10)] +
+	      F[6][11] * D[PIDX(10, 11)] + F[6][12] * D[PIDX(10, 12)] +
+	      F[6][7] * D[PIDX(7, 10)] + F[6][8] * D[PIDX(8, 10)]) +
+	     F[9][11] * (F[6][9] * D[PIDX(9, 11)] + F[6][10] * D[PIDX(10, 11)] +
+			 F[6][11] * D[PIDX(11, 11)] + F[6][12] * D[PIDX(11, 12)] +
+			 F[6][7] * D[PIDX(7, 11)] + F[6][8] * D[PIDX(8, 11)]) +
+	     F[9][12] * (F[6][9] * D[PIDX(9, 12)] + F[6][10] * D[PIDX(10, 12)] +
+			 F[6][11] * D[PIDX(11, 12)] + F[6][12] * D[PIDX(12, 12)] +
+			 F[6][7] * D[PIDX(7, 12)] + F[6][8] * D[PIDX(8, 12)]) +
+	     F[9][6] * (F[6][7] * D[PIDX(6, 7)] + F[6][8] * D[PIDX(6, 8)] +
+			F[6][9] * D[PIDX(6, 9)] + F[6][10] * D[PIDX(6, 10)] +
+			F[6][11] * D[PIDX(6, 11)] + F[6][12] * D[PIDX(6, 12)]) +
+	     F[9][7] * (F[6][7] * D[PIDX(7, 7)] + F[6][8] * D[PIDX(7, 8)] +
+			F[6][9] * D[PIDX(7, 9)] + F[6][10] * D[PIDX(7, 10)] +
+			F[6][11] * D[PIDX(7, 11)] + F[6][12] * D[PIDX(7, 12)]) +
+	     F[9][8] * (F[6][7] * D[PIDX(7, 8)] + F[6][8] * D[PIDX(8, 8)] +
+			F[6][9] * D[PIDX(8, 9)] + F[6][10] * D[PIDX(8, 10)] +
+			F[6][11] * D[PIDX(8, 11)] + F[6][12] * D[PIDX(8, 12)]) +
 	     G[9][0] * G[6][0] * Q[0] + G[9][1] * G[6][1] * Q[1] +
-	     G[9][2] * G[6][2] * Q[2]) * Tsq + (F[9][6] * D[6][6] +
-						F[9][7] * D[6][7] +
-						F[9][8] * D[6][8] +
-						F[6][9] * D[9][9] +
-						F[9][10] * D[6][10] +
-						F[6][10] * D[9][10] +
-						F[9][11] * D[6][11] +
-						F[6][11] * D[9][11] +
-						F[9][12] * D[6][12] +
-						F[6][12] * D[9][12] +
-						F[6][7] * D[7][9] +
-						F[6][8] * D[8][9]) * T +
-	    D[6][9];
-	P[6][10] = P[10][6] =
-	    (F[6][9] * D[9][10] + F[6][10] * D[10][10] +
-	     F[6][11] * D[10][11] + F[6][12] * D[10][12] +
-	     F[6][7] * D[7][10] + F[6][8] * D[8][10]) * T + D[6][10];
-	P[6][11] = P[11][6] =
-	    (F[6][9] * D[9][11] + F[6][10] * D[10][11] +
-	     F[6][11] * D[11][11] + F[6][12] * D[11][12] +
-	     F[6][7] * D[7][11] + F[6][8] * D[8][11]) * T + D[6][11];
-	P[6][12] = P[12][6] =
-	    (F[6][9] * D[9][12] + F[6][10] * D[10][12] +
-	     F[6][11] * D[11][12] + F[6][12] * D[12][12] +
-	     F[6][7] * D[7][12] + F[6][8] * D[8][12]) * T + D[6][12];
-	P[7][7] =
+	     G[9][2] * G[6][2] * Q[2]) * Tsq + (F[9][6] * D[PIDX(6, 6)] +
+						F[9][7] * D[PIDX(6, 7)] +
+						F[9][8] * D[PIDX(6, 8)] +
+						F[6][9] * D[PIDX(9, 9)] +
+						F[9][10] * D[PIDX(6, 10)] +
+						F[6][10] * D[PIDX(9, 10)] +
+						F[9][11] * D[PIDX(6, 11)] +
+						F[6][11] * D[PIDX(9, 11)] +
+						F[9][12] * D[PIDX(6, 12)] +
+						F[6][12] * D[PIDX(9, 12)] +
+						F[6][7] * D[PIDX(7, 9)] +
+						F[6][8] * D[PIDX(8, 9)]) * T +
+	    D[PIDX(6, 9)];
+	P[PIDX(6, 10)] =
+	    (F[6][9] * D[PIDX(9, 10)] + F[6][10] * D[PIDX(10, 10)] +
+	     F[6][11] * D[PIDX(10, 11)] + F[6][12] * D[PIDX(10, 12)] +
+	     F[6][7] * D[PIDX(7, 10)] + F[6][8] * D[PIDX(8, 10)]) * T + D[PIDX(6, 10)];
+	P[PIDX(6, 11)] =
+	    (F[6][9] * D[PIDX(9, 11)] + F[6][10] * D[PIDX(10, 11)] +
+	     F[6][11] * D[PIDX(11, 11)] + F[6][12] * D[PIDX(11, 12)] +
+	     F[6][7] * D[PIDX(7, 11)] + F[6][8] * D[PIDX(8, 11)]) * T + D[PIDX(6, 11)];
+	P[PIDX(6, 12)] =
+	    (F[6][9] * D[PIDX(9, 12)] + F[6][10] * D[PIDX(10, 12)] +
+	     F[6][11] * D[PIDX(11, 12)] + F[6][12] * D[PIDX(12, 12)] +
+	     F[6][7] * D[PIDX(7, 12)] + F[6][8] * D[PIDX(8, 12)]) * T + D[PIDX(6, 12)];
+	P[PIDX(7, 7)] =
 	    (Q[0] * G[7][0] * G[7][0] + Q[1] * G[7][1] * G[7][1] +
-	     Q[2] * G[7][2] * G[7][2] + F[7][9] * (F[7][9] * D[9][9] +
-						   F[7][10] * D[9][10] +
-						   F[7][11] * D[9][11] +
-						   F[7][12] * D[9][12] +
-						   F[7][6] * D[6][9] +
-						   F[7][8] * D[8][9]) +
-	     F[7][10] * (F[7][9] * D[9][10] + F[7][10] * D[10][10] +
-			 F[7][11] * D[10][11] + F[7][12] * D[10][12] +
-			 F[7][6] * D[6][10] + F[7][8] * D[8][10]) +
-	     F[7][11] * (F[7][9] * D[9][11] + F[7][10] * D[10][11] +
-			 F[7][11] * D[11][11] + F[7][12] * D[11][12] +
-			 F[7][6] * D[6][11] + F[7][8] * D[8][11]) +
-	     F[7][12] * (F[7][9] * D[9][12] + F[7][10] * D[10][12] +
-			 F[7][11] * D[11][12] + F[7][12] * D[12][12] +
-			 F[7][6] * D[6][12] + F[7][8] * D[8][12]) +
-	     F[7][6] * (F[7][6] * D[6][6] + F[7][8] * D[6][8] +
-			F[7][9] * D[6][9] + F[7][10] * D[6][10] +
-			F[7][11] * D[6][11] + F[7][12] * D[6][12]) +
-	     F[7][8] * (F[7][6] * D[6][8] + F[7][8] * D[8][8] +
-			F[7][9] * D[8][9] + F[7][10] * D[8][10] +
-			F[7][11] * D[8][11] + F[7][12] * D[8][12])) * Tsq +
-	    (2 * F[7][6] * D[6][7] + 2 * F[7][8] * D[7][8] +
-	     2 * F[7][9] * D[7][9] + 2 * F[7][10] * D[7][10] +
-	     2 * F[7][11] * D[7][11] + 2 * F[7][12] * D[7][12]) * T +
-	    D[7][7];
-	P[7][8] = P[8][7] =
+	     Q[2] * G[7][2] * G[7][2] + F[7][9] * (F[7][9] * D[PIDX(9, 9)] +
+						   F[7][10] * D[PIDX(9, 10)] +
+						   F[7][11] * D[PIDX(9, 11)] +
+						   F[7][12] * D[PIDX(9, 12)] +
+						   F[7][6] * D[PIDX(6, 9)] +
+						   F[7][8] * D[PIDX(8, 9)]) +
+	     F[7][10] * (F[7][9] * D[PIDX(9, 10)] + F[7][10] * D[PIDX(10, 10)] +
+			 F[7][11] * D[PIDX(10, 11)] + F[7][12] * D[PIDX(10, 12)] +
+			 F[7][6] * D[PIDX(6, 10)] + F[7][8] * D[PIDX(8, 10)]) +
+	     F[7][11] * (F[7][9] * D[PIDX(9, 11)] + F[7][10] * D[PIDX(10, 11)] +
+			 F[7][11] * D[PIDX(11, 11)] + F[7][12] * D[PIDX(11, 12)] +
+			 F[7][6] * D[PIDX(6, 11)] + F[7][8] * D[PIDX(8, 11)]) +
+	     F[7][12] * (F[7][9] * D[PIDX(9, 12)] + F[7][10] * D[PIDX(10, 12)] +
+			 F[7][11] * D[PIDX(11, 12)] + F[7][12] * D[PIDX(12, 12)] +
+			 F[7][6] * D[PIDX(6, 12)] + F[7][8] * D[PIDX(8, 12)]) +
+	     F[7][6] * (F[7][6] * D[PIDX(6, 6)] + F[7][8] * D[PIDX(6, 8)] +
+			F[7][9] * D[PIDX(6, 9)] + F[7][10] * D[PIDX(6, 10)] +
+			F[7][11] * D[PIDX(6, 11)] + F[7][12] * D[PIDX(6, 12)]) +
+	     F[7][8] * (F[7][6] * D[PIDX(6, 8)] + F[7][8] * D[PIDX(8, 8)] +
+			F[7][9] * D[PIDX(8, 9)] + F[7][10] * D[PIDX(8, 10)] +
+			F[7][11] * D[PIDX(8, 11)] + F[7][12] * D[PIDX(8, 12)])) * Tsq +
+	    (2 * F[7][6] * D[PIDX(6, 7)] + 2 * F[7][8] * D[PIDX(7, 8)] +
+	     2 * F[7][9] * D[PIDX(7, 9)] + 2 * F[7][10] * D[PIDX(7, 10)] +
+	     2 * F[7][11] * D[PIDX(7, 11)] + 2 * F[7][12] * D[PIDX(7, 12)]) * T +
+	    D[PIDX(7, 7)];
+	P[PIDX(7, 8)] =
 	    (F[8][9] *
-	     (F[7][9] * D[9][9] + F[7][10] * D[9][10] +
-	      F[7][11] * D[9][11] + F[7][12] * D[9][12] +
-	      F[7][6] * D[6][9] + F[7][8] * D[8][9]) +
-	     F[8][10] * (F[7][9] * D[9][10] + F[7][10] * D[10][10] +
-			 F[7][11] * D[10][11] + F[7][12] * D[10][12] +
-			 F[7][6] * D[6][10] + F[7][8] * D[8][10]) +
-	     F[8][11] * (F[7][9] * D[9][11] + F[7][10] * D[10][11] +
-			 F[7][11] * D[11][11] + F[7][12] * D[11][12] +
-			 F[7][6] * D[6][11] + F[7][8] * D[8][11]) +
-	     F[8][12] * (F[7][9] * D[9][12] + F[7][10] * D[10][12] +
-			 F[7][11] * D[11][12] + F[7][12] * D[12][12] +
-			 F[7][6] * D[6][12] + F[7][8] * D[8][12]) +
-	     F[8][6] * (F[7][6] * D[6][6] + F[7][8] * D[6][8] +
-			F[7][9] * D[6][9] + F[7][10] * D[6][10] +
-			F[7][11] * D[6][11] + F[7][12] * D[6][12]) +
-	     F[8][7] * (F[7][6] * D[6][7] + F[7][8] * D[7][8] +
-			F[7][9] * D[7][9] + F[7][10] * D[7][10] +
-			F[7][11] * D[7][11] + F[7][12] * D[7][12]) +
+	     (F[7][9] * D[PIDX(9, 9)] + F[7][10] * D[PIDX(9, 10)] +
+	      F[7][11] * D[PIDX(9, 11)] + F[7][12] * D[PIDX(9, 12)] +
+	      F[7][6] * D[PIDX(6, 9)] + F[7][8] * D[PIDX(8, 9)]) +
+	     F[8][10] * (F[7][9] * D[PIDX(9, 10)] + F[7][10] * D[PIDX(10, 10)] +
+			 F[7][11] * D[PIDX(10, 11)] + F[7][12] * D[PIDX(10, 12)] +
+			 F[7][6] * D[PIDX(6, 10)] + F[7][8] * D[PIDX(8, 10)]) +
+	     F[8][11] * (F[7][9] * D[PIDX(9, 11)] + F[7][10] * D[PIDX(10, 11)] +
+			 F[7][11] * D[PIDX(11, 11)] + F[7][12] * D[PIDX(11, 12)] +
+			 F[7][6] * D[PIDX(6, 11)] + F[7][8] * D[PIDX(8, 11)]) +
+	     F[8][12] * (F[7][9] * D[PIDX(9, 12)] + F[7][10] * D[PIDX(10, 12)] +
+			 F[7][11] * D[PIDX(11, 12)] + F[7][12] * D[PIDX(12, 12)] +
+			 F[7][6] * D[PIDX(6, 12)] + F[7][8] * D[PIDX(8, 12)]) +
+	     F[8][6] * (F[7][6] * D[PIDX(6, 6)] + F[7][8] * D[PIDX(6, 8)] +
+			F[7][9] * D[PIDX(6, 9)] + F[7][10] * D[PIDX(6, 10)] +
+			F[7][11] * D[PIDX(6, 11)] + F[7][12] * D[PIDX(6, 12)]) +
+	     F[8][7] * (F[7][6] * D[PIDX(6, 7)] + F[7][8] * D[PIDX(7, 8)] +
+			F[7][9] * D[PIDX(7, 9)] + F[7][10] * D[PIDX(7, 10)] +
+			F[7][11] * D[PIDX(7, 11)] + F[7][12] * D[PIDX(7, 12)]) +
 	     G[7][0] * G[8][0] * Q[0] + G[7][1] * G[8][1] * Q[1] +
-	     G[7][2] * G[8][2] * Q[2]) * Tsq + (F[7][6] * D[6][8] +
-						F[8][6] * D[6][7] +
-						F[8][7] * D[7][7] +
-						F[7][8] * D[8][8] +
-						F[7][9] * D[8][9] +
-						F[8][9] * D[7][9] +
-						F[7][10] * D[8][10] +
-						F[8][10] * D[7][10] +
-						F[7][11] * D[8][11] +
-						F[8][11] * D[7][11] +
-						F[7][12] * D[8][12] +
-						F[8][12] * D[7][12]) * T +
-	    D[7][8];
-	P[7][9] = P[9][7] =
+	     G[7][2] * G[8][2] * Q[2]) * Tsq + (F[7][6] * D[PIDX(6, 8)] +
+						F[8][6] * D[PIDX(6, 7)] +
+						F[8][7] * D[PIDX(7, 7)] +
+						F[7][8] * D[PIDX(8, 8)] +
+						F[7][9] * D[PIDX(8, 9)] +
+						F[8][9] * D[PIDX(7, 9)] +
+						F[7][10] * D[PIDX(8, 10)] +
+						F[8][10] * D[PIDX(7, 10)] +
+						F[7][11] * D[PIDX(8, 11)] +
+						F[8][11] * D[PIDX(7, 11)] +
+						F[7][12] * D[PIDX(8, 12)] +
+						F[8][12] * D[PIDX(7, 12)]) * T +
+	    D[PIDX(7, 8)];
+	P[PIDX(7, 9)] =
 	    (F[9][10] *
-	     (F[7][9] * D[9][10] + F[7][10] * D[10][10] +
-	      F[7][11] * D[10][11] + F[7][12] * D[10][12] +
-	      F[7][6] * D[6][10] + F[7][8] * D[8][10]) +
-	     F[9][11] * (F[7][9] * D[9][11] + F[7][10] * D[10][11] +
-			 F[7][11] * D[11][11] + F[7][12] * D[11][12] +
-			 F[7][6] * D[6][11] + F[7][8] * D[8][11]) +
-	     F[9][12] * (F[7][9] * D[9][12] + F[7][10] * D[10][12] +
-			 F[7][11] * D[11][12] + F[7][12] * D[12][12] +
-			 F[7][6] * D[6][12] + F[7][8] * D[8][12]) +
-	     F[9][6] * (F[7][6] * D[6][6] + F[7][8] * D[6][8] +
-			F[7][9] * D[6][9] + F[7][10] * D[6][10] +
-			F[7][11] * D[6][11] + F[7][12] * D[6][12]) +
-	     F[9][7] * (F[7][6] * D[6][7] + F[7][8] * D[7][8] +
-			F[7][9] * D[7][9] + F[7][10] * D[7][10] +
-			F[7][11] * D[7][11] + F[7][12] * D[7][12]) +
-	     F[9][8] * (F[7][6] * D[6][8] + F[7][8] * D[8][8] +
-			F[7][9] * D[8][9] + F[7][10] * D[8][10] +
-			F[7][11] * D[8][11] + F[7][12] * D[8][12]) +
+	     (F[7][9] * D[PIDX(9, 10)] + F[7][10] * D[PIDX(10, 10)] +
+	      F[7][11] * D[PIDX(10, 11)] + F[7][12] * D[PIDX(10, 12)] +
+	      F[7][6] * D[PIDX(6, 10)] + F[7][8] * D[PIDX(8, 10)]) +
+	     F[9][11] * (F[7][9] * D[PIDX(9, 11)] + F[7][10] * D[PIDX(10, 11)] +
+			 F[7][11] * D[PIDX(11, 11)] + F[7][12] * D[PIDX(11, 12)] +
+			 F[7][6] * D[PIDX(6, 11)] + F[7][8] * D[PIDX(8, 11)]) +
+	     F[9][12] * (F[7][9] * D[PIDX(9, 12)] + F[7][10] * D[PIDX(10, 12)] +
+			 F[7][11] * D[PIDX(11, 12)] + F[7][12] * D[PIDX(12, 12)] +
+			 F[7][6] * D[PIDX(6, 12)] + F[7][8] * D[PIDX(8, 12)]) +
+	     F[9][6] * (F[7][6] * D[PIDX(6, 6)] + F[7][8] * D[PIDX(6, 8)] +
+			F[7][9] * D[PIDX(6, 9)] + F[7][10] * D[PIDX(6, 10)] +
+			F[7][11] * D[PIDX(6, 11)] + F[7][12] * D[PIDX(6, 12)]) +
+	     F[9][7] * (F[7][6] * D[PIDX(6, 7)] + F[7][8] * D[PIDX(7, 8)] +
+			F[7][9] * D[PIDX(7, 9)] + F[7][10] * D[PIDX(7, 10)] +
+			F[7][11] * D[PIDX(7, 11)] + F[7][12] * D[PIDX(7, 12)]) +
+	     F[9][8] * (F[7][6] * D[PIDX(6, 8)] + F[7][8] * D[PIDX(8, 8)] +
+			F[7][9] * D[PIDX(8, 9)] + F[7][10] * D[PIDX(8, 10)] +
+			F[7][11] * D[PIDX(8, 11)] + F[7][12] * D[PIDX(8, 12)]) +
 	     G[9][0] * G[7][0] * Q[0] + G[9][1] * G[7][1] * Q[1] +
-	     G[9][2] * G[7][2] * Q[2]) * Tsq + (F[9][6] * D[6][7] +
-						F[9][7] * D[7][7] +
-						F[9][8] * D[7][8] +
-						F[7][9] * D[9][9] +
-						F[9][10] * D[7][10] +
-						F[7][10] * D[9][10] +
-						F[9][11] * D[7][11] +
-						F[7][11] * D[9][11] +
-						F[9][12] * D[7][12] +
-						F[7][12] * D[9][12] +
-						F[7][6] * D[6][9] +
-						F[7][8] * D[8][9]) * T +
-	    D[7][9];
-	P[7][10] = P[10][7] =
-	    (F[7][9] * D[9][10] + F[7][10] * D[10][10] +
-	     F[7][11] * D[10][11] + F[7][12] * D[10][12] +
-	     F[7][6] * D[6][10] + F[7][8] * D[8][10]) * T + D[7][10];
-	P[7][11] = P[11][7] =
-	    (F[7][9] * D[9][11] + F[7][10] * D[10][11] +
-	     F[7][11] * D[11][11] + F[7][12] * D[11][12] +
-	     F[7][6] * D[6][11] + F[7][8] * D[8][11]) * T + D[7][11];
-	P[7][12] = P[12][7] =
-	    (F[7][9] * D[9][12] + F[7][10] * D[10][12] +
-	     F[7][11] * D[11][12] + F[7][12] * D[12][12] +
-	     F[7][6] * D[6][12] + F[7][8] * D[8][12]) * T + D[7][12];
-	P[8][8] =
+	     G[9][2] * G[7][2] * Q[2]) * Tsq + (F[9][6] * D[PIDX(6, 7)] +
+						F[9][7] * D[PIDX(7, 7)] +
+						F[9][8] * D[PIDX(7, 8)] +
+						F[7][9] * D[PIDX(9, 9)] +
+						F[9][10] * D[PIDX(7, 10)] +
+						F[7][10] * D[PIDX(9, 10)] +
+						F[9][11] * D[PIDX(7, 11)] +
+						F[7][11] * D[PIDX(9, 11)] +
+						F[9][12] * D[PIDX(7, 12)] +
+						F[7][12] * D[PIDX(9, 12)] +
+						F[7][6] * D[PIDX(6, 9)] +
+						F[7][8] * D[PIDX(8, 9)]) * T +
+	    D[PIDX(7, 9)];
+	P[PIDX(7, 10)] =
+	    (F[7][9] * D[PIDX(9, 10)] + F[7][10] * D[PIDX(10, 10)] +
+	     F[7][11] * D[PIDX(10, 11)] + F[7][12] * D[PIDX(10, 12)] +
+	     F[7][6] * D[PIDX(6, 10)] + F[7][8] * D[PIDX(8, 10)]) * T + D[PIDX(7, 10)];
+	P[PIDX(7, 11)] =
+	    (F[7][9] * D[PIDX(9, 11)] + F[7][10] * D[PIDX(10, 11)] +
+	     F[7][11] * D[PIDX(11, 11)] + F[7][12] * D[PIDX(11, 12)] +
+	     F[7][6] * D[PIDX(6, 11)] + F[7][8] * D[PIDX(8, 11)]) * T + D[PIDX(7, 11)];
+	P[PIDX(7, 12)] =
+	    (F[7][9] * D[PIDX(9, 12)] + F[7][10] * D[PIDX(10, 12)] +
+	     F[7][11] * D[PIDX(11, 12)] + F[7][12] * D[PIDX(12, 12)] +
+	     F[7][6] * D[PIDX(6, 12)] + F[7][8] * D[PIDX(8, 12)]) * T + D[PIDX(7, 12)];
+	P[PIDX(8, 8)] =
 	    (Q[0] * G[8][0] * G[8][0] + Q[1] * G[8][1] * G[8][1] +
-	     Q[2] * G[8][2] * G[8][2] + F[8][9] * (F[8][9] * D[9][9] +
-						   F[8][10] * D[9][10] +
-						   F[8][11] * D[9][11] +
-						   F[8][12] * D[9][12] +
-						   F[8][6] * D[6][9] +
-						   F[8][7] * D[7][9]) +
-	     F[8][10] * (F[8][9] * D[9][10] + F[8][10] * D[10][10] +
-			 F[8][11] * D[10][11] + F[8][12] * D[10][12] +
-			 F[8][6] * D[6][10] + F[8][7] * D[7][10]) +
-	     F[8][11] * (F[8][9] * D[9][11] + F[8][10] * D[10][11] +
-			 F[8][11] * D[11][11] + F[8][12] * D[11][12] +
-			 F[8][6] * D[6][11] + F[8][7] * D[7][11]) +
-	     F[8][12] * (F[8][9] * D[9][12] + F[8][10] * D[10][12] +
-			 F[8][11] * D[11][12] + F[8][12] * D[12][12] +
-			 F[8][6] * D[6][12] + F[8][7] * D[7][12]) +
-	     F[8][6] * (F[8][6] * D[6][6] + F[8][7] * D[6][7] +
-			F[8][9] * D[6][9] + F[8][10] * D[6][10] +
-			F[8][11] * D[6][11] + F[8][12] * D[6][12]) +
-	     F[8][7] * (F[8][6] * D[6][7] + F[8][7] * D[7][7] +
-			F[8][9] * D[7][9] + F[8][10] * D[7][10] +
-			F[8][11] * D[7][11] + F[8][12] * D[7][12])) * Tsq +
-	    (2 * F[8][6] * D[6][8] + 2 * F[8][7] * D[7][8] +
-	     2 * F[8][9] * D[8][9] + 2 * F[8][10] * D[8][10] +
-	     2 * F[8][11] * D[8][11] + 2 * F[8][12] * D[8][12]) * T +
-	    D[8][8];
-	P[8][9] = P[9][8] =
+	     Q[2] * G[8][2] * G[8][2] + F[8][9] * (F[8][9] * D[PIDX(9, 9)] +
+						   F[8][10] * D[PIDX(9, 10)] +
+						   F[8][11] * D[PIDX(9, 11)] +
+						   F[8][12] * D[PIDX(9, 12)] +
+						   F[8][6] * D[PIDX(6, 9)] +
+						   F[8][7] * D[PIDX(7, 9)]) +
+	     F[8][10] * (F[8][9] * D[PIDX(9, 10)] + F[8][10] * D[PIDX(10, 10)] +
+			 F[8][11] * D[PIDX(10, 11)] + F[8][12] * D[PIDX(10, 12)] +
+			 F[8][6] * D[PIDX(6, 10)] + F[8][7] * D[PIDX(7, 10)]) +
+	     F[8][11] * (F[8][9] * D[PIDX(9, 11)] + F[8][10] * D[PIDX(10, 11)] +
+			 F[8][11] * D[PIDX(11, 11)] + F[8][12] * D[PIDX(11, 12)] +
+			 F[8][6] * D[PIDX(6, 11)] + F[8][7] * D[PIDX(7, 11)]) +
+	     F[8][12] * (F[8][9] * D[PIDX(9, 12)] + F[8][10] * D[PIDX(10, 12)] +
+			 F[8][11] * D[PIDX(11, 12)] + F[8][12] * D[PIDX(12, 12)] +
+			 F[8][6] * D[PIDX(6, 12)] + F[8][7] * D[PIDX(7, 12)]) +
+	     F[8][6] * (F[8][6] * D[PIDX(6, 6)] + F[8][7] * D[PIDX(6, 7)] +
+			F[8][9] * D[PIDX(6, 9)] + F[8][10] * D[PIDX(6, 10)] +
+			F[8][11] * D[PIDX(6, 11)] + F[8][12] * D[PIDX(6, 12)]) +
+	     F[8][7] * (F[8][6] * D[PIDX(6, 7)] + F[8][7] * D[PIDX(7, 7)] +
+			F[8][9] * D[PIDX(7, 9)] + F[8][10] * D[PIDX(7, 10)] +
+			F[8][11] * D[PIDX(7, 11)] + F[8][12] * D[PIDX(7, 12)])) * Tsq +
+	    (2 * F[8][6] * D[PIDX(6, 8)] + 2 * F[8][7] * D[PIDX(7, 8)] +
+	     2 * F[8][9] * D[PIDX(8, 9)] + 2 * F[8][10] * D[PIDX(8, 10)] +
+	     2 * F[8][11] * D[PIDX(8, 11)] + 2 * F[8][12] * D[PIDX(8, 12)]) * T +
+	    D[PIDX(8, 8)];
+	P[PIDX(8, 9)] =
 	    (F[9][10] *
-	     (F[8][9] * D[9][10] + F[8][10] * D[10][10] +
-	      F[8][11] * D[10][11] + F[8][12] * D[10][12] +
-	      F[8][6] * D[6][10] + F[8][7] * D[7][10]) +
-	     F[9][11] * (F[8][9] * D[9][11] + F[8][10] * D[10][11] +
-			 F[8][11] * D[11][11] + F[8][12] * D[11][12] +
-			 F[8][6] * D[6][11] + F[8][7] * D[7][11]) +
-	     F[9][12] * (F[8][9] * D[9][12] + F[8][10] * D[10][12] +
-			 F[8][11] * D[11][12] + F[8][12] * D[12][12] +
-			 F[8][6] * D[6][12] + F[8][7] * D[7][12]) +
-	     F[9][6] * (F[8][6] * D[6][6] + F[8][7] * D[6][7] +
-			F[8][9] * D[6][9] + F[8][10] * D[6][10] +
-			F[8][11] * D[6][11] + F[8][12] * D[6][12]) +
-	     F[9][7] * (F[8][6] * D[6][7] + F[8][7] * D[7][7] +
-			F[8][9] * D[7][9] + F[8][10] * D[7][10] +
-			F[8][11] * D[7][11] + F[8][12] * D[7][12]) +
-	     F[9][8] * (F[8][6] * D[6][8] + F[8][7] * D[7][8] +
-			F[8][9] * D[8][9] + F[8][10] * D[8][10] +
-			F[8][11] * D[8][11] + F[8][12] * D[8][12]) +
+	     (F[8][9] * D[PIDX(9, 10)] + F[8][10] * D[PIDX(10, 10)] +
+	      F[8][11] * D[PIDX(10, 11)] + F[8][12] * D[PIDX(10, 12)] +
+	      F[8][6] * D[PIDX(6, 10)] + F[8][7] * D[PIDX(7, 10)]) +
+	     F[9][11] * (F[8][9] * D[PIDX(9, 11)] + F[8][10] * D[PIDX(10, 11)] +
+			 F[8][11] * D[PIDX(11, 11)] + F[8][12] * D[PIDX(11, 12)] +
+			 F[8][6] * D[PIDX(6, 11)] + F[8][7] * D[PIDX(7, 11)]) +
+	     F[9][12] * (F[8][9] * D[PIDX(9, 12)] + F[8][10] * D[PIDX(10, 12)] +
+			 F[8][11] * D[PIDX(11, 12)] + F[8][12] * D[PIDX(12, 12)] +
+			 F[8][6] * D[PIDX(6, 12)] + F[8][7] * D[PIDX(7, 12)]) +
+	     F[9][6] * (F[8][6] * D[PIDX(6, 6)] + F[8][7] * D[PIDX(6, 7)] +
+			F[8][9] * D[PIDX(6, 9)] + F[8][10] * D[PIDX(6, 10)] +
+			F[8][11] * D[PIDX(6, 11)] + F[8][12] * D[PIDX(6, 12)]) +
+	     F[9][7] * (F[8][6] * D[PIDX(6, 7)] + F[8][7] * D[PIDX(7, 7)] +
+			F[8][9] * D[PIDX(7, 9)] + F[8][10] * D[PIDX(7, 10)] +
+			F[8][11] * D[PIDX(7, 11)] + F[8][12] * D[PIDX(7, 12)]) +
+	     F[9][8] * (F[8][6] * D[PIDX(6, 8)] + F[8][7] * D[PIDX(7, 8)] +
+			F[8][9] * D[PIDX(8, 9)] + F[8][10] * D[PIDX(8, 10)] +
+			F[8][11] * D[PIDX(8, 11)] + F[8][12] * D[PIDX(8, 12)]) +
 	     G[9][0] * G[8][0] * Q[0] + G[9][1] * G[8][1] * Q[1] +
-	     G[9][2] * G[8][2] * Q[2]) * Tsq + (F[9][6] * D[6][8] +
-						F[9][7] * D[7][8] +
-						F[9][8] * D[8][8] +
-						F[8][9] * D[9][9] +
-						F[9][10] * D[8][10] +
-						F[8][10] * D[9][10] +
-						F[9][11] * D[8][11] +
-						F[8][11] * D[9][11] +
-						F[9][12] * D[8][12] +
-						F[8][12] * D[9][12] +
-						F[8][6] * D[6][9] +
-						F[8][7] * D[7][9]) * T +
-	    D[8][9];
-	P[8][10] = P[10][8] =
-	    (F[8][9] * D[9][10] + F[8][10] * D[10][10] +
-	     F[8][11] * D[10][11] + F[8][12] * D[10][12] +
-	     F[8][6] * D[6][10] + F[8][7] * D[7][10]) * T + D[8][10];
-	P[8][11] = P[11][8] =
-	    (F[8][9] * D[9][11] + F[8][10] * D[10][11] +
-	     F[8][11] * D[11][11] + F[8][12] * D[11][12] +
-	     F[8][6] * D[6][11] + F[8][7] * D[7][11]) * T + D[8][11];
-	P[8][12] = P[12][8] =
-	    (F[8][9] * D[9][12] + F[8][10] * D[10][12] +
-	     F[8][11] * D[11][12] + F[8][12] * D[12][12] +
-	     F[8][6] * D[6][12] + F[8][7] * D[7][12]) * T + D[8][12];
-	P[9][9] =
+	     G[9][2] * G[8][2] * Q[2]) * Tsq + (F[9][6] * D[PIDX(6, 8)] +
+						F[9][7] * D[PIDX(7, 8)] +
+						F[9][8] * D[PIDX(8, 8)] +
+						F[8][9] * D[PIDX(9, 9)] +
+						F[9][10] * D[PIDX(8, 10)] +
+						F[8][10] * D[PIDX(9, 10)] +
+						F[9][11] * D[PIDX(8, 11)] +
+						F[8][11] * D[PIDX(9, 11)] +
+						F[9][12] * D[PIDX(8, 12)] +
+						F[8][12] * D[PIDX(9, 12)] +
+						F[8][6] * D[PIDX(6, 9)] +
+						F[8][7] * D[PIDX(7, 9)]) * T +
+	    D[PIDX(8, 9)];
+	P[PIDX(8, 10)] =
+	    (F[8][9] * D[PIDX(9, 10)] + F[8][10] * D[PIDX(10, 10)] +
+	     F[8][11] * D[PIDX(10, 11)] + F[8][12] * D[PIDX(10, 12)] +
+	     F[8][6] * D[PIDX(6, 10)] + F[8][7] * D[PIDX(7, 10)]) * T + D[PIDX(8, 10)];
+	P[PIDX(8, 11)] =
+	    (F[8][9] * D[PIDX(9, 11)] + F[8][10] * D[PIDX(10, 11)] +
+	     F[8][11] * D[PIDX(11, 11)] + F[8][12] * D[PIDX(11, 12)] +
+	     F[8][6] * D[PIDX(6, 11)] + F[8][7] * D[PIDX(7, 11)]) * T + D[PIDX(8, 11)];
+	P[PIDX(8, 12)] =
+	    (F[8][9] * D[PIDX(9, 12)] + F[8][10] * D[PIDX(10, 12)] +
+	     F[8][11] * D[PIDX(11, 12)] + F[8][12] * D[PIDX(12, 12)] +
+	     F[8][6] * D[PIDX(6, 12)] + F[8][7] * D[PIDX(7, 12)]) * T + D[PIDX(8, 12)];
+	P[PIDX(9, 9)] =
 	    (Q[0] * G[9][0] * G[9][0] + Q[1] * G[9][1] * G[9][1] +
-	     Q[2] * G[9][2] * G[9][2] + F[9][10] * (F[9][10] * D[10][10] +
-						    F[9][11] * D[10][11] +
-						    F[9][12] * D[10][12] +
-						    F[9][6] * D[6][10] +
-						    F[9][7] * D[7][10] +
-						    F[9][8] * D[8][10]) +
-	     F[9][11] * (F[9][10] * D[10][11] + F[9][11] * D[11][11] +
-			 F[9][12] * D[11][12] + F[9][6] * D[6][11] +
-			 F[9][7] * D[7][11] + F[9][8] * D[8][11]) +
-	     F[9][12] * (F[9][10] * D[10][12] + F[9][11] * D[11][12] +
-			 F[9][12] * D[12][12] + F[9][6] * D[6][12] +
-			 F[9][7] * D[7][12] + F[9][8] * D[8][12]) +
-	     F[9][6] * (F[9][6] * D[6][6] + F[9][7] * D[6][7] +
-			F[9][8] * D[6][8] + F[9][10] * D[6][10] +
-			F[9][11] * D[6][11] + F[9][12] * D[6][12]) +
-	     F[9][7] * (F[9][6] * D[6][7] + F[9][7] * D[7][7] +
-			F[9][8] * D[7][8] + F[9][10] * D[7][10] +
-			F[9][11] * D[7][11] + F[9][12] * D[7][12]) +
-	     F[9][8] * (F[9][6] * D[6][8] + F[9][7] * D[7][8] +
-			F[9][8] * D[8][8] + F[9][10] * D[8][10] +
-			F[9][11] * D[8][11] + F[9][12] * D[8][12])) * Tsq +
-	    (2 * F[9][10] * D[9][10] + 2 * F[9][11] * D[9][11] +
-	     2 * F[9][12] * D[9][12] + 2 * F[9][6] * D[6][9] +
-	     2 * F[9][7] * D[7][9] + 2 * F[9][8] * D[8][9]) * T + D[9][9];
-	P[9][10] = P[10][9] =
-	    (F[9][10] * D[10][10] + F[9][11] * D[10][11] +
-	     F[9][12] * D[10][12] + F[9][6] * D[6][10] +
-	     F[9][7] * D[7][10] + F[9][8] * D[8][10]) * T + D[9][10];
-	P[9][11] = P[11][9] =
-	    (F[9][10] * D[10][11] + F[9][11] * D[11][11] +
-	     F[9][12] * D[11][12] + F[9][6] * D[6][11] +
-	     F[9][7] * D[7][11] + F[9][8] * D[8][11]) * T + D[9][11];
-	P[9][12] = P[12][9] =
-	    (F[9][10] * D[10][12] + F[9][11] * D[11][12] +
-	     F[9][12] * D[12][12] + F[9][6] * D[6][12] +
-	     F[9][7] * D[7][12] + F[9][8] * D[8][12]) * T + D[9][12];
-	P[10][10] = Q[6] * Tsq + D[10][10];
-	P[10][11] = P[11][10] = D[10][11];
-	P[10][12] = P[12][10] = D[10][12];
-	P[11][11] = Q[7] * Tsq + D[11][11];
-	P[11][12] = P[12][11] = D[11][12];
-	P[12][12] = Q[8] * Tsq + D[12][12];
+	     Q[2] * G[9][2] * G[9][2] + F[9][10] * (F[9][10] * D[PIDX(10, 10)] +
+						    F[9][11] * D[PIDX(10, 11)] +
+						    F[9][12] * D[PIDX(10, 12)] +
+						    F[9][6] * D[PIDX(6, 10)] +
+						    F[9][7] * D[PIDX(7, 10)] +
+						    F[9][8] * D[PIDX(8, 10)]) +
+	     F[9][11] * (F[9][10] * D[PIDX(10, 11)] + F[9][11] * D[PIDX(11, 11)] +
+			 F[9][12] * D[PIDX(11, 12)] + F[9][6] * D[PIDX(6, 11)] +
+			 F[9][7] * D[PIDX(7, 11)] + F[9][8] * D[PIDX(8, 11)]) +
+	     F[9][12] * (F[9][10] * D[PIDX(10, 12)] + F[9][11] * D[PIDX(11, 12)] +
+			 F[9][12] * D[PIDX(12, 12)] + F[9][6] * D[PIDX(6, 12)] +
+			 F[9][7] * D[PIDX(7, 12)] + F[9][8] * D[PIDX(8, 12)]) +
+	     F[9][6] * (F[9][6] * D[PIDX(6, 6)] + F[9][7] * D[PIDX(6, 7)] +
+			F[9][8] * D[PIDX(6, 8)] + F[9][10] * D[PIDX(6, 10)] +
+			F[9][11] * D[PIDX(6, 11)] + F[9][12] * D[PIDX(6, 12)]) +
+	     F[9][7] * (F[9][6] * D[PIDX(6, 7)] + F[9][7] * D[PIDX(7, 7)] +
+			F[9][8] * D[PIDX(7, 8)] + F[9][10] * D[PIDX(7, 10)] +
+			F[9][11] * D[PIDX(7, 11)] + F[9][12] * D[PIDX(7, 12)]) +
+	     F[9][8] * (F[9][6] * D[PIDX(6, 8)] + F[9][7] * D[PIDX(7, 8)] +
+			F[9][8] * D[PIDX(8, 8)] + F[9][10] * D[PIDX(8, 10)] +
+			F[9][11] * D[PIDX(8, 11)] + F[9][12] * D[PIDX(8, 12)])) * Tsq +
+	    (2 * F[9][10] * D[PIDX(9, 10)] + 2 * F[9][11] * D[PIDX(9, 11)] +
+	     2 * F[9][12] * D[PIDX(9, 12)] + 2 * F[9][6] * D[PIDX(6, 9)] +
+	     2 * F[9][7] * D[PIDX(7, 9)] + 2 * F[9][8] * D[PIDX(8, 9)]) * T + D[PIDX(9, 9)];
+	P[PIDX(9, 10)] =
+	    (F[9][10] * D[PIDX(10, 10)] + F[9][11] * D[PIDX(10, 11)] +
+	     F[9][12] * D[PIDX(10, 12)] + F[9][6] * D[PIDX(6, 10)] +
+	     F[9][7] * D[PIDX(7, 10)] + F[9][8] * D[PIDX(8, 10)]) * T + D[PIDX(9, 10)];
+	P[PIDX(9, 11)] =
+	    (F[9][10] * D[PIDX(10, 11)] + F[9][11] * D[PIDX(11, 11)] +
+	     F[9][12] * D[PIDX(11, 12)] + F[9][6] * D[PIDX(6, 11)] +
+	     F[9][7] * D[PIDX(7, 11)] + F[9][8] * D[PIDX(8, 11)]) * T + D[PIDX(9, 11)];
+	P[PIDX(9, 12)] =
+	    (F[9][10] * D[PIDX(10, 12)] + F[9][11] * D[PIDX(11, 12)] +
+	     F[9][12] * D[PIDX(12, 12)] + F[9][6] * D[PIDX(6, 12)] +
+	     F[9][7] * D[PIDX(7, 12)] + F[9][8] * D[PIDX(8, 12)]) * T + D[PIDX(9, 12)];
+	P[PIDX(10, 10)] = Q[6] * Tsq + D[PIDX(10, 10)];
+	P[PIDX(10, 11)] = D[PIDX(10, 11)];
+	P[PIDX(10, 12)] = D[PIDX(10, 12)];
+	P[PIDX(11, 11)] = Q[7] * Tsq + D[PIDX(11, 11)];
+	P[PIDX(11, 12)] = D[PIDX(11, 12)];
+	P[PIDX(12, 12)] = Q[8] * Tsq + D[PIDX(12, 12)];
 }
 #endif
 
@@ -1331,10 +1399,11 @@ static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 //            - or see Simon, "Optimal State Estimation," 1st Ed, p.150
 //  The SensorsUsed variable is a bitwise mask indicating which sensors
 //     should be used in the update.
+//  Only the columns of H that LinearizeH can fill in are used, see HCols
 //  ************************************************
 
 static void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
-		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
+		  float Y[NUMV], float P[NUMP], float X[NUMX],
 		  uint16_t SensorsUsed)
 {
 	float HP[NUMX], HPHR, Error;
@@ -1344,22 +1413,27 @@ static void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 
 		if (SensorsUsed & (0x01 << m)) {	// use this sensor for update
 
-			for (j = 0; j < NUMX; j++) {	// Find Hp = H*P
+			for (j = 0; j < NUMX; j++)
 				HP[j] = 0;
-				for (k = 0; k < NUMX; k++)
-					HP[j] += H[m][k] * P[k][j];
+			for (k = HCols[m][0]; k < HCols[m][1]; k++) {	// Find Hp = H*P
+				const float Hmk = H[m][k];
+				for (j = 0; j < k; j++)	// lower triangle of row k is column k
+					HP[j] += Hmk * P[PROW(j) + k];
+				for (j = k; j < NUMX; j++)
+					HP[j] += Hmk * P[PROW(k) + j];
 			}
 			HPHR = R[m];	// Find  HPHR = H*P*H' + R
-			for (k = 0; k < NUMX; k++)
+			for (k = HCols[m][0]; k < HCols[m][1]; k++)
 				HPHR += HP[k] * H[m][k];
 
 			for (k = 0; k < NUMX; k++)
 				K[k][m] = HP[k] / HPHR;	// find K = HP/HPHR
 
 			for (i = 0; i < NUMX; i++) {	// Find P(m)= P(m-1) + K*HP
+				float *Pi = &P[PROW(i)];
+				const float Kim = K[i][m];
 				for (j = i; j < NUMX; j++)
-					P[i][j] = P[j][i] =
-					    P[i][j] - K[i][m] * HP[j];
+					Pi[j] -= Kim * HP[j];
 			}
 
 			Error = Z[m] - Y[m];
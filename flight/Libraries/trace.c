@@ -0,0 +1,183 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       trace.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Timestamped probes along the sensor to actuator path
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "openpilot.h"
+#include "trace.h"
+
+#if defined(TRACE_DIAGNOSTICS)
+
+#include "tracestats.h"
+
+/*
+ * Every probe keeps running statistics that only its own task writes, so
+ * hitting a probe never takes a lock. The latency of a probe is measured
+ * from the gyro sample at the start of its chain, which is handed down from
+ * the probe upstream of it when it is hit.
+ *
+ * The most recent probe hits are also kept in a ring for the timeline. A
+ * slot is claimed with an atomic increment and tagged with its index once
+ * written, so the reader can tell a slot that is being overwritten.
+ */
+
+// Private constants
+#define TRACE_RING_SIZE 64	/* Power of two */
+#define TRACE_TAG(index, probe) (((index) << 8) | (probe))
+
+// Private types
+struct trace_probe_stats {
+	uint32_t last_time;	/* Raw time of the last hit */
+	uint32_t origin;	/* Raw time of the gyro sample that led to it */
+	uint32_t count;		/* Hits, wraps around */
+	uint32_t latency_sum;	/* Sum of the latencies in us, wraps around */
+	uint16_t period_min;
+	uint16_t period_max;
+	uint16_t latency_max;
+	volatile bool reset;	/* Set by the reader to restart the extremes */
+};
+
+struct trace_event {
+	volatile uint32_t time;
+	volatile uint32_t tag;
+};
+
+// Private variables
+static const uint8_t upstream[TRACE_NUM_PROBES] = {
+	[TRACE_GYRO] = TRACE_GYRO,
+	[TRACE_ATTITUDE] = TRACE_GYRO,
+	[TRACE_STABILIZATION_START] = TRACE_GYRO,
+	[TRACE_STABILIZATION_DONE] = TRACE_STABILIZATION_START,
+	[TRACE_ACTUATOR] = TRACE_STABILIZATION_DONE,
+};
+
+static struct trace_probe_stats probes[TRACE_NUM_PROBES];
+static struct trace_event ring[TRACE_RING_SIZE];
+static uint32_t ring_head;
+
+// What was reported the last time, to turn the running sums into rates
+static uint32_t reported_count[TRACE_NUM_PROBES];
+static uint32_t reported_latency_sum[TRACE_NUM_PROBES];
+static uint32_t last_update_time;
+
+static uint16_t clamp_us(uint32_t us)
+{
+	return (us > UINT16_MAX) ? UINT16_MAX : us;
+}
+
+/**
+ * Record a hit of a probe point
+ */
+void TraceProbe(enum trace_probe probe)
+{
+	uint32_t now = PIOS_DELAY_GetRaw();
+	struct trace_probe_stats *stats = &probes[probe];
+
+	uint32_t origin = (upstream[probe] == probe) ? now : probes[upstream[probe]].origin;
+	uint16_t latency = clamp_us(PIOS_DELAY_DiffuS(origin));
+	uint16_t period = clamp_us(PIOS_DELAY_DiffuS(stats->last_time));
+
+	// The first hit has no period yet, the second one starts the extremes
+	if (stats->count > 0) {
+		if (stats->reset || stats->count == 1) {
+			stats->period_min = stats->period_max = period;
+			stats->latency_max = latency;
+			stats->reset = false;
+		} else {
+			if (period < stats->period_min)
+				stats->period_min = period;
+			if (period > stats->period_max)
+				stats->period_max = period;
+			if (latency > stats->latency_max)
+				stats->latency_max = latency;
+		}
+	}
+
+	stats->origin = origin;
+	stats->last_time = now;
+	stats->latency_sum += latency;
+	stats->count++;
+
+	uint32_t index = __sync_fetch_and_add(&ring_head, 1);
+	struct trace_event *event = &ring[index % TRACE_RING_SIZE];
+	event->tag = TRACE_TAG(index - TRACE_RING_SIZE, TRACE_NUM_PROBES);
+	event->time = now;
+	event->tag = TRACE_TAG(index, probe);
+}
+
+/**
+ * Update TraceStats with the statistics since the last update and the
+ * most recent probe hits
+ */
+void TraceUpdateStats(void)
+{
+	TraceStatsData data;
+
+	uint32_t window_us = PIOS_DELAY_DiffuS(last_update_time);
+	last_update_time = PIOS_DELAY_GetRaw();
+	if (window_us == 0)
+		window_us = 1;
+
+	for (int i = 0; i < TRACE_NUM_PROBES; i++) {
+		struct trace_probe_stats *stats = &probes[i];
+
+		uint32_t count = stats->count;
+		uint32_t latency_sum = stats->latency_sum;
+		uint32_t hits = count - reported_count[i];
+
+		data.Rate[i] = hits * 1.0e6f / window_us;
+		data.Latency[i] = hits ? (float) (latency_sum - reported_latency_sum[i]) / hits : 0;
+		data.Jitter[i] = (hits > 1 && !stats->reset) ? stats->period_max - stats->period_min : 0;
+		data.MaxLatency[i] = (hits && !stats->reset) ? stats->latency_max : 0;
+		stats->reset = true;
+
+		reported_count[i] = count;
+		reported_latency_sum[i] = latency_sum;
+	}
+
+	// Newest events first
+	uint32_t head = ring_head;
+	for (int i = 0; i < TRACESTATS_EVENTPROBE_NUMELEM; i++) {
+		uint32_t index = head - 1 - i;
+		struct trace_event *event = &ring[index % TRACE_RING_SIZE];
+
+		uint32_t tag = event->tag;
+		uint32_t time = event->time;
+		if ((uint32_t) i < head && tag == event->tag && (tag >> 8) == (index & 0x00ffffff)) {
+			data.EventProbe[i] = tag & 0xff;
+			data.EventAge[i] = PIOS_DELAY_DiffuS(time);
+		} else {
+			data.EventProbe[i] = TRACESTATS_EVENTPROBE_NONE;
+			data.EventAge[i] = 0;
+		}
+	}
+
+	TraceStatsSet(&data);
+}
+
+#endif /* TRACE_DIAGNOSTICS */
+
+/**
+ * @}
+ */
@@ -48,6 +48,7 @@
 #include "manualcontrolcommand.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "trace.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE 2
@@ -379,6 +380,7 @@ static void actuatorTask(void* parameters)
 		{
 			success &= set_channel(n, command.Channel[n], &actuatorSettings);
 		}
+		TRACE_PROBE(TRACE_ACTUATOR);
 
 		if(!success) {
 			command.NumFailedUpdates++;
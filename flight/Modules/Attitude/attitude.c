@@ -62,6 +62,7 @@
 #include "gyrosbias.h"
 #include "homelocation.h"
 #include "sensorsettings.h"
+#include "insschedule.h"
 #include "inssettings.h"
 #include "insstate.h"
 #include "magnetometer.h"
@@ -73,8 +74,9 @@
 #include "velocityactual.h"
 #include "coordinate_conversions.h"
 #include "WorldMagModel.h"
+#include "trace.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
+#include "pios_semaphore.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 2200
@@ -130,15 +132,40 @@ struct cfvert {
 	float baro_zero;
 };
 
+//! The stages of the INSGPS that are scheduled and timed separately
+enum ins_stage {
+	INS_STAGE_STATE_PREDICTION,
+	INS_STAGE_COVARIANCE_PREDICTION,
+	INS_STAGE_CORRECTION,
+	INS_STAGE_NUM
+};
+
+//! Tracks when the INSGPS stages run and how long they take
+struct ins_schedule {
+	//! Time the state was predicted over since the last covariance prediction
+	float      covariance_dT;
+	//! Number of state predictions since the last covariance prediction
+	uint8_t    predictions;
+
+	//! Start of the window the rates and times are measured over
+	uint32_t   window_start;
+	//! How often each stage ran in this window
+	uint16_t   runs[INS_STAGE_NUM];
+	//! Total time spent in each stage in this window
+	uint32_t   total_us[INS_STAGE_NUM];
+	//! Longest run of each stage in this window
+	uint16_t   max_us[INS_STAGE_NUM];
+};
+
 // Private variables
 static struct pios_thread *attitudeTaskHandle;
 
-static struct pios_queue *gyroQueue;
-static struct pios_queue *accelQueue;
-static struct pios_queue *magQueue;
-static struct pios_queue *baroQueue;
-static struct pios_queue *gpsQueue;
-static struct pios_queue *gpsVelQueue;
+static UAVObjSignal gyroSignal;
+static UAVObjSignal accelSignal;
+static UAVObjSignal magSignal;
+static UAVObjSignal baroSignal;
+static UAVObjSignal gpsSignal;
+static UAVObjSignal gpsVelSignal;
 
 static AttitudeSettingsData attitudeSettings;
 static HomeLocationData homeLocation;
@@ -150,6 +177,7 @@ static const float zeros[3] = {0.0f, 0.0f, 0.0f};
 
 static struct complementary_filter_state complementary_filter_state;
 static struct cfvert cfvert; //!< State information for vertical filter
+static struct ins_schedule ins_schedule;
 
 // Private functions
 static void AttitudeTask(void *parameters);
@@ -179,6 +207,12 @@ static int32_t setNavigationINSGPS();
 static void updateNedAccel();
 static void settingsUpdatedCb(UAVObjEvent * objEv);
 
+//! Account for one run of an INSGPS stage
+static void ins_schedule_record(enum ins_stage stage, uint32_t start_time);
+
+//! Publish the INSGPS schedule once a second
+static void ins_schedule_publish(uint8_t decimation);
+
 //! A low pass filter on the accels which helps with vibration resistance
 static void apply_accel_filter(const float * raw, float * filtered);
 static int32_t getNED(GPSPositionData * gpsPosition, float * NED);
@@ -217,6 +251,7 @@ int32_t AttitudeInitialize(void)
 	AttitudeSettingsInitialize();
 	SensorSettingsInitialize();
 	INSSettingsInitialize();
+	INSScheduleInitialize();
 	INSStateInitialize();
 	NedAccelInitialize();
 	NEDPositionInitialize();
@@ -242,13 +277,13 @@ int32_t AttitudeInitialize(void)
  */
 int32_t AttitudeStart(void)
 {
-	// Create the queues for the sensors
-	gyroQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
-	accelQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
-	magQueue = PIOS_Queue_Create(2, sizeof(UAVObjEvent));
-	baroQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
-	gpsQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
-	gpsVelQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
+	// Only the latest value of the sensors is used, so signals are enough
+	gyroSignal.sema = PIOS_Semaphore_Create();
+	accelSignal.sema = PIOS_Semaphore_Create();
+	magSignal.sema = PIOS_Semaphore_Create();
+	baroSignal.sema = PIOS_Semaphore_Create();
+	gpsSignal.sema = PIOS_Semaphore_Create();
+	gpsVelSignal.sema = PIOS_Semaphore_Create();
 
 	// Initialize quaternion
 	AttitudeActualData attitude;
@@ -267,16 +302,16 @@ int32_t AttitudeStart(void)
 	gyrosBias.z = 0;
 	GyrosBiasSet(&gyrosBias);
 
-	GyrosConnectQueue(gyroQueue);
-	AccelsConnectQueue(accelQueue);
+	GyrosConnectSignal(&gyroSignal);
+	AccelsConnectSignal(&accelSignal);
 	if (MagnetometerHandle())
-		MagnetometerConnectQueue(magQueue);
+		MagnetometerConnectSignal(&magSignal);
 	if (BaroAltitudeHandle())
-		BaroAltitudeConnectQueue(baroQueue);
+		BaroAltitudeConnectSignal(&baroSignal);
 	if (GPSPositionHandle())
-		GPSPositionConnectQueue(gpsQueue);
+		GPSPositionConnectSignal(&gpsSignal);
 	if (GPSVelocityHandle())
-		GPSVelocityConnectQueue(gpsVelQueue);
+		GPSVelocityConnectSignal(&gpsVelSignal);
 
 	// Start main task
 	attitudeTaskHandle = PIOS_Thread_Create(AttitudeTask, "Attitude", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
@@ -365,6 +400,7 @@ static void AttitudeTask(void *parameters)
 			setAttitudeINSGPS();
 			break;
 		}
+		TRACE_PROBE(TRACE_ATTITUDE);
 
 		// Use the selected source for position and velocity
 		switch (stateEstimation.NavigationFilter) {
@@ -401,7 +437,6 @@ static float cf_q[4];
  */
 static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool raw_gps)
 {
-	UAVObjEvent ev;
 	GyrosData gyrosData;
 	AccelsData accelsData;
 	static int32_t timeval;
@@ -410,8 +445,8 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 	// If this is the primary estimation filter, wait until the accel and
 	// gyro objects are updated. If it timeouts then go to failsafe.
 	if (!secondary) {
-		bool gyroTimeout  = PIOS_Queue_Receive(gyroQueue, &ev, FAILSAFE_TIMEOUT_MS) != true;
-		bool accelTimeout = PIOS_Queue_Receive(accelQueue, &ev, 1) != true;
+		bool gyroTimeout  = PIOS_Semaphore_Take(gyroSignal.sema, FAILSAFE_TIMEOUT_MS) != true;
+		bool accelTimeout = PIOS_Semaphore_Take(accelSignal.sema, 1) != true;
 
 		// When one of these is updated so should the other.
 		if (gyroTimeout || accelTimeout) {
@@ -440,7 +475,7 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 
 		// Wait for a mag reading if a magnetometer was registered
 		if (PIOS_SENSORS_GetQueue(PIOS_SENSOR_MAG) != NULL) {
-			if (!secondary && PIOS_Queue_Receive(magQueue, &ev, 20) != true) {
+			if (!secondary && PIOS_Semaphore_Take(magSignal.sema, 20) != true) {
 				return -1;
 			}
 			MagnetometerGet(&magData);
@@ -545,6 +580,10 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 	GyrosGet(&gyrosData);
 	accumulate_gyro(&gyrosData);
 
+	// Gyro samples replaced before they were read count as event system errors
+	if (!secondary)
+		UAVObjSignalSkipped(&gyroSignal);
+
 	// Compute the dT using the cpu clock
 	dT = PIOS_DELAY_DiffuS(timeval) / 1000000.0f;
 	timeval = PIOS_DELAY_GetRaw();
@@ -590,7 +629,7 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 	}
 
 	float mag_err[3];
-	if (secondary || PIOS_Queue_Receive(magQueue, &ev, 0) == true)
+	if (secondary || PIOS_Semaphore_Take(magSignal.sema, 0) == true)
 	{
 		MagnetometerData mag;
 		MagnetometerGet(&mag);
@@ -693,7 +732,7 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 		// When this is the only filter compute th vertical state from baro data
 		// Reset the filter for barometric data
 		cfvert_predict_pos(&cfvert, z_accel, dT);
-		if (PIOS_Queue_Receive(baroQueue, &ev, 0) == true) {
+		if (PIOS_Semaphore_Take(baroSignal.sema, 0) == true) {
 			float baro;
 			BaroAltitudeAltitudeGet(&baro);
 			cfvert_update_baro(&cfvert, baro, dT);
@@ -779,12 +818,11 @@ static void cfvert_update_baro(struct cfvert *cf, float baro, float dt)
 //! Set the navigation information to the raw estimates
 static int32_t setNavigationRaw()
 {
-	UAVObjEvent ev;
 
 	if (homeLocation.Set == HOMELOCATION_SET_FALSE) {
 		set_state_estimation_error(SYSTEMALARMS_STATEESTIMATION_NOHOME);
-		PIOS_Queue_Receive(gpsQueue, &ev, 0);
-	} else if (PIOS_Queue_Receive(gpsQueue, &ev, 0) == true) {
+		PIOS_Semaphore_Take(gpsSignal.sema, 0);
+	} else if (PIOS_Semaphore_Take(gpsSignal.sema, 0) == true) {
 		float NED[3];
 		// Transform the GPS position into NED coordinates
 		GPSPositionData gpsPosition;
@@ -816,7 +854,7 @@ static int32_t setNavigationRaw()
 		PositionActualDownSet(&cfvert.position_z);
 	}
 
-	if (PIOS_Queue_Receive(gpsVelQueue, &ev, 0) == true) {
+	if (PIOS_Semaphore_Take(gpsVelSignal.sema, 0) == true) {
 		// Transform the GPS position into NED coordinates
 		GPSVelocityData gpsVelocity;
 		GPSVelocityGet(&gpsVelocity);
@@ -837,11 +875,10 @@ static int32_t setNavigationRaw()
 //! Set the navigation information to the raw estimates
 static int32_t setNavigationNone()
 {
-	UAVObjEvent ev;
 
 	// Throw away data to prevent queue overflows
-	PIOS_Queue_Receive(gpsQueue, &ev, 0);
-	PIOS_Queue_Receive(gpsVelQueue, &ev, 0);
+	PIOS_Semaphore_Take(gpsSignal.sema, 0);
+	PIOS_Semaphore_Take(gpsVelSignal.sema, 0);
 
 	PositionActualDownSet(&cfvert.position_z);
 	VelocityActualDownSet(&cfvert.velocity_z);
@@ -936,7 +973,6 @@ static bool home_location_updated;
  */
 static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 {
-	UAVObjEvent ev;
 	GyrosData gyrosData;
 	AccelsData accelsData;
 	MagnetometerData magData;
@@ -979,17 +1015,20 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 
 		ins_last_time = PIOS_DELAY_GetRaw();
 
+		memset(&ins_schedule, 0, sizeof(ins_schedule));
+		ins_schedule.window_start = ins_last_time;
+
 		return 0;
 	}
 
-	mag_updated = mag_updated || PIOS_Queue_Receive(magQueue, &ev, 0);
-	baro_updated = baro_updated || PIOS_Queue_Receive(baroQueue, &ev, 0);
-	gps_updated = gps_updated || (PIOS_Queue_Receive(gpsQueue, &ev, 0) && outdoor_mode);
-	gps_vel_updated = gps_vel_updated || (PIOS_Queue_Receive(gpsVelQueue, &ev, 0) && outdoor_mode);
+	mag_updated = mag_updated || PIOS_Semaphore_Take(magSignal.sema, 0);
+	baro_updated = baro_updated || PIOS_Semaphore_Take(baroSignal.sema, 0);
+	gps_updated = gps_updated || (PIOS_Semaphore_Take(gpsSignal.sema, 0) && outdoor_mode);
+	gps_vel_updated = gps_vel_updated || (PIOS_Semaphore_Take(gpsVelSignal.sema, 0) && outdoor_mode);
 
 	// Wait until the gyro and accel object is updated, if a timeout then go to failsafe
-	if (PIOS_Queue_Receive(gyroQueue, &ev, FAILSAFE_TIMEOUT_MS) != true ||
-		PIOS_Queue_Receive(accelQueue, &ev, 1) != true)
+	if (PIOS_Semaphore_Take(gyroSignal.sema, FAILSAFE_TIMEOUT_MS) != true ||
+		PIOS_Semaphore_Take(accelSignal.sema, 1) != true)
 	{
 		return -1;
 	}
@@ -998,6 +1037,7 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	GyrosGet(&gyrosData);
 	AccelsGet(&accelsData);
 	GyrosBiasGet(&gyrosBias);
+	UAVObjSignalSkipped(&gyroSignal);
 
 	// Need to get these values before initializing
 	if (mag_updated)
@@ -1110,6 +1150,9 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 
 		ins_last_time = PIOS_DELAY_GetRaw();	
 
+		ins_schedule.covariance_dT = 0;
+		ins_schedule.predictions = 0;
+
 		return 0;
 	}
 
@@ -1125,8 +1168,8 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	// This should only happen at start up or at mode switches
 	if(dT > 0.01f)
 		dT = 0.01f;
-	else if(dT <= 0.001f)
-		dT = 0.001f;
+	else if(dT <= 0.0005f)
+		dT = 0.0005f;
 
 	// If the gyro bias setting was updated we should reset
 	// the state estimate of the EKF
@@ -1148,11 +1191,31 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		INSSetGyroBias(zeros);
 	}
 
-	// Advance the state estimate
+	// Advance the state estimate at the full sensor rate
+	uint32_t stage_start = PIOS_DELAY_GetRaw();
 	INSStatePrediction(gyros, &accelsData.x, dT);
+	ins_schedule_record(INS_STAGE_STATE_PREDICTION, stage_start);
+
+	// The covariance only has to be current when corrections are applied, so
+	// it is advanced over several state predictions at once. Measurements that
+	// arrive in between stay flagged and are applied together afterwards.
+	uint8_t decimation = insSettings.CovarianceDecimation > 0 ? insSettings.CovarianceDecimation : 1;
+	ins_schedule.covariance_dT += dT;
+	if (++ins_schedule.predictions < decimation) {
+		float q[4];
+		INSGetState(NULL, NULL, q, NULL);
+		calc_ned_accel(q, &accelsData.x);
+
+		ins_schedule_publish(decimation);
+		return 0;
+	}
 
 	// Advance the covariance estimate
-	INSCovariancePrediction(dT);
+	stage_start = PIOS_DELAY_GetRaw();
+	INSCovariancePrediction(ins_schedule.covariance_dT);
+	ins_schedule_record(INS_STAGE_COVARIANCE_PREDICTION, stage_start);
+	ins_schedule.covariance_dT = 0;
+	ins_schedule.predictions = 0;
 
 	if(mag_updated) {
 		sensors |= MAG_SENSORS;
@@ -1210,8 +1273,11 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	 * TODO: Need to add a general sanity check for all the inputs to make sure their kosher
 	 * although probably should occur within INS itself
 	 */
-	if (sensors)
+	if (sensors) {
+		stage_start = PIOS_DELAY_GetRaw();
 		INSCorrection(&magData.x, NED, vel, ( baroData.Altitude + baro_offset ), sensors);
+		ins_schedule_record(INS_STAGE_CORRECTION, stage_start);
+	}
 
 	// Export the state and variance for monitoring the EKF
 	INSStateData state;
@@ -1221,9 +1287,44 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 
 	calc_ned_accel(&state.State[6], &accelsData.x);
 
+	ins_schedule_publish(decimation);
+
 	return 0;
 }
 
+static void ins_schedule_record(enum ins_stage stage, uint32_t start_time)
+{
+	uint32_t us = PIOS_DELAY_DiffuS(start_time);
+
+	ins_schedule.runs[stage]++;
+	ins_schedule.total_us[stage] += us;
+	if (us > ins_schedule.max_us[stage])
+		ins_schedule.max_us[stage] = (us > UINT16_MAX) ? UINT16_MAX : us;
+}
+
+static void ins_schedule_publish(uint8_t decimation)
+{
+	uint32_t window_us = PIOS_DELAY_DiffuS(ins_schedule.window_start);
+	if (window_us < 1000000)
+		return;
+
+	INSScheduleData schedule;
+	schedule.CovarianceDecimation = decimation;
+	for (int i = 0; i < INS_STAGE_NUM; i++) {
+		uint16_t runs = ins_schedule.runs[i];
+		schedule.Rate[i] = runs * 1.0e6f / window_us;
+		schedule.Time[i] = runs ? (float) ins_schedule.total_us[i] / runs : 0;
+		schedule.MaxTime[i] = ins_schedule.max_us[i];
+
+		ins_schedule.runs[i] = 0;
+		ins_schedule.total_us[i] = 0;
+		ins_schedule.max_us[i] = 0;
+	}
+	INSScheduleSet(&schedule);
+
+	ins_schedule.window_start = PIOS_DELAY_GetRaw();
+}
+
 //! Set the attitude to the current INSGPS estimate
 static int32_t setAttitudeINSGPS()
 {
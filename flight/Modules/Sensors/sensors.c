@@ -48,6 +48,7 @@
 #include "magnetometer.h"
 #include "magbias.h"
 #include "coordinate_conversions.h"
+#include "trace.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 1000
@@ -306,6 +307,7 @@ static void update_gyros(struct pios_sensor_gyro_data *gyros)
 	}
 
 	GyrosSet(&gyrosData);
+	TRACE_PROBE(TRACE_GYRO);
 }
 
 /**
@@ -39,7 +39,7 @@
 #include "openpilot.h"
 #include "stabilization.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
+#include "pios_semaphore.h"
 
 #include "accels.h"
 #include "actuatordesired.h"
@@ -59,13 +59,12 @@
 #include "pid.h"
 #include "sin_lookup.h"
 #include "misc_math.h"
+#include "trace.h"
 
 // Includes for various stabilization algorithms
 #include "virtualflybar.h"
 
 // Private constants
-#define MAX_QUEUE_SIZE 1
-
 #if defined(PIOS_STABILIZATION_STACK_SIZE)
 #define STACK_SIZE_BYTES PIOS_STABILIZATION_STACK_SIZE
 #else
@@ -99,7 +98,7 @@ enum {
 static struct pios_thread *taskHandle;
 static StabilizationSettingsData settings;
 static TrimAnglesData trimAngles;
-static struct pios_queue *queue;
+static UAVObjSignal gyroSignal;
 float gyro_alpha = 0;
 float axis_lock_accum[3] = {0,0,0};
 uint8_t max_axis_lock = 0;
@@ -121,12 +120,11 @@ static void SettingsUpdatedCb(UAVObjEvent * ev);
 int32_t StabilizationStart()
 {
 	// Initialize variables
-	// Create object queue
-	queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
+	// Only the latest gyro sample is used, so a signal is enough
+	gyroSignal.sema = PIOS_Semaphore_Create();
 
 	// Listen for updates.
-	//	AttitudeActualConnectQueue(queue);
-	GyrosConnectQueue(queue);
+	GyrosConnectSignal(&gyroSignal);
 	
 	// Connect settings callback
 	StabilizationSettingsConnectCallback(SettingsUpdatedCb);
@@ -166,8 +164,6 @@ MODULE_INITCALL(StabilizationInitialize, StabilizationStart);
  */
 static void stabilizationTask(void* parameters)
 {
-	UAVObjEvent ev;
-	
 	uint32_t timeval = PIOS_DELAY_GetRaw();
 	
 	ActuatorDesiredData actuatorDesired;
@@ -200,7 +196,7 @@ static void stabilizationTask(void* parameters)
 		PIOS_WDG_UpdateFlag(PIOS_WDG_STABILIZATION);
 		
 		// Wait until the AttitudeRaw object is updated, if a timeout then go to failsafe
-		if (PIOS_Queue_Receive(queue, &ev, FAILSAFE_TIMEOUT_MS) != true)
+		if (PIOS_Semaphore_Take(gyroSignal.sema, FAILSAFE_TIMEOUT_MS) != true)
 		{
 			AlarmsSet(SYSTEMALARMS_ALARM_STABILIZATION,SYSTEMALARMS_ALARM_WARNING);
 			continue;
@@ -213,6 +209,8 @@ static void stabilizationTask(void* parameters)
 		StabilizationDesiredGet(&stabDesired);
 		AttitudeActualGet(&attitudeActual);
 		GyrosGet(&gyrosData);
+		UAVObjSignalSkipped(&gyroSignal);
+		TRACE_PROBE(TRACE_STABILIZATION_START);
 		ActuatorDesiredGet(&actuatorDesired);
 #if defined(RATEDESIRED_DIAGNOSTICS)
 		RateDesiredGet(&rateDesired);
@@ -615,6 +613,7 @@ static void stabilizationTask(void* parameters)
 
 		if(flightStatus.FlightMode != FLIGHTSTATUS_FLIGHTMODE_MANUAL) {
 			ActuatorDesiredSet(&actuatorDesired);
+			TRACE_PROBE(TRACE_STABILIZATION_DONE);
 		} else {
 			// Force all axes to reinitialize when engaged
 			for(uint8_t i=0; i< MAX_AXES; i++)
@@ -33,6 +33,7 @@
 #include "systemmod.h"
 #include "sanitycheck.h"
 #include "objectpersistence.h"
+#include "objectpersistencebatch.h"
 #include "flightstatus.h"
 #include "manualcontrolsettings.h"
 #include "stabilizationsettings.h"
@@ -42,6 +43,10 @@
 #include "taskinfo.h"
 #include "watchdogstatus.h"
 #include "taskmonitor.h"
+#include "trace.h"
+#if defined(TRACE_DIAGNOSTICS)
+#include "tracestats.h"
+#endif
 #include "pios_thread.h"
 #include "pios_queue.h"
 
@@ -56,6 +61,7 @@
 // Private constants
 #define SYSTEM_UPDATE_PERIOD_MS 1000
 #define LED_BLINK_RATE_HZ 5
+#define LOGFS_GC_SLOTS_PER_UPDATE 16
 
 #ifndef IDLE_COUNTS_PER_SEC_AT_NO_LOAD
 #define IDLE_COUNTS_PER_SEC_AT_NO_LOAD 995998	// calibrated by running tests/test_cpuload.c
@@ -80,8 +86,13 @@ static struct pios_thread *systemTaskHandle;
 static struct pios_queue *objectPersistenceQueue;
 static bool stackOverflow;
 
+#if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
+extern uintptr_t pios_uavo_settings_fs_id;
+#endif
+
 // Private functions
 static void objectUpdatedCb(UAVObjEvent * ev);
+static void objectPersistenceBatchUpdated(void);
 
 #if (defined(COPTERCONTROL) || defined(REVOLUTION) || defined(SIM_OSX)) && ! (defined(SIM_POSIX))
 static void configurationUpdatedCb(UAVObjEvent * ev);
@@ -122,14 +133,19 @@ int32_t SystemModInitialize(void)
 	SystemStatsInitialize();
 	FlightStatusInitialize();
 	ObjectPersistenceInitialize();
+	ObjectPersistenceBatchInitialize();
 #if defined(DIAG_TASKS)
 	TaskInfoInitialize();
 #endif
 #if defined(WDG_STATS_DIAGNOSTICS)
 	WatchdogStatusInitialize();
 #endif
+#if defined(TRACE_DIAGNOSTICS)
+	TraceStatsInitialize();
+#endif
 
-	objectPersistenceQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
+	// Room for one single object and one batch request
+	objectPersistenceQueue = PIOS_Queue_Create(2, sizeof(UAVObjEvent));
 	if (objectPersistenceQueue == NULL)
 		return -1;
 
@@ -166,6 +182,7 @@ static void systemTask(void *parameters)
 
 	// Listen for SettingPersistance object updates, connect a callback function
 	ObjectPersistenceConnectQueue(objectPersistenceQueue);
+	ObjectPersistenceBatchConnectQueue(objectPersistenceQueue);
 
 #if (defined(COPTERCONTROL) || defined(REVOLUTION) || defined(SIM_OSX)) && ! (defined(SIM_POSIX))
 	// Run this initially to make sure the configuration is checked
@@ -202,6 +219,11 @@ static void systemTask(void *parameters)
 		TaskMonitorUpdateAll();
 #endif
 
+#if defined(TRACE_DIAGNOSTICS)
+		// Update the latency along the sensor to actuator path
+		TraceUpdateStats();
+#endif
+
 		// Flash the heartbeat LED
 #if defined(PIOS_LED_HEARTBEAT)
 		PIOS_LED_Toggle(PIOS_LED_HEARTBEAT);
@@ -222,6 +244,14 @@ static void systemTask(void *parameters)
 		FlightStatusData flightStatus;
 		FlightStatusGet(&flightStatus);
 
+#if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
+		// Reclaim flash for settings a little at a time while disarmed, so
+		// that saving a setting doesn't have to copy the whole log at once
+		if (flightStatus.Armed == FLIGHTSTATUS_ARMED_DISARMED) {
+			PIOS_FLASHFS_CollectGarbage(pios_uavo_settings_fs_id, LOGFS_GC_SLOTS_PER_UPDATE);
+		}
+#endif
+
 		UAVObjEvent ev;
 		int delayTime = flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED ?
 			SYSTEM_UPDATE_PERIOD_MS / (LED_BLINK_RATE_HZ * 2) :
@@ -242,6 +272,11 @@ static void objectUpdatedCb(UAVObjEvent * ev)
 	ObjectPersistenceData objper;
 	UAVObjHandle obj;
 
+	if (ev->obj == ObjectPersistenceBatchHandle()) {
+		objectPersistenceBatchUpdated();
+		return;
+	}
+
 	// If the object updated was the ObjectPersistence execute requested action
 	if (ev->obj == ObjectPersistenceHandle()) {
 		// Get object data
@@ -308,7 +343,6 @@ static void objectUpdatedCb(UAVObjEvent * ev)
 		} else if (objper.Operation == OBJECTPERSISTENCE_OPERATION_FULLERASE) {
 			retval = -1;
 #if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
-			extern uintptr_t pios_uavo_settings_fs_id;
 			retval = PIOS_FLASHFS_Format(pios_uavo_settings_fs_id);
 #endif
 		}
@@ -327,6 +361,37 @@ static void objectUpdatedCb(UAVObjEvent * ev)
 	}
 }
 
+/**
+ * Save every object listed in the ObjectPersistenceBatch in a single flash
+ * session and report the outcome for each of them
+ */
+static void objectPersistenceBatchUpdated(void)
+{
+	ObjectPersistenceBatchData batch;
+	ObjectPersistenceBatchGet(&batch);
+
+	if (batch.Operation != OBJECTPERSISTENCEBATCH_OPERATION_SAVE)
+		return;
+
+	if (batch.NumberOfObjects > OBJECTPERSISTENCEBATCH_OBJECTID_NUMELEM) {
+		batch.Operation = OBJECTPERSISTENCEBATCH_OPERATION_ERROR;
+		ObjectPersistenceBatchSet(&batch);
+		return;
+	}
+
+	int8_t results[OBJECTPERSISTENCEBATCH_OBJECTID_NUMELEM];
+	int32_t retval = UAVObjSaveBatch(batch.ObjectID, batch.InstanceID, batch.NumberOfObjects, results);
+
+	for (uint8_t i = 0; i < batch.NumberOfObjects; i++) {
+		batch.Status[i] = (results[i] == 0) ?
+			OBJECTPERSISTENCEBATCH_STATUS_SAVED : OBJECTPERSISTENCEBATCH_STATUS_FAILED;
+	}
+
+	batch.Operation = (retval == 0) ?
+		OBJECTPERSISTENCEBATCH_OPERATION_COMPLETED : OBJECTPERSISTENCEBATCH_OPERATION_ERROR;
+	ObjectPersistenceBatchSet(&batch);
+}
+
 /**
  * Called whenever a critical configuration component changes
  */
@@ -493,7 +558,7 @@ static void updateSystemAlarms()
 	EventGetStats(&evStats);
 	UAVObjClearStats();
 	EventClearStats();
-	if (objStats.eventCallbackErrors > 0 || objStats.eventQueueErrors > 0  || evStats.eventErrors > 0) {
+	if (objStats.eventCallbackErrors > 0 || objStats.eventQueueErrors > 0  || objStats.signalSkips > 0 || evStats.eventErrors > 0) {
 		AlarmsSet(SYSTEMALARMS_ALARM_EVENTSYSTEM, SYSTEMALARMS_ALARM_WARNING);
 	} else {
 		AlarmsClear(SYSTEMALARMS_ALARM_EVENTSYSTEM);
@@ -33,6 +33,7 @@
 #include "gcstelemetrystats.h"
 #include "modulesettings.h"
 #include "sessionmanaging.h"
+#include "settingsdigest.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
 
@@ -47,6 +48,7 @@
 #define STATS_UPDATE_PERIOD_MS 4000
 #define CONNECTION_TIMEOUT_MS 8000
 #define PAUSE_PERIODIC_UPDATE_TIMEOUT 6000
+#define RX_BUFFER_SIZE 16
 // Private types
 
 // Private variables
@@ -63,8 +65,6 @@ static void telemetryTxPriTask(void *parameters);
 
 static struct pios_thread *telemetryTxTaskHandle;
 static struct pios_thread *telemetryRxTaskHandle;
-static uint32_t txErrors;
-static uint32_t txRetries;
 static uint32_t timeOfLastObjectUpdate;
 static UAVTalkConnection uavTalkCon;
 static bool pausePeriodicUpdates;
@@ -82,8 +82,10 @@ static void gcsTelemetryStatsUpdated();
 static void updateSettings();
 static uintptr_t getComPort();
 static void session_managing_updated(UAVObjEvent * ev);
+static void settings_digest_updated(UAVObjEvent * ev);
 static void update_object_instances(uint32_t obj_id, uint32_t inst_id);
 static void check_pause_periodic_updates_timeout();
+static void processTxQueue(struct pios_queue *txQueue);
 
 /**
  * Initialise the telemetry module
@@ -137,10 +139,9 @@ int32_t TelemetryInitialize(void)
     
 	// Initialise UAVTalk
 	uavTalkCon = UAVTalkInitialize(&transmitData);
+	UAVTalkConfigureTransactions(uavTalkCon, REQ_TIMEOUT_MS, MAX_RETRIES, NULL);
     
 	// Create periodic event that will be used to update the telemetry stats
-	txErrors = 0;
-	txRetries = 0;
 	UAVObjEvent ev;
 	memset(&ev, 0, sizeof(UAVObjEvent));
 	EventPeriodicQueueCreate(&ev, priorityQueue, STATS_UPDATE_PERIOD_MS);
@@ -148,6 +149,9 @@ int32_t TelemetryInitialize(void)
 	SessionManagingInitialize();
 	SessionManagingConnectCallback(session_managing_updated);
 
+	SettingsDigestInitialize();
+	SettingsDigestConnectCallback(settings_digest_updated);
+
 	//register the new uavo instance callback function in the uavobjectmanager
 	UAVObjRegisterNewInstanceCB(update_object_instances);
 
@@ -269,8 +273,6 @@ static void processObjEvent(UAVObjEvent * ev)
 	UAVObjMetadata metadata;
 	UAVObjUpdateMode updateMode;
 	FlightTelemetryStatsData flightStats;
-	int32_t retries;
-	int32_t success;
 
 	if (ev->obj == 0) {
 		updateTelemetryStats();
@@ -282,60 +284,33 @@ static void processObjEvent(UAVObjEvent * ev)
 		UAVObjGetMetadata(ev->obj, &metadata);
 		updateMode = UAVObjGetTelemetryUpdateMode(&metadata);
 
-		// Act on event
-		retries = 0;
-		success = -1;
+		// Act on event. Acked sends and requests do not wait for the GCS, the
+		// retries are done by UAVTalkProcessTransactions() and the failures
+		// and retries are counted in the UAVTalk statistics. When all the
+		// transactions are pending the update is sent once without an ack.
 		if (ev->event == EV_UPDATED || ev->event == EV_UPDATED_MANUAL || ((ev->event == EV_UPDATED_PERIODIC) && (updateMode != UPDATEMODE_THROTTLED))) {
-			// Send update to GCS (with retries)
+			// Send update to GCS
 			if (pausePeriodicUpdates) {
 				check_pause_periodic_updates_timeout();
 			}
-			while (retries < MAX_RETRIES && success == -1) {
-				if((ev->obj !=FlightTelemetryStatsHandle()) && (ev->event == EV_UPDATED_PERIODIC) && pausePeriodicUpdates) {
-					success = 0;
-				} else {
-					success = UAVTalkSendObject(uavTalkCon, ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata), REQ_TIMEOUT_MS);	// call blocks until ack is received or timeout
-				}
-				++retries;
-			}
-			// Update stats
-			txRetries += (retries - 1);
-			if (success == -1) {
-				++txErrors;
+			if (!((ev->obj != FlightTelemetryStatsHandle()) && (ev->event == EV_UPDATED_PERIODIC) && pausePeriodicUpdates)) {
+				UAVTalkSendObjectAsync(uavTalkCon, ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata));
 			}
 		} else if (ev->event == EV_UPDATE_REQ) {
-			// Request object update from GCS (with retries)
-			while (retries < MAX_RETRIES && success == -1) {
-				success = UAVTalkSendObjectRequest(uavTalkCon, ev->obj, ev->instId, REQ_TIMEOUT_MS);	// call blocks until update is received or timeout
-				++retries;
-			}
-			// Update stats
-			txRetries += (retries - 1);
-			if (success == -1) {
-				++txErrors;
-			}
+			// Request object update from GCS
+			UAVTalkSendObjectRequestAsync(uavTalkCon, ev->obj, ev->instId);
 		} else if (ev->event == EV_UPDATED_PERIODIC && updateMode == UPDATEMODE_THROTTLED) {
 
 			// Get the event mask
 			int32_t eventMask = getEventMask(ev->obj, priorityQueue);
 
 			if (eventMask & EV_UPDATED_THROTTLED_DIRTY) { // If EV_UPDATED_THROTTLED_DIRTY flag is set then send the data like normal.
-				// Send update to GCS (with retries)
+				// Send update to GCS
 				if (pausePeriodicUpdates) {
 					check_pause_periodic_updates_timeout();
 				}
-				while (retries < MAX_RETRIES && success == -1) {
-					if (pausePeriodicUpdates) {
-						success = 0;
-					} else {
-						success = UAVTalkSendObject(uavTalkCon, ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata), REQ_TIMEOUT_MS);	// call blocks until ack is received or timeout
-					}
-					++retries;
-				}
-				// Update stats
-				txRetries += (retries - 1);
-				if (success == -1) {
-					++txErrors;
+				if (!pausePeriodicUpdates) {
+					UAVTalkSendObjectAsync(uavTalkCon, ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata));
 				}
 			}
 		}
@@ -352,19 +327,32 @@ static void processObjEvent(UAVObjEvent * ev)
 }
 
 /**
- * Telemetry transmit task, regular priority
+ * Wait for the next queue event, but no longer than until the next
+ * retransmission of a pending transaction is due
  */
-static void telemetryTxTask(void *parameters)
+static void processTxQueue(struct pios_queue *txQueue)
 {
 	UAVObjEvent ev;
 
+	uint32_t timeout = UAVTalkProcessTransactions(uavTalkCon);
+	if (timeout == UAVTALK_NO_DEADLINE) {
+		timeout = PIOS_QUEUE_TIMEOUT_MAX;
+	}
+
+	if (PIOS_Queue_Receive(txQueue, &ev, timeout) == true) {
+		// Process event
+		processObjEvent(&ev);
+	}
+}
+
+/**
+ * Telemetry transmit task, regular priority
+ */
+static void telemetryTxTask(void *parameters)
+{
 	// Loop forever
 	while (1) {
-		// Wait for queue message
-		if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
-			// Process event
-			processObjEvent(&ev);
-		}
+		processTxQueue(queue);
 	}
 }
 
@@ -374,15 +362,9 @@ static void telemetryTxTask(void *parameters)
 #if defined(PIOS_TELEM_PRIORITY_QUEUE)
 static void telemetryTxPriTask(void *parameters)
 {
-	UAVObjEvent ev;
-
 	// Loop forever
 	while (1) {
-		// Wait for queue message
-		if (PIOS_Queue_Receive(priorityQueue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
-			// Process event
-			processObjEvent(&ev);
-		}
+		processTxQueue(priorityQueue);
 	}
 }
 #endif
@@ -398,15 +380,13 @@ static void telemetryRxTask(void *parameters)
 		uintptr_t inputPort = getComPort();
 
 		if (inputPort) {
-			// Block until data are available
-			uint8_t serial_data[1];
+			// Block until data are available, then take all that fits
+			uint8_t serial_data[RX_BUFFER_SIZE];
 			uint16_t bytes_to_process;
 
 			bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort, serial_data, sizeof(serial_data), 500);
 			if (bytes_to_process > 0) {
-				for (uint8_t i = 0; i < bytes_to_process; i++) {
-					UAVTalkProcessInputStream(uavTalkCon,serial_data[i]);
-				}
+				UAVTalkProcessInputBuffer(uavTalkCon, serial_data, bytes_to_process);
 			}
 		} else {
 			PIOS_Thread_Sleep(5);
@@ -490,18 +470,14 @@ static void updateTelemetryStats()
 		flightStats.RxDataRate = (float)utalkStats.rxBytes / ((float)STATS_UPDATE_PERIOD_MS / 1000.0f);
 		flightStats.TxDataRate = (float)utalkStats.txBytes / ((float)STATS_UPDATE_PERIOD_MS / 1000.0f);
 		flightStats.RxFailures += utalkStats.rxErrors;
-		flightStats.TxFailures += txErrors;
-		flightStats.TxRetries += txRetries;
-		txErrors = 0;
-		txRetries = 0;
+		flightStats.TxFailures += utalkStats.txErrors;
+		flightStats.TxRetries += utalkStats.txRetries;
 	} else {
 		flightStats.RxDataRate = 0;
 		flightStats.TxDataRate = 0;
 		flightStats.RxFailures = 0;
 		flightStats.TxFailures = 0;
 		flightStats.TxRetries = 0;
-		txErrors = 0;
-		txRetries = 0;
 	}
 
 	// Check for connection timeout
@@ -641,6 +617,40 @@ static void session_managing_updated(UAVObjEvent * ev)
 	}
 }
 
+/**
+ * SettingsDigest object updated callback
+ * The GCS sends the page it wants, answer with the digests of the
+ * objects on that page so it can skip those it has a current copy of
+ */
+static void settings_digest_updated(UAVObjEvent * ev)
+{
+	if (ev->event != EV_UNPACKED)
+		return;
+
+	SettingsDigestData settingsDigest;
+	SettingsDigestGet(&settingsDigest);
+
+	uint8_t count = UAVObjCount();
+	settingsDigest.NumberOfObjects = count;
+	for (uint8_t i = 0; i < SETTINGSDIGEST_OBJECTID_NUMELEM; i++) {
+		uint16_t index = settingsDigest.Page * SETTINGSDIGEST_OBJECTID_NUMELEM + i;
+		UAVObjHandle obj = NULL;
+		if (index < count)
+			obj = UAVObjGetByID(UAVObjIDByIndex(index));
+
+		if (obj != NULL) {
+			settingsDigest.ObjectID[i] = UAVObjGetID(obj);
+			settingsDigest.Digest[i] = UAVObjGetDigest(obj);
+			settingsDigest.MetaDigest[i] = UAVObjGetDigest(UAVObjGetLinkedObj(obj));
+		} else {
+			settingsDigest.ObjectID[i] = 0;
+			settingsDigest.Digest[i] = 0;
+			settingsDigest.MetaDigest[i] = 0;
+		}
+	}
+	SettingsDigestSet(&settingsDigest);
+}
+
 /**
  * New UAVO object instance callback
  * This is called from the uavobjectmanager
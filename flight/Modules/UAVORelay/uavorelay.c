@@ -157,8 +157,8 @@ static void uavoRelayTask(void *parameters)
 		bytes_to_process = PIOS_COM_ReceiveBuffer(uavorelay_com_id, serial_data, sizeof(serial_data), 0);
 		do {
 			bytes_to_process = PIOS_COM_ReceiveBuffer(uavorelay_com_id, serial_data, sizeof(serial_data), 0);
-			for (uint8_t i = 0; i < bytes_to_process; i++)
-				UAVTalkProcessInputStream(uavTalkCon,serial_data[i]);
+			if (bytes_to_process > 0)
+				UAVTalkProcessInputBuffer(uavTalkCon, serial_data, bytes_to_process);
 		} while (bytes_to_process > 0);
 
 	}
@@ -32,6 +32,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>		/* NULL */
+#include <string.h>		/* memset */
 
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
@@ -56,6 +57,18 @@ struct logfs_state {
 	uint16_t num_free_slots;   /* slots in free state */
 	uint16_t num_active_slots; /* slots in active state */
 
+	/* Index of the active arena with one tag per slot, see logfs_index_tag() */
+	uint8_t *slot_index;
+
+	/* Garbage collection in progress, see logfs_garbage_collect() */
+	bool gc_active;
+	uint8_t gc_arena_id;     /* arena the active slots are being copied to */
+	uint16_t gc_src_slot_id; /* next slot of the active arena to copy */
+	uint16_t gc_dst_slot_id; /* next empty slot of the destination arena */
+
+	/* Flash transaction held across calls, see PIOS_FLASHFS_BeginSession() */
+	bool session_active;
+
 	/* Underlying flash partition handle */
 	uintptr_t partition_id;
 	uint32_t partition_size;
@@ -335,6 +348,20 @@ struct slot_header {
 	uint16_t obj_size;
 } __attribute__((packed));
 
+/*
+ * Tag of an object in the slot index, or 0 for a slot that holds no active object.
+ *
+ * Looking up an object only needs to read the slot headers with a matching tag
+ * from flash instead of every header in the arena.
+ */
+static uint8_t logfs_index_tag(uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint32_t hash = obj_id ^ (obj_inst_id * 0x9E3779B1);
+	hash ^= hash >> 16;
+	hash ^= hash >> 8;
+	return (hash & 0xFF) % 255 + 1;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
 static int32_t logfs_raw_copy_bytes (const struct logfs_state *logfs, uintptr_t src_addr, uint16_t src_size, uintptr_t dst_addr)
 {
@@ -406,6 +433,9 @@ static int32_t logfs_unmount_log(struct logfs_state *logfs)
 	logfs->num_free_slots   = 0;
 	logfs->mounted          = false;
 
+	/* Any collection in progress was for the arena that just went away */
+	logfs->gc_active        = false;
+
 	return 0;
 }
 
@@ -437,12 +467,15 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 		PIOS_Assert (slot_hdr.state == SLOT_STATE_EMPTY ||
 			logfs->num_free_slots == 0);
 
+		logfs->slot_index[slot_id] = 0;
+
 		switch (slot_hdr.state) {
 		case SLOT_STATE_EMPTY:
 			logfs->num_free_slots++;
 			break;
 		case SLOT_STATE_ACTIVE:
 			logfs->num_active_slots++;
+			logfs->slot_index[slot_id] = logfs_index_tag(slot_hdr.obj_id, slot_hdr.obj_inst_id);
 			break;
 		case SLOT_STATE_RESERVED:
 		case SLOT_STATE_OBSOLETE:
@@ -470,12 +503,16 @@ static struct logfs_state *PIOS_FLASHFS_Logfs_alloc(void)
 	if (!logfs) return (NULL);
 
 	logfs->magic = PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+	logfs->slot_index = NULL;
+	logfs->gc_active = false;
+	logfs->session_active = false;
 	return(logfs);
 }
 static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
 	/* Invalidate the magic */
 	logfs->magic = ~PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+	PIOS_free(logfs->slot_index);
 	PIOS_free(logfs);
 }
 
@@ -521,6 +558,15 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
 	logfs->partition_size = partition_size; /* size of underlying partition */
 	logfs->mounted        = false;
 
+	/* Allocate the slot index, it is filled in when the log is mounted */
+	uint16_t num_slots = cfg->arena_size / cfg->slot_size;
+	logfs->slot_index = (uint8_t *) PIOS_malloc(num_slots);
+	if (!logfs->slot_index) {
+		rc = -1;
+		goto out_exit;
+	}
+	memset(logfs->slot_index, 0, num_slots);
+
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -1;
 		goto out_exit;
@@ -587,12 +633,24 @@ out_exit:
 	return rc;
 }
 
-/* NOTE: Must be called while holding the flash transaction lock */
-static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
-	PIOS_Assert (logfs->mounted);
+/*
+ * Garbage collection copies the active slots of the active arena into the
+ * next arena and then switches over to it.  It is done a bounded number of
+ * slots at a time so that it can be spread over several calls from a low
+ * priority task instead of holding the flash for the whole copy.
+ *
+ * The destination arena stays RESERVED while it is being filled, so a
+ * power loss at any point mounts the (complete) source arena again.  Only
+ * once everything has been copied is the destination activated and the
+ * source obsoleted.  Objects saved in the meantime are appended to the
+ * source arena and copied when the collection gets to them, while objects
+ * deleted after they have been copied are obsoleted in both arenas.
+ */
 
-	/* Source arena is the active arena */
-	uint8_t src_arena_id = logfs->active_arena_id;
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t logfs_gc_start (struct logfs_state *logfs)
+{
+	PIOS_Assert (logfs->mounted && !logfs->gc_active);
 
 	/* Compute destination arena */
 	uint8_t dst_arena_id = (logfs->active_arena_id + 1) % (logfs->partition_size / logfs->cfg->arena_size);
@@ -608,56 +666,176 @@ static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
 		return -2;
 	}
 
-	/* Copy active slots from active arena to destination arena */
-	uint16_t dst_slot_id = 1;
-	for (uint16_t src_slot_id = 1;
-	     src_slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
-	     src_slot_id++) {
+	logfs->gc_arena_id    = dst_arena_id;
+	logfs->gc_src_slot_id = 1;
+	logfs->gc_dst_slot_id = 1;
+	logfs->gc_active      = true;
+
+	return 0;
+}
+
+/*
+ * Copy up to max_slots active slots from the active arena to the destination arena
+ * @return 1 once every slot written to the active arena so far has been copied
+ * @return 0 if there are more slots left to copy
+ * @return < 0 on failure
+ * NOTE: Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_copy (struct logfs_state *logfs, uint16_t max_slots)
+{
+	uint16_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+
+	/* Slots past this one have never been written */
+	uint16_t end_slot_id = num_slots - logfs->num_free_slots;
+
+	while (logfs->gc_src_slot_id < end_slot_id) {
+		/* Only slots holding an active object need to be copied */
+		if (logfs->slot_index[logfs->gc_src_slot_id] == 0) {
+			logfs->gc_src_slot_id++;
+			continue;
+		}
+
+		if (max_slots == 0) {
+			return 0;
+		}
+
+		if (logfs->gc_dst_slot_id == num_slots) {
+			/*
+			 * Objects that were rewritten since we copied them have
+			 * used up the destination arena, start over.
+			 */
+			return -1;
+		}
+
 		struct slot_header slot_hdr;
-		uintptr_t src_addr = logfs_get_addr (logfs, src_arena_id, src_slot_id);
+		uintptr_t src_addr = logfs_get_addr (logfs, logfs->active_arena_id, logfs->gc_src_slot_id);
 		if (PIOS_FLASH_read_data(logfs->partition_id,
 						src_addr,
 						(uint8_t *)&slot_hdr,
 						sizeof (slot_hdr)) != 0) {
-			return -3;
+			return -2;
 		}
 
 		if (slot_hdr.state == SLOT_STATE_ACTIVE) {
-			uintptr_t dst_addr = logfs_get_addr (logfs, dst_arena_id, dst_slot_id);
+			uintptr_t dst_addr = logfs_get_addr (logfs, logfs->gc_arena_id, logfs->gc_dst_slot_id);
 			if (logfs_raw_copy_bytes(logfs,
 							src_addr,
 							sizeof(slot_hdr) + slot_hdr.obj_size,
 							dst_addr) != 0) {
 				/* Failed to copy all bytes */
-				return -4;
+				return -3;
+			}
+			logfs->gc_dst_slot_id++;
+			max_slots--;
+		}
+
+		logfs->gc_src_slot_id++;
+	}
+
+	return 1;
+}
+
+/*
+ * Obsolete the copy of an object that was deleted after it had already been
+ * copied to the destination arena
+ * NOTE: Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_obsolete_copy (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	for (uint16_t slot_id = 1; slot_id < logfs->gc_dst_slot_id; slot_id++) {
+		struct slot_header slot_hdr;
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->gc_arena_id, slot_id);
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						slot_addr,
+						(uint8_t *)&slot_hdr,
+						sizeof (slot_hdr)) != 0) {
+			return -1;
+		}
+
+		if (slot_hdr.state == SLOT_STATE_ACTIVE &&
+			slot_hdr.obj_id      == obj_id &&
+			slot_hdr.obj_inst_id == obj_inst_id) {
+			slot_hdr.state = SLOT_STATE_OBSOLETE;
+			if (PIOS_FLASH_write_data(logfs->partition_id,
+							slot_addr,
+							(uint8_t *)&slot_hdr,
+							sizeof(slot_hdr)) != 0) {
+				return -2;
 			}
-			dst_slot_id++;
 		}
 	}
 
+	return 0;
+}
+
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t logfs_gc_finish (struct logfs_state *logfs)
+{
+	/* Source arena is the active arena */
+	uint8_t src_arena_id = logfs->active_arena_id;
+	uint8_t dst_arena_id = logfs->gc_arena_id;
+
+	logfs->gc_active = false;
+
 	/* Activate the destination arena */
 	if (logfs_activate_arena (logfs, dst_arena_id) != 0) {
-		return -5;
+		return -1;
 	}
 
 	/* Unmount the source arena */
 	if (logfs_unmount_log (logfs) != 0) {
-		return -6;
+		return -2;
 	}
 
 	/* Obsolete the source arena */
 	if (logfs_obsolete_arena (logfs, src_arena_id) != 0) {
-		return -7;
+		return -3;
 	}
 
 	/* Mount the new arena */
 	if (logfs_mount_log (logfs, dst_arena_id) != 0) {
-		return -8;
+		return -4;
 	}
 
 	return 0;
 }
 
+/*
+ * Start or continue garbage collection, copying at most max_slots slots
+ * @return 0 if garbage collection completed
+ * @return 1 if garbage collection needs to be called again
+ * @return < 0 on failure
+ * NOTE: Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_garbage_collect (struct logfs_state *logfs, uint16_t max_slots)
+{
+	PIOS_Assert (logfs->mounted);
+
+	if (!logfs->gc_active && logfs_gc_start (logfs) != 0) {
+		return -1;
+	}
+
+	switch (logfs_gc_copy (logfs, max_slots)) {
+	case 0:
+		/* More to copy on the next call */
+		return 1;
+	case 1:
+		/* Everything copied, switch over to the new arena */
+		if (logfs_gc_finish (logfs) != 0) {
+			return -2;
+		}
+		return 0;
+	case -1:
+		/* Destination arena filled up, start over on the next call */
+		logfs->gc_active = false;
+		return 1;
+	default:
+		/* Abandon this collection, the destination arena is erased again on the next one */
+		logfs->gc_active = false;
+		return -3;
+	}
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
 static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *curr_slot, uint32_t obj_id, uint16_t obj_inst_id)
 {
@@ -667,9 +845,16 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 	/* First slot in the arena is reserved for arena header, skip it. */
 	if (*curr_slot == 0) *curr_slot = 1;
 
+	uint8_t tag = logfs_index_tag(obj_id, obj_inst_id);
+
 	for (uint16_t slot_id = *curr_slot;
 	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
 	     slot_id++) {
+		/* Only slots holding an active object with the same tag can match */
+		if (logfs->slot_index[slot_id] != tag) {
+			continue;
+		}
+
 		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
 
 		if (PIOS_FLASH_read_data(logfs->partition_id,
@@ -678,10 +863,6 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 						sizeof (*slot_hdr)) != 0) {
 			return -2;
 		}
-		if (slot_hdr->state == SLOT_STATE_EMPTY) {
-			/* We hit the end of the log */
-			break;
-		}
 		if (slot_hdr->state == SLOT_STATE_ACTIVE &&
 			slot_hdr->obj_id      == obj_id &&
 			slot_hdr->obj_inst_id == obj_inst_id) {
@@ -696,7 +877,6 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 }
 
 /* NOTE: Must be called while holding the flash transaction lock */
-/* OPTIMIZE: could trust that there is at most one active version of every object and terminate the search when we find one */
 static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
 {
 	int8_t rc;
@@ -720,6 +900,14 @@ static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, u
 			}
 			/* Object has been successfully obsoleted and is no longer active */
 			logfs->num_active_slots--;
+			logfs->slot_index[curr_slot_id] = 0;
+
+			/* Don't let garbage collection bring back a copy it already made */
+			if (logfs->gc_active && curr_slot_id < logfs->gc_src_slot_id &&
+				logfs_gc_obsolete_copy (logfs, obj_id, obj_inst_id) != 0) {
+				rc = -3;
+				goto out_exit;
+			}
 			break;
 		case -1:
 			/* Search completed, object not found */
@@ -832,54 +1020,19 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
 
 	/* Object has been successfully written to the slot */
 	logfs->num_active_slots++;
+	logfs->slot_index[free_slot_id] = logfs_index_tag(obj_id, obj_inst_id);
 	return 0;
 }
 
 
-/**********************************
- *
- * Provide a PIOS_FLASHFS_* driver
- *
- *********************************/
-#include "pios_flashfs.h"	/* API for flash filesystem */
-
-/**
- * @brief Saves one object instance to the filesystem
- * @param[in] fs_id The filesystem to use for this action
- * @param[in] obj UAVObject ID of the object to save
- * @param[in] obj_inst_id The instance number of the object being saved
- * @param[in] obj_data Contents of the object being saved
- * @param[in] obj_size Size of the object being saved
- * @return 0 if success or error code
- * @retval -1 if fs_id is not a valid filesystem instance
- * @retval -2 if failed to start transaction
- * @retval -3 if failure to delete any previous versions of the object
- * @retval -4 if filesystem is entirely full and garbage collection won't help
- * @retval -5 if garbage collection failed
- * @retval -6 if filesystem is full even after garbage collection should have freed space
- * @retval -7 if writing the new object to the filesystem failed
- */
-int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
+/* NOTE: Must be called while holding the flash transaction lock */
+static int8_t logfs_obj_save(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
 {
 	int8_t rc;
 
-	struct logfs_state *logfs = (struct logfs_state *)fs_id;
-
-	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
-		rc = -1;
-		goto out_exit;
-	}
-
-	PIOS_Assert(obj_size <= (logfs->cfg->slot_size - sizeof(struct slot_header)));
-
-	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
-		rc = -2;
-		goto out_exit;
-	}
-
 	if (logfs_delete_object (logfs, obj_id, obj_inst_id) != 0) {
 		rc = -3;
-		goto out_end_trans;
+		goto out_exit;
 	}
 
 	/*
@@ -891,15 +1044,20 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 	if (logfs_fs_is_full(logfs)) {
 		/* Note: Filesystem Full means we're full of *active* records so gc won't help at all. */
 		rc = -4;
-		goto out_end_trans;
+		goto out_exit;
 	}
 
 	/* Is garbage collection required? */
 	if (logfs_log_is_full(logfs)) {
 		/* Note: Log Full means the log is full but may contain obsolete slots so gc may free some space */
-		if (logfs_garbage_collect(logfs) != 0) {
+		int32_t gc_rc;
+		do {
+			/* Finish any collection that is in progress, all at once */
+			gc_rc = logfs_garbage_collect(logfs, UINT16_MAX);
+		} while (gc_rc == 1);
+		if (gc_rc != 0) {
 			rc = -5;
-			goto out_end_trans;
+			goto out_exit;
 		}
 		/* Check one more time just to be sure we actually free'd some space */
 		if (logfs_log_is_full(logfs)) {
@@ -910,7 +1068,7 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 			 */
 			PIOS_DEBUG_Assert(0);
 			rc = -6;
-			goto out_end_trans;
+			goto out_exit;
 		}
 	}
 
@@ -918,13 +1076,100 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 	if (logfs_append_to_log(logfs, obj_id, obj_inst_id, obj_data, obj_size) != 0) {
 		/* Error during append */
 		rc = -7;
-		goto out_end_trans;
+		goto out_exit;
 	}
 
 	/* Object successfully written to the log */
 	rc = 0;
 
-out_end_trans:
+out_exit:
+	return rc;
+}
+
+/* NOTE: Must be called while holding the flash transaction lock */
+static int8_t logfs_obj_load(const struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
+{
+	int8_t rc;
+
+	/* Find the object in the log */
+	uint16_t slot_id = 0;
+	struct slot_header slot_hdr;
+	if (logfs_object_find_next (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
+		/* Object does not exist in fs */
+		rc = -3;
+		goto out_exit;
+	}
+
+	/* Sanity check what we've found */
+	if (slot_hdr.obj_size != obj_size) {
+		/* Object sizes don't match.  Not safe to copy contents. */
+		rc = -4;
+		goto out_exit;
+	}
+
+	/* Read the contents of the object from the log */
+	if (obj_size > 0) {
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						slot_addr + sizeof(slot_hdr),
+						(uint8_t *)obj_data,
+						obj_size) != 0) {
+			/* Failed to read object data from the log */
+			rc = -5;
+			goto out_exit;
+		}
+	}
+
+	/* Object successfully loaded */
+	rc = 0;
+
+out_exit:
+	return rc;
+}
+
+/**********************************
+ *
+ * Provide a PIOS_FLASHFS_* driver
+ *
+ *********************************/
+#include "pios_flashfs.h"	/* API for flash filesystem */
+
+/**
+ * @brief Saves one object instance to the filesystem
+ * @param[in] fs_id The filesystem to use for this action
+ * @param[in] obj UAVObject ID of the object to save
+ * @param[in] obj_inst_id The instance number of the object being saved
+ * @param[in] obj_data Contents of the object being saved
+ * @param[in] obj_size Size of the object being saved
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if failure to delete any previous versions of the object
+ * @retval -4 if filesystem is entirely full and garbage collection won't help
+ * @retval -5 if garbage collection failed
+ * @retval -6 if filesystem is full even after garbage collection should have freed space
+ * @retval -7 if writing the new object to the filesystem failed
+ */
+int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
+{
+	int8_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	PIOS_Assert(obj_size <= (logfs->cfg->slot_size - sizeof(struct slot_header)));
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	rc = logfs_obj_save(logfs, obj_id, obj_inst_id, obj_data, obj_size);
+
 	PIOS_FLASH_end_transaction(logfs->partition_id);
 
 out_exit:
@@ -963,39 +1208,8 @@ int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 		goto out_exit;
 	}
 
-	/* Find the object in the log */
-	uint16_t slot_id = 0;
-	struct slot_header slot_hdr;
-	if (logfs_object_find_next (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
-		/* Object does not exist in fs */
-		rc = -3;
-		goto out_end_trans;
-	}
-
-	/* Sanity check what we've found */
-	if (slot_hdr.obj_size != obj_size) {
-		/* Object sizes don't match.  Not safe to copy contents. */
-		rc = -4;
-		goto out_end_trans;
-	}
-
-	/* Read the contents of the object from the log */
-	if (obj_size > 0) {
-		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
-		if (PIOS_FLASH_read_data(logfs->partition_id,
-						slot_addr + sizeof(slot_hdr),
-						(uint8_t *)obj_data,
-						obj_size) != 0) {
-			/* Failed to read object data from the log */
-			rc = -5;
-			goto out_end_trans;
-		}
-	}
-
-	/* Object successfully loaded */
-	rc = 0;
+	rc = logfs_obj_load(logfs, obj_id, obj_inst_id, obj_data, obj_size);
 
-out_end_trans:
 	PIOS_FLASH_end_transaction(logfs->partition_id);
 
 out_exit:
@@ -1043,6 +1257,178 @@ out_exit:
 	return rc;
 }
 
+/**
+ * @brief Hold the filesystem for a series of saves and loads
+ * @param[in] fs_id The filesystem to use for this action
+ * @param[in] num_objs Number of objects about to be saved
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if garbage collection failed
+ * @note Until PIOS_FLASHFS_EndSession() only the PIOS_FLASHFS_Session* calls
+ *       may be used by the caller, other tasks block on the flash transaction.
+ *       Room for num_objs new slots is made up front so that the saves which
+ *       follow don't collect garbage half way through.
+ */
+int32_t PIOS_FLASHFS_BeginSession(uintptr_t fs_id, uint16_t num_objs)
+{
+	int32_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	PIOS_Assert(!logfs->session_active);
+	logfs->session_active = true;
+
+	/* Each save obsoletes the previous copy, so collecting helps unless the fs is full */
+	if (logfs->num_free_slots < num_objs && !logfs_fs_is_full(logfs)) {
+		int32_t gc_rc;
+		do {
+			gc_rc = logfs_garbage_collect(logfs, UINT16_MAX);
+		} while (gc_rc == 1);
+		if (gc_rc != 0) {
+			logfs->session_active = false;
+			PIOS_FLASH_end_transaction(logfs->partition_id);
+			rc = -3;
+			goto out_exit;
+		}
+	}
+
+	rc = 0;
+
+out_exit:
+	return rc;
+}
+
+/**
+ * @brief Release the filesystem held by PIOS_FLASHFS_BeginSession()
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if no session is in progress
+ */
+int32_t PIOS_FLASHFS_EndSession(uintptr_t fs_id)
+{
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		return -1;
+	}
+
+	if (!logfs->session_active) {
+		return -2;
+	}
+
+	logfs->session_active = false;
+	PIOS_FLASH_end_transaction(logfs->partition_id);
+
+	return 0;
+}
+
+/**
+ * @brief Saves one object instance within a session
+ * @return same as PIOS_FLASHFS_ObjSave(), -2 meaning no session is in progress
+ */
+int32_t PIOS_FLASHFS_SessionObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
+{
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		return -1;
+	}
+
+	if (!logfs->session_active) {
+		return -2;
+	}
+
+	PIOS_Assert(obj_size <= (logfs->cfg->slot_size - sizeof(struct slot_header)));
+
+	return logfs_obj_save(logfs, obj_id, obj_inst_id, obj_data, obj_size);
+}
+
+/**
+ * @brief Loads one object instance within a session
+ * @return same as PIOS_FLASHFS_ObjLoad(), -2 meaning no session is in progress
+ */
+int32_t PIOS_FLASHFS_SessionObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
+{
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		return -1;
+	}
+
+	if (!logfs->session_active) {
+		return -2;
+	}
+
+	PIOS_Assert(obj_size <= (logfs->cfg->slot_size - sizeof(struct slot_header)));
+
+	return logfs_obj_load(logfs, obj_id, obj_inst_id, obj_data, obj_size);
+}
+
+/**
+ * @brief Reclaim obsolete slots a few at a time, ahead of the log filling up
+ * @param[in] fs_id The filesystem to use for this action
+ * @param[in] max_slots Maximum number of slots to copy during this call
+ * @return 0 if no garbage collection is needed (any more), 1 if it is still in progress, or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if garbage collection failed
+ * @note Meant to be called periodically from a low priority task, so that saving
+ *       an object rarely has to collect the whole arena by itself.
+ */
+int32_t PIOS_FLASHFS_CollectGarbage(uintptr_t fs_id, uint16_t max_slots)
+{
+	int32_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	if (!logfs->gc_active) {
+		/*
+		 * Only start collecting once a quarter of the log is left and
+		 * there is a worthwhile number of obsolete slots to reclaim.
+		 */
+		uint16_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+		uint16_t num_obsolete_slots = num_slots - 1 - logfs->num_free_slots - logfs->num_active_slots;
+		if (logfs->num_free_slots >= num_slots / 4 ||
+			num_obsolete_slots < num_slots / 8) {
+			rc = 0;
+			goto out_end_trans;
+		}
+	}
+
+	rc = logfs_garbage_collect(logfs, max_slots);
+	if (rc < 0) {
+		rc = -3;
+	}
+
+out_end_trans:
+	PIOS_FLASH_end_transaction(logfs->partition_id);
+
+out_exit:
+	return rc;
+}
+
 /**
  * @brief Erases all filesystem arenas and activate the first arena
  * @param[in] fs_id The filesystem to use for this action
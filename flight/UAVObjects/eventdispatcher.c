@@ -50,6 +50,15 @@
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGH
 #define MAX_UPDATE_PERIOD_MS 1000
 
+// The periodic events are kept in a two level timer wheel. The first level has
+// one slot per ms for the next WHEEL_SLOTS ms, the second one slot per
+// WHEEL_SLOTS ms for the WHEEL_SLOTS slots after that. Later events wait in an
+// overflow list. Both bitmaps below need exactly 64 slots.
+#define WHEEL_SLOTS 64
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_BITS 6
+#define LOOKUP_SLOTS 32
+
 // Private types
 
 
@@ -67,14 +76,23 @@ typedef struct {
  */
 struct PeriodicObjectListStruct {
 	EventCallbackInfo evInfo; /** Event callback information */
-    uint16_t updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
-    int32_t timeToNextUpdateMs; /** Time delay to the next update */
-    struct PeriodicObjectListStruct* next; /** Needed by linked list library (utlist.h) */
+	uint16_t updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
+	uint32_t nextUpdateMs; /** System time of the next update */
+	struct PeriodicObjectListStruct** slot; /** Timer wheel list the entry is in, or NULL */
+	struct PeriodicObjectListStruct* next; /** Needed by linked list library (utlist.h) */
+	struct PeriodicObjectListStruct* prev;
+	struct PeriodicObjectListStruct* lookupNext; /** Next entry with the same lookup hash */
 };
 typedef struct PeriodicObjectListStruct PeriodicObjectList;
 
 // Private variables
-static PeriodicObjectList* objList;
+static PeriodicObjectList* wheelMs[WHEEL_SLOTS];
+static PeriodicObjectList* wheelBlocks[WHEEL_SLOTS];
+static PeriodicObjectList* wheelOverflow;
+static uint64_t wheelMsUsed; /** Bit n is set when wheelMs[n] is not empty */
+static uint64_t wheelBlocksUsed;
+static uint32_t wheelTime; /** The wheel is processed up to and including this time */
+static PeriodicObjectList* lookup[LOOKUP_SLOTS];
 static struct pios_queue *queue;
 static struct pios_thread *eventTaskHandle;
 static struct pios_recursive_mutex *mutex;
@@ -86,6 +104,15 @@ static void eventTask();
 static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs);
 static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs);
 static uint16_t randomizePeriod(uint16_t periodMs);
+static PeriodicObjectList** lookupSlot(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue);
+static PeriodicObjectList* lookupEntry(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue);
+static void wheelInsert(PeriodicObjectList* objEntry);
+static void wheelRemove(PeriodicObjectList* objEntry);
+static void wheelSchedule(PeriodicObjectList* objEntry, uint16_t delayMs);
+static void wheelCascade(PeriodicObjectList** slot);
+static void dispatchPeriodic(PeriodicObjectList* objEntry, uint32_t timeNow);
+static int32_t firstUsedSlot(uint64_t used, uint32_t start);
+static uint32_t wheelNextTime();
 
 
 /**
@@ -95,7 +122,13 @@ static uint16_t randomizePeriod(uint16_t periodMs);
 int32_t EventDispatcherInitialize()
 {
 	// Initialize variables
-	objList = NULL;
+	memset(wheelMs, 0, sizeof(wheelMs));
+	memset(wheelBlocks, 0, sizeof(wheelBlocks));
+	memset(lookup, 0, sizeof(lookup));
+	wheelOverflow = NULL;
+	wheelMsUsed = 0;
+	wheelBlocksUsed = 0;
+	wheelTime = PIOS_Thread_Systime();
 	memset(&stats, 0, sizeof(EventStats));
 
 	// Create mutex
@@ -214,37 +247,37 @@ int32_t EventPeriodicQueueUpdate(UAVObjEvent* ev, struct pios_queue *queue, uint
 static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs)
 {
 	PeriodicObjectList* objEntry;
+	PeriodicObjectList** lookupHead;
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	// Check that the object is not already connected
-	LL_FOREACH(objList, objEntry)
+	if (lookupEntry(ev, cb, queue) != NULL)
 	{
-		if (objEntry->evInfo.cb == cb &&
-			objEntry->evInfo.queue == queue &&
-			objEntry->evInfo.ev.obj == ev->obj &&
-			objEntry->evInfo.ev.instId == ev->instId &&
-			objEntry->evInfo.ev.event == ev->event)
-		{
-			// Already registered, do nothing
-			PIOS_Recursive_Mutex_Unlock(mutex);
-			return -1;
-		}
+		// Already registered, do nothing
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
 	}
-    // Create handle
+	// Create handle
 	objEntry = (PeriodicObjectList*)PIOS_malloc(sizeof(PeriodicObjectList));
-	if (objEntry == NULL) return -1;
+	if (objEntry == NULL) {
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
+	}
 	objEntry->evInfo.ev.obj = ev->obj;
 	objEntry->evInfo.ev.instId = ev->instId;
 	objEntry->evInfo.ev.event = ev->event;
 	objEntry->evInfo.cb = cb;
 	objEntry->evInfo.queue = queue;
-    objEntry->updatePeriodMs = periodMs;
-    objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
-    // Add to list
-    LL_APPEND(objList, objEntry);
+	objEntry->updatePeriodMs = periodMs;
+	objEntry->slot = NULL;
+	// Add to lookup table and schedule
+	lookupHead = lookupSlot(ev, cb, queue);
+	objEntry->lookupNext = *lookupHead;
+	*lookupHead = objEntry;
+	wheelSchedule(objEntry, randomizePeriod(periodMs)); // avoid bunching of updates
 	// Release lock
 	PIOS_Recursive_Mutex_Unlock(mutex);
-    return 0;
+	return 0;
 }
 
 /**
@@ -261,25 +294,18 @@ static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	// Find object
-	LL_FOREACH(objList, objEntry)
+	objEntry = lookupEntry(ev, cb, queue);
+	if (objEntry == NULL)
 	{
-		if (objEntry->evInfo.cb == cb &&
-			objEntry->evInfo.queue == queue &&
-			objEntry->evInfo.ev.obj == ev->obj &&
-			objEntry->evInfo.ev.instId == ev->instId &&
-			objEntry->evInfo.ev.event == ev->event)
-		{
-			// Object found, update period
-			objEntry->updatePeriodMs = periodMs;
-			objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
-			// Release lock
-			PIOS_Recursive_Mutex_Unlock(mutex);
-			return 0;
-		}
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
 	}
-    // If this point is reached the object was not found
+	// Object found, update period
+	objEntry->updatePeriodMs = periodMs;
+	wheelSchedule(objEntry, randomizePeriod(periodMs)); // avoid bunching of updates
+	// Release lock
 	PIOS_Recursive_Mutex_Unlock(mutex);
-    return -1;
+	return 0;
 }
 
 /**
@@ -326,61 +352,242 @@ static void eventTask()
 }
 
 /**
- * Handle periodic updates for all objects.
- * \return The system time until the next update (in ms) or -1 if failed
+ * Handle the periodic updates that are due, ms by ms since the last call.
+ * Only the entries that expire and the ones that move closer to the first
+ * level of the wheel are touched.
+ * \return The system time of the next update (in ms)
  */
 static int32_t processPeriodicUpdates()
 {
 	PeriodicObjectList* objEntry;
-	int32_t timeNow;
-    int32_t timeToNextUpdate;
-    int32_t offset;
+	uint32_t timeNow;
+	uint32_t nextUpdate;
 
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-    // Iterate through each object and update its timer, if zero then transmit object.
-    // Also calculate smallest delay to next update.
-    timeToNextUpdate = PIOS_Thread_Systime() + MAX_UPDATE_PERIOD_MS;
-    LL_FOREACH(objList, objEntry)
-    {
-        // If object is configured for periodic updates
-        if (objEntry->updatePeriodMs > 0)
-        {
-            // Check if time for the next update
-        	timeNow = PIOS_Thread_Systime();
-            if (objEntry->timeToNextUpdateMs <= timeNow)
-            {
-                // Reset timer
-            	offset = ( timeNow - objEntry->timeToNextUpdateMs ) % objEntry->updatePeriodMs;
-            	objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
-    			// Invoke callback, if one
-    			if ( objEntry->evInfo.cb != 0)
-    			{
-    				objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
-    			}
-    			// Push event to queue, if one
-    			if ( objEntry->evInfo.queue != 0)
-    			{
-    				if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
-    				{
-						if (objEntry->evInfo.ev.obj != NULL)
-							stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
-    					++stats.eventErrors;
-    				}
-    			}
-            }
-            // Update minimum delay
-            if (objEntry->timeToNextUpdateMs < timeToNextUpdate)
-            {
-            	timeToNextUpdate = objEntry->timeToNextUpdateMs;
-            }
-        }
-    }
-
-    // Done
-    PIOS_Recursive_Mutex_Unlock(mutex);
-    return timeToNextUpdate;
+	timeNow = PIOS_Thread_Systime();
+	while ((int32_t)(timeNow - wheelTime) > 0)
+	{
+		uint32_t tick = wheelTime + 1;
+
+		// Move the events of the next block down into the ms slots before
+		// processing its first ms, and every so often the far away ones
+		if ((tick & WHEEL_MASK) == 0)
+		{
+			if ((tick & ((WHEEL_SLOTS << WHEEL_BITS) - 1)) == 0)
+				wheelCascade(&wheelOverflow);
+			wheelCascade(&wheelBlocks[(tick >> WHEEL_BITS) & WHEEL_MASK]);
+		}
+		wheelTime = tick;
+
+		// The entries of this slot are due now. An entry whose next update
+		// lands in the same slot again goes to the end of the list.
+		while ((objEntry = wheelMs[tick & WHEEL_MASK]) != NULL &&
+			(int32_t)(objEntry->nextUpdateMs - tick) <= 0)
+		{
+			dispatchPeriodic(objEntry, timeNow);
+		}
+	}
+
+	nextUpdate = wheelNextTime();
+
+	// Done
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return nextUpdate;
+}
+
+/**
+ * Invoke the callback or push the event of an entry that is due and schedule
+ * its next update, skipping the updates that were missed.
+ */
+static void dispatchPeriodic(PeriodicObjectList* objEntry, uint32_t timeNow)
+{
+	uint32_t offset;
+
+	// Reset timer
+	offset = (timeNow - objEntry->nextUpdateMs) % objEntry->updatePeriodMs;
+	wheelRemove(objEntry);
+	objEntry->nextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
+	wheelInsert(objEntry);
+
+	// Invoke callback, if one
+	if (objEntry->evInfo.cb != 0)
+	{
+		objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
+	}
+	// Push event to queue, if one
+	if (objEntry->evInfo.queue != 0)
+	{
+		if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
+		{
+			if (objEntry->evInfo.ev.obj != NULL)
+				stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
+			++stats.eventErrors;
+		}
+	}
+}
+
+/**
+ * (Re)start the periodic updates of an entry, or stop them if its period is zero.
+ * \param[in] objEntry The entry
+ * \param[in] delayMs Time to the first update
+ */
+static void wheelSchedule(PeriodicObjectList* objEntry, uint16_t delayMs)
+{
+	wheelRemove(objEntry);
+	if (objEntry->updatePeriodMs == 0)
+		return;
+
+	// An update that is due already happens the next ms
+	objEntry->nextUpdateMs = PIOS_Thread_Systime() + delayMs;
+	if ((int32_t)(objEntry->nextUpdateMs - wheelTime) <= 0)
+		objEntry->nextUpdateMs = wheelTime + 1;
+	wheelInsert(objEntry);
+}
+
+/**
+ * Add an entry to the wheel level that matches how far away its next update is
+ */
+static void wheelInsert(PeriodicObjectList* objEntry)
+{
+	uint32_t slot;
+	uint32_t due = objEntry->nextUpdateMs;
+
+	if (due - wheelTime <= WHEEL_SLOTS)
+	{
+		slot = due & WHEEL_MASK;
+		objEntry->slot = &wheelMs[slot];
+		wheelMsUsed |= (uint64_t)1 << slot;
+	}
+	else if ((due >> WHEEL_BITS) - (wheelTime >> WHEEL_BITS) <= WHEEL_SLOTS)
+	{
+		slot = (due >> WHEEL_BITS) & WHEEL_MASK;
+		objEntry->slot = &wheelBlocks[slot];
+		wheelBlocksUsed |= (uint64_t)1 << slot;
+	}
+	else
+	{
+		objEntry->slot = &wheelOverflow;
+	}
+	DL_APPEND(*objEntry->slot, objEntry);
+}
+
+/**
+ * Take an entry out of the wheel, if it is in it
+ */
+static void wheelRemove(PeriodicObjectList* objEntry)
+{
+	PeriodicObjectList** slot = objEntry->slot;
+
+	if (slot == NULL)
+		return;
+
+	DL_DELETE(*slot, objEntry);
+	objEntry->slot = NULL;
+	if (*slot == NULL)
+	{
+		if (slot >= wheelMs && slot < wheelMs + WHEEL_SLOTS)
+			wheelMsUsed &= ~((uint64_t)1 << (slot - wheelMs));
+		else if (slot >= wheelBlocks && slot < wheelBlocks + WHEEL_SLOTS)
+			wheelBlocksUsed &= ~((uint64_t)1 << (slot - wheelBlocks));
+	}
+}
+
+/**
+ * Insert the entries of a slot again, now that their updates got closer.
+ * The slot is emptied first, as an entry can go back into the same slot.
+ */
+static void wheelCascade(PeriodicObjectList** slot)
+{
+	PeriodicObjectList* objEntry;
+	PeriodicObjectList* moving = NULL;
+
+	while ((objEntry = *slot) != NULL)
+	{
+		wheelRemove(objEntry);
+		DL_APPEND(moving, objEntry);
+	}
+	while ((objEntry = moving) != NULL)
+	{
+		DL_DELETE(moving, objEntry);
+		wheelInsert(objEntry);
+	}
+}
+
+/**
+ * Index of the first set bit of a bitmap of wheel slots, starting from a slot
+ * and wrapping around, or -1 if none is set
+ */
+static int32_t firstUsedSlot(uint64_t used, uint32_t start)
+{
+	uint64_t rotated;
+
+	start &= WHEEL_MASK;
+	rotated = (used >> start) | (used << ((WHEEL_SLOTS - start) & WHEEL_MASK));
+	if (rotated == 0)
+		return -1;
+	return __builtin_ctzll(rotated);
+}
+
+/**
+ * The time the wheel next needs processing, which is the next update or the
+ * next time entries move down a level
+ */
+static uint32_t wheelNextTime()
+{
+	uint32_t nextTime = wheelTime + MAX_UPDATE_PERIOD_MS;
+	uint32_t nextBlock = (wheelTime >> WHEEL_BITS) + 1;
+	int32_t slot;
+
+	slot = firstUsedSlot(wheelMsUsed, wheelTime + 1);
+	if (slot >= 0)
+		return wheelTime + 1 + slot; // always before anything in the higher levels
+
+	slot = firstUsedSlot(wheelBlocksUsed, nextBlock);
+	if (slot >= 0 && (int32_t)(((nextBlock + slot) << WHEEL_BITS) - nextTime) < 0)
+		nextTime = (nextBlock + slot) << WHEEL_BITS;
+
+	if (wheelOverflow != NULL)
+	{
+		uint32_t nextOverflow = (wheelTime | ((WHEEL_SLOTS << WHEEL_BITS) - 1)) + 1;
+		if ((int32_t)(nextOverflow - nextTime) < 0)
+			nextTime = nextOverflow;
+	}
+
+	return nextTime;
+}
+
+/**
+ * The lookup table chain an event would be in
+ */
+static PeriodicObjectList** lookupSlot(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue)
+{
+	uintptr_t hash = (uintptr_t)ev->obj ^ (uintptr_t)cb ^ (uintptr_t)queue;
+	hash = (hash >> 2) ^ (hash >> 7) ^ ev->instId ^ ev->event;
+	return &lookup[hash & (LOOKUP_SLOTS - 1)];
+}
+
+/**
+ * Find the entry of a periodic event
+ * \return The entry or NULL if the event is not registered
+ */
+static PeriodicObjectList* lookupEntry(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue)
+{
+	PeriodicObjectList* objEntry;
+
+	for (objEntry = *lookupSlot(ev, cb, queue); objEntry != NULL; objEntry = objEntry->lookupNext)
+	{
+		if (objEntry->evInfo.cb == cb &&
+			objEntry->evInfo.queue == queue &&
+			objEntry->evInfo.ev.obj == ev->obj &&
+			objEntry->evInfo.ev.instId == ev->instId &&
+			objEntry->evInfo.ev.event == ev->event)
+		{
+			return objEntry;
+		}
+	}
+	return NULL;
 }
 
 /**
@@ -32,6 +32,7 @@
 #define UAVOBJECTMANAGER_H
 
 #include "pios_queue.h"
+#include "pios_semaphore.h"
 
 #define UAVOBJ_ALL_INSTANCES 0xFFFF
 #define UAVOBJ_MAX_INSTANCES 1000
@@ -126,6 +127,19 @@ typedef struct {
  */
 typedef void (*UAVObjEventCallback)(UAVObjEvent* ev);
 
+/**
+ * Event signal, for consumers that only need the latest value of an object. Instead
+ * of queueing a copy of each event the sequence number is incremented and the
+ * semaphore given. The consumer waits on the semaphore, reads the object and calls
+ * UAVObjSignalSkipped() to find out from the sequence number how many updates it
+ * missed.
+ */
+typedef struct {
+	struct pios_semaphore *sema;
+	volatile uint32_t sequence;
+	uint32_t handled;
+} UAVObjSignal;
+
 /**
  * Callback used to initialize the object fields to their default values.
  */
@@ -139,6 +153,7 @@ typedef struct {
 	uint32_t eventCallbackErrors;
 	uint32_t lastCallbackErrorID;
 	uint32_t lastQueueErrorID;
+	uint32_t signalSkips;
 } UAVObjStats;
 
 typedef void (*new_uavo_instance_cb_t)(uint32_t,uint32_t);
@@ -160,8 +175,10 @@ bool UAVObjIsMetaobject(UAVObjHandle obj);
 bool UAVObjIsSettings(UAVObjHandle obj);
 int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId, const uint8_t* dataIn);
 int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t* dataOut);
+uint32_t UAVObjGetDigest(UAVObjHandle obj_handle);
 int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId);
 int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId);
+int32_t UAVObjSaveBatch(const uint32_t obj_ids[], const uint16_t inst_ids[], uint8_t count, int8_t results[]);
 int32_t UAVObjDeleteById(uint32_t obj_id, uint16_t inst_id);
 #if defined(PIOS_INCLUDE_SDCARD)
 int32_t UAVObjSaveToFile(UAVObjHandle obj_handle, uint16_t instId, FILEINFO* file);
@@ -201,6 +218,9 @@ int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue, ui
 int32_t UAVObjDisconnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue);
 int32_t UAVObjConnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb, uint8_t eventMask);
 int32_t UAVObjDisconnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb);
+int32_t UAVObjConnectSignal(UAVObjHandle obj_handle, UAVObjSignal *signal, uint8_t eventMask);
+int32_t UAVObjDisconnectSignal(UAVObjHandle obj_handle, UAVObjSignal *signal);
+uint32_t UAVObjSignalSkipped(UAVObjSignal *signal);
 void UAVObjRequestUpdate(UAVObjHandle obj);
 void UAVObjRequestInstanceUpdate(UAVObjHandle obj_handle, uint16_t instId);
 void UAVObjUpdated(UAVObjHandle obj);
@@ -74,6 +74,8 @@ static inline int32_t $(NAME)ConnectQueue(struct pios_queue *queue) { return UAV
 
 static inline int32_t $(NAME)ConnectCallback(UAVObjEventCallback cb) { return UAVObjConnectCallback($(NAME)Handle(), cb, EV_MASK_ALL_UPDATES); }
 
+static inline int32_t $(NAME)ConnectSignal(UAVObjSignal *signal) { return UAVObjConnectSignal($(NAME)Handle(), signal, EV_MASK_ALL_UPDATES); }
+
 static inline uint16_t $(NAME)CreateInstance() { return UAVObjCreateInstance($(NAME)Handle(), &$(NAME)SetDefaults); }
 
 static inline void $(NAME)RequestUpdate() { UAVObjRequestUpdate($(NAME)Handle()); }
@@ -34,6 +34,7 @@
 #include "pios_heap.h"		/* PIOS_malloc_no_dma */
 #include "pios_mutex.h"
 #include "pios_queue.h"
+#include "pios_semaphore.h"
 
 extern uintptr_t pios_uavo_settings_fs_id;
 
@@ -54,6 +55,7 @@ typedef void* InstanceHandle;
 struct ObjectEventEntry {
 	struct pios_queue         *queue;
 	UAVObjEventCallback       cb;
+	UAVObjSignal              *signal;
 	uint8_t                   eventMask;
 	struct ObjectEventEntry * next;
 };
@@ -61,11 +63,15 @@ struct ObjectEventEntry {
 /*
   MetaInstance   == [UAVOBase [UAVObjMetadata]]
   SingleInstance == [UAVOBase [UAVOData [InstanceData]]]
-  MultiInstance  == [UAVOBase [UAVOData [NumInstances [InstanceData0 [next]]]]
-                                                  ____________________/
-                                                  \-->[InstanceData1 [next]]
-                                                  _________...________/
-                                                  \-->[InstanceDataN [next]]
+  MultiInstance  == [UAVOBase [UAVOData [NumInstances [NumBlocks [Blocks [InstanceData0]]]]]
+                                                                   |
+                                                                   \-->[Block0 [Block1 ... [BlockM]]]
+                                                                           |       |
+                                                                           |       \-->[InstanceData2 [InstanceData3]]
+                                                                           \-->[InstanceData1]
+
+  Block b holds the 2^b instances 2^b to 2^(b+1)-1, so an instance is found
+  with a count leading zeros and an offset into its block.
  */
 
 /*
@@ -116,22 +122,25 @@ struct UAVOSingle {
 	 */
 } __attribute__((packed));
 
-/* Part of a linked list of instances chained off of a multi instance UAVO. */
-struct UAVOMultiInst {
-	struct UAVOMultiInst * next;
-	uint8_t                instance[];
-	/* 
-	 * Additional space will be malloc'd here to hold the
-	 * the data for this instance.
-	 */
-} __attribute__((packed));
+/*
+ * Instances 1 and up of a multi instance object live in blocks. The first
+ * blocks double in size, block b holding instances 2^b to 2^(b+1)-1, up to
+ * INSTANCE_BLOCK_MAX instances. The following blocks all hold that many, so
+ * at most INSTANCE_BLOCK_MAX-1 unused instances are ever allocated.
+ */
+#define INSTANCE_BLOCK_LOG2 4
+#define INSTANCE_BLOCK_MAX (1 << INSTANCE_BLOCK_LOG2)
+#define INSTANCE_NUM_BLOCKS (INSTANCE_BLOCK_LOG2 + (UAVOBJ_MAX_INSTANCES - 1) / INSTANCE_BLOCK_MAX)
 
 /* Augmented type for Multi Instance Data UAVO */
 struct UAVOMulti {
 	struct UAVOData        uavo;
 
 	uint16_t               num_instances;
-	struct UAVOMultiInst   instance0;
+	/* Blocks holding instances 1 and up, allocated as they are needed */
+	uint8_t                num_blocks;
+	uint8_t              * blocks[INSTANCE_NUM_BLOCKS];
+	uint8_t                instance0[];
 	/*
 	 * Additional space will be malloc'd here to hold the
 	 * the data for instance 0.
@@ -148,7 +157,11 @@ struct UAVOMulti {
 
 /** all information about instances are dependant on object type **/
 #define ObjSingleInstanceDataOffset(obj) ((void*)(&(( (struct UAVOSingle*)obj )->instance0)))
-#define InstanceDataOffset(inst) ((void*)&(( (struct UAVOMultiInst*)inst )->instance))
+#define InstanceBlock(instId) ((instId) < INSTANCE_BLOCK_MAX ? 31 - __builtin_clz(instId) : \
+	INSTANCE_BLOCK_LOG2 - 1 + ((instId) >> INSTANCE_BLOCK_LOG2))
+#define InstanceBlockStart(block) ((block) < INSTANCE_BLOCK_LOG2 ? 1 << (block) : \
+	((block) - INSTANCE_BLOCK_LOG2 + 1) << INSTANCE_BLOCK_LOG2)
+#define InstanceBlockSize(block) ((block) < INSTANCE_BLOCK_LOG2 ? 1 << (block) : INSTANCE_BLOCK_MAX)
 #define InstanceData(instance) (void*)instance
 
 // Private functions
@@ -157,9 +170,9 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId);
 static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId);
 static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
-			UAVObjEventCallback cb, uint8_t eventMask);
+			UAVObjEventCallback cb, UAVObjSignal *signal, uint8_t eventMask);
 static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
-			UAVObjEventCallback cb);
+			UAVObjEventCallback cb, UAVObjSignal *signal);
 
 // Private variables
 static struct UAVOData * uavo_list;
@@ -283,8 +296,9 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
 	uavo_multi->num_instances = 1;
 
 	/* Clear the instance data carried in the UAVO */
-	uavo_multi->instance0.next = NULL;
-	memset (&(uavo_multi->instance0.instance), 0, num_bytes);
+	uavo_multi->num_blocks = 0;
+	memset(uavo_multi->blocks, 0, sizeof(uavo_multi->blocks));
+	memset (&(uavo_multi->instance0), 0, num_bytes);
 
 	/* Give back the generic UAVO part */
 	return (&(uavo_multi->uavo));
@@ -665,6 +679,38 @@ unlock_exit:
 	return rc;
 }
 
+/**
+ * Compute a CRC32 over the data of every instance of an object, used by
+ * the GCS to tell whether its cached copy is still current
+ * \param[in] obj The object handle
+ * \return The digest
+ */
+uint32_t UAVObjGetDigest(UAVObjHandle obj_handle)
+{
+	PIOS_Assert(obj_handle);
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	uint32_t crc = 0;
+
+	if (UAVObjIsMetaobject(obj_handle)) {
+		crc = PIOS_CRC32_updateCRC(crc,
+			(const uint8_t *) MetaDataPtr((struct UAVOMeta *)obj_handle), MetaNumBytes);
+	} else {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+		uint16_t numInstances = UAVObjGetNumInstances(obj_handle);
+
+		for (uint16_t instId = 0; instId < numInstances; instId++) {
+			crc = PIOS_CRC32_updateCRC(crc,
+				(const uint8_t *) InstanceData(getInstance(obj, instId)), obj->instance_size);
+		}
+	}
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return crc;
+}
+
 #if defined(PIOS_INCLUDE_FASTHEAP)
 /**
  * Trampoline buffer used for loads from the underlying filesystem.
@@ -836,6 +882,61 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 	return 0;
 }
 
+/**
+ * Save several objects in a single filesystem session, reading each one
+ * back to verify it. Used to save a whole set of settings at once.
+ * @param[in] obj_ids The object IDs
+ * @param[in] inst_ids The instance of each object
+ * @param[in] count The number of objects
+ * @param[out] results 0 for each object saved and verified, -1 otherwise
+ * @return 0 if every object was saved or -1 if any failed
+ */
+int32_t UAVObjSaveBatch(const uint32_t obj_ids[], const uint16_t inst_ids[], uint8_t count, int8_t results[])
+{
+	int32_t rc = 0;
+
+	for (uint8_t i = 0; i < count; i++)
+		results[i] = -1;
+
+	if (PIOS_FLASHFS_BeginSession(pios_uavo_settings_fs_id, count) != 0)
+		return -1;
+
+	for (uint8_t i = 0; i < count; i++) {
+		UAVObjHandle obj_handle = UAVObjGetByID(obj_ids[i]);
+		// Metaobjects keep their metadata as instance 0
+		InstanceHandle instEntry = obj_handle ?
+			getInstance((struct UAVOData *)obj_handle, inst_ids[i]) : NULL;
+		if (instEntry == NULL) {
+			rc = -1;
+			continue;
+		}
+
+		uint8_t *data = InstanceData(instEntry);
+		uint32_t obj_id = obj_ids[i];
+		uint16_t num_bytes = UAVObjGetNumBytes(obj_handle);
+
+#if defined(PIOS_INCLUDE_FASTHEAP)
+		memcpy(uavobj_save_trampoline, data, num_bytes);
+		if (PIOS_FLASHFS_SessionObjSave(pios_uavo_settings_fs_id, obj_id, inst_ids[i], uavobj_save_trampoline, num_bytes) == 0 &&
+			PIOS_FLASHFS_SessionObjLoad(pios_uavo_settings_fs_id, obj_id, inst_ids[i], uavobj_load_trampoline, num_bytes) == 0 &&
+			memcmp(uavobj_load_trampoline, data, num_bytes) == 0)
+			results[i] = 0;
+#else /* PIOS_INCLUDE_FASTHEAP */
+		// No spare buffer to compare against, read back in place as UAVObjLoad does
+		if (PIOS_FLASHFS_SessionObjSave(pios_uavo_settings_fs_id, obj_id, inst_ids[i], data, num_bytes) == 0 &&
+			PIOS_FLASHFS_SessionObjLoad(pios_uavo_settings_fs_id, obj_id, inst_ids[i], data, num_bytes) == 0)
+			results[i] = 0;
+#endif /* PIOS_INCLUDE_FASTHEAP */
+
+		if (results[i] != 0)
+			rc = -1;
+	}
+
+	PIOS_FLASHFS_EndSession(pios_uavo_settings_fs_id);
+
+	return rc;
+}
+
 /**
  * Delete an object from the file system (SD card).
  * @param[in] obj_id The object id
@@ -1507,7 +1608,7 @@ int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue,
 	PIOS_Assert(queue);
 	int32_t res;
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	res = connectObj(obj_handle, queue, 0, eventMask);
+	res = connectObj(obj_handle, queue, 0, 0, eventMask);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return res;
 }
@@ -1524,7 +1625,7 @@ int32_t UAVObjDisconnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue)
 	PIOS_Assert(queue);
 	int32_t res;
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	res = disconnectObj(obj_handle, queue, 0);
+	res = disconnectObj(obj_handle, queue, 0, 0);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return res;
 }
@@ -1543,7 +1644,7 @@ int32_t UAVObjConnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb,
 	PIOS_Assert(obj_handle);
 	int32_t res;
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	res = connectObj(obj_handle, 0, cb, eventMask);
+	res = connectObj(obj_handle, 0, cb, 0, eventMask);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return res;
 }
@@ -1559,11 +1660,77 @@ int32_t UAVObjDisconnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb
 	PIOS_Assert(obj_handle);
 	int32_t res;
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	res = disconnectObj(obj_handle, 0, cb);
+	res = disconnectObj(obj_handle, 0, cb, 0);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return res;
 }
 
+/**
+ * Connect an event signal to the object, if the signal is already connected then the event mask is only updated.
+ * Events matching the event mask increment the sequence number of the signal and give its semaphore, so unlike
+ * a queue the signal never overflows but only tells the consumer that the object has a newer value.
+ * \param[in] obj The object handle
+ * \param[in] signal The event signal, its semaphore must already be created
+ * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjConnectSignal(UAVObjHandle obj_handle, UAVObjSignal *signal,
+			uint8_t eventMask)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(signal && signal->sema);
+	int32_t res;
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	// A binary semaphore is created given, only wake up for actual events
+	PIOS_Semaphore_Take(signal->sema, 0);
+	signal->handled = signal->sequence;
+	res = connectObj(obj_handle, 0, 0, signal, eventMask);
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return res;
+}
+
+/**
+ * Disconnect an event signal from the object.
+ * \param[in] obj The object handle
+ * \param[in] signal The event signal
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjDisconnectSignal(UAVObjHandle obj_handle, UAVObjSignal *signal)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(signal);
+	int32_t res;
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	res = disconnectObj(obj_handle, 0, 0, signal);
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return res;
+}
+
+/**
+ * Account for the updates a signal consumer did not see. Call it after waking up, once the
+ * object has been read. The skipped updates are added to the signalSkips statistics counter.
+ * \param[in] signal The event signal
+ * eturn The number of updates that were replaced by a newer one before the consumer read them
+ */
+uint32_t UAVObjSignalSkipped(UAVObjSignal *signal)
+{
+	PIOS_Assert(signal);
+	uint32_t sequence = signal->sequence;
+	uint32_t skipped = sequence - signal->handled;
+
+	// A wakeup whose update was already read with an earlier one skips nothing
+	if (skipped == 0)
+		return 0;
+
+	signal->handled = sequence;
+	if (--skipped > 0) {
+		PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+		stats.signalSkips += skipped;
+		PIOS_Recursive_Mutex_Unlock(mutex);
+	}
+	return skipped;
+}
+
 /**
  * Request an update of the object's data from the GCS. The call will not wait for the response, a EV_UPDATED event
  * will be generated as soon as the object is updated.
@@ -1668,6 +1835,12 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 					stats.lastCallbackErrorID = UAVObjGetID(obj);
 				}
 			}
+
+			// Signal the consumer, a semaphore that is already given stays given
+			if (event->signal) {
+				event->signal->sequence++;
+				PIOS_Semaphore_Give(event->signal->sema);
+			}
 		}
 	}
 
@@ -1679,7 +1852,8 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
  */
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 {
-	struct UAVOMultiInst *instEntry;
+	struct UAVOMulti *uavo_multi = (struct UAVOMulti *) obj;
+	InstanceHandle instEntry = NULL;
 
 	/* Don't allow more than one instance for single instance objects */
 	if (UAVObjIsSingleInstance(&(obj->base))) {
@@ -1697,30 +1871,34 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 		return NULL;
 	}
 
-	// Create any missing instances (all instance IDs must be sequential)
-	for (uint16_t n = UAVObjGetNumInstances(&(obj->base)); n < instId; ++n) {
-		if (createInstance(obj, n) == NULL) {
-			return NULL;
+	// Create the instance and any missing ones before it (all instance IDs must be sequential)
+	while (uavo_multi->num_instances <= instId) {
+		uint16_t n = uavo_multi->num_instances;
+		uint8_t block = InstanceBlock(n);
+
+		/* The first instance of a block allocates room for the whole block */
+		if (block == uavo_multi->num_blocks) {
+			uavo_multi->blocks[block] = (uint8_t *) PIOS_malloc_no_dma(InstanceBlockSize(block) * obj->instance_size);
+			if (!uavo_multi->blocks[block])
+				return NULL;
+			uavo_multi->num_blocks++;
 		}
-	}
 
-	/* Create the actual instance */
-	instEntry = (struct UAVOMultiInst *) PIOS_malloc_no_dma(sizeof(struct UAVOMultiInst)+obj->instance_size);
-	if (!instEntry)
-		return NULL;
-	memset(InstanceDataOffset(instEntry), 0, obj->instance_size);
-	LL_APPEND(( (struct UAVOMulti*)obj )->instance0.next, instEntry);
+		instEntry = uavo_multi->blocks[block] + (n - InstanceBlockStart(block)) * obj->instance_size;
+		memset(instEntry, 0, obj->instance_size);
 
-	( (struct UAVOMulti*)obj )->num_instances++;
+		uavo_multi->num_instances++;
 
-	// Fire event
-	UAVObjInstanceUpdated((UAVObjHandle) obj, instId);
+		// Fire event
+		UAVObjInstanceUpdated((UAVObjHandle) obj, n);
 
-	// Done
-	if (newUavObjInstanceCB) {
-		newUavObjInstanceCB(obj->id, UAVObjGetNumInstances(obj));
+		if (newUavObjInstanceCB) {
+			newUavObjInstanceCB(obj->id, UAVObjGetNumInstances(obj));
+		}
 	}
-	return InstanceDataOffset(instEntry);
+
+	// Done
+	return instEntry;
 }
 
 /**
@@ -1754,17 +1932,12 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
 		if (instId >= uavo_multi->num_instances)
 			return NULL;
 
-		// Look for specified instance ID
-		uint16_t instance = 0;
-		struct UAVOMultiInst *instEntry;
-		LL_FOREACH(&(uavo_multi->instance0), instEntry) {
-			if (instance++ == instId) {
-				/* Found it */
-				return &(instEntry->instance);
-			}
-		}
-		/* Instance was not found */
-		return NULL;
+		if (instId == 0)
+			return (&(uavo_multi->instance0));
+
+		/* Find the block holding the instance and the offset within it */
+		uint8_t block = InstanceBlock(instId);
+		return uavo_multi->blocks[block] + (instId - InstanceBlockStart(block)) * obj->instance_size;
 	}
 }
 
@@ -1773,11 +1946,12 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
  * \param[in] obj The object handle
  * \param[in] queue The event queue
  * \param[in] cb The event callback
+ * \param[in] signal The event signal
  * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
  * \return 0 if success or -1 if failure
  */
 static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
-			UAVObjEventCallback cb, uint8_t eventMask)
+			UAVObjEventCallback cb, UAVObjSignal *signal, uint8_t eventMask)
 {
 	struct ObjectEventEntry *event;
 	struct UAVOBase *obj;
@@ -1785,7 +1959,7 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 	// Check that the queue is not already connected, if it is simply update event mask
 	obj = (struct UAVOBase *) obj_handle;
 	LL_FOREACH(obj->next_event, event) {
-		if (event->queue == queue && event->cb == cb) {
+		if (event->queue == queue && event->cb == cb && event->signal == signal) {
 			// Already connected, update event mask and return
 			event->eventMask = eventMask;
 			return 0;
@@ -1799,6 +1973,7 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 	}
 	event->queue = queue;
 	event->cb = cb;
+	event->signal = signal;
 	event->eventMask = eventMask;
 	LL_APPEND(obj->next_event, event);
 
@@ -1811,10 +1986,11 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
  * \param[in] obj The object handle
  * \param[in] queue The event queue
  * \param[in] cb The event callback
+ * \param[in] signal The event signal
  * \return 0 if success or -1 if failure
  */
 static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
-			UAVObjEventCallback cb)
+			UAVObjEventCallback cb, UAVObjSignal *signal)
 {
 	struct ObjectEventEntry *event;
 	struct UAVOBase *obj;
@@ -1823,7 +1999,8 @@ static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 	obj = (struct UAVOBase *) obj_handle;
 	LL_FOREACH(obj->next_event, event) {
 		if ((event->queue == queue
-				&& event->cb == cb)) {
+				&& event->cb == cb
+				&& event->signal == signal)) {
 			LL_DELETE(obj->next_event, event);
 			PIOS_free(event);
 			return 0;
@@ -1851,7 +2028,7 @@ int32_t getEventMask(UAVObjHandle obj_handle, struct pios_queue *queue)
 	// Iterate over the event listeners, looking for the event matching the queue
 	obj = (struct UAVOBase *) obj_handle;
 	LL_FOREACH(obj->next_event, event) {
-		if (event->queue == queue && event->cb == 0) {
+		if (event->queue == queue && event->cb == 0 && event->signal == 0) {
 			// Already connected, update event mask and return
 			eventMask = event->eventMask;
 			break;
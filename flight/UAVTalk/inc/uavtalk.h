@@ -43,11 +43,18 @@ typedef struct {
     uint32_t rxObjects;
     uint32_t txObjects;
     uint32_t txErrors;
+    uint32_t txRetries;
     uint32_t rxErrors;
 } UAVTalkStats;
 
 typedef void* UAVTalkConnection;
 
+//! Called when a pipelined transaction is answered (success) or runs out of attempts
+typedef void (*UAVTalkTransactionCallback)(UAVObjHandle obj, uint16_t instId, bool success, uint8_t retries);
+
+//! Returned by UAVTalkProcessTransactions when nothing is pending
+#define UAVTALK_NO_DEADLINE 0xffffffff
+
 typedef enum {UAVTALK_STATE_ERROR=0, UAVTALK_STATE_SYNC, UAVTALK_STATE_TYPE, UAVTALK_STATE_SIZE, UAVTALK_STATE_OBJID, UAVTALK_STATE_INSTID, UAVTALK_STATE_TIMESTAMP, UAVTALK_STATE_DATA, UAVTALK_STATE_CS, UAVTALK_STATE_COMPLETE} UAVTalkRxState;
 
 // Public functions
@@ -57,11 +64,16 @@ UAVTalkOutputStream UAVTalkGetOutputStream(UAVTalkConnection connection);
 int32_t UAVTalkSendObject(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
 int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
 int32_t UAVTalkSendObjectRequest(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, int32_t timeoutMs);
+int32_t UAVTalkConfigureTransactions(UAVTalkConnection connection, uint32_t timeoutMs, uint8_t maxAttempts, UAVTalkTransactionCallback callback);
+int32_t UAVTalkSendObjectAsync(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, uint8_t acked);
+int32_t UAVTalkSendObjectRequestAsync(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId);
+uint32_t UAVTalkProcessTransactions(UAVTalkConnection connection);
 int32_t UAVTalkSendAck(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId);
 int32_t UAVTalkSendNack(UAVTalkConnection connectionHandle, uint32_t objId);
 int32_t UAVTalkSendBuf(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_t len);
 UAVTalkRxState UAVTalkProcessInputStream(UAVTalkConnection connection, uint8_t rxbyte);
 UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connection, uint8_t rxbyte);
+UAVTalkRxState UAVTalkProcessInputBuffer(UAVTalkConnection connection, const uint8_t *data, uint32_t length);
 UAVTalkRxState UAVTalkRelayInputStream(UAVTalkConnection connectionHandle, uint8_t rxbyte);
 void UAVTalkGetStats(UAVTalkConnection connection, UAVTalkStats *stats);
 void UAVTalkResetStats(UAVTalkConnection connection);
@@ -80,6 +80,20 @@ typedef struct {
     uint16_t rxPacketLength;
 } UAVTalkInputProcessor;
 
+//! Number of acked sends and requests that can be outstanding at once
+#ifndef UAVTALK_MAX_TRANSACTIONS
+#define UAVTALK_MAX_TRANSACTIONS        8
+#endif
+
+//! A pending acked send or object request, free when obj is zero
+typedef struct {
+    UAVObjHandle obj;
+    uint16_t instId;
+    uint8_t type;
+    uint8_t attempts;
+    uint32_t deadline;
+} UAVTalkTransaction;
+
 //! Information for the physical link
 typedef struct {
     uint8_t canari;
@@ -89,6 +103,10 @@ typedef struct {
     struct pios_semaphore *respSema;
     UAVObjHandle respObj;
     uint16_t respInstId;
+    UAVTalkTransaction transactions[UAVTALK_MAX_TRANSACTIONS];
+    uint32_t transTimeoutMs;
+    uint8_t transMaxAttempts;
+    UAVTalkTransactionCallback transCallback;
     UAVTalkStats stats;
     UAVTalkInputProcessor iproc;
     uint8_t *rxBuffer;
@@ -45,6 +45,10 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId);
 static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, uint8_t* data, int32_t length);
 static void updateAck(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static void receivePacket(UAVTalkConnectionData *connection);
+static int32_t startTransaction(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
+static void completeTransactions(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type, bool success);
+static void finishTransaction(UAVTalkConnectionData *connection, UAVTalkTransaction *trans, bool success);
 
 /**
  * Initialize the UAVTalk library
@@ -73,6 +77,10 @@ UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream)
 	if (!connection->txBuffer) return 0;
 	connection->respSema = PIOS_Semaphore_Create();
 	PIOS_Semaphore_Take(connection->respSema, 0); // reset to zero
+	memset(connection->transactions, 0, sizeof(connection->transactions));
+	connection->transTimeoutMs = 250;
+	connection->transMaxAttempts = 2;
+	connection->transCallback = NULL;
 	UAVTalkResetStats( (UAVTalkConnection) connection );
 	return (UAVTalkConnection) connection;
 }
@@ -234,6 +242,211 @@ int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjH
 	}
 }
 
+/**
+ * Configure the transactions started by UAVTalkSendObjectAsync() and
+ * UAVTalkSendObjectRequestAsync().
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] timeoutMs Time to wait for the response before sending again
+ * \param[in] maxAttempts Number of times a transaction is sent before it fails
+ * \param[in] callback Called with the outcome of every transaction, can be NULL
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkConfigureTransactions(UAVTalkConnection connectionHandle, uint32_t timeoutMs, uint8_t maxAttempts, UAVTalkTransactionCallback callback)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	if (maxAttempts == 0)
+		return -1;
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	connection->transTimeoutMs = timeoutMs;
+	connection->transMaxAttempts = maxAttempts;
+	connection->transCallback = callback;
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return 0;
+}
+
+/**
+ * Send the specified object without waiting for the ack. An acked send stays
+ * in the transaction table until the ack arrives or it runs out of attempts,
+ * so that several of them can be outstanding at the same time. The outcome is
+ * reported to the callback set with UAVTalkConfigureTransactions() and the
+ * failures and retries are counted in the statistics.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to send
+ * \param[in] instId The instance ID or UAVOBJ_ALL_INSTANCES for all instances.
+ * \param[in] acked Selects if an ack is required (1:ack required, 0: ack not required)
+ * \return 0 Success
+ * \return 1 The transaction table is full, the object was sent without an ack
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectAsync(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint8_t acked)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	if (acked == 1)
+	{
+		return startTransaction(connection, obj, instId, UAVTALK_TYPE_OBJ_ACK);
+	}
+	else
+	{
+		return objectTransaction(connection, obj, instId, UAVTALK_TYPE_OBJ, 0);
+	}
+}
+
+/**
+ * Request an update for the specified object without waiting for it, see
+ * UAVTalkSendObjectAsync().
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to update
+ * \param[in] instId The instance ID or UAVOBJ_ALL_INSTANCES for all instances.
+ * \return 0 Success
+ * \return 1 The transaction table is full, the request was sent once without retries
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectRequestAsync(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+	return startTransaction(connection, obj, instId, UAVTALK_TYPE_OBJ_REQ);
+}
+
+/**
+ * Send again the transactions whose response is overdue and fail the ones
+ * that ran out of attempts. Call it from the transmit task whenever the time
+ * it returns has passed.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return Time in ms until the next transaction is due, or UAVTALK_NO_DEADLINE when none is pending
+ */
+uint32_t UAVTalkProcessTransactions(UAVTalkConnection connectionHandle)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return UAVTALK_NO_DEADLINE);
+
+	uint32_t next = UAVTALK_NO_DEADLINE;
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	uint32_t now = PIOS_Thread_Systime();
+	for (int i = 0; i < UAVTALK_MAX_TRANSACTIONS; i++) {
+		UAVTalkTransaction *trans = &connection->transactions[i];
+		if (trans->obj == 0)
+			continue;
+
+		int32_t remaining = (int32_t)(trans->deadline - now);
+		if (remaining <= 0) {
+			if (trans->attempts >= connection->transMaxAttempts) {
+				finishTransaction(connection, trans, false);
+				continue;
+			}
+			// Sends the current data, which may be newer than the lost one
+			trans->attempts++;
+			trans->deadline = now + connection->transTimeoutMs;
+			sendObject(connection, trans->obj, trans->instId, trans->type);
+			remaining = connection->transTimeoutMs;
+		}
+
+		if ((uint32_t)remaining < next)
+			next = remaining;
+	}
+
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return next;
+}
+
+/**
+ * Send an object or request and add it to the transaction table. A transaction
+ * that is still pending for the same object is restarted with the new data
+ * instead of taking another entry. When the table is full the update is not
+ * dropped, it is sent once without waiting for the response.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object
+ * \param[in] instId The instance ID of UAVOBJ_ALL_INSTANCES for all instances.
+ * \param[in] type UAVTALK_TYPE_OBJ_ACK or UAVTALK_TYPE_OBJ_REQ
+ * \return 0 Success
+ * \return 1 The transaction table is full, sent without a transaction
+ */
+static int32_t startTransaction(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type)
+{
+	UAVTalkTransaction *trans = NULL;
+	UAVTalkTransaction *unused = NULL;
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	for (int i = 0; i < UAVTALK_MAX_TRANSACTIONS; i++) {
+		UAVTalkTransaction *t = &connection->transactions[i];
+		if (t->obj == obj && t->instId == instId && t->type == type) {
+			trans = t;
+			break;
+		}
+		if (t->obj == 0 && unused == NULL)
+			unused = t;
+	}
+
+	if (trans == NULL)
+		trans = unused;
+
+	if (trans == NULL) {
+		sendObject(connection, obj, instId, type == UAVTALK_TYPE_OBJ_ACK ? UAVTALK_TYPE_OBJ : type);
+		PIOS_Recursive_Mutex_Unlock(connection->lock);
+		return 1;
+	}
+
+	trans->obj = obj;
+	trans->instId = instId;
+	trans->type = type;
+	trans->attempts = 1;
+	trans->deadline = PIOS_Thread_Systime() + connection->transTimeoutMs;
+
+	// A failed send is taken care of by the retries
+	sendObject(connection, obj, instId, type);
+
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return 0;
+}
+
+/**
+ * Finish the pending transactions that a received message answers
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object of the received message
+ * \param[in] instId The instance ID of UAVOBJ_ALL_INSTANCES for all instances.
+ * \param[in] type Type of the transactions that are answered, 0 for any type
+ * \param[in] success False when the GCS refused the transactions
+ */
+static void completeTransactions(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type, bool success)
+{
+	for (int i = 0; i < UAVTALK_MAX_TRANSACTIONS; i++) {
+		UAVTalkTransaction *trans = &connection->transactions[i];
+		if (trans->obj == obj && (type == 0 || trans->type == type) &&
+			(trans->instId == instId || trans->instId == UAVOBJ_ALL_INSTANCES || instId == UAVOBJ_ALL_INSTANCES)) {
+			finishTransaction(connection, trans, success);
+		}
+	}
+}
+
+/**
+ * Free a transaction table entry, count and report its outcome. Called with
+ * the connection lock held.
+ */
+static void finishTransaction(UAVTalkConnectionData *connection, UAVTalkTransaction *trans, bool success)
+{
+	UAVObjHandle obj = trans->obj;
+	trans->obj = 0;
+
+	connection->stats.txRetries += trans->attempts - 1;
+	if (!success)
+		connection->stats.txErrors++;
+
+	if (connection->transCallback)
+		connection->transCallback(obj, trans->instId, success, trans->attempts - 1);
+}
+
 /**
  * Execute the requested transaction on an object.
  * \param[in] connection UAVTalkConnection to be used
@@ -555,11 +768,78 @@ UAVTalkRxState UAVTalkProcessInputStream(UAVTalkConnection connectionHandle, uin
 	{
 		UAVTalkConnectionData *connection;
 		CHECKCONHANDLE(connectionHandle,connection,return -1);
-		UAVTalkInputProcessor *iproc = &connection->iproc;
 
-		PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
-		receiveObject(connection, iproc->type, iproc->objId, iproc->instId, connection->rxBuffer, iproc->length);
-		PIOS_Recursive_Mutex_Unlock(connection->lock);
+		receivePacket(connection);
+	}
+
+	return state;
+}
+
+/**
+ * Process a buffer of bytes from the telemetry stream. Every complete packet
+ * is received as by UAVTalkProcessInputStream(). Bytes outside of a packet
+ * are skipped up to the next sync byte and the payload of a packet is copied
+ * and added to the CRC as one span, only the header goes through the state
+ * machine byte by byte.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] data Received bytes
+ * \param[in] length Number of received bytes
+ * \return UAVTalkRxState after the last byte
+ */
+UAVTalkRxState UAVTalkProcessInputBuffer(UAVTalkConnection connectionHandle, const uint8_t *data, uint32_t length)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	UAVTalkInputProcessor *iproc = &connection->iproc;
+	UAVTalkRxState state = iproc->state;
+	uint32_t pos = 0;
+
+	while (pos < length)
+	{
+		uint32_t span = length - pos;
+
+		if (iproc->state == UAVTALK_STATE_ERROR || iproc->state == UAVTALK_STATE_COMPLETE ||
+				iproc->state == UAVTALK_STATE_SYNC)
+		{
+			// Skip to the next sync byte
+			const uint8_t *sync = memchr(&data[pos], UAVTALK_SYNC_VAL, span);
+			if (sync != &data[pos])
+			{
+				if (sync)
+					span = sync - &data[pos];
+				connection->stats.rxBytes += span;
+				iproc->state = UAVTALK_STATE_SYNC;
+				state = iproc->state;
+				pos += span;
+				continue;
+			}
+		}
+		else if (iproc->state == UAVTALK_STATE_DATA)
+		{
+			// Take as much of the payload as there is
+			if (span > iproc->length - iproc->rxCount)
+				span = iproc->length - iproc->rxCount;
+
+			memcpy(&connection->rxBuffer[iproc->rxCount], &data[pos], span);
+			iproc->cs = PIOS_CRC_updateCRC(iproc->cs, &data[pos], span);
+			iproc->rxCount += span;
+			iproc->rxPacketLength += span;
+			connection->stats.rxBytes += span;
+			pos += span;
+
+			if (iproc->rxCount >= iproc->length)
+			{
+				iproc->state = UAVTALK_STATE_CS;
+				iproc->rxCount = 0;
+			}
+			state = iproc->state;
+			continue;
+		}
+
+		state = UAVTalkProcessInputStreamQuiet(connectionHandle, data[pos++]);
+		if (state == UAVTALK_STATE_COMPLETE)
+			receivePacket(connection);
 	}
 
 	return state;
@@ -632,6 +912,19 @@ UAVTalkRxState UAVTalkRelayInputStream(UAVTalkConnection connectionHandle, uint8
 	return state;
 }
 
+/**
+ * Hand a complete packet from the receive state machine to receiveObject()
+ * \param[in] connection UAVTalkConnection to be used
+ */
+static void receivePacket(UAVTalkConnectionData *connection)
+{
+	UAVTalkInputProcessor *iproc = &connection->iproc;
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	receiveObject(connection, iproc->type, iproc->objId, iproc->instId, connection->rxBuffer, iproc->length);
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+}
+
 /**
  * Send a ACK through the telemetry link.
  * \param[in] connectionHandle UAVTalkConnection to be used
@@ -741,6 +1034,7 @@ static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, ui
 				UAVObjUnpack(obj, instId, data);
 				// Check if an ack is pending
 				updateAck(connection, obj, instId);
+				completeTransactions(connection, obj, instId, UAVTALK_TYPE_OBJ_REQ, true);
 			}
 			else
 			{
@@ -779,7 +1073,10 @@ static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, ui
 				sendObject(connection, obj, instId, UAVTALK_TYPE_OBJ);
 			break;
 		case UAVTALK_TYPE_NACK:
-			// Do nothing on flight side, let it time out.
+			// The GCS does not know the object, fail the pipelined transactions
+			// right away and let a blocking one time out.
+			if (obj)
+				completeTransactions(connection, obj, UAVOBJ_ALL_INSTANCES, 0, false);
 			break;
 		case UAVTALK_TYPE_ACK:
 			// All instances, not allowed for ACK messages
@@ -787,6 +1084,7 @@ static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, ui
 			{
 				// Check if an ack is pending
 				updateAck(connection, obj, instId);
+				completeTransactions(connection, obj, instId, UAVTALK_TYPE_OBJ_ACK, true);
 			}
 			else
 			{
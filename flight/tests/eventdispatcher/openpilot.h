@@ -0,0 +1,7 @@
+/* Only the parts of openpilot.h that the event dispatcher uses */
+#include <pios.h>
+
+#include "utlist.h"
+#include "uavobjectmanager.h"
+#include "eventdispatcher.h"
+#include "taskmonitor.h"
@@ -0,0 +1,16 @@
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <pios_heap.h>
+#include <pios_mutex.h>
+#include <pios_queue.h>
+#include <pios_thread.h>
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
@@ -0,0 +1,4 @@
+/* Normally generated from the object definitions */
+typedef enum {
+	TASKINFO_RUNNING_EVENTDISPATCHER,
+} TaskInfoRunningElem;
@@ -0,0 +1,245 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* malloc */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <setjmp.h>		/* setjmp */
+#include <time.h>		/* clock */
+
+extern "C" {
+
+#include "openpilot.h"
+
+}
+
+/*
+ * The event task runs for real on a fake clock: every time it waits on its
+ * queue the clock jumps ahead by the time it asked to wait. The task never
+ * returns, so once the test has run long enough the wait jumps back out of it.
+ */
+
+#define MAX_EVENTS 500
+
+static uint32_t systime;
+static uint32_t endTime;
+static jmp_buf taskExit;
+static void (*eventTask)(void *);
+static uint32_t wakeups;
+
+struct EventRecord {
+	uint16_t periodMs;
+	uint32_t count;
+	uint32_t firstMs;
+	uint32_t lastMs;
+	uint32_t maxError; /* Largest deviation of an interval from the period */
+};
+
+static EventRecord records[MAX_EVENTS];
+
+extern "C" {
+
+static struct pios_recursive_mutex fakeMutex;
+static struct pios_queue fakeQueue;
+static struct pios_thread fakeThread;
+
+struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void) { return &fakeMutex; }
+bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *, uint32_t) { return true; }
+bool PIOS_Recursive_Mutex_Unlock(struct pios_recursive_mutex *) { return true; }
+uint32_t PIOS_Thread_Systime(void) { return systime; }
+void *PIOS_malloc(size_t size) { return malloc(size); }
+struct pios_queue *PIOS_Queue_Create(size_t, size_t) { return &fakeQueue; }
+bool PIOS_Queue_Send(struct pios_queue *, const void *, uint32_t) { return true; }
+int32_t TaskMonitorAdd(TaskInfoRunningElem, struct pios_thread *) { return 0; }
+uint32_t UAVObjGetID(UAVObjHandle) { return 0; }
+
+struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *, size_t, void *, enum pios_thread_prio_e)
+{
+	eventTask = fp;
+	return &fakeThread;
+}
+
+bool PIOS_Queue_Receive(struct pios_queue *, void *, uint32_t timeout_ms)
+{
+	wakeups++;
+	systime += timeout_ms;
+	if ((int32_t)(systime - endTime) >= 0)
+		longjmp(taskExit, 1);
+	return false;
+}
+
+}
+
+static void periodicCallback(UAVObjEvent *ev)
+{
+	EventRecord *record = &records[ev->instId];
+
+	if (record->count == 0) {
+		record->firstMs = systime;
+	} else {
+		uint32_t interval = systime - record->lastMs;
+		uint32_t error = interval > record->periodMs ? interval - record->periodMs : record->periodMs - interval;
+		if (error > record->maxError)
+			record->maxError = error;
+	}
+	record->lastMs = systime;
+	record->count++;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class EventDispatcherPeriodic : public testing::Test {
+protected:
+	virtual void SetUp() {
+		systime = 1000;
+		memset(records, 0, sizeof(records));
+		ASSERT_EQ(0, EventDispatcherInitialize());
+		ASSERT_TRUE(eventTask != NULL);
+	}
+
+	int32_t create(uint16_t n, uint16_t periodMs) {
+		UAVObjEvent ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.instId = n;
+		ev.event = EV_UPDATED_PERIODIC;
+		records[n].periodMs = periodMs;
+		return EventPeriodicCallbackCreate(&ev, periodicCallback, periodMs);
+	}
+
+	int32_t update(uint16_t n, uint16_t periodMs) {
+		UAVObjEvent ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.instId = n;
+		ev.event = EV_UPDATED_PERIODIC;
+		records[n].periodMs = periodMs;
+		records[n].count = 0;
+		records[n].maxError = 0;
+		return EventPeriodicCallbackUpdate(&ev, periodicCallback, periodMs);
+	}
+
+	// Let the event task run until the clock reaches the given time
+	void runUntil(uint32_t time) {
+		endTime = time;
+		if (setjmp(taskExit) == 0)
+			eventTask(NULL);
+	}
+};
+
+TEST_F(EventDispatcherPeriodic, RegistersOnce) {
+	EXPECT_EQ(0, create(0, 100));
+	EXPECT_EQ(-1, create(0, 100));
+	EXPECT_EQ(0, create(1, 100));
+	EXPECT_EQ(0, update(1, 50));
+	EXPECT_EQ(-1, update(2, 50));
+}
+
+TEST_F(EventDispatcherPeriodic, FiresOnTime) {
+	const uint32_t duration = 20000;
+
+	// Short ones that only use the first level of the wheel, ones that
+	// cascade down from the second and ones that start in the overflow list
+	for (uint16_t n = 0; n < MAX_EVENTS; n++) {
+		uint16_t period;
+		if (n % 10 == 0)
+			period = 5000 + n * 7;
+		else if (n % 3 == 0)
+			period = 1 + n % 64;
+		else
+			period = 65 + (n * 37) % 3000;
+		ASSERT_EQ(0, create(n, period));
+	}
+
+	uint32_t start = systime;
+	runUntil(start + duration);
+
+	for (uint16_t n = 0; n < MAX_EVENTS; n++) {
+		EventRecord *record = &records[n];
+		// The first update comes at a random time within the first period
+		ASSERT_GT(record->count, 0U) << "event " << n << " period " << record->periodMs;
+		EXPECT_LE(record->firstMs - start, (uint32_t)record->periodMs) << "event " << n;
+		EXPECT_EQ(0U, record->maxError) << "event " << n << " period " << record->periodMs;
+		EXPECT_EQ((start + duration - 1 - record->firstMs) / record->periodMs + 1, record->count) << "event " << n;
+	}
+}
+
+TEST_F(EventDispatcherPeriodic, FollowsPeriodUpdates) {
+	ASSERT_EQ(0, create(0, 100));
+	ASSERT_EQ(0, create(1, 250));
+	runUntil(systime + 1000);
+	EXPECT_GE(records[0].count, 9U);
+
+	ASSERT_EQ(0, update(0, 7));
+	ASSERT_EQ(0, update(1, 0));
+	runUntil(systime + 700);
+	EXPECT_GE(records[0].count, 99U);
+	EXPECT_EQ(0U, records[0].maxError);
+	EXPECT_EQ(0U, records[1].count);
+}
+
+TEST_F(EventDispatcherPeriodic, DispatchCostPerTick) {
+	const uint32_t duration = 600000;
+	double cost[2];
+	uint32_t ticks[2];
+
+	// Ten fast events, first alone and then with 490 slow ones registered
+	for (int round = 0; round < 2; round++) {
+		SetUp();
+		for (uint16_t n = 0; n < 10; n++)
+			ASSERT_EQ(0, create(n, 10 + n));
+		if (round == 1) {
+			for (uint16_t n = 10; n < MAX_EVENTS; n++)
+				ASSERT_EQ(0, create(n, 1000 + n * 100));
+		}
+
+		wakeups = 0;
+		clock_t cpuStart = clock();
+		runUntil(systime + duration);
+		cost[round] = (double)(clock() - cpuStart) / CLOCKS_PER_SEC * 1e9 / wakeups;
+		ticks[round] = wakeups;
+	}
+
+	printf("10 events: %u wakeups, %.0f ns each; 500 events: %u wakeups, %.0f ns each\n",
+		ticks[0], cost[0], ticks[1], cost[1]);
+
+	// The slow events add a few wakeups of their own, but a wakeup does not
+	// get more expensive because of them
+	EXPECT_LT(ticks[1], ticks[0] * 2);
+	EXPECT_LT(cost[1], cost[0] * 4);
+}
+
+/**
+ * @}
+ * @}
+ */
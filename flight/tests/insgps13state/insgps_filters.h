@@ -0,0 +1,97 @@
+/**
+ ******************************************************************************
+ * @file       insgps_filters.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Several builds of the INSGPS filter to compare against each other
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef INSGPS_FILTERS_H
+#define INSGPS_FILTERS_H
+
+#include "insgps.h"
+
+//! The public interface of one build of the filter, so the test can run several side by side
+struct insgps_filter {
+	void (*init)(void);
+	void (*state_prediction)(const float gyro_data[3], const float accel_data[3], float dT);
+	void (*covariance_prediction)(float dT);
+	void (*correction)(const float mag_data[3], const float Pos[3], const float Vel[3], float BaroAlt, uint16_t SensorsUsed);
+	void (*get_state)(float *pos, float *vel, float *attitude, float *bias);
+	void (*get_variance)(float *p);
+	void (*reset_p)(const float PDiag[13]);
+	void (*set_state)(const float pos[3], const float vel[3], const float q[4], const float gyro_bias[3], const float accel_bias[3]);
+	void (*set_pos_vel_var)(float PosVar, float VelVar, float VertPosVar);
+	void (*set_accel_var)(const float accel_var[3]);
+	void (*set_gyro_var)(const float gyro_var[3]);
+	void (*set_mag_north)(const float B[3]);
+	void (*set_mag_var)(const float scaled_mag_var[3]);
+	void (*set_baro_var)(float baro_var);
+	void (*pos_vel_reset)(const float pos[3], const float vel[3]);
+};
+
+//! The library as built for debug builds (GENERAL_COV)
+extern const struct insgps_filter insgps_general;
+
+//! The filter before the packed covariance, as built for flight
+extern const struct insgps_filter insgps_reference;
+
+//! The filter before the packed covariance, as built for debug builds (GENERAL_COV)
+extern const struct insgps_filter insgps_reference_general;
+
+/*
+ * insgps13state_reference.inc is an unmodified copy of the old
+ * flight/Libraries/insgps13state.c. The builds other than the library itself
+ * rename the public functions with REF() so that they don't clash.
+ */
+#if defined(REF)
+#define ins_get_num_states REF(ins_get_num_states)
+#define INSGPSInit REF(INSGPSInit)
+#define INSStatePrediction REF(INSStatePrediction)
+#define INSCovariancePrediction REF(INSCovariancePrediction)
+#define INSCorrection REF(INSCorrection)
+#define INSGetState REF(INSGetState)
+#define INSGetVariance REF(INSGetVariance)
+#define INSResetP REF(INSResetP)
+#define INSSetState REF(INSSetState)
+#define INSSetPosVelVar REF(INSSetPosVelVar)
+#define INSSetGyroBias REF(INSSetGyroBias)
+#define INSSetAccelVar REF(INSSetAccelVar)
+#define INSSetGyroVar REF(INSSetGyroVar)
+#define INSSetMagVar REF(INSSetMagVar)
+#define INSSetBaroVar REF(INSSetBaroVar)
+#define INSSetMagNorth REF(INSSetMagNorth)
+#define INSPosVelReset REF(INSPosVelReset)
+
+#define INSGPS_FILTER { \
+	INSGPSInit, INSStatePrediction, INSCovariancePrediction, INSCorrection, \
+	INSGetState, INSGetVariance, INSResetP, INSSetState, INSSetPosVelVar, \
+	INSSetAccelVar, INSSetGyroVar, INSSetMagNorth, INSSetMagVar, INSSetBaroVar, \
+	INSPosVelReset, }
+#endif /* REF */
+
+#endif /* INSGPS_FILTERS_H */
+
+/**
+ * @}
+ * @}
+ */
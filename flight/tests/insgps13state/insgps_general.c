@@ -0,0 +1,38 @@
+/**
+ ******************************************************************************
+ * @file       insgps_general.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief The library built with the compact covariance prediction of debug builds
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#define GENERAL_COV
+#define REF(name) general_##name
+#include "insgps_filters.h"
+#include "insgps13state.c"
+
+const struct insgps_filter insgps_general = INSGPS_FILTER;
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,346 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* fabs */
+#include <time.h>		/* clock */
+
+extern "C" {
+
+#include "insgps_filters.h"
+#include "physical_constants.h"
+
+}
+
+static const struct insgps_filter insgps_packed = {
+	INSGPSInit, INSStatePrediction, INSCovariancePrediction, INSCorrection,
+	INSGetState, INSGetVariance, INSResetP, INSSetState, INSSetPosVelVar,
+	INSSetAccelVar, INSSetGyroVar, INSSetMagNorth, INSSetMagVar, INSSetBaroVar,
+	INSPosVelReset,
+};
+
+/*
+ * A recording of a simulated flight: the vehicle weaves around while rolling,
+ * pitching and turning, sampled at the attitude loop rate with noisy
+ * gyros and accels, magnetometer and baro at 50 Hz and GPS at 5 Hz.
+ * It is generated deterministically so that every filter sees exactly the
+ * same sensor data.
+ */
+
+#define SIM_DT 0.002f
+#define MAG_PERIOD 10
+#define BARO_PERIOD 10
+#define GPS_PERIOD 100
+
+struct SensorFrame {
+	float gyro[3];
+	float accel[3];
+	float mag[3];
+	float pos[3];
+	float vel[3];
+	float baro;
+	uint16_t sensors;
+	float attitude[4];	/* True attitude after this frame, to check the filter against */
+};
+
+class FlightRecording {
+public:
+	FlightRecording(uint32_t numFrames) : numFrames(numFrames), seed(20141018) {
+		frames = new SensorFrame[numFrames];
+
+		const double Be[3] = { 0.43, 0.05, 0.90 };
+		const double gyroBias[3] = { 0.02, -0.01, 0.015 };
+		double q[4] = { 1, 0, 0, 0 };
+		double pos[3] = { 0, 0, 0 };
+		double vel[3] = { 0, 0, 0 };
+
+		for (uint32_t n = 0; n < numFrames; n++) {
+			double t = n * SIM_DT;
+			double w[3] = { 0.6 * sin(0.7 * t), 0.4 * cos(0.5 * t), 0.3 * sin(0.3 * t) + 0.1 };
+			double a[3] = { 1.5 * cos(0.2 * t), 1.5 * sin(0.25 * t), 0.3 * sin(0.5 * t) - GRAVITY };
+
+			// Body to earth rotation
+			double R[3][3] = {
+				{ q[0]*q[0] + q[1]*q[1] - q[2]*q[2] - q[3]*q[3], 2 * (q[1]*q[2] - q[0]*q[3]), 2 * (q[1]*q[3] + q[0]*q[2]) },
+				{ 2 * (q[1]*q[2] + q[0]*q[3]), q[0]*q[0] - q[1]*q[1] + q[2]*q[2] - q[3]*q[3], 2 * (q[2]*q[3] - q[0]*q[1]) },
+				{ 2 * (q[1]*q[3] - q[0]*q[2]), 2 * (q[2]*q[3] + q[0]*q[1]), q[0]*q[0] - q[1]*q[1] - q[2]*q[2] + q[3]*q[3] },
+			};
+
+			SensorFrame *frame = &frames[n];
+			memset(frame, 0, sizeof(*frame));
+			for (int i = 0; i < 3; i++) {
+				frame->gyro[i] = w[i] + gyroBias[i] + 0.005 * gauss();
+				frame->accel[i] = R[0][i] * a[0] + R[1][i] * a[1] + R[2][i] * a[2] + 0.05 * gauss();
+				frame->mag[i] = R[0][i] * Be[0] + R[1][i] * Be[1] + R[2][i] * Be[2] + 0.01 * gauss();
+				frame->pos[i] = pos[i] + (i < 2 ? 0.5 : 1.0) * gauss();
+				frame->vel[i] = vel[i] + 0.1 * gauss();
+			}
+			frame->baro = -pos[2] + 0.3 * gauss();
+
+			if (n % MAG_PERIOD == 0)
+				frame->sensors |= MAG_SENSORS;
+			if (n % BARO_PERIOD == 5)
+				frame->sensors |= BARO_SENSOR;
+			if (n % GPS_PERIOD == 50)
+				frame->sensors |= HORIZ_POS_SENSORS | HORIZ_VEL_SENSORS | VERT_VEL_SENSORS;
+
+			// Move on to the next sample
+			double qdot[4] = {
+				(-q[1] * w[0] - q[2] * w[1] - q[3] * w[2]) / 2,
+				(q[0] * w[0] - q[3] * w[1] + q[2] * w[2]) / 2,
+				(q[3] * w[0] + q[0] * w[1] - q[1] * w[2]) / 2,
+				(-q[2] * w[0] + q[1] * w[1] + q[0] * w[2]) / 2,
+			};
+			double qmag = 0;
+			for (int i = 0; i < 4; i++) {
+				q[i] += qdot[i] * SIM_DT;
+				qmag += q[i] * q[i];
+			}
+			for (int i = 0; i < 4; i++) {
+				q[i] /= sqrt(qmag);
+				frame->attitude[i] = q[i];
+			}
+			for (int i = 0; i < 3; i++) {
+				double accel = a[i] + (i == 2 ? GRAVITY : 0);
+				pos[i] += vel[i] * SIM_DT + accel * SIM_DT * SIM_DT / 2;
+				vel[i] += accel * SIM_DT;
+			}
+		}
+	}
+
+	~FlightRecording() {
+		delete[] frames;
+	}
+
+	// Start a filter the same way the attitude module does
+	void start(const struct insgps_filter *ins) {
+		const float accel_var[3] = { 0.01f, 0.01f, 0.01f };
+		const float gyro_var[3] = { 1e-5f, 1e-5f, 1e-4f };
+		const float mag_var[3] = { 0.005f, 0.005f, 0.05f };
+		const float Be[3] = { 0.43f, 0.05f, 0.90f };
+		const float Pdiag[13] = { 25.0f, 25.0f, 25.0f, 5.0f, 5.0f, 5.0f, 1e-5f, 1e-5f, 1e-5f, 1e-5f, 1e-5f, 1e-5f, 1e-5f };
+		const float zeros[3] = { 0, 0, 0 };
+		const float q[4] = { 1, 0, 0, 0 };
+
+		ins->init();
+		ins->set_mag_var(mag_var);
+		ins->set_accel_var(accel_var);
+		ins->set_gyro_var(gyro_var);
+		ins->set_baro_var(0.1f);
+		ins->reset_p(Pdiag);
+		ins->set_pos_vel_var(0.25f, 0.01f, 1.0f);
+		ins->set_mag_north(Be);
+		ins->set_state(zeros, zeros, q, zeros, zeros);
+	}
+
+	// Run one frame through a filter
+	void replay(const struct insgps_filter *ins, uint32_t n) {
+		const SensorFrame *frame = &frames[n];
+		ins->state_prediction(frame->gyro, frame->accel, SIM_DT);
+		ins->covariance_prediction(SIM_DT);
+		if (frame->sensors)
+			ins->correction(frame->mag, frame->pos, frame->vel, frame->baro, frame->sensors);
+	}
+
+	const SensorFrame *frame(uint32_t n) const {
+		return &frames[n];
+	}
+
+	const uint32_t numFrames;
+
+private:
+	double gauss() {
+		// Box-Muller on a fixed sequence of uniform numbers
+		double u1 = (next() + 1.0) / 4294967296.0;
+		double u2 = next() / 4294967296.0;
+		return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+	}
+
+	uint32_t next() {
+		seed = seed * 1664525 + 1013904223;
+		return seed;
+	}
+
+	SensorFrame *frames;
+	uint32_t seed;
+};
+
+struct FilterOutput {
+	float pos[3], vel[3], q[4], bias[3];
+	float var[13];
+
+	FilterOutput(const struct insgps_filter *ins) {
+		ins->get_state(pos, vel, q, bias);
+		ins->get_variance(var);
+	}
+};
+
+// Largest differences between two filters over a replay
+struct Divergence {
+	double pos, vel, q, bias, var;
+
+	Divergence() : pos(0), vel(0), q(0), bias(0), var(0) {}
+
+	void add(const FilterOutput &a, const FilterOutput &b) {
+		for (int i = 0; i < 3; i++) {
+			pos = fmax(pos, fabs(a.pos[i] - b.pos[i]));
+			vel = fmax(vel, fabs(a.vel[i] - b.vel[i]));
+			bias = fmax(bias, fabs(a.bias[i] - b.bias[i]));
+		}
+		for (int i = 0; i < 4; i++)
+			q = fmax(q, fabs(a.q[i] - b.q[i]));
+		for (int i = 0; i < 13; i++)
+			var = fmax(var, fabs(a.var[i] - b.var[i]) / fabs(b.var[i]));
+	}
+};
+
+class INSGPSReplay : public testing::Test {
+};
+
+#define NUM_FILTERS 4
+
+static const struct insgps_filter *filters[NUM_FILTERS] = {
+	&insgps_packed, &insgps_general, &insgps_reference, &insgps_reference_general,
+};
+static const char *filterNames[NUM_FILTERS] = {
+	"packed", "packed debug", "old", "old debug",
+};
+
+// Everything is compared to the old flight build
+#define REFERENCE_FILTER 2
+
+TEST_F(INSGPSReplay, MatchesReferenceKernels) {
+	FlightRecording recording(60 / SIM_DT);
+	Divergence divergence[NUM_FILTERS];
+
+	for (int f = 0; f < NUM_FILTERS; f++)
+		recording.start(filters[f]);
+
+	for (uint32_t n = 0; n < recording.numFrames; n++) {
+		for (int f = 0; f < NUM_FILTERS; f++)
+			recording.replay(filters[f], n);
+
+		FilterOutput ref(filters[REFERENCE_FILTER]);
+		for (int f = 0; f < NUM_FILTERS; f++)
+			divergence[f].add(FilterOutput(filters[f]), ref);
+
+		if (n == recording.numFrames / 2) {
+			// Exercise the other ways P gets written halfway through
+			const float pos[3] = { ref.pos[0], ref.pos[1], ref.pos[2] };
+			const float vel[3] = { ref.vel[0], ref.vel[1], ref.vel[2] };
+			for (int f = 0; f < NUM_FILTERS; f++)
+				filters[f]->pos_vel_reset(pos, vel);
+		}
+	}
+
+	printf("largest difference to the old flight build over %u frames:\n", recording.numFrames);
+	for (int f = 0; f < NUM_FILTERS; f++) {
+		if (f == REFERENCE_FILTER)
+			continue;
+		printf("  %-12s pos %.2e m, vel %.2e m/s, q %.2e, bias %.2e rad/s, variance %.2e relative\n",
+			filterNames[f], divergence[f].pos, divergence[f].vel, divergence[f].q,
+			divergence[f].bias, divergence[f].var);
+	}
+
+	// Only rounding differences are expected, about as large as between the two old builds
+	for (int f = 0; f < 2; f++) {
+		EXPECT_LT(divergence[f].pos, 1e-3) << filterNames[f];
+		EXPECT_LT(divergence[f].vel, 1e-4) << filterNames[f];
+		EXPECT_LT(divergence[f].q, 1e-5) << filterNames[f];
+		EXPECT_LT(divergence[f].bias, 1e-6) << filterNames[f];
+		EXPECT_LT(divergence[f].var, 1e-3) << filterNames[f];
+	}
+
+	// And the filter actually tracked the flight
+	FilterOutput out(&insgps_packed);
+	const float *attitude = recording.frame(recording.numFrames - 1)->attitude;
+	float dot = 0;
+	for (int i = 0; i < 4; i++)
+		dot += out.q[i] * attitude[i];
+	EXPECT_GT(fabs(dot), 0.999f);
+	EXPECT_NEAR(0.02f, out.bias[0], 0.01f);
+}
+
+TEST_F(INSGPSReplay, KernelTime) {
+	FlightRecording recording(10 / SIM_DT);
+	double prediction[NUM_FILTERS], correction[NUM_FILTERS];
+	const float mag[3] = { 0.43f, 0.05f, 0.90f };
+	const float zeros[3] = { 0, 0, 0 };
+	const uint32_t repeats = 5000;
+
+	for (int f = 0; f < NUM_FILTERS; f++) {
+		// Get the filter into a realistic state first
+		recording.start(filters[f]);
+		for (uint32_t n = 0; n < recording.numFrames; n++)
+			recording.replay(filters[f], n);
+
+		// Corrections are always interleaved with predictions, otherwise P
+		// shrinks into denormals. Best of a few rounds, to keep other load
+		// on the machine out of it.
+		double both = HUGE_VAL;
+		prediction[f] = HUGE_VAL;
+		for (int round = 0; round < 5; round++) {
+			clock_t start = clock();
+			for (uint32_t n = 0; n < repeats; n++)
+				filters[f]->covariance_prediction(SIM_DT);
+			prediction[f] = fmin(prediction[f], (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / repeats);
+
+			start = clock();
+			for (uint32_t n = 0; n < repeats; n++) {
+				filters[f]->covariance_prediction(SIM_DT);
+				filters[f]->correction(mag, zeros, zeros, 0, FULL_SENSORS);
+			}
+			both = fmin(both, (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / repeats);
+		}
+		correction[f] = both - prediction[f];
+
+		printf("%-12s covariance prediction %6.0f ns, full correction %6.0f ns\n",
+			filterNames[f], prediction[f], correction[f]);
+	}
+
+	// The library itself is instrumented for coverage, so only the other
+	// builds are timed against each other: the debug covariance prediction
+	// and the correction, which is the same in both builds of the library
+	EXPECT_LT(prediction[1] * 2, prediction[3]);
+	EXPECT_LT(correction[1], correction[2]);
+}
+
+/**
+ * @}
+ * @}
+ */
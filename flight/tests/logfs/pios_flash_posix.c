@@ -19,6 +19,33 @@ struct flash_posix_dev {
 	FILE * flash_file;
 };
 
+uint32_t pios_posix_flash_reads;
+
+int32_t pios_posix_flash_power_cut_countdown = -1;
+void (*pios_posix_flash_power_cut)(void);
+
+/* Counts down to the next power cut, returns true when it is due now */
+static bool PIOS_Flash_Posix_PowerFails(void)
+{
+	if (pios_posix_flash_power_cut_countdown < 0) {
+		return false;
+	}
+
+	return (pios_posix_flash_power_cut_countdown-- == 0);
+}
+
+/* The power went away part way through, don't return into the filesystem */
+static void PIOS_Flash_Posix_PowerCut(struct flash_posix_dev * flash_dev)
+{
+	fflush(flash_dev->flash_file);
+
+	assert(pios_posix_flash_power_cut);
+	pios_posix_flash_power_cut();
+
+	/* Power cut handler must not return */
+	abort();
+}
+
 static struct flash_posix_dev * PIOS_Flash_Posix_Alloc(void)
 {
 	struct flash_posix_dev * flash_dev = PIOS_malloc(sizeof(struct flash_posix_dev));
@@ -109,12 +136,20 @@ static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 	assert (buf);
 	memset((void *)buf, 0xFF, flash_dev->cfg->size_of_sector);
 
+	/* A power cut leaves the sector partially erased */
+	bool power_fails = PIOS_Flash_Posix_PowerFails();
+	uint32_t len = power_fails ? rand() % flash_dev->cfg->size_of_sector : flash_dev->cfg->size_of_sector;
+
 	size_t s;
-	s = fwrite (buf, 1, flash_dev->cfg->size_of_sector, flash_dev->flash_file);
+	s = fwrite (buf, 1, len, flash_dev->flash_file);
 
 	free(buf);
 
-	assert (s == flash_dev->cfg->size_of_sector);
+	assert (s == len);
+
+	if (power_fails) {
+		PIOS_Flash_Posix_PowerCut(flash_dev);
+	}
 
 	return 0;
 }
@@ -132,11 +167,21 @@ static int32_t PIOS_Flash_Posix_WriteData(uintptr_t chip_id, uint32_t chip_offse
 		assert(0);
 	}
 
+	/* A power cut only gets part of the data written */
+	bool power_fails = PIOS_Flash_Posix_PowerFails();
+	if (power_fails) {
+		len = rand() % (len + 1);
+	}
+
 	size_t s;
 	s = fwrite (data, 1, len, flash_dev->flash_file);
 
 	assert (s == len);
 
+	if (power_fails) {
+		PIOS_Flash_Posix_PowerCut(flash_dev);
+	}
+
 	return 0;
 }
 
@@ -149,6 +194,8 @@ static int32_t PIOS_Flash_Posix_ReadData(uintptr_t chip_id, uint32_t chip_offset
 
 	assert(flash_dev->transaction_in_progress);
 
+	pios_posix_flash_reads++;
+
 	if (fseek (flash_dev->flash_file, chip_offset, SEEK_SET) != 0) {
 		assert(0);
 	}
@@ -9,3 +9,15 @@ int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix
 void PIOS_Flash_Posix_Destroy(uintptr_t chip_id);
 
 extern const struct pios_flash_driver pios_posix_flash_driver;
+
+/* Number of reads from the flash, to measure how much a filesystem operation reads */
+extern uint32_t pios_posix_flash_reads;
+
+/*
+ * Power cut emulation: when the countdown of writes and erases reaches zero
+ * the next one is only partially done and pios_posix_flash_power_cut is
+ * called, which must not return (ie. it longjmps back into the test).
+ * A negative countdown never cuts the power.
+ */
+extern int32_t pios_posix_flash_power_cut_countdown;
+extern void (*pios_posix_flash_power_cut)(void);
@@ -37,6 +37,8 @@
 #include <stdlib.h>		/* abort */
 #include <string.h>		/* memset */
 #include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock */
+#include <setjmp.h>		/* setjmp */
 
 extern "C" {
 
@@ -79,6 +81,9 @@ extern struct flashfs_logfs_cfg flashfs_config_waypoints;
 class LogfsTestRaw : public testing::Test {
 protected:
   virtual void SetUp() {
+    /* Keep the power on unless a test wants to cut it */
+    pios_posix_flash_power_cut_countdown = -1;
+
     /* create an empty, appropriately sized flash filesystem */
     FILE * theflash = fopen("theflash.bin", "w");
     uint8_t sector[flash_config.size_of_sector];
@@ -333,6 +338,265 @@ TEST_F(LogfsTestCooked, WriteManyVerify) {
   EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
 }
 
+TEST_F(LogfsTestCooked, BootNearlyFull) {
+  const uint16_t num_slots = flashfs_config_settings.arena_size / flashfs_config_settings.slot_size;
+  const uint16_t num_objs = num_slots * 3 / 4;
+
+  /* Fill all but a few slots with objects, a quarter of them saved twice */
+  for (uint16_t i = 0; i < num_objs; i++) {
+    obj1[0] = i;
+    ASSERT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + i, i % 3, obj1, sizeof(obj1)));
+  }
+  for (uint16_t i = 0; i < num_slots - num_objs - 4; i++) {
+    obj1[0] = i + 1;
+    ASSERT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + i, i % 3, obj1, sizeof(obj1)));
+  }
+
+  /* Boot: mount the filesystem and load every object, like UAVObjLoadSettings() */
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  pios_posix_flash_reads = 0;
+  clock_t cpuStart = clock();
+
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  uint32_t mount_reads = pios_posix_flash_reads;
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  for (uint16_t i = 0; i < num_objs; i++) {
+    ASSERT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i, i % 3, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(i < num_slots - num_objs - 4 ? i + 1 : i, obj1_check[0]) << "object " << i;
+  }
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 1, obj1_check, sizeof(obj1_check)));
+
+  double elapsed = (double)(clock() - cpuStart) / CLOCKS_PER_SEC * 1000;
+  printf("boot with %u objects in %u slots: %u flash reads (%u to mount), %.2f ms\n",
+    num_objs, num_slots, pios_posix_flash_reads, mount_reads, elapsed);
+
+  /* One scan to mount, then about a header and the data for each object */
+  EXPECT_LE(mount_reads, (uint32_t)num_slots + 2);
+  EXPECT_LT(pios_posix_flash_reads - mount_reads, (uint32_t)num_objs * 3);
+}
+
+TEST_F(LogfsTestCooked, IndexFollowsGarbageCollect) {
+  const uint16_t num_slots = flashfs_config_settings.arena_size / flashfs_config_settings.slot_size;
+
+  /* Keep rewriting a few objects so the log fills up and gets collected */
+  for (uint16_t i = 0; i < num_slots * 3; i++) {
+    obj1[0] = i;
+    ASSERT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + i % 7, 0, obj1, sizeof(obj1)));
+    if (i % 5 == 0) {
+      ASSERT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID + i % 7, 0));
+    }
+  }
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  for (uint16_t i = num_slots * 3 - 7; i < num_slots * 3; i++) {
+    if (i % 5 == 0) {
+      EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i % 7, 0, obj1_check, sizeof(obj1_check)));
+    } else {
+      ASSERT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i % 7, 0, obj1_check, sizeof(obj1_check)));
+      EXPECT_EQ((uint8_t)i, obj1_check[0]);
+    }
+  }
+}
+
+TEST_F(LogfsTestCooked, IncrementalGarbageCollect) {
+  const uint16_t num_slots = flashfs_config_settings.arena_size / flashfs_config_settings.slot_size;
+  const uint16_t num_objs = 40;
+  const uint16_t slots_per_call = 8;
+  int16_t expected[num_objs];
+
+  /* Nothing to collect in a fresh filesystem */
+  EXPECT_EQ(0, PIOS_FLASHFS_CollectGarbage(fs_id, slots_per_call));
+
+  /* Rewrite a few objects until most of the log is obsolete */
+  for (uint16_t i = 0; i < num_slots - 20; i++) {
+    obj1[0] = i;
+    ASSERT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + i % num_objs, 0, obj1, sizeof(obj1)));
+    expected[i % num_objs] = obj1[0];
+  }
+
+  /* Collect a few slots at a time, saving and deleting objects in between */
+  uint16_t calls = 0;
+  int32_t rc;
+  while ((rc = PIOS_FLASHFS_CollectGarbage(fs_id, slots_per_call)) == 1) {
+    calls++;
+    ASSERT_LT(calls, num_slots);
+
+    uint16_t saved = (calls * 7) % num_objs;
+    obj1[0] = 100 + calls;
+    ASSERT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + saved, 0, obj1, sizeof(obj1)));
+    expected[saved] = obj1[0];
+
+    if (calls % 3 == 0) {
+      uint16_t deleted = (calls * 11 + 3) % num_objs;
+      ASSERT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID + deleted, 0));
+      expected[deleted] = -1;
+    }
+  }
+  EXPECT_EQ(0, rc);
+  EXPECT_GE(calls, num_objs / slots_per_call);
+
+  /* The log was compacted, so there is nothing left to collect */
+  EXPECT_EQ(0, PIOS_FLASHFS_CollectGarbage(fs_id, slots_per_call));
+
+  /* Every object survived the move, also after mounting the new arena from scratch */
+  unsigned char obj1_check[OBJ1_SIZE];
+  for (int boot = 0; boot < 2; boot++) {
+    for (uint16_t i = 0; i < num_objs; i++) {
+      if (expected[i] < 0) {
+        EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i, 0, obj1_check, sizeof(obj1_check))) << "object " << i;
+      } else {
+        ASSERT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i, 0, obj1_check, sizeof(obj1_check))) << "object " << i;
+        EXPECT_EQ(expected[i], obj1_check[0]) << "object " << i;
+      }
+    }
+
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    ASSERT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+}
+
+TEST_F(LogfsTestCooked, SessionSaveVerify) {
+  const uint16_t num_slots = flashfs_config_settings.arena_size / flashfs_config_settings.slot_size;
+  const uint16_t num_objs = 30;
+
+  /* Session calls are refused outside a session */
+  EXPECT_EQ(-2, PIOS_FLASHFS_SessionObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+  EXPECT_EQ(-2, PIOS_FLASHFS_EndSession(fs_id));
+  EXPECT_EQ(-1, PIOS_FLASHFS_BeginSession(fs_id + 1, num_objs));
+
+  /* Leave fewer free slots than the batch needs */
+  for (uint16_t i = 0; i < num_slots - 10; i++) {
+    obj1[0] = i;
+    ASSERT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + i % num_objs, 0, obj1, sizeof(obj1)));
+  }
+
+  /* Save and read back the whole batch within one flash transaction */
+  unsigned char obj1_check[OBJ1_SIZE];
+  ASSERT_EQ(0, PIOS_FLASHFS_BeginSession(fs_id, num_objs));
+  for (uint16_t i = 0; i < num_objs; i++) {
+    obj1[0] = 200 + i;
+    ASSERT_EQ(0, PIOS_FLASHFS_SessionObjSave(fs_id, OBJ1_ID + i, 0, obj1, sizeof(obj1))) << "object " << i;
+    ASSERT_EQ(0, PIOS_FLASHFS_SessionObjLoad(fs_id, OBJ1_ID + i, 0, obj1_check, sizeof(obj1_check))) << "object " << i;
+    EXPECT_EQ(200 + i, obj1_check[0]);
+  }
+  EXPECT_EQ(-3, PIOS_FLASHFS_SessionObjLoad(fs_id, OBJ2_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, PIOS_FLASHFS_EndSession(fs_id));
+
+  /* The batch is there for regular loads and after mounting again */
+  for (int boot = 0; boot < 2; boot++) {
+    for (uint16_t i = 0; i < num_objs; i++) {
+      ASSERT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i, 0, obj1_check, sizeof(obj1_check))) << "object " << i;
+      EXPECT_EQ(200 + i, obj1_check[0]);
+    }
+
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    ASSERT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+}
+
+static jmp_buf power_cut_jmp;
+
+static void power_cut(void)
+{
+  longjmp(power_cut_jmp, 1);
+}
+
+TEST_F(LogfsTestCooked, SurvivesPowerCuts) {
+  const int num_objs = 24;
+  const int num_cuts = 400;
+
+  /* What is in the filesystem for each object, -1 if nothing */
+  static int16_t committed[num_objs];
+  for (int i = 0; i < num_objs; i++) {
+    committed[i] = -1;
+  }
+
+  srand(20141018);
+  pios_posix_flash_power_cut = power_cut;
+
+  uint32_t saves = 0;
+  uint32_t gc_cuts = 0;
+  unsigned char obj1_check[OBJ1_SIZE];
+
+  for (int cut = 0; cut < num_cuts; cut++) {
+    /* Object that was being changed when the power went and its new value */
+    volatile int pending_obj = -1;
+    volatile int16_t pending_value = -1;
+    volatile bool pending_gc = false;
+
+    if (setjmp(power_cut_jmp) == 0) {
+      pios_posix_flash_power_cut_countdown = rand() % 600;
+
+      /* Keep changing the filesystem until the power goes */
+      while (true) {
+        int obj = rand() % num_objs;
+        int op = rand() % 10;
+        if (op < 7) {
+          int16_t value = rand() % 256;
+          pending_obj = obj;
+          pending_value = value;
+          memset(obj1, value, sizeof(obj1));
+          ASSERT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + obj, 0, obj1, sizeof(obj1)));
+          committed[obj] = value;
+          saves++;
+        } else if (op < 8) {
+          pending_obj = obj;
+          pending_value = -1;
+          ASSERT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID + obj, 0));
+          committed[obj] = -1;
+        } else {
+          pending_gc = true;
+          ASSERT_LE(0, PIOS_FLASHFS_CollectGarbage(fs_id, 4));
+          pending_gc = false;
+        }
+        pending_obj = -1;
+      }
+    }
+
+    if (pending_gc) {
+      gc_cuts++;
+    }
+
+    /* Reboot, the filesystem must always mount again */
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+    ASSERT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+    ASSERT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS)) << "cut " << cut;
+
+    for (int i = 0; i < num_objs; i++) {
+      int16_t found = -1;
+      int32_t rc = PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i, 0, obj1_check, sizeof(obj1_check));
+      if (rc == 0) {
+        found = obj1_check[0];
+        for (uint32_t j = 1; j < sizeof(obj1_check); j++) {
+          ASSERT_EQ(found, obj1_check[j]) << "cut " << cut << " object " << i;
+        }
+      } else {
+        ASSERT_EQ(-3, rc) << "cut " << cut << " object " << i;
+      }
+
+      if (i == pending_obj) {
+        /*
+         * The object being changed may still have its old value, or already
+         * the new one. Saving deletes the old value first so it may also be gone.
+         */
+        EXPECT_TRUE(found == committed[i] || found == pending_value || found == -1)
+          << "cut " << cut << " object " << i << " found " << found;
+        committed[i] = found;
+      } else {
+        EXPECT_EQ(committed[i], found) << "cut " << cut << " object " << i;
+      }
+    }
+  }
+
+  printf("%d power cuts during %u saves, %u of them while collecting garbage\n", num_cuts, saves, gc_cuts);
+
+  /* Both the background and the on demand collection got interrupted */
+  EXPECT_GT(gc_cuts, 0U);
+  EXPECT_GT(saves, 4U * flashfs_config_settings.arena_size / flashfs_config_settings.slot_size);
+}
+
 class LogfsTestCookedMultiPart : public LogfsTestRaw {
 protected:
   virtual void SetUp() {
@@ -0,0 +1,6 @@
+/* Only the parts of openpilot.h that the object manager uses */
+#include <pios.h>
+
+#include "utlist.h"
+#include "uavobjectmanager.h"
+#include "eventdispatcher.h"
@@ -0,0 +1,367 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* malloc */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock */
+
+
+extern "C" {
+
+#include "openpilot.h"
+
+}
+
+extern "C" {
+
+static struct pios_recursive_mutex fakeMutex;
+uintptr_t pios_uavo_settings_fs_id;
+
+struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void) { return &fakeMutex; }
+bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *, uint32_t) { return true; }
+bool PIOS_Recursive_Mutex_Unlock(struct pios_recursive_mutex *) { return true; }
+/* Counted like pios_heap.c, which never gives memory back */
+static size_t heapUsed;
+static uint32_t heapFrees;
+
+void *PIOS_malloc_no_dma(size_t size) { heapUsed += size; return malloc(size); }
+void PIOS_free(void *buf) { heapFrees++; free(buf); }
+
+/* A one deep queue and a binary semaphore, the handle tells if they are full */
+struct pios_semaphore *PIOS_Semaphore_Create(void) { struct pios_semaphore *sema = (struct pios_semaphore *) malloc(sizeof(*sema)); sema->sema_handle = 1; return sema; }
+bool PIOS_Semaphore_Give(struct pios_semaphore *sema) { sema->sema_handle = 1; return true; }
+
+bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t)
+{
+	bool taken = sema->sema_handle != 0;
+	sema->sema_handle = 0;
+	return taken;
+}
+
+bool PIOS_Queue_Send(struct pios_queue *queue, const void *, uint32_t)
+{
+	if (queue->queue_handle != 0)
+		return false;
+	queue->queue_handle = 1;
+	return true;
+}
+int32_t EventCallbackDispatch(UAVObjEvent *, UAVObjEventCallback) { return 0; }
+int32_t PIOS_FLASHFS_ObjSave(uintptr_t, uint32_t, uint16_t, uint8_t *, uint16_t) { return -1; }
+int32_t PIOS_FLASHFS_ObjLoad(uintptr_t, uint32_t, uint16_t, uint8_t *, uint16_t) { return -1; }
+int32_t PIOS_FLASHFS_ObjDelete(uintptr_t, uint32_t, uint16_t) { return -1; }
+int32_t PIOS_FLASHFS_BeginSession(uintptr_t, uint16_t) { return -1; }
+int32_t PIOS_FLASHFS_EndSession(uintptr_t) { return -1; }
+int32_t PIOS_FLASHFS_SessionObjSave(uintptr_t, uint32_t, uint16_t, uint8_t *, uint16_t) { return -1; }
+int32_t PIOS_FLASHFS_SessionObjLoad(uintptr_t, uint32_t, uint16_t, uint8_t *, uint16_t) { return -1; }
+
+}
+
+#define INSTANCE_SIZE 37
+
+static uint32_t newInstances;
+static uint32_t lastNumInstances;
+
+static void newInstance(uint32_t, uint32_t numInstances)
+{
+	newInstances++;
+	lastNumInstances = numInstances;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVObjectManagerMulti : public testing::Test {
+protected:
+	virtual void SetUp() {
+		ASSERT_EQ(0, UAVObjInitialize());
+		UAVObjRegisterNewInstanceCB(newInstance);
+		newInstances = 0;
+		lastNumInstances = 0;
+	}
+
+	// Register a multi instance object with the given number of instances
+	UAVObjHandle multi(uint32_t id, uint16_t numInstances) {
+		UAVObjHandle obj = UAVObjRegister(id, 0, 0, INSTANCE_SIZE, NULL);
+		for (uint16_t n = 1; n < numInstances; n++)
+			UAVObjCreateInstance(obj, NULL);
+		return obj;
+	}
+
+	static void fill(uint8_t *data, uint16_t instId) {
+		for (int i = 0; i < INSTANCE_SIZE; i++)
+			data[i] = (uint8_t)(instId * 7 + i);
+	}
+};
+
+TEST_F(UAVObjectManagerMulti, CreatesInstancesInOrder) {
+	UAVObjHandle obj = multi(0x1000, 5);
+	ASSERT_TRUE(obj != NULL);
+	EXPECT_EQ(5, UAVObjGetNumInstances(obj));
+	EXPECT_EQ(4U, newInstances);
+	EXPECT_EQ(5U, lastNumInstances);
+
+	// Unpacking an instance past the end creates the ones in between
+	uint8_t data[INSTANCE_SIZE];
+	fill(data, 40);
+	EXPECT_EQ(-1, UAVObjSetInstanceData(obj, 40, data));
+	ASSERT_EQ(0, UAVObjUnpack(obj, 40, data));
+	EXPECT_EQ(41, UAVObjGetNumInstances(obj));
+	EXPECT_EQ(40U, newInstances);
+	EXPECT_EQ(41U, lastNumInstances);
+
+	EXPECT_EQ(41, UAVObjCreateInstance(obj, NULL));
+	EXPECT_EQ(42, UAVObjGetNumInstances(obj));
+
+	uint8_t zero[INSTANCE_SIZE];
+	memset(zero, 0, sizeof(zero));
+	for (uint16_t n = 0; n < 42; n++) {
+		ASSERT_EQ(0, UAVObjGetInstanceData(obj, n, data)) << "instance " << n;
+		if (n != 40) {
+			EXPECT_EQ(0, memcmp(zero, data, INSTANCE_SIZE)) << "instance " << n;
+		}
+	}
+	EXPECT_EQ(-1, UAVObjGetInstanceData(obj, 42, data));
+}
+
+TEST_F(UAVObjectManagerMulti, InstancesAreIndependent) {
+	const uint16_t count = UAVOBJ_MAX_INSTANCES;
+	UAVObjHandle obj = multi(0x2000, 1);
+	uint8_t data[INSTANCE_SIZE];
+	uint8_t expected[INSTANCE_SIZE];
+
+	// Fill from the top down so all instances get created at once
+	for (int n = count - 1; n >= 0; n--) {
+		fill(data, n);
+		ASSERT_EQ(0, UAVObjUnpack(obj, n, data)) << "instance " << n;
+	}
+	EXPECT_EQ(count, UAVObjGetNumInstances(obj));
+	EXPECT_EQ(-1, UAVObjUnpack(obj, count, data));
+	UAVObjCreateInstance(obj, NULL);
+	EXPECT_EQ(count, UAVObjGetNumInstances(obj));
+
+	for (uint16_t n = 0; n < count; n++) {
+		fill(expected, n);
+		ASSERT_EQ(0, UAVObjGetInstanceData(obj, n, data)) << "instance " << n;
+		EXPECT_EQ(0, memcmp(expected, data, INSTANCE_SIZE)) << "instance " << n;
+	}
+
+	// Field access lands in the right instance
+	uint8_t field = 0xa5;
+	ASSERT_EQ(0, UAVObjSetInstanceDataField(obj, 513, &field, INSTANCE_SIZE - 1, 1));
+	ASSERT_EQ(0, UAVObjGetInstanceData(obj, 512, data));
+	fill(expected, 512);
+	EXPECT_EQ(0, memcmp(expected, data, INSTANCE_SIZE));
+	ASSERT_EQ(0, UAVObjGetInstanceData(obj, 514, data));
+	fill(expected, 514);
+	EXPECT_EQ(0, memcmp(expected, data, INSTANCE_SIZE));
+	field = 0;
+	ASSERT_EQ(0, UAVObjGetInstanceDataField(obj, 513, &field, INSTANCE_SIZE - 1, 1));
+	EXPECT_EQ(0xa5, field);
+}
+
+TEST_F(UAVObjectManagerMulti, HeapFollowsInstances) {
+	const uint16_t counts[] = { 2, 17, 65, 200, UAVOBJ_MAX_INSTANCES };
+
+	for (int i = 0; i < 5; i++) {
+		UAVObjHandle obj = multi(0x2400 + 2 * i, 1);
+		size_t before = heapUsed;
+		uint32_t frees = heapFrees;
+
+		for (uint16_t n = 1; n < counts[i]; n++)
+			ASSERT_EQ(n, UAVObjCreateInstance(obj, NULL));
+
+		// Nothing is freed, and fewer than 16 instances are allocated ahead
+		size_t used = heapUsed - before;
+		EXPECT_EQ(frees, heapFrees) << counts[i] << " instances";
+		EXPECT_GE(used, (size_t)(counts[i] - 1) * INSTANCE_SIZE) << counts[i] << " instances";
+		EXPECT_LT(used, (size_t)(counts[i] - 1 + 16) * INSTANCE_SIZE) << counts[i] << " instances";
+	}
+}
+
+TEST_F(UAVObjectManagerMulti, DigestFollowsData) {
+	UAVObjHandle obj = multi(0x2800, 3);
+	UAVObjHandle same = multi(0x2802, 3);
+	uint8_t data[INSTANCE_SIZE];
+
+	for (uint16_t n = 0; n < 3; n++) {
+		fill(data, n);
+		ASSERT_EQ(0, UAVObjSetInstanceData(obj, n, data));
+		ASSERT_EQ(0, UAVObjSetInstanceData(same, n, data));
+	}
+	uint32_t digest = UAVObjGetDigest(obj);
+	EXPECT_EQ(digest, UAVObjGetDigest(same));
+
+	// A change in any instance shows up
+	data[INSTANCE_SIZE - 1] ^= 0x01;
+	ASSERT_EQ(0, UAVObjSetInstanceData(obj, 2, data));
+	EXPECT_NE(digest, UAVObjGetDigest(obj));
+	data[INSTANCE_SIZE - 1] ^= 0x01;
+	ASSERT_EQ(0, UAVObjSetInstanceData(obj, 2, data));
+	EXPECT_EQ(digest, UAVObjGetDigest(obj));
+
+	// So does a new instance
+	UAVObjCreateInstance(obj, NULL);
+	EXPECT_NE(digest, UAVObjGetDigest(obj));
+
+	// The metadata has a digest of its own
+	UAVObjHandle meta = UAVObjGetLinkedObj(same);
+	uint32_t metaDigest = UAVObjGetDigest(meta);
+	UAVObjMetadata metadata;
+	ASSERT_EQ(0, UAVObjGetMetadata(same, &metadata));
+	metadata.telemetryUpdatePeriod += 100;
+	ASSERT_EQ(0, UAVObjSetMetadata(same, &metadata));
+	EXPECT_NE(metaDigest, UAVObjGetDigest(meta));
+	EXPECT_EQ(digest, UAVObjGetDigest(same));
+}
+
+TEST_F(UAVObjectManagerMulti, AccessTime) {
+	const uint16_t sizes[] = { 1, 16, 64 };
+	const uint32_t rounds = 200000;
+	double cost[3];
+	uint8_t data[INSTANCE_SIZE];
+
+	// Get and set every instance, which is what sending or logging all of them does
+	for (int i = 0; i < 3; i++) {
+		UAVObjHandle obj = multi(0x3000 + 2 * i, sizes[i]);
+		ASSERT_EQ(sizes[i], UAVObjGetNumInstances(obj));
+
+		uint32_t accesses = 0;
+		clock_t cpuStart = clock();
+		for (uint32_t r = 0; r < rounds / sizes[i] + 1; r++) {
+			for (uint16_t n = 0; n < sizes[i]; n++) {
+				UAVObjGetInstanceData(obj, n, data);
+				data[0]++;
+				UAVObjSetInstanceData(obj, n, data);
+				accesses += 2;
+			}
+		}
+		cost[i] = (double)(clock() - cpuStart) / CLOCKS_PER_SEC * 1e9 / accesses;
+	}
+
+	printf("ns per access: %.1f at 1 instance, %.1f at 16, %.1f at 64\n",
+		cost[0], cost[1], cost[2]);
+
+	// The cost of reaching an instance does not depend on how many come before it
+	EXPECT_LT(cost[2], cost[0] * 3);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVObjectManagerSignal : public testing::Test {
+protected:
+	virtual void SetUp() {
+		ASSERT_EQ(0, UAVObjInitialize());
+		UAVObjClearStats();
+		obj = UAVObjRegister(0x4000, 1, 0, INSTANCE_SIZE, NULL);
+		ASSERT_TRUE(obj != NULL);
+		signal.sema = PIOS_Semaphore_Create();
+		signal.sequence = 0;
+	}
+
+	UAVObjHandle obj;
+	UAVObjSignal signal;
+};
+
+TEST_F(UAVObjectManagerSignal, WakesOnMatchingEvents) {
+	uint8_t data[INSTANCE_SIZE];
+	memset(data, 0, sizeof(data));
+
+	// The semaphore is created given, but connecting does not count as an event
+	ASSERT_EQ(0, UAVObjConnectSignal(obj, &signal, EV_UPDATED));
+	EXPECT_FALSE(PIOS_Semaphore_Take(signal.sema, 0));
+
+	ASSERT_EQ(0, UAVObjSetData(obj, data));
+	EXPECT_EQ(1U, signal.sequence);
+	EXPECT_TRUE(PIOS_Semaphore_Take(signal.sema, 0));
+	EXPECT_FALSE(PIOS_Semaphore_Take(signal.sema, 0));
+
+	// Events outside the mask are ignored
+	UAVObjUpdated(obj);
+	EXPECT_EQ(1U, signal.sequence);
+	EXPECT_FALSE(PIOS_Semaphore_Take(signal.sema, 0));
+
+	// Connecting again only updates the mask
+	ASSERT_EQ(0, UAVObjConnectSignal(obj, &signal, EV_MASK_ALL_UPDATES));
+	UAVObjUpdated(obj);
+	EXPECT_EQ(2U, signal.sequence);
+
+	ASSERT_EQ(0, UAVObjDisconnectSignal(obj, &signal));
+	EXPECT_EQ(-1, UAVObjDisconnectSignal(obj, &signal));
+	ASSERT_EQ(0, UAVObjSetData(obj, data));
+	EXPECT_EQ(2U, signal.sequence);
+}
+
+TEST_F(UAVObjectManagerSignal, NeverOverflows) {
+	struct pios_queue queue;
+	uint8_t data[INSTANCE_SIZE];
+	memset(&queue, 0, sizeof(queue));
+	memset(data, 0, sizeof(data));
+
+	ASSERT_EQ(0, UAVObjConnectQueue(obj, &queue, EV_MASK_ALL_UPDATES));
+	ASSERT_EQ(0, UAVObjConnectSignal(obj, &signal, EV_MASK_ALL_UPDATES));
+	ASSERT_EQ(EV_MASK_ALL_UPDATES, getEventMask(obj, &queue));
+
+	// A burst of updates while the consumers are busy
+	for (int i = 0; i < 10; i++) {
+		data[0] = i;
+		ASSERT_EQ(0, UAVObjSetData(obj, data));
+	}
+
+	// The queue kept the first event and dropped the rest
+	UAVObjStats stats;
+	UAVObjGetStats(&stats);
+	EXPECT_EQ(9U, stats.eventQueueErrors);
+
+	// The signal woke up once and tells how many updates were missed
+	EXPECT_TRUE(PIOS_Semaphore_Take(signal.sema, 0));
+	EXPECT_EQ(10U, signal.sequence);
+	ASSERT_EQ(0, UAVObjGetData(obj, data));
+	EXPECT_EQ(9, data[0]);
+	EXPECT_EQ(9U, UAVObjSignalSkipped(&signal));
+	UAVObjGetStats(&stats);
+	EXPECT_EQ(9U, stats.signalSkips);
+
+	// Nothing is skipped while the consumer keeps up
+	EXPECT_EQ(0U, UAVObjSignalSkipped(&signal));
+	ASSERT_EQ(0, UAVObjSetData(obj, data));
+	EXPECT_TRUE(PIOS_Semaphore_Take(signal.sema, 0));
+	EXPECT_EQ(0U, UAVObjSignalSkipped(&signal));
+	UAVObjGetStats(&stats);
+	EXPECT_EQ(9U, stats.signalSkips);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,5 @@
+/* Only the parts of openpilot.h that UAVTalk uses */
+#include <pios.h>
+
+#include "uavobjectmanager.h"
+#include "uavtalk.h"
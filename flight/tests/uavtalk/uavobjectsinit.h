@@ -0,0 +1,2 @@
+/* Normally generated from the object definitions */
+#define UAVOBJECTS_LARGEST 256
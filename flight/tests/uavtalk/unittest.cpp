@@ -0,0 +1,376 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* malloc */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <deque>
+#include <vector>
+
+extern "C" {
+
+#include "openpilot.h"
+#include "uavtalk_priv.h"	/* UAVTALK_MAX_TRANSACTIONS */
+
+}
+
+/*
+ * The flight side and a GCS are two UAVTalk connections joined by a link
+ * that delays every packet and can drop some of them. Time only moves when
+ * the test advances the fake system clock.
+ */
+
+#define NUM_OBJECTS 32
+#define OBJ_SIZE 24
+#define OBJ_ID(n) (0x1000 + (n))
+
+#define TRANS_TIMEOUT_MS 250
+#define TRANS_MAX_ATTEMPTS 2
+
+static uint32_t systime;
+static uint8_t objects[NUM_OBJECTS][OBJ_SIZE];
+static bool unknownToGcs[NUM_OBJECTS];
+static bool gcsReceiving;
+
+struct Packet {
+	uint32_t deliverAt;
+	std::vector<uint8_t> data;
+};
+
+struct Link {
+	std::deque<Packet> packets;
+	uint32_t latencyMs;
+	uint32_t lossPercent;
+	uint32_t dropNext;
+	uint32_t sent;
+	uint32_t dropped;
+};
+
+static Link toGcs;
+static Link toFlight;
+static uint32_t lossSeed;
+
+struct Outcome {
+	uint32_t succeeded;
+	uint32_t failed;
+	uint32_t retries;
+};
+
+static Outcome outcome;
+
+extern "C" {
+
+/* Single threaded, so locking is a no-op */
+static struct pios_recursive_mutex fakeMutex;
+static struct pios_semaphore fakeSema;
+
+struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void) { return &fakeMutex; }
+bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *, uint32_t) { return true; }
+bool PIOS_Recursive_Mutex_Unlock(struct pios_recursive_mutex *) { return true; }
+struct pios_semaphore *PIOS_Semaphore_Create(void) { return &fakeSema; }
+bool PIOS_Semaphore_Take(struct pios_semaphore *, uint32_t) { return false; }
+bool PIOS_Semaphore_Give(struct pios_semaphore *) { return true; }
+uint32_t PIOS_Thread_Systime(void) { return systime; }
+void *PIOS_malloc(size_t size) { return malloc(size); }
+
+static int32_t objectIndex(UAVObjHandle obj)
+{
+	return (uint8_t (*)[OBJ_SIZE]) obj - objects;
+}
+
+UAVObjHandle UAVObjGetByID(uint32_t id)
+{
+	if (id < OBJ_ID(0) || id >= OBJ_ID(NUM_OBJECTS))
+		return 0;
+	if (gcsReceiving && unknownToGcs[id - OBJ_ID(0)])
+		return 0;
+	return objects[id - OBJ_ID(0)];
+}
+
+uint32_t UAVObjGetID(UAVObjHandle obj) { return OBJ_ID(objectIndex(obj)); }
+uint32_t UAVObjGetNumBytes(UAVObjHandle) { return OBJ_SIZE; }
+uint16_t UAVObjGetNumInstances(UAVObjHandle) { return 1; }
+bool UAVObjIsSingleInstance(UAVObjHandle) { return true; }
+
+int32_t UAVObjUnpack(UAVObjHandle obj, uint16_t, const uint8_t *dataIn)
+{
+	memcpy(obj, dataIn, OBJ_SIZE);
+	return 0;
+}
+
+int32_t UAVObjPack(UAVObjHandle obj, uint16_t, uint8_t *dataOut)
+{
+	memcpy(dataOut, obj, OBJ_SIZE);
+	return 0;
+}
+
+}
+
+static bool lose(Link *link)
+{
+	if (link->dropNext > 0) {
+		link->dropNext--;
+		return true;
+	}
+	lossSeed = lossSeed * 1103515245 + 12345;
+	return (lossSeed >> 16) % 100 < link->lossPercent;
+}
+
+static int32_t send(Link *link, uint8_t *data, int32_t length)
+{
+	link->sent++;
+	if (lose(link)) {
+		link->dropped++;
+		return length;
+	}
+
+	Packet packet;
+	packet.deliverAt = systime + link->latencyMs;
+	packet.data.assign(data, data + length);
+	link->packets.push_back(packet);
+	return length;
+}
+
+static int32_t flightOutput(uint8_t *data, int32_t length) { return send(&toGcs, data, length); }
+static int32_t gcsOutput(uint8_t *data, int32_t length) { return send(&toFlight, data, length); }
+
+static void transactionCompleted(UAVObjHandle, uint16_t, bool success, uint8_t retries)
+{
+	if (success)
+		outcome.succeeded++;
+	else
+		outcome.failed++;
+	outcome.retries += retries;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVTalkTransactions : public testing::Test {
+protected:
+	virtual void SetUp() {
+		systime = 1000;
+		lossSeed = 1;
+		gcsReceiving = false;
+		memset(objects, 0, sizeof(objects));
+		memset(unknownToGcs, 0, sizeof(unknownToGcs));
+		memset(&outcome, 0, sizeof(outcome));
+		toGcs = Link();
+		toFlight = Link();
+
+		flight = UAVTalkInitialize(&flightOutput);
+		gcs = UAVTalkInitialize(&gcsOutput);
+		ASSERT_EQ(0, UAVTalkConfigureTransactions(flight, TRANS_TIMEOUT_MS, TRANS_MAX_ATTEMPTS, &transactionCompleted));
+		nextDeadline = UAVTALK_NO_DEADLINE;
+	}
+
+	void deliver(Link *link, UAVTalkConnection connection) {
+		while (!link->packets.empty() && link->packets.front().deliverAt <= systime) {
+			Packet packet = link->packets.front();
+			link->packets.pop_front();
+			gcsReceiving = (connection == gcs);
+			UAVTalkProcessInputBuffer(connection, &packet.data[0], packet.data.size());
+			gcsReceiving = false;
+		}
+	}
+
+	// What the telemetry transmit task does between queue events
+	void advance(uint32_t ms) {
+		for (uint32_t i = 0; i < ms; i++) {
+			systime++;
+			deliver(&toGcs, gcs);
+			deliver(&toFlight, flight);
+			if (nextDeadline != UAVTALK_NO_DEADLINE && --nextDeadline == 0)
+				service();
+		}
+	}
+
+	void service() {
+		nextDeadline = UAVTalkProcessTransactions(flight);
+	}
+
+	int32_t sendAcked(int n) {
+		objects[n][0]++;
+		int32_t ret = UAVTalkSendObjectAsync(flight, objects[n], 0, 1);
+		service();
+		return ret;
+	}
+
+	UAVTalkConnection flight;
+	UAVTalkConnection gcs;
+	uint32_t nextDeadline;
+};
+
+TEST_F(UAVTalkTransactions, SendsWithoutWaiting) {
+	toGcs.latencyMs = 100;
+	toFlight.latencyMs = 100;
+
+	// All of them go out before the first ack can possibly arrive
+	for (int n = 0; n < UAVTALK_MAX_TRANSACTIONS; n++)
+		EXPECT_EQ(0, sendAcked(n));
+	EXPECT_EQ((uint32_t)UAVTALK_MAX_TRANSACTIONS, toGcs.sent);
+	EXPECT_EQ(0U, outcome.succeeded);
+
+	// One round trip later everything is acked
+	advance(200);
+	EXPECT_EQ((uint32_t)UAVTALK_MAX_TRANSACTIONS, outcome.succeeded);
+	EXPECT_EQ(0U, outcome.failed);
+	EXPECT_EQ(0U, outcome.retries);
+	EXPECT_EQ(UAVTALK_NO_DEADLINE, UAVTalkProcessTransactions(flight));
+}
+
+TEST_F(UAVTalkTransactions, SendsUnackedWhenFull) {
+	toGcs.latencyMs = 100;
+	toFlight.latencyMs = 100;
+
+	for (int n = 0; n < UAVTALK_MAX_TRANSACTIONS; n++)
+		EXPECT_EQ(0, sendAcked(n));
+
+	// The update still goes out, only without an ack
+	EXPECT_EQ(1, sendAcked(UAVTALK_MAX_TRANSACTIONS));
+	EXPECT_EQ((uint32_t)UAVTALK_MAX_TRANSACTIONS + 1, toGcs.sent);
+
+	// A newer update of a pending object takes over its entry
+	EXPECT_EQ(0, sendAcked(0));
+
+	advance(200);
+	UAVTalkStats stats;
+	UAVTalkGetStats(gcs, &stats);
+	EXPECT_EQ((uint32_t)UAVTALK_MAX_TRANSACTIONS + 2, stats.rxObjects);
+	EXPECT_EQ((uint32_t)UAVTALK_MAX_TRANSACTIONS, outcome.succeeded);
+	EXPECT_EQ(0, sendAcked(UAVTALK_MAX_TRANSACTIONS));
+}
+
+TEST_F(UAVTalkTransactions, RetransmitsLostPackets) {
+	toGcs.latencyMs = 20;
+	toFlight.latencyMs = 20;
+	toGcs.dropNext = 1;
+
+	EXPECT_EQ(0, sendAcked(3));
+	EXPECT_EQ((uint32_t)TRANS_TIMEOUT_MS, nextDeadline);
+
+	advance(TRANS_TIMEOUT_MS - 1);
+	EXPECT_EQ(0U, outcome.succeeded);
+	EXPECT_EQ(1U, toGcs.sent);
+
+	advance(1 + 40);
+	EXPECT_EQ(2U, toGcs.sent);
+	EXPECT_EQ(1U, outcome.succeeded);
+	EXPECT_EQ(1U, outcome.retries);
+}
+
+TEST_F(UAVTalkTransactions, LostAckIsRetransmitted) {
+	toGcs.latencyMs = 20;
+	toFlight.latencyMs = 20;
+	toFlight.dropNext = 1;
+
+	EXPECT_EQ(0, sendAcked(3));
+	advance(TRANS_TIMEOUT_MS + 40);
+	EXPECT_EQ(1U, outcome.succeeded);
+	EXPECT_EQ(1U, outcome.retries);
+}
+
+TEST_F(UAVTalkTransactions, FailsAfterMaxAttempts) {
+	toGcs.lossPercent = 100;
+
+	EXPECT_EQ(0, sendAcked(5));
+	advance(TRANS_TIMEOUT_MS * TRANS_MAX_ATTEMPTS);
+	EXPECT_EQ((uint32_t)TRANS_MAX_ATTEMPTS, toGcs.sent);
+	EXPECT_EQ(0U, outcome.succeeded);
+	EXPECT_EQ(1U, outcome.failed);
+	EXPECT_EQ((uint32_t)TRANS_MAX_ATTEMPTS - 1, outcome.retries);
+	EXPECT_EQ(UAVTALK_NO_DEADLINE, UAVTalkProcessTransactions(flight));
+
+	UAVTalkStats stats;
+	UAVTalkGetStats(flight, &stats);
+	EXPECT_EQ(1U, stats.txErrors);
+	EXPECT_EQ((uint32_t)TRANS_MAX_ATTEMPTS - 1, stats.txRetries);
+}
+
+TEST_F(UAVTalkTransactions, NackFailsRightAway) {
+	toGcs.latencyMs = 10;
+	toFlight.latencyMs = 10;
+	unknownToGcs[7] = true;
+
+	EXPECT_EQ(0, sendAcked(7));
+	advance(20);
+	EXPECT_EQ(1U, outcome.failed);
+	EXPECT_EQ(0U, outcome.retries);
+	EXPECT_EQ(1U, toGcs.sent);
+	EXPECT_EQ(UAVTALK_NO_DEADLINE, UAVTalkProcessTransactions(flight));
+}
+
+TEST_F(UAVTalkTransactions, RequestIsAnsweredByObject) {
+	toGcs.latencyMs = 10;
+	toFlight.latencyMs = 10;
+
+	EXPECT_EQ(0, UAVTalkSendObjectRequestAsync(flight, objects[2], 0));
+	service();
+	advance(20);
+	EXPECT_EQ(1U, outcome.succeeded);
+	EXPECT_EQ(UAVTALK_NO_DEADLINE, UAVTalkProcessTransactions(flight));
+}
+
+TEST_F(UAVTalkTransactions, UpdateRateWithLatencyAndLoss) {
+	const uint32_t duration = 20000;
+	const uint32_t roundTrip = 200;
+
+	toGcs.latencyMs = roundTrip / 2;
+	toFlight.latencyMs = roundTrip / 2;
+	toGcs.lossPercent = 10;
+	toFlight.lossPercent = 10;
+
+	// Every 25 ms the next object is updated, 40 updates/s in total and
+	// seldom enough that an object is not updated again while it is pending
+	uint32_t unacked = 0;
+	for (uint32_t t = 0; t < duration; t += 25) {
+		if (sendAcked((t / 25) % NUM_OBJECTS) == 1)
+			unacked++;
+		advance(25);
+	}
+	advance(TRANS_TIMEOUT_MS * TRANS_MAX_ATTEMPTS);
+
+	double rate = outcome.succeeded * 1000.0 / duration;
+	printf("%u acked, %u failed, %u retries, %u sent unacked, %.1f updates/s over a %u ms round trip\n",
+		outcome.succeeded, outcome.failed, outcome.retries, unacked, rate, roundTrip);
+
+	// Waiting for every ack would allow one update per round trip at best
+	EXPECT_GT(rate, (UAVTALK_MAX_TRANSACTIONS / 2) * 1000.0 / roundTrip);
+	EXPECT_EQ(UAVTALK_NO_DEADLINE, UAVTalkProcessTransactions(flight));
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -45,23 +45,26 @@ namespace core {
     int KiberTileCache::MemoryCacheCapacity()
     {
         kiberCacheLock.lockForRead();
-        return _MemoryCacheCapacity;
+        int ret=_MemoryCacheCapacity;
         kiberCacheLock.unlock();
+        return ret;
     }
 
+    /**
+    * Drop the oldest tiles until the bytes held fit the capacity, which is
+    * given in MB. Must be called with the MemoryCache lock held for writing.
+    */
     void KiberTileCache::RemoveMemoryOverload()
     {
-        while(MemoryCacheSize()>MemoryCacheCapacity())
+        qint64 capacity=(qint64)MemoryCacheCapacity()*1048576;
+        while(memoryCacheSize>capacity && list.count()>0)
         {
-            if(cachequeue.count()>0 && list.count()>0)
-            {
 #ifdef DEBUG_MEMORY_CACHE
-                qDebug()<<"Cleaning Memory cache="<<" started with "<<cachequeue.count()<<" tile "<<"ocupying "<<memoryCacheSize<<" bytes";
+            qDebug()<<"Cleaning Memory cache="<<" started with "<<cachequeue.count()<<" tile "<<"ocupying "<<memoryCacheSize<<" bytes";
 #endif
-                RawTile first=list.dequeue();
-                memoryCacheSize-=cachequeue.value(first).size();
-                cachequeue.remove(first);
-            }
+            RawTile first=list.dequeue();
+            memoryCacheSize-=cachequeue.value(first).size();
+            cachequeue.remove(first);
         }
 #ifdef DEBUG_MEMORY_CACHE
         qDebug()<<"Cleaning Memory cache="<<" ended with "<<cachequeue.count()<<" tile "<<"ocupying "<<memoryCacheSize<<" bytes";
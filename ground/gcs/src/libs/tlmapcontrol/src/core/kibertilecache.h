@@ -47,7 +47,7 @@ namespace core {
         QReadWriteLock kiberCacheLock;
         QHash <RawTile,QByteArray> cachequeue;
         QQueue <RawTile> list;
-        long memoryCacheSize;
+        qint64 memoryCacheSize;
     private:
         int _MemoryCacheCapacity;
 
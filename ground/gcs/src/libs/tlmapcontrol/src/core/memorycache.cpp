@@ -48,12 +48,23 @@ namespace core {
     {
         kiberCacheLock.lockForWrite();
         // QPixmapCache::Key key=TilesInMemory.insert(pic);
+        if(TilesInMemory.cachequeue.contains(tile))
+        {
+            // Replaced in place, it keeps its age
+            TilesInMemory.memoryCacheSize +=pic.size()-TilesInMemory.cachequeue.value(tile).size();
+            TilesInMemory.cachequeue.insert(tile,pic);
+            kiberCacheLock.unlock();
+            return;
+        }
         TilesInMemory.memoryCacheSize +=pic.size();
 #ifdef DEBUG_MEMORY_CACHE
         qDebug()<<"Current memory="<<TilesInMemory.memoryCacheSize<<" in "<<TilesInMemory.cachequeue.count()<<" tiles";
 #endif
         TilesInMemory.cachequeue.insert(tile,pic);
         TilesInMemory.list.enqueue(tile);
+        // Evict as tiles arrive rather than once a load burst is over, so
+        // the bytes held never exceed the capacity
+        TilesInMemory.RemoveMemoryOverload();
 
         kiberCacheLock.unlock();
     }
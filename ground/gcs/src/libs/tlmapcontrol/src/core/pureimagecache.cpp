@@ -32,15 +32,100 @@
 namespace core {
     qlonglong PureImageCache::ConnCounter=0;
 
-    PureImageCache::PureImageCache()
+    /**
+    * A connection to the tile database owned by one thread, with the
+    * statements used for every tile prepared once
+    */
+    class PureImageCache::Connection
     {
+    public:
+        Connection(const QString &file,const QString &name,int generation);
+        ~Connection();
+        bool isOpen() const {return open;}
 
+        QString name;
+        int generation;
+        QSqlDatabase db;
+        QSqlQuery *selectTile;
+        QSqlQuery *selectExists;
+        QSqlQuery *insertTile;
+        QSqlQuery *insertData;
+    private:
+        bool open;
+    };
+
+    PureImageCache::Connection::Connection(const QString &file,const QString &name,int generation):
+        name(name),generation(generation),selectTile(0),selectExists(0),insertTile(0),insertData(0),open(false)
+    {
+        db = QSqlDatabase::addDatabase("QSQLITE",name);
+        db.setDatabaseName(file);
+        // The write-behind thread and the loaders may overlap, wait instead of failing
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=2000");
+        if(!db.open())
+        {
+#ifdef DEBUG_PUREIMAGECACHE
+            qDebug()<<"Connection: "<<db.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+            return;
+        }
+        {
+            QSqlQuery query(db);
+            // Readers then never wait on the writer, and a commit costs one sync at checkpoints
+            query.exec("PRAGMA journal_mode=WAL");
+            query.exec("PRAGMA synchronous=NORMAL");
+            // Databases created before the index existed get it on first use
+            query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (Type, Zoom, X, Y)");
+        }
+        selectTile=new QSqlQuery(db);
+        selectExists=new QSqlQuery(db);
+        insertTile=new QSqlQuery(db);
+        insertData=new QSqlQuery(db);
+        open=selectTile->prepare("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE Type=? AND Zoom=? AND X=? AND Y=?)") &&
+                selectExists->prepare("SELECT 1 FROM Tiles WHERE Type=? AND Zoom=? AND X=? AND Y=?") &&
+                insertTile->prepare("INSERT INTO Tiles(X, Y, Zoom, Type, Date) VALUES(?, ?, ?, ?, ?)") &&
+                insertData->prepare("INSERT INTO TilesData(id, Tile) VALUES(?, ?)");
+    }
+
+    PureImageCache::Connection::~Connection()
+    {
+        // Nothing may refer to the connection any more when it is removed
+        delete selectTile;
+        delete selectExists;
+        delete insertTile;
+        delete insertData;
+        db.close();
+        db=QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+    }
+
+    PureImageCache::PureImageCache():generation(0)
+    {
+
+    }
+
+    /**
+    * Connection of the calling thread, opened on first use. Must be called
+    * with the lock held.
+    */
+    PureImageCache::Connection *PureImageCache::connection()
+    {
+        Connection *cn=connections.localData();
+        if(cn && cn->generation==generation)
+            return cn;
+        Mcounter.lock();
+        qlonglong id=++ConnCounter;
+        Mcounter.unlock();
+        // setLocalData() deletes the connection to the previous cache location
+        cn=new Connection(gtilecache+"Data.qmdb",QString("PureImageCache%1").arg(id),generation);
+        connections.setLocalData(cn);
+        return cn;
     }
 
     void PureImageCache::setGtileCache(const QString &value)
     {
         lock.lockForWrite();
         gtilecache=value;
+        ++generation;
         QDir d;
         if(!d.exists(gtilecache))
         {
@@ -163,6 +248,14 @@ namespace core {
             {
 #ifdef DEBUG_PUREIMAGECACHE
                 qDebug()<<"CreateEmptyDB: "<<query.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+                db.close();
+                return false;
+            }
+            if(!query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (Type, Zoom, X, Y)"))
+            {
+#ifdef DEBUG_PUREIMAGECACHE
+                qDebug()<<"CreateEmptyDB: "<<query.lastError().driverText();
 #endif //DEBUG_PUREIMAGECACHE
                 db.close();
                 return false;
@@ -174,86 +267,113 @@ namespace core {
     }
     bool PureImageCache::PutImageToCache(const QByteArray &tile, const MapType::Types &type,const Point &pos,const int &zoom)
     {
+        CacheItemQueue item(type,pos,tile,zoom);
+        QList<CacheItemQueue *> tiles;
+        tiles.append(&item);
+        return PutImagesToCache(tiles);
+    }
+    /**
+    * Store several tiles in one transaction, used by the write-behind
+    * TileCacheQueue to commit whatever accumulated since its last pass
+    */
+    bool PureImageCache::PutImagesToCache(const QList<CacheItemQueue *> &tiles)
+    {
+        lock.lockForRead();
         if(gtilecache.isEmpty()|gtilecache.isNull())
+        {
+            lock.unlock();
             return false;
-        lock.lockForRead();
+        }
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"PutImageToCache Start:";//<<pos;
+        qDebug()<<"PutImagesToCache Start:"<<tiles.count();
 #endif //DEBUG_PUREIMAGECACHE
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        Connection *cn=connection();
+        bool ret=cn->isOpen() && cn->db.transaction();
+        if(ret)
         {
-            QSqlDatabase cn;
-            cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-            QString db=gtilecache+"Data.qmdb";
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if(cn.open())
+            QString date=QDateTime::currentDateTime().toString();
+            foreach(CacheItemQueue *item,tiles)
             {
+                cn->insertTile->addBindValue(item->GetPosition().X());
+                cn->insertTile->addBindValue(item->GetPosition().Y());
+                cn->insertTile->addBindValue(item->GetZoom());
+                cn->insertTile->addBindValue((int)item->GetMapType());
+                cn->insertTile->addBindValue(date);
+                if(!cn->insertTile->exec())
                 {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                    query.addBindValue(pos.X());
-                    query.addBindValue(pos.Y());
-                    query.addBindValue(zoom);
-
-                    query.addBindValue((int)type);
-                    query.addBindValue(QDateTime::currentDateTime().toString());
-                    query.exec();
+                    ret=false;
+                    break;
                 }
+                cn->insertData->addBindValue(cn->insertTile->lastInsertId());
+                cn->insertData->addBindValue(item->GetImg());
+                if(!cn->insertData->exec())
                 {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                    query.addBindValue(tile);
-                    query.exec();
+                    ret=false;
+                    break;
                 }
-                cn.close();
+            }
+            if(ret)
+                ret=cn->db.commit();
+            else
+            {
+#ifdef DEBUG_PUREIMAGECACHE
+                qDebug()<<"PutImagesToCache: "<<cn->db.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+                cn->db.rollback();
             }
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
-        return true;
+        return ret;
+    }
+    /**
+    * Whether a tile is stored, answered from the index without reading the tile
+    */
+    bool PureImageCache::IsImageInCache(MapType::Types type, Point pos, int zoom)
+    {
+        lock.lockForRead();
+        bool ret=false;
+        if(gtilecache.isEmpty()|gtilecache.isNull())
+        {
+            lock.unlock();
+            return ret;
+        }
+        Connection *cn=connection();
+        if(cn->isOpen())
+        {
+            cn->selectExists->addBindValue((int)type);
+            cn->selectExists->addBindValue(zoom);
+            cn->selectExists->addBindValue(pos.X());
+            cn->selectExists->addBindValue(pos.Y());
+            ret=cn->selectExists->exec() && cn->selectExists->next();
+            cn->selectExists->finish();
+        }
+        lock.unlock();
+        return ret;
     }
     QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
     {
         lock.lockForRead();
         QByteArray ar;
         if(gtilecache.isEmpty()|gtilecache.isNull())
+        {
+            lock.unlock();
             return ar;
-        QString dir=gtilecache;
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        }
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"Cache dir="<<dir<<" Try to GET:"<<pos.X()+","+pos.Y();
+        qDebug()<<"Cache dir="<<gtilecache<<" Try to GET:"<<pos.X()+","+pos.Y();
 #endif //DEBUG_PUREIMAGECACHE
-
+        Connection *cn=connection();
+        if(cn->isOpen())
         {
-            QString db=dir+"Data.qmdb";
-            {
-                QSqlDatabase cn;
-
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
-                {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=%1 AND Y=%2 AND Zoom=%3 AND Type=%4)").arg(pos.X()).arg(pos.Y()).arg(zoom).arg((int) type));
-                        query.next();
-                        if(query.isValid())
-                        {
-                            ar=query.value(0).toByteArray();
-                        }
-                    }
-                    cn.close();
-                }
-            }
+            cn->selectTile->addBindValue((int)type);
+            cn->selectTile->addBindValue(zoom);
+            cn->selectTile->addBindValue(pos.X());
+            cn->selectTile->addBindValue(pos.Y());
+            if(cn->selectTile->exec() && cn->selectTile->next())
+                ar=cn->selectTile->value(0).toByteArray();
+            // Release the read snapshot so that checkpoints can proceed
+            cn->selectTile->finish();
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
         return ar;
     }
@@ -286,10 +406,14 @@ namespace core {
                             if(QDateTime::fromString(query.value(5).toString()).daysTo(QDateTime::currentDateTime())>days)
                                 add.append(query.value(0).toLongLong());
                         }
+                        cn.transaction();
+                        query.prepare("DELETE FROM Tiles WHERE id = ?");
                         foreach(long i,add)
                         {
-                            query.exec(QString("DELETE FROM Tiles WHERE id = %1;").arg(i));
+                            query.addBindValue((qlonglong)i);
+                            query.exec();
                         }
+                        cn.commit();
                     }
 
                     cn.close();
@@ -43,7 +43,14 @@
 #include <QList>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QThreadStorage>
+#include "cacheitemqueue.h"
 namespace core {
+    /**
+    * The tiles are kept in an SQLite database in WAL mode. Each thread
+    * opens its own connection on first use and keeps it, along with its
+    * prepared statements, until it exits.
+    */
     class PureImageCache
     {
 
@@ -51,16 +58,24 @@ namespace core {
         PureImageCache();
         static bool CreateEmptyDB(const QString &file);
         bool PutImageToCache(const QByteArray &tile,const MapType::Types &type,const core::Point &pos, const int &zoom);
+        bool PutImagesToCache(const QList<CacheItemQueue *> &tiles);
         QByteArray GetImageFromCache(MapType::Types type, core::Point pos, int zoom);
+        bool IsImageInCache(MapType::Types type, core::Point pos, int zoom);
         QString GtileCache();
         void setGtileCache(const QString &value);
         static bool ExportMapDataToDB(QString sourceFile, QString destFile);
         void deleteOlderTiles(int const& days);
     private:
+        class Connection;
+        Connection *connection();
+
         QString gtilecache;
         QMutex Mcounter;
         QReadWriteLock lock;
         static qlonglong ConnCounter;
+        QThreadStorage<Connection *> connections;
+        // Bumped when the cache moves, connections to the old database are reopened
+        int generation;
 
     };
 
@@ -80,21 +80,23 @@ void TileCacheQueue::run()
 #endif //DEBUG_TILECACHEQUEUE
     while(true)
     {
-        CacheItemQueue *task;
+        QList<CacheItemQueue *> tasks;
 #ifdef DEBUG_TILECACHEQUEUE
         qDebug()<<"Cache";
 #endif //DEBUG_TILECACHEQUEUE
         if(tileCacheQueue.count()>0)
         {
+            // Write everything queued so far in one transaction
             mutex.lock();
-            task=tileCacheQueue.dequeue();
+            while(!tileCacheQueue.isEmpty() && tasks.count()<MAX_BATCH)
+                tasks.append(tileCacheQueue.dequeue());
             mutex.unlock();
 #ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Cache engine Put:"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
+            qDebug()<<"Cache engine Put:"<<tasks.count()<<"tiles";
 #endif //DEBUG_TILECACHEQUEUE
-            Cache::Instance()->ImageCache.PutImageToCache(task->GetImg(),task->GetMapType(),task->GetPosition(),task->GetZoom());
+            Cache::Instance()->ImageCache.PutImagesToCache(tasks);
             usleep(44);
-            delete task;
+            qDeleteAll(tasks);
         }
 
         else
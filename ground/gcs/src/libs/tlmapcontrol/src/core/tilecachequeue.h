@@ -51,6 +51,8 @@ namespace core {
     protected:
         QQueue<CacheItemQueue*> tileCacheQueue;
     private:
+        // Most tiles written in one transaction
+        static const int MAX_BATCH=256;
         void run();
         QMutex mutex;
         QMutex waitmutex;
@@ -357,143 +357,17 @@ namespace core {
             //Attempt to read file from original source
             if(accessmode!=AccessMode::CacheOnly)
             {
-                { //Otherwise, we're getting the tiles from the internet
-                    QEventLoop q;
-                    QNetworkReply *reply;
-                    QNetworkRequest qheader;
-                    QNetworkAccessManager network;
-                    QTimer tT;
-                    tT.setSingleShot(true);
-                    connect(&network, SIGNAL(finished(QNetworkReply*)),
-                            &q, SLOT(quit()));
-                    connect(&tT, SIGNAL(timeout()), &q, SLOT(quit()));
-                    network.setProxy(Proxy);
-    #ifdef DEBUG_GMAPS
-                    qDebug()<<"Try Tile from the Internet";
-    #endif //DEBUG_GMAPS
-    #ifdef DEBUG_TIMINGS
-                    qDebug()<<"opmaps before make image url"<<time.elapsed();
-    #endif
-                    QString url=MakeImageUrl(type,pos,zoom,LanguageStr);
-    #ifdef DEBUG_TIMINGS
-                    qDebug()<<"opmaps after make image url"<<time.elapsed();
-    #endif		//url	"http://vec02.maps.yandex.ru/tiles?l=map&v=2.10.2&x=7&y=5&z=3"	string
-                    //"http://map3.pergo.com.tr/tile/02/000/000/007/000/000/002.png"
-                    qheader.setUrl(QUrl(url));
-                    qheader.setRawHeader("User-Agent",UserAgent);
-                    qheader.setRawHeader("Accept","*/*");
-                    switch(type)
-                    {
-                    case MapType::GoogleMap:
-                    case MapType::GoogleSatellite:
-                    case MapType::GoogleLabels:
-                    case MapType::GoogleTerrain:
-                    case MapType::GoogleHybrid:
-                        {
-                            qheader.setRawHeader("Referrer", "http://maps.google.com/");
-                        }
-                        break;
-
-                    case MapType::GoogleMapChina:
-                    case MapType::GoogleSatelliteChina:
-                    case MapType::GoogleLabelsChina:
-                    case MapType::GoogleTerrainChina:
-                    case MapType::GoogleHybridChina:
-                        {
-                            qheader.setRawHeader("Referrer", "http://ditu.google.cn/");
-                        }
-                        break;
-
-                    case MapType::BingHybrid:
-                    case MapType::BingMap:
-                    case MapType::BingSatellite:
-                        {
-                            qheader.setRawHeader("Referrer", "http://www.bing.com/maps/");
-                        }
-                        break;
-
-                    case MapType::YahooHybrid:
-                    case MapType::YahooLabels:
-                    case MapType::YahooMap:
-                    case MapType::YahooSatellite:
-                        {
-                            qheader.setRawHeader("Referrer", "http://maps.yahoo.com/");
-                        }
-                        break;
-
-                    case MapType::ArcGIS_MapsLT_Map_Labels:
-                    case MapType::ArcGIS_MapsLT_Map:
-                    case MapType::ArcGIS_MapsLT_OrtoFoto:
-                    case MapType::ArcGIS_MapsLT_Map_Hybrid:
-                        {
-                            qheader.setRawHeader("Referrer", "http://www.maps.lt/map_beta/");
-                        }
-                        break;
-
-                    case MapType::OpenStreetMapSurfer:
-                    case MapType::OpenStreetMapSurferTerrain:
-                        {
-                            qheader.setRawHeader("Referrer", "http://www.mapsurfer.net/");
-                        }
-                        break;
-
-                    case MapType::OpenStreetMap:
-                    case MapType::OpenStreetOsm:
-                        {
-                            qheader.setRawHeader("Referrer", "http://www.openstreetmap.org/");
-                        }
-                        break;
-
-                    case MapType::YandexMapRu:
-                        {
-                            qheader.setRawHeader("Referrer", "http://maps.yandex.ru/");
-                        }
-                        break;
-                    default:
-                        break;
-                    }
-#ifdef DEBUG_GMAPS
-                    qDebug() << "qheader: " << qheader.url();
-#endif //DEBUG_GMAPS
-                    reply=network.get(qheader);
-                    tT.start(Timeout);
-                    q.exec();
-
-                    if(!tT.isActive()){
-                        errorvars.lock();
-                        ++diag.timeouts;
-                        errorvars.unlock();
-                        return ret;
-                    }
-                    tT.stop();
-                    if( (reply->error()!=QNetworkReply::NoError))
-                    {
-                        errorvars.lock();
-                        ++diag.networkerrors;
-                        errorvars.unlock();
-                        reply->deleteLater();
-                        return ret;
-                    }
-                    ret=reply->readAll();
-                    reply->deleteLater();//TODO can't this be global??
-                    if(ret.isEmpty())
-                    {
-    #ifdef DEBUG_GMAPS
-                        qDebug()<<"Invalid Tile";
-    #endif //DEBUG_GMAPS
-                        errorvars.lock();
-                        ++diag.emptytiles;
-                        errorvars.unlock();
-                        return ret;
-                    }
-    #ifdef DEBUG_GMAPS
-                    qDebug()<<"Received Tile from the Internet";
-    #endif //DEBUG_GMAPS
-                    errorvars.lock();
-                    ++diag.tilesFromNet;
-                }
-
-                errorvars.unlock();
+#ifdef DEBUG_TIMINGS
+                qDebug()<<"opmaps before make image url"<<time.elapsed();
+#endif
+                QString url=MakeImageUrl(type,pos,zoom,LanguageStr);
+#ifdef DEBUG_TIMINGS
+                qDebug()<<"opmaps after make image url"<<time.elapsed();
+#endif		//url	"http://vec02.maps.yandex.ru/tiles?l=map&v=2.10.2&x=7&y=5&z=3"	string
+                //"http://map3.pergo.com.tr/tile/02/000/000/007/000/000/002.png"
+                ret=DownloadImage(type,url);
+                if(ret.isEmpty())
+                    return ret;
 
                 //Save tile to cache
                 if (useMemoryCache)
@@ -523,6 +397,144 @@ namespace core {
         return ret;
     }
 
+    /**
+     * @brief Fetches a tile from its source, bypassing the memory and database caches
+     * @param type Type of map, selects the Referrer sent
+     * @param url Address of the tile, from MakeImageUrl or a local tile server
+     * @return The tile as received, empty on error or timeout
+     */
+    QByteArray TLMaps::DownloadImage(const MapType::Types &type,const QString &url)
+    {
+        QByteArray ret;
+        QEventLoop q;
+        QNetworkReply *reply;
+        QNetworkRequest qheader;
+        QNetworkAccessManager network;
+        QTimer tT;
+        tT.setSingleShot(true);
+        connect(&network, SIGNAL(finished(QNetworkReply*)),
+                &q, SLOT(quit()));
+        connect(&tT, SIGNAL(timeout()), &q, SLOT(quit()));
+        network.setProxy(Proxy);
+#ifdef DEBUG_GMAPS
+        qDebug()<<"Try Tile from the Internet";
+#endif //DEBUG_GMAPS
+        qheader.setUrl(QUrl(url));
+        qheader.setRawHeader("User-Agent",UserAgent);
+        qheader.setRawHeader("Accept","*/*");
+        switch(type)
+        {
+        case MapType::GoogleMap:
+        case MapType::GoogleSatellite:
+        case MapType::GoogleLabels:
+        case MapType::GoogleTerrain:
+        case MapType::GoogleHybrid:
+            {
+                qheader.setRawHeader("Referrer", "http://maps.google.com/");
+            }
+            break;
+
+        case MapType::GoogleMapChina:
+        case MapType::GoogleSatelliteChina:
+        case MapType::GoogleLabelsChina:
+        case MapType::GoogleTerrainChina:
+        case MapType::GoogleHybridChina:
+            {
+                qheader.setRawHeader("Referrer", "http://ditu.google.cn/");
+            }
+            break;
+
+        case MapType::BingHybrid:
+        case MapType::BingMap:
+        case MapType::BingSatellite:
+            {
+                qheader.setRawHeader("Referrer", "http://www.bing.com/maps/");
+            }
+            break;
+
+        case MapType::YahooHybrid:
+        case MapType::YahooLabels:
+        case MapType::YahooMap:
+        case MapType::YahooSatellite:
+            {
+                qheader.setRawHeader("Referrer", "http://maps.yahoo.com/");
+            }
+            break;
+
+        case MapType::ArcGIS_MapsLT_Map_Labels:
+        case MapType::ArcGIS_MapsLT_Map:
+        case MapType::ArcGIS_MapsLT_OrtoFoto:
+        case MapType::ArcGIS_MapsLT_Map_Hybrid:
+            {
+                qheader.setRawHeader("Referrer", "http://www.maps.lt/map_beta/");
+            }
+            break;
+
+        case MapType::OpenStreetMapSurfer:
+        case MapType::OpenStreetMapSurferTerrain:
+            {
+                qheader.setRawHeader("Referrer", "http://www.mapsurfer.net/");
+            }
+            break;
+
+        case MapType::OpenStreetMap:
+        case MapType::OpenStreetOsm:
+            {
+                qheader.setRawHeader("Referrer", "http://www.openstreetmap.org/");
+            }
+            break;
+
+        case MapType::YandexMapRu:
+            {
+                qheader.setRawHeader("Referrer", "http://maps.yandex.ru/");
+            }
+            break;
+        default:
+            break;
+        }
+#ifdef DEBUG_GMAPS
+        qDebug() << "qheader: " << qheader.url();
+#endif //DEBUG_GMAPS
+        reply=network.get(qheader);
+        tT.start(Timeout);
+        q.exec();
+
+        if(!tT.isActive()){
+            errorvars.lock();
+            ++diag.timeouts;
+            errorvars.unlock();
+            return ret;
+        }
+        tT.stop();
+        if( (reply->error()!=QNetworkReply::NoError))
+        {
+            errorvars.lock();
+            ++diag.networkerrors;
+            errorvars.unlock();
+            reply->deleteLater();
+            return ret;
+        }
+        ret=reply->readAll();
+        reply->deleteLater();//TODO can't this be global??
+        if(ret.isEmpty())
+        {
+#ifdef DEBUG_GMAPS
+            qDebug()<<"Invalid Tile";
+#endif //DEBUG_GMAPS
+            errorvars.lock();
+            ++diag.emptytiles;
+            errorvars.unlock();
+            return ret;
+        }
+#ifdef DEBUG_GMAPS
+        qDebug()<<"Received Tile from the Internet";
+#endif //DEBUG_GMAPS
+        errorvars.lock();
+        ++diag.tilesFromNet;
+        errorvars.unlock();
+        return ret;
+    }
+
     bool TLMaps::ExportToGMDB(const QString &file)
     {
         return Cache::Instance()->ImageCache.ExportMapDataToDB(Cache::Instance()->ImageCache.GtileCache()+QDir::separator()+"Data.qmdb",file);
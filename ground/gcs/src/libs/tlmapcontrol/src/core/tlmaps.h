@@ -67,6 +67,7 @@ namespace core {
 
 
         QByteArray GetImageFromServer(const MapType::Types &type,const core::Point &pos,const int &zoom);
+        QByteArray DownloadImage(const MapType::Types &type,const QString &url);
         QByteArray GetImageFromFile(const MapType::Types &type,const core::Point &pos,const int &zoom, double hScale, double vScale, QString userImageFileName, internals::PureProjection *projection);
         bool UseMemoryCache(){return useMemoryCache;}//TODO
         void setUseMemoryCache(const bool& value){useMemoryCache=value;}
@@ -139,11 +139,17 @@ namespace internals {
 #endif //DEBUG_CORE
                                 }
 
+                                // Decode here rather than on every paint in the GUI thread, in
+                                // the format the raster engine draws fastest
+                                QImage image;
                                 if(tileImage.length()!=0)
+                                    image=QImage::fromData(tileImage).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+                                if(!image.isNull())
                                 {
                                     Moverlays.lock();
                                     {
-                                        t->Overlays.append(tileImage);
+                                        t->Overlays.append(image);
 #ifdef DEBUG_CORE
                                         qDebug()<<"Core::run append tileImage:"<<tileImage.length()<<" to tile:"<<t->GetPos().ToString()<<" now has "<<t->Overlays.count()<<" overlays"<<" ID="<<debug;
 #endif //DEBUG_CORE
@@ -10,6 +10,7 @@ HEADERS += core.h \
     pointlatlng.h \
     rectlatlng.h \
     sizelatlng.h \
+    tileprefetcher.h \
     debugheader.h
 SOURCES += core.cpp \
     rectangle.cpp \
@@ -20,6 +21,7 @@ SOURCES += core.cpp \
     sizelatlng.cpp \
     pointlatlng.cpp \
     loadtask.cpp \
+    tileprefetcher.cpp \
     mousewheelzoomtype.cpp
 HEADERS += ./projections/lks94projection.h \
     ./projections/mercatorprojection.h \
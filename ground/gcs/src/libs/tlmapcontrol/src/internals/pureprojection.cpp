@@ -83,12 +83,14 @@ Point PureProjection::FromLatLngToPixel(const PointLatLng &p,const int &zoom)
          Point topLeft = FromPixelToTileXY(FromLatLngToPixel(rect.LocationTopLeft(), zoom));
          Point rightBottom = FromPixelToTileXY(FromLatLngToPixel(rect.Bottom(), rect.Right(), zoom));
 
+         // Every point is visited once, no need to look for duplicates, which
+         // made large areas such as a prefetch quadratic in the tile count
          for(int x = (topLeft.X() - padding); x <= (rightBottom.X() + padding); x++)
          {
             for(int y = (topLeft.Y() - padding); y <= (rightBottom.Y() + padding); y++)
             {
                Point p = Point(x, y);
-               if(!ret.contains(p) && p.X() >= 0 && p.Y() >= 0)
+               if(p.X() >= 0 && p.Y() >= 0)
                {
                   ret.append(p);
                }
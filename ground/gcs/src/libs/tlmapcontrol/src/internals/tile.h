@@ -54,7 +54,8 @@ public:
         this->pos=cSource.pos;
     }
     bool HasValue(){return !(zoom==0);}
-    QList<QByteArray> Overlays;
+    // Decoded by the loader threads, painting only blits them
+    QList<QImage> Overlays;
 protected:
 
     QMutex mutex;
@@ -0,0 +1,305 @@
+/**
+******************************************************************************
+*
+* @file       tileprefetcher.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Stores the tiles of an area in the cache ahead of use
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "tileprefetcher.h"
+#include "../core/tlmaps.h"
+#include <QRunnable>
+#include <QImage>
+
+using namespace core;
+
+namespace internals {
+    /**
+    * Takes tiles from the prefetcher until there are none left
+    */
+    class TilePrefetcher::Worker:public QRunnable
+    {
+    public:
+        Worker(TilePrefetcher *prefetcher):prefetcher(prefetcher){}
+        void run()
+        {
+            Job job;
+            while(prefetcher->NextJob(job))
+                prefetcher->Fetch(job);
+            prefetcher->WorkerFinished();
+        }
+    private:
+        TilePrefetcher *prefetcher;
+    };
+
+    TilePrefetcher::TilePrefetcher(QObject *parent):QObject(parent),nextJob(0),pendingBytes(0),heldBytes(0),peakBytes(0),
+        memoryBudget(DEFAULT_MEMORY_BUDGET),threadCount(DEFAULT_THREAD_COUNT),runningWorkers(0),done(0),stored(0),skipped(0),failed(0),cancel(false)
+    {
+    }
+
+    TilePrefetcher::~TilePrefetcher()
+    {
+        Cancel();
+        Wait();
+    }
+
+    /**
+    * @brief Start storing the tiles of an area, for every layer of the map type
+    *
+    * @param type map type, as shown by the map
+    * @param projection projection of the map type, only used before returning
+    * @param area area to store
+    * @param minZoom lowest zoom level stored
+    * @param maxZoom highest zoom level stored
+    * @return false if a prefetch is already running or there is nothing to fetch
+    */
+    bool TilePrefetcher::Start(MapType::Types const& type,PureProjection *projection,RectLatLng const& area,int minZoom,int maxZoom)
+    {
+        mutex.lock();
+        if(runningWorkers>0 || area.IsEmpty())
+        {
+            mutex.unlock();
+            return false;
+        }
+
+        jobs.clear();
+        QVector<MapType::Types> layers=TLMaps::Instance()->GetAllLayersOfType(type);
+        for(int zoom=minZoom;zoom<=maxZoom;++zoom)
+        {
+            QList<Point> points=projection->GetAreaTileList(area,zoom,0);
+            int maxY=projection->GetTileMatrixMaxXY(zoom).Height();
+            foreach(MapType::Types layer,layers)
+            {
+                // User images are made from a file and never cached
+                if(layer==MapType::UserImage)
+                    continue;
+                foreach(Point p,points)
+                {
+                    Job job;
+                    job.type=layer;
+                    // tile number inversion(BottomLeft -> TopLeft) for pergo maps, as Core does
+                    job.pos=(layer==MapType::PergoTurkeyMap)? Point(p.X(),maxY-p.Y()) : p;
+                    job.zoom=zoom;
+                    jobs.append(job);
+                }
+            }
+        }
+        if(jobs.isEmpty())
+        {
+            mutex.unlock();
+            return false;
+        }
+
+        nextJob=0;
+        pendingBytes=0;
+        heldBytes=0;
+        peakBytes=0;
+        done=0;
+        stored=0;
+        skipped=0;
+        failed=0;
+        cancel=false;
+        runningWorkers=qMax(1,threadCount);
+        pool.setMaxThreadCount(runningWorkers);
+        for(int i=0;i<runningWorkers;++i)
+            pool.start(new Worker(this));
+        int total=jobs.count();
+        mutex.unlock();
+
+        emit Progress(0,total);
+        return true;
+    }
+
+    /**
+    * @brief Stop fetching. The tiles already downloaded are still written
+    * and Finished() is emitted once they are.
+    */
+    void TilePrefetcher::Cancel()
+    {
+        mutex.lock();
+        cancel=true;
+        budgetFreed.wakeAll();
+        mutex.unlock();
+    }
+
+    void TilePrefetcher::Wait()
+    {
+        pool.waitForDone();
+    }
+
+    bool TilePrefetcher::IsRunning()
+    {
+        mutex.lock();
+        bool ret=runningWorkers>0;
+        mutex.unlock();
+        return ret;
+    }
+
+    qint64 TilePrefetcher::PeakMemory()
+    {
+        mutex.lock();
+        qint64 ret=peakBytes;
+        mutex.unlock();
+        return ret;
+    }
+
+    /**
+    * Hand out the next tile, waiting while the tiles held use up the budget.
+    * Pending tiles are committed at half the budget, so whenever it is used
+    * up a batch is being written and will free it.
+    */
+    bool TilePrefetcher::NextJob(Job &job)
+    {
+        mutex.lock();
+        while(!cancel && heldBytes>0 && heldBytes>=memoryBudget)
+            budgetFreed.wait(&mutex);
+        bool ret=!cancel && nextJob<jobs.count();
+        if(ret)
+            job=jobs[nextJob++];
+        mutex.unlock();
+        return ret;
+    }
+
+    QString TilePrefetcher::MakeUrl(const Job &job)
+    {
+        if(urlTemplate.isEmpty())
+            return TLMaps::Instance()->MakeImageUrl(job.type,job.pos,job.zoom,LanguageType().toShortString(TLMaps::Instance()->GetLanguage()));
+        QString url=urlTemplate;
+        url.replace("{z}",QString::number(job.zoom));
+        url.replace("{x}",QString::number(job.pos.X()));
+        url.replace("{y}",QString::number(job.pos.Y()));
+        return url;
+    }
+
+    /**
+    * Download a tile unless the cache has it already. Decoding it checks it
+    * is an image, a provider may answer with an error page or a truncated file.
+    */
+    void TilePrefetcher::Fetch(const Job &job)
+    {
+        if(Cache::Instance()->ImageCache.IsImageInCache(job.type,job.pos,job.zoom))
+        {
+            JobDone(&skipped);
+            return;
+        }
+
+        QString url=MakeUrl(job);
+        int retry=0;
+        do
+        {
+            QByteArray tile=TLMaps::Instance()->DownloadImage(job.type,url);
+            if(!tile.isEmpty() && !QImage::fromData(tile).isNull())
+            {
+                Store(job,tile);
+                return;
+            }
+        }
+        while(++retry<TLMaps::Instance()->RetryLoadTile && !cancel);
+        JobDone(&failed);
+    }
+
+    /**
+    * Queue a tile for writing, the worker which fills a batch writes it
+    */
+    void TilePrefetcher::Store(const Job &job,const QByteArray &tile)
+    {
+        QList<CacheItemQueue *> batch;
+        qint64 batchBytes=0;
+
+        mutex.lock();
+        pending.append(new CacheItemQueue(job.type,job.pos,tile,job.zoom));
+        pendingBytes+=tile.size();
+        heldBytes+=tile.size();
+        peakBytes=qMax(peakBytes,heldBytes);
+        if(pending.count()>=MAX_BATCH || pendingBytes*2>=memoryBudget)
+        {
+            batch=pending;
+            batchBytes=pendingBytes;
+            pending.clear();
+            pendingBytes=0;
+        }
+        mutex.unlock();
+
+        JobDone(0);
+        if(!batch.isEmpty())
+            Write(batch,batchBytes);
+    }
+
+    void TilePrefetcher::Write(const QList<CacheItemQueue *> &batch,qint64 bytes)
+    {
+        bool ok=Cache::Instance()->ImageCache.PutImagesToCache(batch);
+        qDeleteAll(batch);
+
+        mutex.lock();
+        if(ok)
+            stored+=batch.count();
+        else
+            failed+=batch.count();
+        heldBytes-=bytes;
+        budgetFreed.wakeAll();
+        mutex.unlock();
+    }
+
+    void TilePrefetcher::JobDone(int *counter)
+    {
+        mutex.lock();
+        if(counter)
+            ++*counter;
+        int count=++done;
+        int total=jobs.count();
+        mutex.unlock();
+
+        if(count==total || (count%32)==0)
+            emit Progress(count,total);
+    }
+
+    /**
+    * The last worker to run out of tiles writes what is left. The others
+    * have returned from their own writes by then.
+    */
+    void TilePrefetcher::WorkerFinished()
+    {
+        mutex.lock();
+        if(runningWorkers>1)
+        {
+            --runningWorkers;
+            mutex.unlock();
+            return;
+        }
+        QList<CacheItemQueue *> batch=pending;
+        qint64 batchBytes=pendingBytes;
+        pending.clear();
+        pendingBytes=0;
+        mutex.unlock();
+
+        if(!batch.isEmpty())
+            Write(batch,batchBytes);
+
+        mutex.lock();
+        runningWorkers=0;
+        int s=stored;
+        int sk=skipped;
+        int f=failed;
+        mutex.unlock();
+
+        emit Finished(s,sk,f);
+    }
+}
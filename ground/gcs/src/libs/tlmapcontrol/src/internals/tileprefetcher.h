@@ -0,0 +1,129 @@
+/**
+******************************************************************************
+*
+* @file       tileprefetcher.h
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Stores the tiles of an area in the cache ahead of use
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef TILEPREFETCHER_H
+#define TILEPREFETCHER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QList>
+#include "../core/maptype.h"
+#include "../core/point.h"
+#include "../core/cacheitemqueue.h"
+#include "pureprojection.h"
+#include "rectlatlng.h"
+
+namespace internals {
+    /**
+    * Stores every tile of an area over a range of zoom levels in the
+    * persistent cache, so that a map used in the field later finds all of
+    * them there. Tiles are downloaded and checked by decoding them on a
+    * pool of worker threads, then committed in batches.
+    *
+    * The tiles come from the map provider, or from a local tile server or
+    * directory when a URL template is set. The tiles waiting to be written
+    * are bounded in bytes, workers stall once the budget is used up until
+    * the batch being written is committed.
+    */
+    class TilePrefetcher:public QObject
+    {
+        Q_OBJECT
+    public:
+        static const int DEFAULT_THREAD_COUNT=4;
+        static const qint64 DEFAULT_MEMORY_BUDGET=16*1048576;
+
+        TilePrefetcher(QObject *parent=0);
+        ~TilePrefetcher();
+
+        bool Start(core::MapType::Types const& type,PureProjection *projection,RectLatLng const& area,int minZoom,int maxZoom);
+        void Cancel();
+        void Wait();
+        bool IsRunning();
+
+        /**
+        * @brief Fetch from a local source instead of the provider
+        *
+        * @param value URL with {z}, {x} and {y} replaced by the tile
+        * coordinates, e.g. http://localhost:8080/{z}/{x}/{y}.png or
+        * file:///media/tiles/{z}/{x}/{y}.png. Empty to use the provider.
+        */
+        void SetUrlTemplate(QString const& value){urlTemplate=value;}
+        QString UrlTemplate()const{return urlTemplate;}
+        void SetMemoryBudget(qint64 const& bytes){memoryBudget=bytes;}
+        qint64 MemoryBudget()const{return memoryBudget;}
+        void SetThreadCount(int const& value){threadCount=value;}
+        int ThreadCount()const{return threadCount;}
+        //! Most bytes held waiting to be written during the last run
+        qint64 PeakMemory();
+
+    signals:
+        void Progress(int done,int total);
+        void Finished(int stored,int skipped,int failed);
+
+    private:
+        class Worker;
+        struct Job
+        {
+            core::MapType::Types type;
+            core::Point pos;
+            int zoom;
+        };
+        // Most tiles written in one transaction
+        static const int MAX_BATCH=256;
+
+        bool NextJob(Job &job);
+        void Fetch(const Job &job);
+        void Store(const Job &job,const QByteArray &tile);
+        void Write(const QList<core::CacheItemQueue *> &batch,qint64 bytes);
+        void JobDone(int *counter);
+        void WorkerFinished();
+        QString MakeUrl(const Job &job);
+
+        QThreadPool pool;
+        QMutex mutex;
+        QWaitCondition budgetFreed;
+        QVector<Job> jobs;
+        int nextJob;
+        // Tiles not yet handed to the cache, and the bytes of those plus the ones being written
+        QList<core::CacheItemQueue *> pending;
+        qint64 pendingBytes;
+        qint64 heldBytes;
+        qint64 peakBytes;
+        qint64 memoryBudget;
+        QString urlTemplate;
+        int threadCount;
+        int runningWorkers;
+        int done;
+        int stored;
+        int skipped;
+        int failed;
+        bool cancel;
+    };
+}
+#endif // TILEPREFETCHER_H
@@ -44,6 +44,7 @@ namespace mapcontrol
 
         core=new internals::Core;
         map=new MapGraphicItem(core,config);
+        prefetcher=new internals::TilePrefetcher(this);
 
         scene()->addItem(map);
         Home=new HomeItem(map,this);
@@ -61,6 +62,8 @@ namespace mapcontrol
         connect(map->core,SIGNAL(OnTileLoadComplete()),this,SIGNAL(OnTileLoadComplete()));
         connect(map->core,SIGNAL(OnTileLoadStart()),this,SIGNAL(OnTileLoadStart()));
         connect(map->core,SIGNAL(OnTilesStillToLoad(int)),this,SIGNAL(OnTilesStillToLoad(int)));
+        connect(prefetcher,SIGNAL(Progress(int,int)),this,SIGNAL(OnPrefetchProgress(int,int)));
+        connect(prefetcher,SIGNAL(Finished(int,int,int)),this,SIGNAL(OnPrefetchFinished(int,int,int)));
         connect(map,SIGNAL(wpdoubleclicked(WayPointItem*)),this,SIGNAL(OnWayPointDoubleClicked(WayPointItem*)));
         connect(scene(),SIGNAL(selectionChanged()),this,SLOT(OnSelectionChanged()));
         SetShowDiagnostics(showDiag);
@@ -646,6 +649,11 @@ namespace mapcontrol
         new MapRipper(core,map->SelectedArea());
     }
 
+    bool TLMapWidget::PrefetchArea(internals::RectLatLng const& area,int minZoom,int maxZoom)
+    {
+        return prefetcher->Start(core->GetMapType(),core->Projection(),area,minZoom,qMin(maxZoom,core->MaxZoom()));
+    }
+
     void TLMapWidget::setSelectedWP(QList<WayPointItem * >list)
     {
         this->scene()->clearSelection();
@@ -42,6 +42,7 @@
 #include "gpsitem.h"
 #include "homeitem.h"
 #include "mapripper.h"
+#include "../internals/tileprefetcher.h"
 #include "mapline.h"
 #include "mapcircle.h"
 #include "waypointcurve.h"
@@ -219,6 +220,10 @@ namespace mapcontrol
 
         internals::RectLatLng SelectedArea()const{return  map->selectedArea;}
         void SetSelectedArea(internals::RectLatLng const& value){ map->selectedArea = value;this->update();}
+        /**
+        * @brief Prefetcher used by PrefetchArea, to set its source, threads and memory budget
+        */
+        internals::TilePrefetcher *Prefetcher(){return prefetcher;}
 
         bool CanDragMap()const{return map->CanDragMap();}
         void SetCanDragMap(bool const& value){map->SetCanDragMap(value);}
@@ -395,6 +400,7 @@ namespace mapcontrol
       private:
         internals::Core *core;
         MapGraphicItem *map;
+        internals::TilePrefetcher *prefetcher;
         bool useOpenGL;
         GeoCoderStatusCode x;
         MapType y;
@@ -521,6 +527,21 @@ namespace mapcontrol
         * @param number the number of tiles still in the queue
         */
         void OnTilesStillToLoad(int number);
+        /**
+        * @brief Fires as a prefetch goes through the tiles of its area
+        *
+        * @param done the number of tiles stored, skipped or failed so far
+        * @param total the number of tiles in the area
+        */
+        void OnPrefetchProgress(int done,int total);
+        /**
+        * @brief Fires once a prefetch has written its last tile
+        *
+        * @param stored the number of tiles added to the cache
+        * @param skipped the number of tiles the cache had already
+        * @param failed the number of tiles which could not be fetched or stored
+        */
+        void OnPrefetchFinished(int stored,int skipped,int failed);
         void OnWayPointDoubleClicked(WayPointItem * waypoint);
         void selectedWPChanged(QList<WayPointItem*>);
     public slots:
@@ -528,6 +549,12 @@ namespace mapcontrol
         * @brief Ripps the current selection to the DB
         */
         void RipMap();
+        /**
+        * @brief Stores every tile of an area between two zoom levels in the cache, without prompting
+        *
+        * @return false if a prefetch is already running or the area is empty
+        */
+        bool PrefetchArea(internals::RectLatLng const& area,int minZoom,int maxZoom);
         void OnSelectionChanged();
 
     };
@@ -0,0 +1,258 @@
+/**
+ ******************************************************************************
+ * @file       tilecachebenchmark.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSLibraries GCS Libraries
+ * @{
+ * @addtogroup TLMapControl
+ * @{
+ * @brief Stores and loads a large number of tiles through PureImageCache and
+ * compares it with opening a connection for every tile as it used to
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+#include <QtCore/qmath.h>
+#include "pureimagecache.h"
+
+using namespace core;
+
+static const int DEFAULT_TILES = 50000;
+//! Typical size of a compressed 256x256 tile
+static const int TILE_BYTES = 2048;
+//! Tiles written per transaction, as TileCacheQueue does
+static const int BATCH_SIZE = 256;
+//! Tiles going through the old code path, it is too slow for the full set
+static const int LEGACY_TILES = 1000;
+static const int LOADER_THREADS = 4;
+static const int ZOOM = 17;
+static const MapType::Types TYPE = MapType::GoogleSatellite;
+
+/**
+ * Lay the tiles out as a square area, like a map panned over at one zoom level
+ */
+static Point tilePosition(int index, int side)
+{
+    return Point(70000 + index % side, 45000 + index / side);
+}
+
+/**
+ * Contents are unique per tile so that a load returning the wrong row shows up
+ */
+static QByteArray tileData(int index)
+{
+    QByteArray data(TILE_BYTES, (char)(index * 31));
+    memcpy(data.data(), &index, sizeof(index));
+    return data;
+}
+
+/**
+ * The store and load as they were done before the connections were kept:
+ * a connection opened and removed for every tile and the SELECT built as text
+ */
+class LegacyTileCache
+{
+public:
+    LegacyTileCache(const QString &file) : file(file), counter(0) {}
+
+    void put(const QByteArray &tile, MapType::Types type, const Point &pos, int zoom)
+    {
+        QString name = QString("legacy%1").arg(++counter);
+        {
+            QSqlDatabase cn = QSqlDatabase::addDatabase("QSQLITE", name);
+            cn.setDatabaseName(file);
+            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
+            if (cn.open()) {
+                {
+                    QSqlQuery query(cn);
+                    query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
+                    query.addBindValue(pos.X());
+                    query.addBindValue(pos.Y());
+                    query.addBindValue(zoom);
+                    query.addBindValue((int)type);
+                    query.addBindValue(QDateTime::currentDateTime().toString());
+                    query.exec();
+                }
+                {
+                    QSqlQuery query(cn);
+                    query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
+                    query.addBindValue(tile);
+                    query.exec();
+                }
+                cn.close();
+            }
+        }
+        QSqlDatabase::removeDatabase(name);
+    }
+
+    QByteArray get(MapType::Types type, const Point &pos, int zoom)
+    {
+        QByteArray ar;
+        QString name = QString("legacy%1").arg(++counter);
+        {
+            QSqlDatabase cn = QSqlDatabase::addDatabase("QSQLITE", name);
+            cn.setDatabaseName(file);
+            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
+            if (cn.open()) {
+                {
+                    QSqlQuery query(cn);
+                    query.exec(QString("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=%1 AND Y=%2 AND Zoom=%3 AND Type=%4)").arg(pos.X()).arg(pos.Y()).arg(zoom).arg((int)type));
+                    if (query.next())
+                        ar = query.value(0).toByteArray();
+                }
+                cn.close();
+            }
+        }
+        QSqlDatabase::removeDatabase(name);
+        return ar;
+    }
+
+private:
+    QString file;
+    int counter;
+};
+
+/**
+ * Loads a slice of the tiles from a pool thread, each of which gets its own connection
+ */
+class Loader : public QRunnable
+{
+public:
+    Loader(PureImageCache *cache, int first, int count, int side, QAtomicInt *errors) :
+        cache(cache), first(first), count(count), side(side), errors(errors) {}
+
+    void run()
+    {
+        for (int i = first; i < first + count; ++i) {
+            if (cache->GetImageFromCache(TYPE, tilePosition(i, side), ZOOM) != tileData(i))
+                errors->ref();
+        }
+    }
+
+private:
+    PureImageCache *cache;
+    int first;
+    int count;
+    int side;
+    QAtomicInt *errors;
+};
+
+static void report(QTextStream &out, const char *name, qint64 nsecs, int tiles, int errors)
+{
+    double seconds = nsecs / 1e9;
+    out << name << ": " << tiles / seconds << " tiles/s, " << nsecs / 1000.0 / tiles << " us/tile";
+    if (errors)
+        out << " (" << errors << " ERRORS)";
+    out << "\n";
+    out.flush();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    int tiles = DEFAULT_TILES;
+    if (argc > 1)
+        tiles = qMax(LEGACY_TILES, QString(argv[1]).toInt());
+    int side = qCeil(qSqrt(tiles));
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        out << "Unable to create a temporary directory\n";
+        return 1;
+    }
+    PureImageCache cache;
+    cache.setGtileCache(dir.path() + "/");
+    out << "Tiles: " << tiles << " of " << TILE_BYTES << " bytes in " << dir.path() << "\n";
+
+    QElapsedTimer timer;
+    int errors;
+
+    // Store, in batches as the write-behind queue hands them over
+    timer.start();
+    QList<CacheItemQueue *> batch;
+    errors = 0;
+    for (int i = 0; i < tiles; ++i) {
+        batch.append(new CacheItemQueue(TYPE, tilePosition(i, side), tileData(i), ZOOM));
+        if (batch.size() == BATCH_SIZE || i == tiles - 1) {
+            if (!cache.PutImagesToCache(batch))
+                errors += batch.size();
+            qDeleteAll(batch);
+            batch.clear();
+        }
+    }
+    report(out, "store, batched transactions", timer.nsecsElapsed(), tiles, errors);
+
+    // Load in a scattered order so that neither SQLite nor the OS sees a sequential scan
+    timer.start();
+    errors = 0;
+    for (int n = 0; n < tiles; ++n) {
+        int i = (int)(((qint64)n * 7919) % tiles);
+        if (cache.GetImageFromCache(TYPE, tilePosition(i, side), ZOOM) != tileData(i))
+            ++errors;
+    }
+    report(out, "load, persistent connection", timer.nsecsElapsed(), tiles, errors);
+
+    // Load from several threads at once, as the map loaders do
+    QThreadPool pool;
+    pool.setMaxThreadCount(LOADER_THREADS);
+    QAtomicInt threadErrors(0);
+    int slice = (tiles + LOADER_THREADS - 1) / LOADER_THREADS;
+    timer.start();
+    for (int t = 0; t < LOADER_THREADS; ++t) {
+        int first = t * slice;
+        pool.start(new Loader(&cache, first, qMin(slice, tiles - first), side, &threadErrors));
+    }
+    pool.waitForDone();
+    report(out, "load, 4 threads", timer.nsecsElapsed(), tiles, threadErrors.load());
+
+    // The old code path, on a subset
+    QString legacyFile = dir.path() + "/Legacy.qmdb";
+    PureImageCache::CreateEmptyDB(legacyFile);
+    LegacyTileCache legacy(legacyFile);
+    timer.start();
+    for (int i = 0; i < LEGACY_TILES; ++i)
+        legacy.put(tileData(i), TYPE, tilePosition(i, side), ZOOM);
+    report(out, "store, connection per tile", timer.nsecsElapsed(), LEGACY_TILES, 0);
+
+    LegacyTileCache legacyMain(dir.path() + "/Data.qmdb");
+    timer.start();
+    errors = 0;
+    for (int n = 0; n < LEGACY_TILES; ++n) {
+        int i = (int)(((qint64)n * 7919) % tiles);
+        if (legacyMain.get(TYPE, tilePosition(i, side), ZOOM) != tileData(i))
+            ++errors;
+    }
+    report(out, "load, connection per tile", timer.nsecsElapsed(), LEGACY_TILES, errors);
+
+    return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
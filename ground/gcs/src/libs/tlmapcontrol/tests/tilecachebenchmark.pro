@@ -0,0 +1,14 @@
+# -------------------------------------------------
+# Map tile cache store and load benchmark
+# Usage: tilecachebenchmark [tiles]
+# -------------------------------------------------
+QT += sql
+TARGET = tilecachebenchmark
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+include(../../../../gcs.pri)
+INCLUDEPATH *= ../src/core
+LIBS += -L../src/build -lcore
+SOURCES += tilecachebenchmark.cpp
+POST_TARGETDEPS += ../src/build/libcore.a
@@ -0,0 +1,237 @@
+/**
+ ******************************************************************************
+ * @file       tileprefetchbenchmark.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSLibraries GCS Libraries
+ * @{
+ * @addtogroup TLMapControl
+ * @{
+ * @brief Prefetches an area from a stand-in tile server on localhost with
+ * one and with several workers, then again once the cache holds it
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QBuffer>
+#include <QImage>
+#include <QQueue>
+#include <QTimer>
+#include "tileprefetcher.h"
+#include "projections/mercatorprojection.h"
+#include "../src/core/cache.h"
+
+using namespace core;
+
+static const int DEFAULT_MIN_ZOOM = 12;
+static const int DEFAULT_MAX_ZOOM = 18;
+//! Time the server takes to answer, as a remote provider would
+static const int DEFAULT_LATENCY_MS = 20;
+//! Kept well below the area size to show the prefetcher stays within it
+static const qint64 MEMORY_BUDGET = 512 * 1024;
+//! Distinct tiles served, encoding them is not what is measured
+static const int TILE_VARIANTS = 16;
+
+/**
+ * Minimal HTTP server answering every GET with a PNG tile after a fixed
+ * delay, in place of a map provider
+ */
+class TileServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    TileServer(int latency) : latency(latency), requests(0)
+    {
+        clock.start();
+        timer.setSingleShot(true);
+        connect(&timer, SIGNAL(timeout()), this, SLOT(answer()));
+        connect(this, SIGNAL(newConnection()), this, SLOT(accept()));
+
+        for (int i = 0; i < TILE_VARIANTS; ++i) {
+            QImage image(256, 256, QImage::Format_RGB32);
+            for (int y = 0; y < image.height(); ++y)
+                for (int x = 0; x < image.width(); ++x)
+                    image.setPixel(x, y, qRgb((x * (i + 1)) & 0xff, (y * 3 + i * 16) & 0xff, ((x ^ y) + i) & 0xff));
+            QByteArray png;
+            QBuffer buffer(&png);
+            buffer.open(QIODevice::WriteOnly);
+            image.save(&buffer, "PNG");
+            tiles.append(png);
+        }
+    }
+
+    int requestCount() const { return requests; }
+
+private slots:
+    void accept()
+    {
+        while (hasPendingConnections()) {
+            QTcpSocket *socket = nextPendingConnection();
+            connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+            connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+        }
+    }
+
+    void readRequest()
+    {
+        QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+        if (!socket->canReadLine())
+            return;
+        // GET /z/x/y.png HTTP/1.1, the rest of the request is not needed
+        QList<QByteArray> line = socket->readLine().split(' ');
+        disconnect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+        ++requests;
+
+        Reply reply;
+        reply.socket = socket;
+        reply.due = clock.elapsed() + latency;
+        reply.data = tiles.at(qHash(line.value(1)) % TILE_VARIANTS);
+        replies.enqueue(reply);
+        if (!timer.isActive())
+            timer.start(latency);
+    }
+
+    void answer()
+    {
+        while (!replies.isEmpty() && replies.head().due <= clock.elapsed()) {
+            Reply reply = replies.dequeue();
+            reply.socket->write("HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nConnection: close\r\nContent-Length: ");
+            reply.socket->write(QByteArray::number(reply.data.size()));
+            reply.socket->write("\r\n\r\n");
+            reply.socket->write(reply.data);
+            reply.socket->disconnectFromHost();
+        }
+        if (!replies.isEmpty())
+            timer.start(qMax((qint64)0, replies.head().due - clock.elapsed()));
+    }
+
+private:
+    struct Reply {
+        QTcpSocket *socket;
+        qint64 due;
+        QByteArray data;
+    };
+
+    QList<QByteArray> tiles;
+    QQueue<Reply> replies;
+    QTimer timer;
+    QElapsedTimer clock;
+    int latency;
+    int requests;
+};
+
+/**
+ * Keeps the counts of the last run and ends the event loop waiting for it
+ */
+class Results : public QObject
+{
+    Q_OBJECT
+
+public:
+    Results() : stored(0), skipped(0), failed(0) {}
+    QEventLoop loop;
+    int stored;
+    int skipped;
+    int failed;
+
+public slots:
+    void finished(int s, int sk, int f)
+    {
+        stored = s;
+        skipped = sk;
+        failed = f;
+        loop.quit();
+    }
+};
+
+static void run(QTextStream &out, const char *name, internals::TilePrefetcher &prefetcher, Results &results,
+                const internals::RectLatLng &area, int minZoom, int maxZoom, TileServer &server)
+{
+    projections::MercatorProjection projection;
+    int requests = server.requestCount();
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!prefetcher.Start(MapType::OpenStreetMap, &projection, area, minZoom, maxZoom)) {
+        out << name << ": nothing to fetch\n";
+        return;
+    }
+    results.loop.exec();
+    prefetcher.Wait();
+    qint64 elapsed = timer.elapsed();
+
+    int tiles = results.stored + results.skipped + results.failed;
+    out << name << ": " << tiles << " tiles in " << elapsed << " ms, "
+        << tiles * 1000.0 / qMax((qint64)1, elapsed) << " tiles/s, "
+        << results.stored << " stored, " << results.skipped << " skipped, " << results.failed << " failed, "
+        << server.requestCount() - requests << " requests, peak " << prefetcher.PeakMemory() / 1024 << " KB held\n";
+    out.flush();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    int minZoom = argc > 1 ? QString(argv[1]).toInt() : DEFAULT_MIN_ZOOM;
+    int maxZoom = argc > 2 ? QString(argv[2]).toInt() : DEFAULT_MAX_ZOOM;
+    int latency = argc > 3 ? QString(argv[3]).toInt() : DEFAULT_LATENCY_MS;
+
+    QTemporaryDir dir;
+    TileServer server(latency);
+    if (!dir.isValid() || !server.listen(QHostAddress::LocalHost)) {
+        out << "Unable to set up the cache directory or the server\n";
+        return 1;
+    }
+
+    // A field sized area, about 2.3 km by 2.2 km
+    internals::RectLatLng area(46.52, 6.60, 0.03, 0.02);
+
+    internals::TilePrefetcher prefetcher;
+    Results results;
+    QObject::connect(&prefetcher, SIGNAL(Finished(int,int,int)), &results, SLOT(finished(int,int,int)));
+    prefetcher.SetUrlTemplate(QString("http://127.0.0.1:%1/{z}/{x}/{y}.png").arg(server.serverPort()));
+    prefetcher.SetMemoryBudget(MEMORY_BUDGET);
+    out << "Zoom " << minZoom << " to " << maxZoom << ", " << latency << " ms latency, "
+        << MEMORY_BUDGET / 1024 << " KB budget\n";
+
+    Cache::Instance()->setCacheLocation(dir.path() + "/serial/");
+    prefetcher.SetThreadCount(1);
+    run(out, "1 worker", prefetcher, results, area, minZoom, maxZoom, server);
+
+    Cache::Instance()->setCacheLocation(dir.path() + "/parallel/");
+    prefetcher.SetThreadCount(internals::TilePrefetcher::DEFAULT_THREAD_COUNT);
+    run(out, "4 workers", prefetcher, results, area, minZoom, maxZoom, server);
+
+    // Everything is in the cache now, nothing should be requested
+    run(out, "again, cached", prefetcher, results, area, minZoom, maxZoom, server);
+
+    return 0;
+}
+
+#include "tileprefetchbenchmark.moc"
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,17 @@
+# -------------------------------------------------
+# Map area prefetch benchmark against a local tile server
+# Usage: tileprefetchbenchmark [min zoom] [max zoom] [latency ms]
+# -------------------------------------------------
+QT += network sql
+TARGET = tileprefetchbenchmark
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+include(../../../../gcs.pri)
+INCLUDEPATH *= ../src/internals
+LIBS += -L../src/build -linternals -lcore
+LIBS += -L$$GCS_LIBRARY_PATH
+include(../../utils/utils.pri)
+SOURCES += tileprefetchbenchmark.cpp
+POST_TARGETDEPS += ../src/build/libcore.a
+POST_TARGETDEPS += ../src/build/libinternals.a
@@ -85,22 +85,22 @@ void DialGadgetWidget::enableOpenGL(bool flag)
 void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
                                           QString object2, QString nfield2,
                                           QString object3, QString nfield3) {
-    if (obj1 != NULL)
-        disconnect(obj1,SIGNAL(objectUpdated(UAVObject*)),this,SLOT(updateNeedle1(UAVObject*)));
-    if (obj2 != NULL)
-        disconnect(obj2,SIGNAL(objectUpdated(UAVObject*)),this,SLOT(updateNeedle2(UAVObject*)));
-    if (obj3 != NULL)
-        disconnect(obj3,SIGNAL(objectUpdated(UAVObject*)),this,SLOT(updateNeedle3(UAVObject*)));
+    obj1 = NULL;
+    obj2 = NULL;
+    obj3 = NULL;
 
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
+    // The needles cannot move faster than the screen refreshes, so take the
+    // updates once per frame rather than every time the objects arrive
+    objManager->subscribeBatched(this, SLOT(objectsUpdated(UAVObjectManager::ObjectSnapshots)));
+
     // Check validity of arguments first, reject empty args and unknown fields.
     if (!(object1.isEmpty() || nfield1.isEmpty())) {
         obj1 = dynamic_cast<UAVDataObject*>( objManager->getObject(object1) );
         if (obj1 != NULL ) {
             // qDebug() << "Connected Object 1 (" << object1 << ").";
-            connect(obj1, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateNeedle1(UAVObject*)));
             if(nfield1.contains("-"))
             {
                 QStringList fieldSubfield = nfield1.split("-", QString::SkipEmptyParts);
@@ -123,7 +123,6 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
         obj2 = dynamic_cast<UAVDataObject*>( objManager->getObject(object2) );
         if (obj2 != NULL ) {
             // qDebug() << "Connected Object 2 (" << object2 << ").";
-            connect(obj2, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateNeedle2(UAVObject*)));
             if(nfield2.contains("-"))
             {
                 QStringList fieldSubfield = nfield2.split("-", QString::SkipEmptyParts);
@@ -146,7 +145,6 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
         obj3 = dynamic_cast<UAVDataObject*>( objManager->getObject(object3) );
         if (obj3 != NULL ) {
             // qDebug() << "Connected Object 3 (" << object3 << ").";
-            connect(obj3, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateNeedle3(UAVObject*)));
             if(nfield3.contains("-"))
             {
                 QStringList fieldSubfield = nfield3.split("-", QString::SkipEmptyParts);
@@ -165,6 +163,20 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
     }
 }
 
+/*!
+  \brief Called once per batch of object updates
+  */
+void DialGadgetWidget::objectsUpdated(const UAVObjectManager::ObjectSnapshots &snapshots) {
+    foreach (const UAVObjectManager::ObjectSnapshot &snapshot, snapshots) {
+        if (snapshot.object == obj1)
+            updateNeedle1(obj1);
+        if (snapshot.object == obj2)
+            updateNeedle2(obj2);
+        if (snapshot.object == obj3)
+            updateNeedle3(obj3);
+    }
+}
+
 /*!
   \brief Called by the UAVObject which got updated
   */
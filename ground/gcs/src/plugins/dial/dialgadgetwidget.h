@@ -76,6 +76,7 @@ public slots:
    void updateNeedle1(UAVObject *object1); // Called by the UAVObject
    void updateNeedle2(UAVObject *object2); // Called by the UAVObject
    void updateNeedle3(UAVObject *object3); // Called by the UAVObject
+   void objectsUpdated(const UAVObjectManager::ObjectSnapshots &snapshots); // Called by the UAVObjectManager
 
 protected:
    void paintEvent(QPaintEvent *event);
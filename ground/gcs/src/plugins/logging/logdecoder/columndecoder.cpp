@@ -0,0 +1,195 @@
+/**
+ ******************************************************************************
+ * @file       columndecoder.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LoggingGadgetPlugin Logging Gadget Plugin
+ * @{
+ * @brief Decodes the packets of one object in a log into column arrays
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "columndecoder.h"
+#include <QFile>
+#include <QtEndian>
+
+ColumnDecoder::ColumnDecoder(QIODevice *iodev, UAVObjectManager *objMngr) :
+    UAVTalk(iodev, objMngr),
+    objId(0),
+    multiInstance(false),
+    timestamp(0),
+    rows(0),
+    capacity(0)
+{
+}
+
+/**
+ * Decode all packets of one object of a log
+ * @param index The index of the mapped log
+ * @param entry The object directory entry
+ * @return false if the object is not known to the object manager
+ */
+bool ColumnDecoder::decode(const LogIndex &index, const LogIndex::Object &entry)
+{
+    UAVObject *obj = objMngr->getObject(entry.objId);
+    if (obj == NULL)
+        return false;
+
+    objId = entry.objId;
+    name = obj->getName();
+    multiInstance = !obj->isSingleInstance();
+    rows = 0;
+    capacity = entry.count;
+    setupColumns(obj);
+
+    const quint32 *packets = index.packetsOf(entry);
+    for (quint32 n = 0; n < entry.count; ++n) {
+        const LogIndex::Packet &packet = index.packet(packets[n]);
+        timestamp = packet.timestamp;
+
+        // Every record holds a whole frame, a truncated one must not swallow
+        // the start of the next record
+        rxState = STATE_SYNC;
+        processInputBuffer(index.packetData(packets[n]), packet.size);
+    }
+
+    return true;
+}
+
+/**
+ * Store one received object as a row
+ */
+bool ColumnDecoder::receiveObject(quint8 type, quint32 objId, quint16 instId, const quint8 *data, qint32 length)
+{
+    if ((type != TYPE_OBJ && type != TYPE_OBJ_ACK) || objId != this->objId || rows >= capacity)
+        return false;
+
+    qToLittleEndian<quint32>(timestamp, (uchar *)timestamps.data() + rows * sizeof(quint32));
+    if (multiInstance)
+        qToLittleEndian<quint16>(instId, (uchar *)instances.data() + rows * sizeof(quint16));
+
+    for (int c = 0; c < columns.size(); ++c) {
+        Column &column = columns[c];
+        if ((qint32)(column.offset + column.size) <= length)
+            memcpy(column.values.data() + rows * column.size, data + column.offset, column.size);
+    }
+    rows++;
+    return true;
+}
+
+/**
+ * Write the decoded rows to a column file
+ * @return true on success
+ */
+bool ColumnDecoder::write(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QByteArray header;
+    header += "Tau Labs columnar log\n";
+    header += QString("object %1 0x%2\n").arg(name).arg(objId, 8, 16, QChar('0')).toLatin1();
+    header += QString("rows %1\n").arg(rows).toLatin1();
+    header += "column timestamp uint32\n";
+    if (multiInstance)
+        header += "column instance uint16\n";
+    foreach (const Column &column, columns)
+        header += QString("column %1 %2\n").arg(column.name).arg(column.type).toLatin1();
+    header += "##\n";
+
+    qint64 expected = header.size() + numBytes();
+    qint64 written = file.write(header);
+    written += file.write(timestamps.constData(), rows * sizeof(quint32));
+    if (multiInstance)
+        written += file.write(instances.constData(), rows * sizeof(quint16));
+    foreach (const Column &column, columns)
+        written += file.write(column.values.constData(), rows * column.size);
+
+    return written == expected;
+}
+
+/**
+ * Size of the decoded columns in bytes
+ */
+qint64 ColumnDecoder::numBytes() const
+{
+    qint64 rowSize = sizeof(quint32) + (multiInstance ? sizeof(quint16) : 0);
+    foreach (const Column &column, columns)
+        rowSize += column.size;
+    return rowSize * rows;
+}
+
+/**
+ * One column per field element, sized for all packets of the object
+ */
+void ColumnDecoder::setupColumns(UAVObject *obj)
+{
+    columns.clear();
+    timestamps.resize(capacity * sizeof(quint32));
+    instances.resize(multiInstance ? capacity * sizeof(quint16) : 0);
+
+    foreach (UAVObjectField *field, obj->getFields()) {
+        quint32 numElements = field->getNumElements();
+        if (numElements == 0)
+            continue;
+        QStringList elementNames = field->getElementNames();
+        quint32 size = field->getNumBytes() / numElements;
+
+        for (quint32 n = 0; n < numElements; ++n) {
+            Column column;
+            column.name = field->getName();
+            if (numElements > 1)
+                column.name += "." + (n < (quint32)elementNames.size() ? elementNames.at(n) : QString::number(n));
+            column.type = typeName(field->getType());
+            column.offset = field->getDataOffset() + n * size;
+            column.size = size;
+            column.values.resize(capacity * size);
+            columns.append(column);
+        }
+    }
+}
+
+/**
+ * Name of the column type of a field type, enums and bitfields are stored
+ * as their underlying integer and strings one character per column
+ */
+const char *ColumnDecoder::typeName(int type)
+{
+    switch (type) {
+    case UAVObjectField::INT8:
+        return "int8";
+    case UAVObjectField::INT16:
+        return "int16";
+    case UAVObjectField::INT32:
+        return "int32";
+    case UAVObjectField::UINT16:
+        return "uint16";
+    case UAVObjectField::UINT32:
+        return "uint32";
+    case UAVObjectField::FLOAT32:
+        return "float32";
+    default:
+        return "uint8";
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,102 @@
+/**
+ ******************************************************************************
+ * @file       columndecoder.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LoggingGadgetPlugin Logging Gadget Plugin
+ * @{
+ * @brief Decodes the packets of one object in a log into column arrays
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef COLUMNDECODER_H
+#define COLUMNDECODER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include "uavtalk/uavtalk.h"
+#include "../logindex.h"
+
+/**
+ * UAVTalk parser that stores received objects as table rows instead of
+ * unpacking them into the shared UAVObjects.
+ *
+ * Every column holds one field element of all rows back to back, in the
+ * little endian wire format. The frames still go through the regular
+ * UAVTalk validation (header, length against the object definition, CRC),
+ * only receiveObject() is replaced. One decoder handles one object at a
+ * time and decoders do not share state, so one can run per thread.
+ *
+ * The column file is a text header in the style of the .tll header,
+ * terminated by "##\n", followed by the columns in the order listed:
+ *
+ *     Tau Labs columnar log
+ *     object AttitudeActual 0xD7E0D964
+ *     rows 1234
+ *     column timestamp uint32
+ *     column instance uint16          (multi instance objects only)
+ *     column Roll float32
+ *     column Gyro.X float32
+ *     ...
+ *     ##
+ */
+class ColumnDecoder : public UAVTalk
+{
+public:
+    ColumnDecoder(QIODevice *iodev, UAVObjectManager *objMngr);
+
+    bool decode(const LogIndex &index, const LogIndex::Object &entry);
+    bool write(const QString &fileName);
+
+    QString tableName() const { return name; }
+    quint32 numRows() const { return rows; }
+    qint64 numBytes() const;
+
+protected:
+    bool receiveObject(quint8 type, quint32 objId, quint16 instId, const quint8 *data, qint32 length);
+
+private:
+    struct Column {
+        QString name;
+        const char *type;
+        quint32 offset;     //!< Offset of the element in the object data
+        quint32 size;       //!< Size of the element
+        QByteArray values;
+    };
+
+    void setupColumns(UAVObject *obj);
+    static const char *typeName(int type);
+
+    QString name;
+    quint32 objId;
+    bool multiInstance;
+    quint32 timestamp;
+    quint32 rows;
+    quint32 capacity;
+    QVector<Column> columns;
+    QByteArray timestamps;
+    QByteArray instances;
+};
+
+#endif // COLUMNDECODER_H
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,22 @@
+# -------------------------------------------------
+# Headless decoder of .tll logs into column files
+# Usage: logdecoder [-j threads] [-o output dir] <logfile.tll>
+#        logdecoder --benchmark [MiB] [work dir]
+# -------------------------------------------------
+QT -= gui
+QT += network concurrent
+TARGET = logdecoder
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+include(../../../../gcs.pri)
+include(../../uavtalk/uavtalk.pri)
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins
+LIBS += -L$$GCS_PLUGIN_PATH/TauLabs
+HEADERS += columndecoder.h \
+    syntheticlog.h \
+    ../logindex.h
+SOURCES += main.cpp \
+    columndecoder.cpp \
+    syntheticlog.cpp \
+    ../logindex.cpp
@@ -0,0 +1,265 @@
+/**
+ ******************************************************************************
+ * @file       main.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LoggingGadgetPlugin Logging Gadget Plugin
+ * @{
+ * @brief Headless decoder of telemetry logs into one column file per object
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QCoreApplication>
+#include <QBuffer>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+#include "columndecoder.h"
+#include "syntheticlog.h"
+#include "uavobjects/uavobjectsinit.h"
+
+/**
+ * Decoding of one object, run on the thread pool
+ */
+struct DecodeJob {
+    const LogIndex *index;
+    quint32 object;
+    UAVObjectManager *objMngr;
+    QString outputDir;
+    quint32 rows;
+    qint64 bytes;
+    bool ok;
+};
+
+static void runJob(DecodeJob &job)
+{
+    // Each job has its own parser, the object manager is only read
+    QBuffer device;
+    device.open(QIODevice::ReadWrite);
+    ColumnDecoder decoder(&device, job.objMngr);
+
+    job.rows = 0;
+    job.bytes = 0;
+    job.ok = decoder.decode(*job.index, job.index->object(job.object));
+    if (!job.ok)
+        return;
+
+    job.rows = decoder.numRows();
+    job.bytes = decoder.numBytes();
+    if (!job.outputDir.isEmpty())
+        job.ok = decoder.write(job.outputDir + "/" + decoder.tableName() + ".col");
+}
+
+static bool largerFirst(const DecodeJob &a, const DecodeJob &b)
+{
+    return a.index->object(a.object).count > b.index->object(b.object).count;
+}
+
+/**
+ * Offset of the first record, after the text header of new format logs
+ */
+static qint64 findDataStart(QFile &file)
+{
+    if (file.readLine().startsWith("Tau Labs git hash")) {
+        int cnt = 0;
+        while (file.readLine() != "##\n" && cnt++ < 10 && !file.atEnd())
+            ;
+        return file.pos();
+    }
+    return 0;
+}
+
+/**
+ * Decode a log into one column file per object
+ * @param outputDir Directory of the column files, empty to only decode
+ * @return 0 on success, the exit code otherwise
+ */
+static int decodeLog(QTextStream &out, const QString &fileName, const QString &outputDir,
+                     int threads, UAVObjectManager *objMngr)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        out << "Unable to open " << fileName << "\n";
+        return 1;
+    }
+    qint64 dataStart = findDataStart(file);
+
+    LogIndex index;
+    if (!index.open(&file, dataStart)) {
+        out << "Unable to index " << fileName << "\n";
+        return 1;
+    }
+    qint64 indexTime = timer.elapsed();
+
+    if (!outputDir.isEmpty() && !QDir().mkpath(outputDir)) {
+        out << "Unable to create " << outputDir << "\n";
+        return 1;
+    }
+
+    // The biggest objects go first so that no thread is left with a long
+    // tail at the end
+    QList<DecodeJob> jobs;
+    for (quint32 n = 0; n < index.numObjects(); ++n) {
+        DecodeJob job;
+        job.index = &index;
+        job.object = n;
+        job.objMngr = objMngr;
+        job.outputDir = outputDir;
+        job.rows = 0;
+        job.bytes = 0;
+        job.ok = false;
+        jobs.append(job);
+    }
+    qSort(jobs.begin(), jobs.end(), largerFirst);
+
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+    QtConcurrent::blockingMap(jobs, runJob);
+    qint64 elapsed = qMax(timer.elapsed(), (qint64)1);
+
+    quint32 objects = 0;
+    quint32 skipped = 0;
+    quint64 rows = 0;
+    qint64 bytes = 0;
+    foreach (const DecodeJob &job, jobs) {
+        if (job.ok) {
+            objects++;
+            rows += job.rows;
+            bytes += job.bytes;
+        } else {
+            skipped += index.object(job.object).count;
+        }
+    }
+
+    out << fileName << ": " << index.numPackets() << " packets, " << objects << " objects, "
+        << rows << " rows, " << skipped << " packets skipped\n";
+    out << "  " << threads << " threads, index " << indexTime << " ms, total " << elapsed << " ms, "
+        << (qint64)(file.size() * 1000.0 / 1048576 / elapsed) << " MiB/s in, "
+        << (qint64)(bytes * 1000.0 / 1048576 / elapsed) << " MiB/s out\n";
+    out.flush();
+
+    return 0;
+}
+
+/**
+ * Decode a synthetic log of the given size, once on a single thread and
+ * once on all cores. The first run builds the index, the second one finds
+ * it cached as a replay would.
+ */
+static int benchmark(QTextStream &out, qint64 size, const QString &dir, UAVObjectManager *objMngr)
+{
+    QString fileName = dir + "/logdecoder-benchmark.tll";
+    QString outputDir = dir + "/logdecoder-benchmark";
+
+    QElapsedTimer timer;
+    timer.start();
+    QFile::remove(LogIndex::indexFileName(fileName));
+    if (!SyntheticLog::generate(fileName, size, objMngr)) {
+        out << "Unable to write " << fileName << "\n";
+        return 1;
+    }
+    out << "Generated " << QFile(fileName).size() / 1048576 << " MiB in " << timer.elapsed() << " ms\n";
+    out.flush();
+
+    int result = decodeLog(out, fileName, outputDir, 1, objMngr);
+    if (result == 0)
+        result = decodeLog(out, fileName, outputDir, QThread::idealThreadCount(), objMngr);
+
+    QDir(outputDir).removeRecursively();
+    QFile::remove(LogIndex::indexFileName(fileName));
+    QFile::remove(fileName);
+    return result;
+}
+
+static void usage(QTextStream &out)
+{
+    out << "Usage: logdecoder [-j threads] [-o output dir] <logfile.tll>\n"
+        << "       logdecoder --generate <MiB> <logfile.tll>\n"
+        << "       logdecoder --benchmark [MiB] [work dir]\n"
+        << "Writes one <object>.col file per object, by default into a directory\n"
+        << "named after the log\n";
+    out.flush();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    UAVObjectManager objMngr;
+    UAVObjectsInitialize(&objMngr);
+
+    QStringList args = app.arguments();
+    args.removeFirst();
+
+    if (!args.isEmpty() && args.first() == "--generate") {
+        if (args.size() != 3) {
+            usage(out);
+            return 1;
+        }
+        if (!SyntheticLog::generate(args.at(2), args.at(1).toLongLong() * 1048576, &objMngr)) {
+            out << "Unable to write " << args.at(2) << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!args.isEmpty() && args.first() == "--benchmark") {
+        qint64 size = args.size() > 1 ? args.at(1).toLongLong() : 1024;
+        QString dir = args.size() > 2 ? args.at(2) : QDir::tempPath();
+        return benchmark(out, size * 1048576, dir, &objMngr);
+    }
+
+    int threads = QThread::idealThreadCount();
+    QString outputDir;
+    while (args.size() > 1) {
+        if (args.first() == "-j") {
+            threads = qMax(args.at(1).toInt(), 1);
+        } else if (args.first() == "-o") {
+            outputDir = args.at(1);
+        } else {
+            break;
+        }
+        args.removeFirst();
+        args.removeFirst();
+    }
+    if (args.size() != 1) {
+        usage(out);
+        return 1;
+    }
+
+    QString fileName = args.first();
+    if (outputDir.isEmpty()) {
+        QFileInfo info(fileName);
+        outputDir = info.absolutePath() + "/" + info.completeBaseName();
+    }
+
+    return decodeLog(out, fileName, outputDir, threads, &objMngr);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,125 @@
+/**
+ ******************************************************************************
+ * @file       syntheticlog.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LoggingGadgetPlugin Logging Gadget Plugin
+ * @{
+ * @brief Writes synthetic telemetry logs for benchmarking
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "syntheticlog.h"
+#include "uavtalk/uavtalk.h"
+
+SyntheticLog::SyntheticLog(const QString &fileName) :
+    file(fileName),
+    timestamp(0)
+{
+}
+
+bool SyntheticLog::open(OpenMode mode)
+{
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    // Same header as a GCS recording, without the version information
+    file.write("Tau Labs git hash:\nsynthetic\nsynthetic\n##\n");
+
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void SyntheticLog::close()
+{
+    file.close();
+    QIODevice::close();
+}
+
+qint64 SyntheticLog::readData(char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+qint64 SyntheticLog::writeData(const char *data, qint64 dataSize)
+{
+    file.write((const char *)&timestamp, sizeof(timestamp));
+    file.write((const char *)&dataSize, sizeof(dataSize));
+    return file.write(data, dataSize);
+}
+
+/**
+ * Write a log of about the requested size. Each record is an instance of a
+ * randomly chosen data object, with one float field changed every time so
+ * that the columns do not compress to nothing, at eight records per ms.
+ * @param fileName Name of the log to write
+ * @param size Size of the log in bytes
+ * @param objMngr Object manager with all objects registered
+ * @return true on success
+ */
+bool SyntheticLog::generate(const QString &fileName, qint64 size, UAVObjectManager *objMngr)
+{
+    SyntheticLog log(fileName);
+    if (!log.open(QIODevice::WriteOnly))
+        return false;
+
+    UAVTalk talk(&log, objMngr);
+
+    QVector<UAVDataObject *> objects;
+    QVector<UAVObjectField *> floatFields;
+    foreach (const QVector<UAVDataObject *> &instances, objMngr->getDataObjectsVector()) {
+        if (instances.isEmpty())
+            continue;
+        UAVDataObject *obj = instances.first();
+        UAVObjectField *floatField = NULL;
+        foreach (UAVObjectField *field, obj->getFields()) {
+            if (field->getType() == UAVObjectField::FLOAT32) {
+                floatField = field;
+                break;
+            }
+        }
+        objects.append(obj);
+        floatFields.append(floatField);
+    }
+    if (objects.isEmpty())
+        return false;
+
+    quint32 seed = 1;
+    quint32 count = 0;
+    while (log.file.pos() < size) {
+        seed = seed * 1103515245 + 12345;
+        int n = (seed >> 8) % objects.size();
+
+        if (floatFields[n] != NULL)
+            floatFields[n]->setDouble(floatFields[n]->getDouble() + 0.25);
+        if (!talk.sendObject(objects[n], false, false))
+            return false;
+
+        if (++count % 8 == 0)
+            log.setTimestamp(count / 8);
+    }
+
+    log.close();
+    return true;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,65 @@
+/**
+ ******************************************************************************
+ * @file       syntheticlog.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LoggingGadgetPlugin Logging Gadget Plugin
+ * @{
+ * @brief Writes synthetic telemetry logs for benchmarking
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SYNTHETICLOG_H
+#define SYNTHETICLOG_H
+
+#include <QFile>
+#include <QIODevice>
+#include "uavobjects/uavobjectmanager.h"
+
+/**
+ * Device that stores everything UAVTalk transmits as .tll records, the same
+ * way LogFile does while recording. generate() uses it to send a mix of all
+ * data objects with changing values until the log reaches a given size.
+ */
+class SyntheticLog : public QIODevice
+{
+    Q_OBJECT
+public:
+    SyntheticLog(const QString &fileName);
+
+    bool open(OpenMode mode);
+    void close();
+    void setTimestamp(quint32 timestamp) { this->timestamp = timestamp; }
+
+    static bool generate(const QString &fileName, qint64 size, UAVObjectManager *objMngr);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 dataSize);
+
+private:
+    QFile file;
+    quint32 timestamp;
+};
+
+#endif // SYNTHETICLOG_H
+
+/**
+ * @}
+ * @}
+ */
@@ -29,7 +29,9 @@
 #include <QDebug>
 #include <QtGlobal>
 #include <QTextStream>
- #include <QMessageBox>
+#include <QMessageBox>
+#include <QFileInfo>
+#include <QDateTime>
 
 // autogenerated version info string. MUST GO BEFORE coreconstants.h INCLUDE
 #include "../../../../../build/ground/gcs/gcsversioninfo.h"
@@ -38,7 +40,12 @@
 
 LogFile::LogFile(QObject *parent) :
     QIODevice(parent),
-    timestampBufferIdx(0)
+    dataStart(0),
+    firstTimestamp(0),
+    readPacket(0),
+    readOffset(0),
+    releasedPacket(0),
+    releasedBytes(0)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerFired()));
 }
@@ -84,6 +91,10 @@ bool LogFile::open(OpenMode mode) {
         QTextStream out(&file);
 
         out << "Tau Labs git hash:\n" <<  gitHash << "\n" << uavoHash << "\n##\n";
+        out.flush();
+
+        dataStart = file.pos();
+        index.clear();
     }
     else if(mode == QIODevice::ReadOnly)
     {
@@ -124,6 +135,7 @@ bool LogFile::open(OpenMode mode) {
             file.seek(0);
         }
 
+        dataStart = file.pos();
     }
     else
     {
@@ -144,7 +156,18 @@ void LogFile::close()
 
     if (timer.isActive())
         timer.stop();
+
+    // Recorded logs get their index written next to them once complete
+    // The index is saved before close() drops its entries
+    bool recording = file.isOpen() && file.isWritable();
     file.close();
+    if (recording) {
+        QFileInfo info(file);
+        if (!index.save(LogIndex::indexFileName(file.fileName()), info.size(), dataStart, info.lastModified().toMSecsSinceEpoch()))
+            qDebug() << "Unable to write the log index for " << file.fileName();
+    }
+    index.close();
+
     QIODevice::close();
 }
 
@@ -157,133 +180,75 @@ qint64 LogFile::writeData(const char * data, qint64 dataSize) {
     file.write((char *) &timeStamp,sizeof(timeStamp));
     file.write((char *) &dataSize, sizeof(dataSize));
 
+    qint64 offset = file.pos();
     qint64 written = file.write(data, dataSize);
-    if(written != -1)
+    if(written != -1) {
+        index.appendPacket(offset, timeStamp, data, dataSize);
         emit bytesWritten(written);
+    }
 
     return dataSize;
 }
 
+/**
+ * Copy the released packets straight out of the log mapping
+ */
 qint64 LogFile::readData(char * data, qint64 maxSize) {
     QMutexLocker locker(&mutex);
-    qint64 toRead = qMin(maxSize,(qint64)dataBuffer.size());
-    memcpy(data,dataBuffer.data(),toRead);
-    dataBuffer.remove(0,toRead);
-    return toRead;
+    qint64 copied = 0;
+    while (copied < maxSize && readPacket < releasedPacket) {
+        const LogIndex::Packet &packet = index.packet(readPacket);
+        qint64 toCopy = qMin(maxSize - copied, (qint64)(packet.size - readOffset));
+        memcpy(data + copied, index.packetData(readPacket) + readOffset, toCopy);
+        copied += toCopy;
+        readOffset += toCopy;
+        if (readOffset == packet.size) {
+            readPacket++;
+            readOffset = 0;
+        }
+    }
+    releasedBytes -= copied;
+    return copied;
 }
 
 qint64 LogFile::bytesAvailable() const
 {
-    return dataBuffer.size();
+    return releasedBytes;
 }
 
+/**
+ * Release the packets that are due at the current replay time
+ */
 void LogFile::timerFired()
 {
-    qint64 dataSize;
-
-    if(file.bytesAvailable() > 4)
-    {
+    int time = myTime.elapsed();
+    lastPlayTime += (time - lastPlayTimeOffset) * playbackSpeed;
+    lastPlayTimeOffset = time;
+
+    quint32 released = releasedPacket;
+    mutex.lock();
+    while (releasedPacket < index.numPackets() &&
+           (qint64)index.packet(releasedPacket).timestamp - firstTimestamp <= lastPlayTime) {
+        releasedBytes += index.packet(releasedPacket).size;
+        releasedPacket++;
+    }
+    mutex.unlock();
 
-        int time;
-        time = myTime.elapsed();
-
-        //Read packets
-        while ((lastPlayTime + ((time - lastPlayTimeOffset)* playbackSpeed) > (lastTimeStamp-firstTimestamp)))
-        {
-            lastPlayTime += ((time - lastPlayTimeOffset)* playbackSpeed);
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
-
-            file.seek(lastTimeStampPos+sizeof(lastTimeStamp));
-
-            file.read((char *) &dataSize, sizeof(dataSize));
-
-            if (dataSize<1 || dataSize>(1024*1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
-            if(file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
-
-            mutex.lock();
-            dataBuffer.append(file.read(dataSize));
-            mutex.unlock();
-            emit readyRead();
-
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
-
-            lastTimeStampPos = timestampPos[timestampBufferIdx];
-            lastTimeStamp = timestampBuffer[timestampBufferIdx];
-            timestampBufferIdx++;
-
-            lastPlayTimeOffset = time;
-            time = myTime.elapsed();
+    if (releasedPacket != released)
+        emit readyRead();
 
-        }
-    } else {
+    if (releasedPacket >= index.numPackets())
         stopReplay();
-    }
-
 }
 
 bool LogFile::startReplay() {
-    dataBuffer.clear();
     myTime.restart();
     lastPlayTimeOffset = 0;
     lastPlayTime = 0;
     playbackSpeed = 1;
 
-    //Read all log timestamps into array
-    timestampBuffer.clear(); //Save beginning of log for later use
-    timestampPos.clear();
-    quint64 logFileStartIdx = file.pos();
-    timestampBufferIdx = 0;
-    lastTimeStamp = 0;
-
-    while (!file.atEnd()){
-        qint64 dataSize;
-
-        //Get time stamp position
-        timestampPos.append(file.pos());
-
-        //Read timestamp and logfile packet size
-        file.read((char *) &lastTimeStamp, sizeof(lastTimeStamp));
-        file.read((char *) &dataSize, sizeof(dataSize));
-
-        //Check if dataSize sync bytes are correct.
-        //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
-        if ((dataSize & 0xFFFFFFFFFFFF0000)!=0){
-            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(file.pos(),0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
-            file.seek(timestampPos.last()+1);
-            timestampPos.pop_back();
-            continue;
-        }
-
-        //Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()){
-            QMessageBox msgBox;
-            msgBox.setText("Corrupted file.");
-            msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
-            msgBox.exec();
-
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
-        }
-
-        timestampBuffer.append(lastTimeStamp);
-
-        file.seek(timestampPos.last()+sizeof(lastTimeStamp)+sizeof(dataSize)+dataSize);
-    }
-
-    //Check if any timestamps were successfully read
-    if (timestampBuffer.size() == 0){
+    // Map the log and attach its index, building the index on first use
+    if (!index.open(&file, dataStart) || index.numPackets() == 0) {
         QMessageBox msgBox;
         msgBox.setText("Empty logfile.");
         msgBox.setInformativeText("No log data can be found.");
@@ -293,12 +258,11 @@ bool LogFile::startReplay() {
         return false;
     }
 
-    //Reset to log beginning.
-    file.seek(logFileStartIdx+sizeof(lastTimeStamp));
-    lastTimeStampPos = timestampPos[0];
-    lastTimeStamp = timestampBuffer[0];
-    firstTimestamp = timestampBuffer[0];
-    timestampBufferIdx = 1;
+    firstTimestamp = index.packet(0).timestamp;
+    readPacket = 0;
+    readOffset = 0;
+    releasedPacket = 0;
+    releasedBytes = 0;
 
     timer.setInterval(10);
     timer.start();
@@ -325,21 +289,23 @@ void LogFile::resumeReplay()
 
 /**
  * @brief LogFile::setReplayTime, sets the playback time
- * @param val, the time in
+ * @param val, the time in seconds from the start of the log
  */
 void LogFile::setReplayTime(double val)
 {
-    quint32 tmpIdx=0;
-    while(timestampBuffer[tmpIdx++] <= val*1000 && tmpIdx <= timestampBufferIdx){
-    }
+    quint32 playTime = val * 1000;
 
-    lastTimeStampPos=timestampPos[tmpIdx];
-    lastTimeStamp=timestampBuffer[tmpIdx];
-    timestampBufferIdx=tmpIdx;
+    // Pending data is dropped, replay continues with the first packet at
+    // or after the requested time
+    mutex.lock();
+    releasedPacket = index.findPacket(firstTimestamp + playTime);
+    readPacket = releasedPacket;
+    readOffset = 0;
+    releasedBytes = 0;
+    mutex.unlock();
 
     lastPlayTimeOffset = myTime.elapsed();
-    lastPlayTime=lastTimeStamp;
+    lastPlayTime = playTime;
 
-    qDebug() << "Replaying at: " << lastTimeStamp << ", but requestion at" << val*1000;
+    qDebug() << "Replaying at: " << lastPlayTime << ", but requestion at" << val*1000;
 }
-
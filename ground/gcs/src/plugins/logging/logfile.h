@@ -35,6 +35,7 @@
 #include <QDebug>
 #include <QBuffer>
 #include "uavobjectmanager.h"
+#include "logindex.h"
 #include <math.h>
 
 class LogFile : public QIODevice
@@ -68,12 +69,10 @@ signals:
     void replayFinished();
 
 protected:
-    QByteArray dataBuffer;
     QTimer timer;
     QTime myTime;
     QFile file;
-    quint32 lastTimeStamp;
-    quint32 lastPlayTime;
+    double lastPlayTime;
     QMutex mutex;
 
 
@@ -81,11 +80,16 @@ protected:
     double playbackSpeed;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
-    quint32 timestampBufferIdx;
-    quint32 lastTimeStampPos;
+    LogIndex index;
+    qint64 dataStart;
     quint32 firstTimestamp;
+
+    // Packets below releasedPacket are due and can be read, reading resumes
+    // at readOffset within readPacket
+    quint32 readPacket;
+    quint32 readOffset;
+    quint32 releasedPacket;
+    qint64 releasedBytes;
 };
 
 #endif // LOGFILE_H
@@ -0,0 +1,346 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logindex.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Time index and object directory of a telemetry log
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logindex.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QtEndian>
+
+static const char INDEX_MAGIC[8] = { 'T', 'L', 'L', 'I', 'N', 'D', 'E', 'X' };
+
+// UAVTalk sync byte, used to pick the object ID out of logged frames
+static const quint8 SYNC_VAL = 0x3C;
+
+LogIndex::LogIndex() :
+    log(NULL),
+    logData(NULL),
+    indexData(NULL),
+    packetTable(NULL),
+    objectTable(NULL),
+    objectPacketTable(NULL),
+    packetCount(0),
+    objectCount(0)
+{
+}
+
+LogIndex::~LogIndex()
+{
+    close();
+}
+
+/**
+ * Returns the name of the sidecar index file of a log
+ */
+QString LogIndex::indexFileName(const QString &logFileName)
+{
+    return logFileName + ".idx";
+}
+
+/**
+ * Map an open log file and attach its index. The cached index is used when
+ * it matches the log, otherwise the index is built with one pass over the
+ * mapping and cached for the next time.
+ * @param log The log file, open for reading
+ * @param dataStart Offset of the first record, after the text header
+ * @return true if the log could be mapped
+ */
+bool LogIndex::open(QFile *log, qint64 dataStart)
+{
+    close();
+
+    qint64 logSize = log->size();
+    if (logSize <= dataStart)
+        return false;
+
+    logData = log->map(0, logSize);
+    if (logData == NULL) {
+        qDebug() << "Unable to map " << log->fileName() << ": " << log->errorString();
+        return false;
+    }
+    this->log = log;
+
+    QString fileName = indexFileName(log->fileName());
+    qint64 logModified = QFileInfo(*log).lastModified().toMSecsSinceEpoch();
+    if (load(fileName, logSize, dataStart, logModified))
+        return true;
+
+    build(logSize, dataStart);
+    if (!save(fileName, logSize, dataStart, logModified))
+        qDebug() << "Unable to cache the log index in " << fileName;
+
+    return true;
+}
+
+/**
+ * Release the mappings and tables
+ */
+void LogIndex::close()
+{
+    if (indexData != NULL) {
+        indexFile.unmap(indexData);
+        indexData = NULL;
+    }
+    if (indexFile.isOpen())
+        indexFile.close();
+
+    if (logData != NULL && log != NULL)
+        log->unmap(logData);
+    logData = NULL;
+    log = NULL;
+
+    clear();
+}
+
+/**
+ * Drop all entries, used before recording a new log
+ */
+void LogIndex::clear()
+{
+    packets.clear();
+    objects.clear();
+    objectPackets.clear();
+    useVectors();
+}
+
+/**
+ * Record a packet written to a log
+ * @param offset Offset of the packet data in the log
+ * @param timestamp Timestamp of the packet
+ * @param data Packet data, a UAVTalk frame
+ * @param size Size of the packet data
+ */
+void LogIndex::appendPacket(qint64 offset, quint32 timestamp, const char *data, quint32 size)
+{
+    Packet entry;
+    entry.offset = offset;
+    entry.timestamp = timestamp;
+    entry.size = size;
+    entry.objId = 0;
+    entry.reserved = 0;
+    if (size >= 8 && (quint8)data[0] == SYNC_VAL)
+        entry.objId = qFromLittleEndian<quint32>((const uchar *)&data[4]);
+    packets.append(entry);
+    packetTable = packets.constData();
+    packetCount = packets.size();
+}
+
+/**
+ * Write the index to a file
+ * @param fileName Name of the index file
+ * @param logSize Size of the indexed log, to detect stale indices
+ * @param dataStart Offset of the first record in the log
+ * @param logModified Modification time of the log in ms since the epoch
+ * @return true on success
+ */
+bool LogIndex::save(const QString &fileName, qint64 logSize, qint64 dataStart, qint64 logModified)
+{
+    if (objectCount == 0 && packetCount > 0)
+        buildDirectory();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.numPackets = packetCount;
+    header.numObjects = objectCount;
+    header.logSize = logSize;
+    header.dataStart = dataStart;
+    header.logModified = logModified;
+
+    qint64 expected = sizeof(header) + packetCount * sizeof(Packet) +
+            objectCount * sizeof(Object) + packetCount * sizeof(quint32);
+    qint64 written = file.write((const char *)&header, sizeof(header));
+    written += file.write((const char *)packetTable, packetCount * sizeof(Packet));
+    written += file.write((const char *)objectTable, objectCount * sizeof(Object));
+    written += file.write((const char *)objectPacketTable, packetCount * sizeof(quint32));
+
+    if (written != expected) {
+        file.remove();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Find the first packet at or after a timestamp with a binary search
+ * @return The packet number, numPackets() if all packets are older
+ */
+quint32 LogIndex::findPacket(quint32 timestamp) const
+{
+    quint32 low = 0;
+    quint32 high = packetCount;
+    while (low < high) {
+        quint32 mid = low + (high - low) / 2;
+        if (packetTable[mid].timestamp < timestamp)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+/**
+ * Map a cached index if it exists and matches the log
+ */
+bool LogIndex::load(const QString &fileName, qint64 logSize, qint64 dataStart, qint64 logModified)
+{
+    indexFile.setFileName(fileName);
+    if (!indexFile.open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 size = indexFile.size();
+    if (size >= (qint64)sizeof(Header))
+        indexData = indexFile.map(0, size);
+    if (indexData == NULL) {
+        indexFile.close();
+        return false;
+    }
+
+    const Header *header = (const Header *)indexData;
+    qint64 expected = sizeof(Header) + header->numPackets * sizeof(Packet) +
+            header->numObjects * sizeof(Object) + header->numPackets * sizeof(quint32);
+    if (memcmp(header->magic, INDEX_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != VERSION || header->logSize != logSize ||
+            header->dataStart != dataStart || header->logModified != logModified ||
+            size != expected || !isValid((const Packet *)(indexData + sizeof(Header)), header->numPackets, logSize)) {
+        indexFile.unmap(indexData);
+        indexData = NULL;
+        indexFile.close();
+        return false;
+    }
+
+    packetCount = header->numPackets;
+    objectCount = header->numObjects;
+    packetTable = (const Packet *)(indexData + sizeof(Header));
+    objectTable = (const Object *)(packetTable + packetCount);
+    objectPacketTable = (const quint32 *)(objectTable + objectCount);
+    return true;
+}
+
+/**
+ * Check a cached packet table against the log it claims to index. An empty
+ * table for a non-empty log, as written by GCS versions which cleared the
+ * index before saving it, or a packet outside the log gets it rebuilt. The
+ * packets are stored in log order, so checking the first and the last one
+ * keeps opening a log independent of its length.
+ */
+bool LogIndex::isValid(const Packet *table, quint32 count, qint64 logSize)
+{
+    if (count == 0)
+        return false;
+    const Packet &first = table[0];
+    const Packet &last = table[count - 1];
+    return first.offset >= 0 && first.offset <= last.offset &&
+            last.offset < logSize && (qint64)last.size <= logSize - last.offset;
+}
+
+/**
+ * Build the index of a log without one, in a single pass over the mapping
+ */
+void LogIndex::build(qint64 logSize, qint64 dataStart)
+{
+    const uchar *start = logData + dataStart;
+    const uchar *end = logData + logSize;
+    const uchar *p = start;
+    const qint64 recordHeader = sizeof(quint32) + sizeof(qint64);
+
+    packets.clear();
+    while (end - p >= recordHeader) {
+        quint32 timestamp;
+        qint64 dataSize;
+        memcpy(&timestamp, p, sizeof(timestamp));
+        memcpy(&dataSize, p + sizeof(timestamp), sizeof(dataSize));
+
+        // Same resynchronisation as the sequential reader: a size with any of
+        // the upper six bytes set is taken as corruption, retry one byte later
+        if (dataSize < 1 || (dataSize & 0xFFFFFFFFFFFF0000) != 0) {
+            p++;
+            continue;
+        }
+        if (end - p - recordHeader < dataSize)
+            break;
+
+        if (!packets.isEmpty() && timestamp < packets.last().timestamp)
+            qDebug() << "Timestamps are not sequential at offset " << (p - logData);
+
+        appendPacket(p + recordHeader - logData, timestamp, (const char *)(p + recordHeader), dataSize);
+        p += recordHeader + dataSize;
+    }
+
+    buildDirectory();
+}
+
+/**
+ * Group the packet numbers by object ID. The packets must be in the vectors.
+ */
+void LogIndex::buildDirectory()
+{
+    QMap<quint32, quint32> counts;
+    for (quint32 n = 0; n < packetCount; ++n)
+        counts[packetTable[n].objId]++;
+
+    objects.clear();
+    objects.reserve(counts.size());
+    QHash<quint32, quint32> next;
+    quint32 first = 0;
+    for (QMap<quint32, quint32>::const_iterator i = counts.constBegin(); i != counts.constEnd(); ++i) {
+        Object obj;
+        obj.objId = i.key();
+        obj.count = i.value();
+        obj.first = first;
+        obj.reserved = 0;
+        objects.append(obj);
+        next.insert(obj.objId, first);
+        first += obj.count;
+    }
+
+    objectPackets.resize(packetCount);
+    for (quint32 n = 0; n < packetCount; ++n)
+        objectPackets[next[packetTable[n].objId]++] = n;
+
+    objectTable = objects.constData();
+    objectPacketTable = objectPackets.constData();
+    objectCount = objects.size();
+}
+
+/**
+ * Point the tables at the in-memory vectors
+ */
+void LogIndex::useVectors()
+{
+    packetTable = packets.constData();
+    objectTable = objects.constData();
+    objectPacketTable = objectPackets.constData();
+    packetCount = packets.size();
+    objectCount = objects.size();
+}
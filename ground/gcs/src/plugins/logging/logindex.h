@@ -0,0 +1,124 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logindex.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Time index and object directory of a telemetry log
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOGINDEX_H
+#define LOGINDEX_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+/**
+ * Index of the packets in a .tll log file.
+ *
+ * The log itself is a sequence of (timestamp, size, UAVTalk frame) records.
+ * The index lists the offset, timestamp, size and object ID of every record
+ * plus a directory grouping the records by object ID. It is stored in a
+ * sidecar file next to the log (see indexFileName()) so that logs stay
+ * readable by older GCS versions. Logs written by this GCS get the index
+ * when they are closed, older logs get it built once on first replay.
+ *
+ * Both the log and the index are accessed through QFile::map(), so opening
+ * a log with a cached index does not read it and packet data is handed out
+ * as pointers into the mapping.
+ */
+class LogIndex
+{
+public:
+    struct Packet {
+        qint64 offset;      //!< Offset of the UAVTalk frame in the log
+        quint32 timestamp;  //!< Milliseconds since the start of logging
+        quint32 size;       //!< Size of the UAVTalk frame
+        quint32 objId;      //!< Object ID of the frame, 0 if not a frame
+        quint32 reserved;
+    };
+
+    struct Object {
+        quint32 objId;
+        quint32 count;      //!< Number of packets of this object
+        quint32 first;      //!< Position of its first packet number in packetsOf()
+        quint32 reserved;
+    };
+
+    LogIndex();
+    ~LogIndex();
+
+    bool open(QFile *log, qint64 dataStart);
+    void close();
+
+    void clear();
+    void appendPacket(qint64 offset, quint32 timestamp, const char *data, quint32 size);
+    bool save(const QString &fileName, qint64 logSize, qint64 dataStart, qint64 logModified);
+
+    quint32 numPackets() const { return packetCount; }
+    const Packet &packet(quint32 n) const { return packetTable[n]; }
+    const uchar *packetData(quint32 n) const { return logData + packetTable[n].offset; }
+    quint32 findPacket(quint32 timestamp) const;
+
+    quint32 numObjects() const { return objectCount; }
+    const Object &object(quint32 n) const { return objectTable[n]; }
+    const quint32 *packetsOf(const Object &obj) const { return objectPacketTable + obj.first; }
+
+    static QString indexFileName(const QString &logFileName);
+
+private:
+    struct Header {
+        char magic[8];
+        quint32 version;
+        quint32 numPackets;
+        quint32 numObjects;
+        quint32 reserved;
+        qint64 logSize;
+        qint64 dataStart;
+        qint64 logModified;
+    };
+
+    static const quint32 VERSION = 2;
+
+    bool load(const QString &fileName, qint64 logSize, qint64 dataStart, qint64 logModified);
+    static bool isValid(const Packet *table, quint32 count, qint64 logSize);
+    void build(qint64 logSize, qint64 dataStart);
+    void buildDirectory();
+    void useVectors();
+
+    QFile *log;
+    uchar *logData;
+    QFile indexFile;
+    uchar *indexData;
+
+    // Tables are either in the index mapping or in the vectors below
+    const Packet *packetTable;
+    const Object *objectTable;
+    const quint32 *objectPacketTable;
+    quint32 packetCount;
+    quint32 objectCount;
+
+    QVector<Packet> packets;
+    QVector<Object> objects;
+    QVector<quint32> objectPackets;
+};
+
+#endif // LOGINDEX_H
@@ -125,6 +125,12 @@ plugin_systemhealth.depends += plugin_uavobjects
 plugin_systemhealth.depends += plugin_uavtalk
 SUBDIRS += plugin_systemhealth
 
+# Trace timeline gadget
+plugin_tracetimeline.subdir = tracetimeline
+plugin_tracetimeline.depends = plugin_coreplugin
+plugin_tracetimeline.depends += plugin_uavobjects
+SUBDIRS += plugin_tracetimeline
+
 # Config gadget
 plugin_config.subdir = config
 plugin_config.depends = plugin_coreplugin
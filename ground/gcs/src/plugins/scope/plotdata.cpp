@@ -41,7 +41,6 @@
  * @param p_uavFieldName The plotted UAVO field name
  */
 Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
-    yDataHistory(0),
     dataUpdated(false)
 {
     uavObjectName = p_uavObject;
@@ -61,13 +60,9 @@ Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
 
     xData = new QVector<double>();
     yData = new QVector<double>();
-    yDataHistory = new QVector<double>();
 
     scalePower = 0;
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
-    correctionCount = 0;
     yMinimum = 0;
     yMaximum = 120;
 
@@ -106,9 +101,6 @@ Plot3dData::Plot3dData(QString p_uavObject, QString p_uavFieldName):
 
     scalePower = 0;
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
-    correctionCount = 0;
     xMinimum = 0;
     xMaximum = 16;
     yMinimum = 0;
@@ -124,8 +116,6 @@ Plot2dData::~Plot2dData()
         delete xData;
     if (yData != NULL)
         delete yData;
-    if (yDataHistory != NULL)
-        delete yDataHistory;
 }
 
 
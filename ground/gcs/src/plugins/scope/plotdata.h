@@ -104,10 +104,6 @@ protected:
     int scalePower; //This is the power to which each value must be raised
     unsigned int meanSamples;
     QString mathFunction;
-    double meanSum;
-
-    double correctionSum;
-    int correctionCount;
 
 private:
 
@@ -4,12 +4,21 @@ TARGET = ScopeGadget
 DEFINES += SCOPE_LIBRARY
 include(../../taulabsgcsplugin.pri)
 include (scope_dependencies.pri)
+
+FFTW {
+    DEFINES += USE_FFTW
+    LIBS += -lfftw3
+}
+
 HEADERS += scopeplugin.h \
     scopes2d/histogramplotdata.h \
     scopes2d/histogramscopeconfig.h \
     scopes2d/scatterplotdata.h \
+    scopes2d/circularsamplebuffer.h \
     scopes2d/scatterplotscopeconfig.h \
     scopes3d/spectrogramplotdata.h \
+    scopes3d/circularrasterdata.h \
+    scopes3d/spectrumanalyzer.h \
     scopes3d/spectrogramscopeconfig.h \
     scopes2d/plotdata2d.h \
     scopes2d/scopes2dconfig.h \
@@ -27,8 +36,11 @@ SOURCES += scopeplugin.cpp \
     scopes2d/histogramplotdata.cpp \
     scopes2d/histogramscopeconfig.cpp \
     scopes2d/scatterplotdata.cpp \
+    scopes2d/circularsamplebuffer.cpp \
     scopes2d/scatterplotscopeconfig.cpp \
     scopes3d/spectrogramplotdata.cpp \
+    scopes3d/circularrasterdata.cpp \
+    scopes3d/spectrumanalyzer.cpp \
     scopes3d/spectrogramscopeconfig.cpp \
     plotdata.cpp
 SOURCES += scopegadgetoptionspage.cpp
@@ -87,6 +87,13 @@ QWidget* ScopeGadgetOptionsPage::createPage(QWidget *parent)
     options_page->cmbColorMapSpectrogram->addItem("Standard", ColorMap::STANDARD);
     options_page->cmbColorMapSpectrogram->addItem("Jet", ColorMap::JET);
 
+    // Populate window function combobox.
+    options_page->cmbSpectrogramWindow->addItem("Rectangular", SpectrumAnalyzer::RECTANGULAR);
+    options_page->cmbSpectrogramWindow->addItem("Hann", SpectrumAnalyzer::HANN);
+    options_page->cmbSpectrogramWindow->addItem("Hamming", SpectrumAnalyzer::HAMMING);
+    options_page->cmbSpectrogramWindow->addItem("Blackman", SpectrumAnalyzer::BLACKMAN);
+    options_page->cmbSpectrogramWindow->setCurrentIndex(options_page->cmbSpectrogramWindow->findData(SpectrumAnalyzer::HANN));
+
     // Fills the combo boxes for the UAVObjects
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
@@ -96,6 +103,7 @@ QWidget* ScopeGadgetOptionsPage::createPage(QWidget *parent)
             if (obj->isSingleInstance())
             {
                 options_page->cmbUAVObjects->addItem(obj->getName());
+                options_page->cmbUAVObjectsSpectrogram->addItem(obj->getName());
             }
             else if(obj->getName() != options_page->cmbUAVObjects->itemText(options_page->cmbUAVObjects->count()-1))
             { //Checks to see if we're duplicating UAVOs because of multiple instances
@@ -383,8 +391,9 @@ void ScopeGadgetOptionsPage::on_cmbUAVObjects_currentIndexChanged(QString val)
 
 /**
  * @brief ScopeGadgetOptionsPage::on_cmbUAVObjectsSpectrogram_currentIndexChanged When a new
- * UAVObject is selected, populate the UAVObject field combo box with the correct values. Only
- * populate with UAVOs that have multiple instances.
+ * UAVObject is selected, populate the UAVObject field combo box with the correct values.
+ * The width of multiple instance UAVOs is their number of instances, the width of single
+ * instance UAVOs is the number of samples in the FFT window.
  * @param val
  */
 void ScopeGadgetOptionsPage::on_cmbUAVObjectsSpectrogram_currentIndexChanged(QString val)
@@ -415,6 +424,12 @@ void ScopeGadgetOptionsPage::on_cmbUAVObjectsSpectrogram_currentIndexChanged(QSt
             options_page->cmbUavoFieldSpectrogram->addItem(field->getName());
     }
 
+    if (objData->isSingleInstance()) {
+        options_page->sbSpectrogramWidth->setRange(SpectrumAnalyzer::MIN_WINDOW_SIZE, SpectrumAnalyzer::MAX_WINDOW_SIZE);
+        options_page->sbSpectrogramWidth->setValue(1024);
+        return;
+    }
+
     // Get range from UAVO name
     unsigned int maxWidth = objManager->getNumInstances(objData->getObjID());
     options_page->sbSpectrogramWidth->setRange(0, maxWidth);
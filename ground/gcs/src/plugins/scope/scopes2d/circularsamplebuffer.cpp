@@ -0,0 +1,485 @@
+/**
+ ******************************************************************************
+ *
+ * @file       circularsamplebuffer.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Fixed capacity sample storage for the scatterplot curves
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopes2d/circularsamplebuffer.h"
+
+#include <math.h>
+
+
+CircularSampleBuffer::CircularSampleBuffer():
+    first(0),
+    used(0),
+    total(0),
+    changes(0)
+{
+}
+
+
+/**
+ * @brief CircularSampleBuffer::setCapacity Resize the ring, keeping the newest samples
+ * @param capacity Maximum number of samples
+ */
+void CircularSampleBuffer::setCapacity(int capacity)
+{
+    if (capacity < 1)
+        capacity = 1;
+    if (capacity == xs.size())
+        return;
+
+    int kept = qMin(used, capacity);
+    QVector<double> newXs(capacity);
+    QVector<double> newYs(capacity);
+    for (int i = 0; i < kept; i++) {
+        newXs[i] = x(used - kept + i);
+        newYs[i] = y(used - kept + i);
+    }
+
+    xs = newXs;
+    ys = newYs;
+    first = 0;
+    used = kept;
+    changes++;
+
+    // The summary is sized for the capacity, rebuild it from the kept samples
+    resetSummary();
+    for (int i = 0; i < kept; i++)
+        summarize(total++, ys.at(i));
+}
+
+
+/**
+ * @brief CircularSampleBuffer::clear Drop all samples
+ */
+void CircularSampleBuffer::clear()
+{
+    first = 0;
+    used = 0;
+    changes++;
+    resetSummary();
+}
+
+
+/**
+ * @brief CircularSampleBuffer::append Add a sample, replacing the oldest one if the buffer is full
+ */
+void CircularSampleBuffer::append(double x, double y)
+{
+    if (xs.isEmpty())
+        setCapacity(1);
+
+    int n;
+    if (used < xs.size()) {
+        n = position(used);
+        used++;
+    } else {
+        n = first;
+        first = position(1);
+    }
+
+    xs[n] = x;
+    ys[n] = y;
+    changes++;
+    summarize(total++, y);
+}
+
+
+/**
+ * @brief CircularSampleBuffer::removeFirst Drop the oldest sample
+ */
+void CircularSampleBuffer::removeFirst()
+{
+    if (used == 0)
+        return;
+
+    first = position(1);
+    used--;
+    changes++;
+}
+
+
+/**
+ * @brief CircularSampleBuffer::lowerBound Find the first sample at or after
+ * an x value, the x values must be increasing
+ * @return The position of the sample, count() if all samples are before x
+ */
+int CircularSampleBuffer::lowerBound(double x) const
+{
+    int low = 0;
+    int high = used;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (this->x(mid) < x)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+
+/**
+ * @brief CircularSampleBuffer::extent Find the lowest and highest sample of a
+ * span. The span is covered with the largest summary blocks that fit in it,
+ * only its unaligned ends are read sample by sample.
+ * @param from Position of the first sample of the span
+ * @param to Position after the last sample of the span
+ * @param result The extent of the span
+ * @return false if the span is empty
+ */
+bool CircularSampleBuffer::extent(int from, int to, Extent &result) const
+{
+    from = qMax(from, 0);
+    to = qMin(to, used);
+    if (from >= to)
+        return false;
+
+    qint64 oldest = total - used;
+    qint64 sample = oldest + from;
+    qint64 end = oldest + to;
+    qint64 minSample = sample;
+    qint64 maxSample = sample;
+    result.minY = result.maxY = y(from);
+
+    while (sample < end) {
+        // Largest level with a block starting at this sample and ending in the span
+        int level = 0;
+        while (level < levels.size()) {
+            qint64 size = (qint64)1 << (LEVEL_SHIFT * (level + 1));
+            if ((sample & (size - 1)) != 0 || sample + size > end)
+                break;
+            level++;
+        }
+        while (level > 0 && block(level, sample >> (LEVEL_SHIFT * level)).id != sample >> (LEVEL_SHIFT * level))
+            level--;
+
+        if (level == 0) {
+            double value = y(sample - oldest);
+            if (value < result.minY) {
+                result.minY = value;
+                minSample = sample;
+            }
+            if (value > result.maxY) {
+                result.maxY = value;
+                maxSample = sample;
+            }
+            sample++;
+        } else {
+            const Block &summary = block(level, sample >> (LEVEL_SHIFT * level));
+            if (summary.minY < result.minY) {
+                result.minY = summary.minY;
+                minSample = summary.minSample;
+            }
+            if (summary.maxY > result.maxY) {
+                result.maxY = summary.maxY;
+                maxSample = summary.maxSample;
+            }
+            sample += (qint64)1 << (LEVEL_SHIFT * level);
+        }
+    }
+
+    result.minPosition = minSample - oldest;
+    result.maxPosition = maxSample - oldest;
+    return true;
+}
+
+
+/**
+ * @brief CircularSampleBuffer::resetSummary Drop the summary and size it for
+ * the capacity. Each level has enough blocks to cover a full buffer that
+ * does not start on a block boundary.
+ */
+void CircularSampleBuffer::resetSummary()
+{
+    total = 0;
+    levels.clear();
+
+    Block unused;
+    unused.id = -1;
+    unused.minY = unused.maxY = 0;
+    unused.minSample = unused.maxSample = 0;
+
+    for (int level = 1; ((qint64)1 << (LEVEL_SHIFT * level)) <= xs.size(); level++)
+        levels.append(QVector<Block>((xs.size() >> (LEVEL_SHIFT * level)) + 2, unused));
+}
+
+
+/**
+ * @brief CircularSampleBuffer::summarize Add a new sample to the blocks containing it
+ */
+void CircularSampleBuffer::summarize(qint64 sample, double y)
+{
+    for (int level = 1; level <= levels.size(); level++) {
+        qint64 id = sample >> (LEVEL_SHIFT * level);
+        QVector<Block> &blocks = levels[level - 1];
+        Block &summary = blocks[id % blocks.size()];
+
+        if (summary.id != id) {
+            // First sample of the block, it replaces the block that was here
+            summary.id = id;
+            summary.minY = summary.maxY = y;
+            summary.minSample = summary.maxSample = sample;
+        } else if (y < summary.minY) {
+            summary.minY = y;
+            summary.minSample = sample;
+        } else if (y > summary.maxY) {
+            summary.maxY = y;
+            summary.maxSample = sample;
+        }
+    }
+}
+
+
+CircularSeriesData::CircularSeriesData(const CircularSampleBuffer *buffer, bool indexAsX):
+    buffer(buffer),
+    indexAsX(indexAsX),
+    columns(0),
+    rectRevision(0),
+    pointsRevision(0),
+    pointsValid(false)
+{
+}
+
+
+/**
+ * @brief CircularSeriesData::setResolution Set the number of pixel columns of the plot
+ * @param columns The width of the plot canvas, 0 to draw all samples
+ */
+void CircularSeriesData::setResolution(int columns)
+{
+    if (columns != this->columns) {
+        this->columns = columns;
+        pointsValid = false;
+    }
+}
+
+
+size_t CircularSeriesData::size() const
+{
+    if (columns <= 0)
+        return buffer->count();
+
+    if (!pointsValid || pointsRevision != buffer->revision())
+        decimate();
+    return points.size();
+}
+
+
+QPointF CircularSeriesData::sample(size_t i) const
+{
+    if (columns <= 0)
+        return point(i);
+    return points.at(i);
+}
+
+
+/**
+ * @brief CircularSeriesData::boundingRect Bounding rectangle of all samples,
+ * recalculated from the buffer summary when the buffer changed
+ */
+QRectF CircularSeriesData::boundingRect() const
+{
+    if (d_boundingRect.width() < 0 || rectRevision != buffer->revision()) {
+        CircularSampleBuffer::Extent extent;
+        if (buffer->extent(0, buffer->count(), extent)) {
+            double left = indexAsX ? 0 : buffer->firstX();
+            double right = indexAsX ? buffer->count() - 1 : buffer->lastX();
+            d_boundingRect = QRectF(left, extent.minY, right - left, extent.maxY - extent.minY);
+        } else {
+            d_boundingRect = QRectF(1.0, 1.0, -2.0, -2.0);
+        }
+        rectRevision = buffer->revision();
+    }
+
+    return d_boundingRect;
+}
+
+
+/**
+ * @brief CircularSeriesData::setRectOfInterest Called by Qwt with the visible area before drawing
+ */
+void CircularSeriesData::setRectOfInterest(const QRectF &rect)
+{
+    if (rect != rectOfInterest) {
+        rectOfInterest = rect;
+        pointsValid = false;
+    }
+}
+
+
+/**
+ * @brief CircularSeriesData::decimate Pick the samples to draw. Up to two
+ * samples per column everything is drawn, above that each column gets its
+ * lowest and highest sample, in the order they were received.
+ */
+void CircularSeriesData::decimate() const
+{
+    points.clear();
+
+    int from = 0;
+    int to = buffer->count();
+    if (rectOfInterest.width() > 0) {
+        if (indexAsX) {
+            from = qBound(0.0, floor(rectOfInterest.left()), (double)to);
+            to = qBound(0.0, ceil(rectOfInterest.right()) + 1, (double)to);
+        } else {
+            from = buffer->lowerBound(rectOfInterest.left());
+            to = buffer->lowerBound(rectOfInterest.right()) + 1;
+        }
+        // Keep one sample outside the area on each side, the curve has to
+        // leave the plot instead of stopping at the last visible sample
+        from = qMax(from - 1, 0);
+        to = qMin(to + 1, buffer->count());
+    }
+
+    int visible = to - from;
+    if (visible <= 2 * columns) {
+        points.reserve(qMax(visible, 0));
+        for (int i = from; i < to; i++)
+            points.append(point(i));
+    } else {
+        points.reserve(2 * columns);
+        for (int column = 0; column < columns; column++) {
+            CircularSampleBuffer::Extent extent;
+            int start = from + (qint64)visible * column / columns;
+            int end = from + (qint64)visible * (column + 1) / columns;
+            if (!buffer->extent(start, end, extent))
+                continue;
+
+            if (extent.minPosition < extent.maxPosition) {
+                points.append(point(extent.minPosition));
+                points.append(point(extent.maxPosition));
+            } else if (extent.minPosition > extent.maxPosition) {
+                points.append(point(extent.maxPosition));
+                points.append(point(extent.minPosition));
+            } else {
+                points.append(point(extent.minPosition));
+            }
+        }
+    }
+
+    pointsRevision = buffer->revision();
+    pointsValid = true;
+}
+
+
+RunningStatistics::RunningStatistics():
+    next(0),
+    used(0),
+    sinceResum(0),
+    offset(0),
+    sum(0),
+    sumSquares(0)
+{
+}
+
+
+/**
+ * @brief RunningStatistics::setWindow Set the number of averaged samples and start over
+ */
+void RunningStatistics::setWindow(int samples)
+{
+    history.fill(0, qMax(samples, 1));
+    next = 0;
+    used = 0;
+    sinceResum = 0;
+    offset = 0;
+    sum = 0;
+    sumSquares = 0;
+}
+
+
+/**
+ * @brief RunningStatistics::append Add a sample, the oldest one leaves the window once it is full
+ */
+void RunningStatistics::append(double value)
+{
+    if (history.isEmpty())
+        setWindow(1);
+    if (used == 0)
+        offset = value;
+
+    if (used == history.size()) {
+        double oldest = history.at(next) - offset;
+        sum -= oldest;
+        sumSquares -= oldest * oldest;
+    } else {
+        used++;
+    }
+
+    history[next] = value;
+    sum += value - offset;
+    sumSquares += (value - offset) * (value - offset);
+    if (++next == history.size())
+        next = 0;
+
+    // Recompute the sums once per window so that they cannot run away due
+    // to floating point rounding errors
+    if (++sinceResum >= history.size())
+        resum();
+}
+
+
+double RunningStatistics::mean() const
+{
+    return used > 0 ? offset + sum / used : 0;
+}
+
+
+/**
+ * @brief RunningStatistics::standardDeviation Sample standard deviation, with Bessel's correction
+ */
+double RunningStatistics::standardDeviation() const
+{
+    if (used < 2)
+        return 0;
+
+    double variance = (sumSquares - sum * sum / used) / (used - 1);
+    return variance > 0 ? sqrt(variance) : 0;
+}
+
+
+/**
+ * @brief RunningStatistics::resum Recompute the sums exactly. They are kept
+ * relative to the current mean, so that the variance of a small signal on a
+ * large offset does not cancel out.
+ */
+void RunningStatistics::resum()
+{
+    offset = 0;
+    for (int i = 0; i < used; i++)
+        offset += history.at(i);
+    offset /= used;
+
+    sum = 0;
+    sumSquares = 0;
+    for (int i = 0; i < used; i++) {
+        double deviation = history.at(i) - offset;
+        sum += deviation;
+        sumSquares += deviation * deviation;
+    }
+    sinceResum = 0;
+}
@@ -0,0 +1,177 @@
+/**
+ ******************************************************************************
+ *
+ * @file       circularsamplebuffer.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Fixed capacity sample storage for the scatterplot curves
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef CIRCULARSAMPLEBUFFER_H
+#define CIRCULARSAMPLEBUFFER_H
+
+#include "qwt/src/qwt_series_data.h"
+
+#include <QVector>
+
+
+/**
+ * @brief The CircularSampleBuffer class A ring of (x, y) samples. Once the
+ * buffer is full every new sample replaces the oldest one, so appending and
+ * dropping old samples never moves the others.
+ *
+ * Next to the samples the buffer keeps the minimum and maximum y of every
+ * aligned block of 4, 16, 64, ... samples, updated as samples arrive. With
+ * them extent() finds the y range of any span of samples in logarithmic
+ * time, which is what the min/max decimation of the curves is built on.
+ */
+class CircularSampleBuffer
+{
+public:
+    /**
+     * @brief The Extent struct Lowest and highest sample of a span, with their positions
+     */
+    struct Extent {
+        double minY;
+        double maxY;
+        int minPosition;
+        int maxPosition;
+    };
+
+    CircularSampleBuffer();
+
+    void setCapacity(int capacity);
+    int capacity() const {return xs.size();}
+    int count() const {return used;}
+    bool isFull() const {return used == xs.size();}
+    quint32 revision() const {return changes;}
+
+    void clear();
+    void append(double x, double y);
+    void removeFirst();
+
+    double x(int i) const {return xs.at(position(i));}
+    double y(int i) const {return ys.at(position(i));}
+    double firstX() const {return x(0);}
+    double lastX() const {return x(used - 1);}
+
+    int lowerBound(double x) const;
+    bool extent(int from, int to, Extent &result) const;
+
+private:
+    struct Block {
+        qint64 id;          //Sample number of the first sample, divided by the block size
+        double minY;
+        double maxY;
+        qint64 minSample;
+        qint64 maxSample;
+    };
+
+    static const int LEVEL_SHIFT = 2; //Each level has blocks four times larger than the one below
+
+    int position(int i) const {int n = first + i; return n < xs.size() ? n : n - xs.size();}
+    void resetSummary();
+    void summarize(qint64 sample, double y);
+    const Block &block(int level, qint64 id) const {
+        const QVector<Block> &blocks = levels.at(level - 1);
+        return blocks.at(id % blocks.size());
+    }
+
+    QVector<double> xs;
+    QVector<double> ys;
+    int first;
+    int used;
+    qint64 total; //Number of samples appended since the last reset, the sample number of the next one
+    quint32 changes;
+    QVector< QVector<Block> > levels;
+};
+
+
+/**
+ * @brief The CircularSeriesData class Presents a CircularSampleBuffer to a
+ * QwtPlotCurve without copying it. The curve owns the adapter, the plot data
+ * owns the buffer.
+ *
+ * Once a resolution is set, the curve only gets the samples within the
+ * visible x range (the rect of interest set by Qwt) and, when these are more
+ * than two per pixel column, only the lowest and highest sample of each
+ * column. The drawn curve looks the same, while the cost of drawing depends
+ * on the width of the plot instead of the number of samples. Zooming in
+ * narrows the rect of interest and brings back the full data.
+ */
+class CircularSeriesData : public QwtSeriesData<QPointF>
+{
+public:
+    CircularSeriesData(const CircularSampleBuffer *buffer, bool indexAsX);
+
+    void setResolution(int columns);
+
+    virtual size_t size() const;
+    virtual QPointF sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+    virtual void setRectOfInterest(const QRectF &rect);
+
+private:
+    QPointF point(int position) const {return QPointF(indexAsX ? position : buffer->x(position), buffer->y(position));}
+    void decimate() const;
+
+    const CircularSampleBuffer *buffer;
+    bool indexAsX; //The sequential plot uses the sample position as x value
+    int columns;
+    QRectF rectOfInterest;
+    mutable quint32 rectRevision;
+
+    // Decimated samples, valid for the buffer revision they were made from
+    mutable QVector<QPointF> points;
+    mutable quint32 pointsRevision;
+    mutable bool pointsValid;
+};
+
+
+/**
+ * @brief The RunningStatistics class Boxcar mean and standard deviation over
+ * the last samples, kept up to date with running sums.
+ */
+class RunningStatistics
+{
+public:
+    RunningStatistics();
+
+    void setWindow(int samples);
+    int window() const {return history.size();}
+
+    void append(double value);
+    double mean() const;
+    double standardDeviation() const;
+
+private:
+    void resum();
+
+    QVector<double> history;
+    int next;
+    int used;
+    int sinceResum;
+    double offset;
+    double sum;
+    double sumSquares;
+};
+
+#endif // CIRCULARSAMPLEBUFFER_H
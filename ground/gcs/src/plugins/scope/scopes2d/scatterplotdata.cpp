@@ -40,18 +40,18 @@
 
 
 /**
- * @brief Scatterplot2dScopeConfig::plotNewData Update plot with new data
+ * @brief TimeSeriesPlotData::plotNewData Update plot with new data
  * @param scopeGadgetWidget
  */
 void TimeSeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig, ScopeGadgetWidget *scopeGadgetWidget)
 {
     Q_UNUSED(plot2dData);
     Q_UNUSED(scopeConfig);
-    Q_UNUSED(scopeGadgetWidget);
 
-    //Plot new data
+    //Plot new data, decimated to the width of the plot
+    seriesData->setResolution(scopeGadgetWidget->canvas()->width());
     if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+        curve->itemChanged();
 
     QDateTime NOW = QDateTime::currentDateTime();
     double toTime = NOW.toTime_t();
@@ -69,11 +69,11 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
 {
     Q_UNUSED(plot2dData);
     Q_UNUSED(scopeConfig);
-    Q_UNUSED(scopeGadgetWidget);
 
-    //Plot new data
+    //Plot new data, decimated to the width of the plot
+    seriesData->setResolution(scopeGadgetWidget->canvas()->width());
     if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+        curve->itemChanged();
 }
 
 
@@ -93,49 +93,13 @@ bool SeriesPlotData::append(UAVObject* obj)
 
             double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
 
-            //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the front
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
-            if (yData->size() > getXWindowSize()) { //If new data overflows the window, remove old data...
-                yData->pop_front();
-            } else //...otherwise, add a new y point at position xData
-                xData->insert(xData->size(), xData->size());
+            //The buffer holds exactly one window, new data overwrites the oldest
+            int windowSize = qMax((int)getXWindowSize(), 1);
+            if (samples.capacity() != windowSize)
+                samples.setCapacity(windowSize);
+
+            //The x value is the position in the buffer
+            samples.append(0, applyMathFunction(currentValue));
 
             return true;
         }
@@ -159,47 +123,12 @@ bool TimeSeriesPlotData::append(UAVObject* obj)
         if (field) {
             QDateTime NOW = QDateTime::currentDateTime(); //THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
             double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the back
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
             double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
-            xData->append(valueX);
+
+            //Grow the buffer if the time window holds more samples than it can take
+            if (samples.isFull())
+                samples.setCapacity(samples.capacity() * 2);
+            samples.append(valueX, applyMathFunction(currentValue));
 
             //Remove stale data
             removeStaleData();
@@ -217,22 +146,8 @@ bool TimeSeriesPlotData::append(UAVObject* obj)
  */
 void TimeSeriesPlotData::removeStaleData()
 {
-    double newestValue;
-    double oldestValue;
-
-    while (1) {
-        if (xData->size() == 0)
-            break;
-
-        newestValue = xData->last();
-        oldestValue = xData->first();
-
-        if (newestValue - oldestValue > getXWindowSize()) {
-            yData->pop_front();
-            xData->pop_front();
-        } else
-            break;
-    }
+    while (samples.count() > 0 && samples.lastX() - samples.firstX() > getXWindowSize())
+        samples.removeFirst();
 }
 
 
@@ -245,6 +160,39 @@ void TimeSeriesPlotData::removeStaleDataTimeout()
 }
 
 
+/**
+ * @brief ScatterplotData::setCurve Set the curve and hand it the sample buffer
+ * @param val The curve, it takes ownership of the adapter
+ */
+void ScatterplotData::setCurve(QwtPlotCurve *val)
+{
+    curve = val;
+    seriesData = new CircularSeriesData(&samples, sampleIndexAsX);
+    curve->setData(seriesData);
+}
+
+
+/**
+ * @brief ScatterplotData::applyMathFunction Apply the scope math to a new value
+ * @param currentValue The scaled value
+ * @return The value to plot
+ */
+double ScatterplotData::applyMathFunction(double currentValue)
+{
+    if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
+        if (statistics.window() != (int)meanSamples)
+            statistics.setWindow(meanSamples);
+        statistics.append(currentValue);
+
+        if (mathFunction  == "Standard deviation")
+            return statistics.standardDeviation();
+        return statistics.mean();
+    }
+
+    return currentValue;
+}
+
+
 /**
  * @brief ScatterplotData::clearPlots Clear all plot data
  */
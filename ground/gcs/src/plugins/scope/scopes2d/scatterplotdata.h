@@ -29,6 +29,7 @@
 #define SCATTERPLOTDATA_H
 
 #include "scopes2d/plotdata2d.h"
+#include "scopes2d/circularsamplebuffer.h"
 #include "uavobject.h"
 #include "qwt/src/qwt_plot_curve.h"
 
@@ -45,15 +46,21 @@ class ScatterplotData : public Plot2dData
     Q_OBJECT
 public:
     ScatterplotData(QString uavObject, QString uavField):
-        Plot2dData(uavObject, uavField){curve = 0;}
+        Plot2dData(uavObject, uavField){curve = 0; seriesData = 0; sampleIndexAsX = false;}
     ~ScatterplotData(){}
 
     virtual void clearPlots(PlotData *);
 
-    void setCurve(QwtPlotCurve *val){curve = val;}
+    void setCurve(QwtPlotCurve *val);
 
 protected:
+    double applyMathFunction(double currentValue);
+
     QwtPlotCurve* curve;
+    CircularSampleBuffer samples; //The curve reads these through seriesData
+    CircularSeriesData *seriesData; //Owned by the curve
+    RunningStatistics statistics;
+    bool sampleIndexAsX;
 };
 
 
@@ -67,7 +74,9 @@ class SeriesPlotData : public ScatterplotData
     Q_OBJECT
 public:
     SeriesPlotData(QString uavObject, QString uavField)
-            : ScatterplotData(uavObject, uavField) {}
+            : ScatterplotData(uavObject, uavField) {
+        sampleIndexAsX = true;
+    }
     ~SeriesPlotData() {}
 
     /*!
@@ -95,6 +104,7 @@ public:
     TimeSeriesPlotData(QString uavObject, QString uavField)
             : ScatterplotData(uavObject, uavField) {
         scalePower = 1;
+        samples.setCapacity(INITIAL_CAPACITY);
     }
     ~TimeSeriesPlotData() {
     }
@@ -104,6 +114,9 @@ public:
     virtual void removeStaleData();
     virtual void plotNewData(PlotData *, ScopeConfig *, ScopeGadgetWidget *);
 
+private:
+    static const int INITIAL_CAPACITY = 1024; //Doubled whenever the time window holds more samples
+
 private slots:
     void removeStaleDataTimeout();
 };
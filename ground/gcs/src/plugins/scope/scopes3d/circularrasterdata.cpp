@@ -0,0 +1,123 @@
+/**
+ ******************************************************************************
+ *
+ * @file       circularrasterdata.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Fixed size raster of the spectrogram rows
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopes3d/circularrasterdata.h"
+
+#include <qnumeric.h>
+#include <string.h>
+
+
+CircularRasterData::CircularRasterData():
+    columns(0),
+    rows(0),
+    oldest(0),
+    cellWidth(0),
+    cellHeight(0)
+{
+}
+
+
+/**
+ * @brief CircularRasterData::resize Allocate the raster, all values are zero
+ */
+void CircularRasterData::resize(int columns, int rows)
+{
+    this->columns = qMax(columns, 0);
+    this->rows = qMax(rows, 0);
+    matrix.fill(0, this->columns * this->rows);
+    oldest = 0;
+    updateCellSize();
+}
+
+
+void CircularRasterData::clear()
+{
+    matrix.fill(0);
+    oldest = 0;
+}
+
+
+/**
+ * @brief CircularRasterData::appendRow Replace the oldest row
+ * @param values numColumns() values
+ */
+void CircularRasterData::appendRow(const double *values)
+{
+    if (rows == 0)
+        return;
+
+    memcpy(matrix.data() + oldest * columns, values, columns * sizeof(double));
+    if (++oldest == rows)
+        oldest = 0;
+}
+
+
+void CircularRasterData::setInterval(Qt::Axis axis, const QwtInterval &interval)
+{
+    QwtRasterData::setInterval(axis, interval);
+    updateCellSize();
+}
+
+
+void CircularRasterData::updateCellSize()
+{
+    cellWidth = columns > 0 ? interval(Qt::XAxis).width() / columns : 0;
+    cellHeight = rows > 0 ? interval(Qt::YAxis).width() / rows : 0;
+}
+
+
+/**
+ * @brief CircularRasterData::pixelHint The values are constant over each
+ * cell, so the spectrogram only needs to be sampled once per cell
+ */
+QRectF CircularRasterData::pixelHint(const QRectF &area) const
+{
+    Q_UNUSED(area);
+
+    if (cellWidth <= 0 || cellHeight <= 0)
+        return QRectF();
+
+    return QRectF(interval(Qt::XAxis).minValue(), interval(Qt::YAxis).minValue(), cellWidth, cellHeight);
+}
+
+
+double CircularRasterData::value(double x, double y) const
+{
+    const QwtInterval xInterval = interval(Qt::XAxis);
+    const QwtInterval yInterval = interval(Qt::YAxis);
+    if (cellWidth <= 0 || cellHeight <= 0 || !xInterval.contains(x) || !yInterval.contains(y))
+        return qQNaN();
+
+    int column = qMin(int((x - xInterval.minValue()) / cellWidth), columns - 1);
+    int row = qMin(int((y - yInterval.minValue()) / cellHeight), rows - 1);
+
+    row += oldest;
+    if (row >= rows)
+        row -= rows;
+
+    return matrix.at(row * columns + column);
+}
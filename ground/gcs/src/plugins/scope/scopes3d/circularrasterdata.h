@@ -0,0 +1,69 @@
+/**
+ ******************************************************************************
+ *
+ * @file       circularrasterdata.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Fixed size raster of the spectrogram rows
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef CIRCULARRASTERDATA_H
+#define CIRCULARRASTERDATA_H
+
+#include "qwt/src/qwt_raster_data.h"
+
+#include <QVector>
+
+
+/**
+ * @brief The CircularRasterData class A matrix of numRows() rows of
+ * numColumns() values, allocated once. Every new row overwrites the oldest
+ * one, so the raster scrolls without moving any value. The oldest row is
+ * shown at the bottom of the y interval and the newest at the top.
+ */
+class CircularRasterData : public QwtRasterData
+{
+public:
+    CircularRasterData();
+
+    void resize(int columns, int rows);
+    int numColumns() const {return columns;}
+    int numRows() const {return rows;}
+
+    void clear();
+    void appendRow(const double *values);
+
+    virtual void setInterval(Qt::Axis axis, const QwtInterval &interval);
+    virtual QRectF pixelHint(const QRectF &area) const;
+    virtual double value(double x, double y) const;
+
+private:
+    void updateCellSize();
+
+    QVector<double> matrix;
+    int columns;
+    int rows;
+    int oldest; //Row that the next appendRow() overwrites
+    double cellWidth;
+    double cellHeight;
+};
+
+#endif // CIRCULARRASTERDATA_H
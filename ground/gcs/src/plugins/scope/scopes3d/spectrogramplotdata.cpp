@@ -36,7 +36,6 @@
 
 #include "qwt/src/qwt.h"
 #include "qwt/src/qwt_color_map.h"
-#include "qwt/src/qwt_matrix_raster_data.h"
 #include "qwt/src/qwt_plot_spectrogram.h"
 #include "qwt/src/qwt_scale_draw.h"
 #include "qwt/src/qwt_scale_widget.h"
@@ -49,21 +48,50 @@
  * @param samplingFrequency
  * @param windowWidth
  * @param timeHorizon
+ * @param windowFunction Window applied before the transform of single instance objects
+ * @param windowOverlap Overlap in percent of consecutive windows of single instance objects
  */
-SpectrogramData::SpectrogramData(QString uavObject, QString uavField, double samplingFrequency, unsigned int windowWidth, double timeHorizon)
+SpectrogramData::SpectrogramData(QString uavObject, QString uavField, double samplingFrequency, unsigned int windowWidth, double timeHorizon,
+                                 SpectrumAnalyzer::WindowFunction windowFunction, int windowOverlap)
         : Plot3dData(uavObject, uavField),
           spectrogram(0),
-          rasterData(0)
+          rasterData(0),
+          singleInstance(false)
 {
     this->samplingFrequency = samplingFrequency;
     this->timeHorizon = timeHorizon;
     this->windowWidth = windowWidth;
     autoscaleValueUpdated = 0;
 
-    // Create raster data
-    rasterData = new QwtMatrixRasterData();
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    UAVObject *obj = objManager ? objManager->getObject(uavObject) : NULL;
+    singleInstance = obj && obj->isSingleInstance();
+
+    // Each row of the raster is one spectrum. The flight side computes one
+    // per window of 2 * windowWidth samples, here there is one per hop.
+    int columns;
+    double rowsPerSecond;
+    if (singleInstance) {
+        analyzer.setup(windowWidth, windowFunction, windowOverlap);
+        columns = analyzer.numBins();
+        rowsPerSecond = samplingFrequency / analyzer.hopSize();
+    } else {
+        columns = qMax((int) windowWidth, 1);
+        rowsPerSecond = samplingFrequency / (2.0 * columns);
+    }
+    int rows = qMax((int) ceil(timeHorizon * rowsPerSecond), 1);
+
+    // Don't exceed 10MB for memory
+    if ((double) rows * columns * sizeof(double) > 10000000.0) {
+        qDebug() << "Limiting the" << uavObject << "spectrogram to 10MB. TimeHorizon: " << timeHorizon << ", windowWidth: " << windowWidth;
+        rows = qMax((int) (10000000 / (columns * sizeof(double))), 1);
+    }
 
-    rasterData->setValueMatrix( *zDataHistory, windowWidth );
+    // The whole raster is allocated once, new rows replace the oldest ones
+    rasterData = new CircularRasterData();
+    rasterData->resize(columns, rows);
+    row.resize(columns);
 
     // Set the ranges for the plot
     resetAxisRanges();
@@ -110,9 +138,6 @@ void SpectrogramData::plotNewData(PlotData *plot3dData, ScopeConfig *scopeConfig
 
     // Check for new data
     if (readAndResetUpdatedFlag() == true){
-        // Plot new data
-        rasterData->setValueMatrix(*zDataHistory, windowWidth);
-
         // Check autoscale. (For some reason, QwtSpectrogram doesn't support autoscale)
         if (zMaximum == 0){
             double newVal = readAndResetAutoscaleValue();
@@ -128,91 +153,119 @@ void SpectrogramData::plotNewData(PlotData *plot3dData, ScopeConfig *scopeConfig
 /**
  * @brief SpectrogramData::append Appends data to spectrogram
  * @param obj UAVO with new data
- * @return
+ * @return true if a row was added
  */
-bool SpectrogramData::append(UAVObject* multiObj)
+bool SpectrogramData::append(UAVObject* obj)
 {
-    QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
-
     // Check to make sure it's the correct UAVO
-    if (uavObjectName == multiObj->getName()) {
+    if (uavObjectName != obj->getName() || obj->isSingleInstance() != singleInstance)
+        return false;
 
-        // Only run on UAVOs that have multiple instances
-        if (multiObj->isSingleInstance())
-            return false;
+    if (singleInstance)
+        return appendSample(obj);
 
-        //Instantiate object manager
-        UAVObjectManager *objManager;
+    return appendInstances(obj);
+}
 
-        ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-        Q_ASSERT(pm != NULL);
-        objManager = pm->getObject<UAVObjectManager>();
-        Q_ASSERT(objManager != NULL);
 
+/**
+ * @brief SpectrogramData::appendSample Feeds a sample to the spectrum analyzer
+ * @param obj Single instance UAVO with new data
+ * @return true if a spectrum was completed
+ */
+bool SpectrogramData::appendSample(UAVObject* obj)
+{
+    UAVObjectField* field = obj->getField(uavFieldName);
+    Q_ASSERT(field);
+    if (!field)
+        return false;
 
-        // Get list of object instances
-        QVector<UAVObject*> list = objManager->getObjectInstancesVector(multiObj->getName());
+    double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
+    if (!analyzer.append(currentValue))
+        return false;
 
-        // Remove a row's worth of data.
-        unsigned int spectrogramWidth = list.size();
+    updateAutoscale(analyzer.spectrum(), analyzer.numBins());
+    rasterData->appendRow(analyzer.spectrum());
 
-        // Check that there is a full window worth of data. While GCS is starting up, the size of
-        // multiple instance UAVOs is 1, so it's possible for spurious data to come in before
-        // the flight controller board has had time to initialize the UAVO size.
-        if (spectrogramWidth != windowWidth){
-            qDebug() << "Incomplete data set in" << multiObj->getName() << "." << uavFieldName <<  "spectrogram: " << spectrogramWidth << " samples provided, but expected " << windowWidth;
-            return false;
-        }
+    return true;
+}
 
-        //Initialize vector where we will read out an entire row of multiple instance UAVO
-        QVector<double> values;
 
-        timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0);
-        UAVObjectField* multiField =  multiObj->getField(uavFieldName);
-        Q_ASSERT(multiField);
-        if (multiField ) {
+/**
+ * @brief SpectrogramData::appendInstances Appends the spectrum held by the instances of a UAVO
+ * @param multiObj Multiple instance UAVO with new data
+ * @return true if a row was added
+ */
+bool SpectrogramData::appendInstances(UAVObject* multiObj)
+{
+    //Instantiate object manager
+    UAVObjectManager *objManager;
 
-            // Get the field of interest
-            foreach (UAVObject *obj, list) {
-                UAVObjectField* field =  obj->getField(uavFieldName);
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    Q_ASSERT(pm != NULL);
+    objManager = pm->getObject<UAVObjectManager>();
+    Q_ASSERT(objManager != NULL);
 
-                double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
 
-                double vecVal = currentValue;
-                //Normally some math would go here, modifying vecVal before appending it to values
-                // .
-                // .
-                // .
+    // Get list of object instances
+    QVector<UAVObject*> list = objManager->getObjectInstancesVector(multiObj->getName());
 
+    // Number of bins in the spectrum
+    unsigned int spectrogramWidth = list.size();
 
-                // Second to last step, see if autoscale is turned on and if the value exceeds the maximum for the scope.
-                if ( zMaximum == 0 &&  vecVal > rasterData->interval(Qt::ZAxis).maxValue()){
-                    // Change scope maximum and color depth
-                    rasterData->setInterval(Qt::ZAxis, QwtInterval(0, vecVal) );
-                    autoscaleValueUpdated = vecVal;
-                }
-                // Last step, assign value to vector
-                values += vecVal;
-            }
+    // Check that there is a full window worth of data. While GCS is starting up, the size of
+    // multiple instance UAVOs is 1, so it's possible for spurious data to come in before
+    // the flight controller board has had time to initialize the UAVO size.
+    if (spectrogramWidth != windowWidth){
+        qDebug() << "Incomplete data set in" << multiObj->getName() << "." << uavFieldName <<  "spectrogram: " << spectrogramWidth << " samples provided, but expected " << windowWidth;
+        return false;
+    }
 
-            while (timeDataHistory->back() - timeDataHistory->front() > timeHorizon){
-                timeDataHistory->pop_front();
-                zDataHistory->remove(0, fminl(spectrogramWidth, zDataHistory->size()));
-            }
+    UAVObjectField* multiField =  multiObj->getField(uavFieldName);
+    Q_ASSERT(multiField);
+    if (multiField ) {
 
-            // Doublecheck that there are the right number of samples. This can occur if the "field" assert fails
-            if(values.size() == (int) windowWidth){
-                *zDataHistory << values;
-            }
+        // Get the field of interest, an entire row of multiple instance UAVO
+        for (int i = 0; i < list.size(); i++) {
+            UAVObject *obj = list.at(i);
+            UAVObjectField* field =  obj->getField(uavFieldName);
+
+            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
 
-            return true;
+            //Normally some math would go here, modifying the value before it is stored
+            row[i] = currentValue;
         }
+
+        updateAutoscale(row.constData(), row.size());
+        rasterData->appendRow(row.constData());
+
+        return true;
     }
 
     return false;
 }
 
 
+/**
+ * @brief SpectrogramData::updateAutoscale If autoscale is turned on, raises the maximum of the scope to the new values
+ */
+void SpectrogramData::updateAutoscale(const double *values, int count)
+{
+    if (zMaximum != 0)
+        return;
+
+    double maximum = rasterData->interval(Qt::ZAxis).maxValue();
+    for (int i = 0; i < count; i++)
+        maximum = qMax(maximum, values[i]);
+
+    if (maximum > rasterData->interval(Qt::ZAxis).maxValue()) {
+        // Change scope maximum and color depth
+        rasterData->setInterval(Qt::ZAxis, QwtInterval(0, maximum));
+        autoscaleValueUpdated = maximum;
+    }
+}
+
+
 /**
  * @brief SpectrogramScopeConfig::clearPlots Clear all plot data
  */
@@ -29,9 +29,10 @@
 #define SPECTROGRAMDATA_H
 
 #include "scopes3d/plotdata3d.h"
+#include "scopes3d/circularrasterdata.h"
+#include "scopes3d/spectrumanalyzer.h"
 #include "uavobject.h"
 #include "qwt/src/qwt_plot_spectrogram.h"
-#include "qwt/src/qwt_matrix_raster_data.h"
 
 #include <QTimer>
 #include <QTime>
@@ -41,12 +42,18 @@
 /**
  * @brief The SpectrogramData class The spectrogram plot has a fixed size
  * data buffer. All the curves in one plot have the same size buffer.
+ *
+ * Multiple instance objects, such as VibrationAnalysisOutput, already hold a
+ * spectrum, one bin per instance. For single instance objects the spectrum
+ * of the field is computed here, over a sliding window of windowWidth
+ * samples.
  */
 class SpectrogramData : public Plot3dData
 {
     Q_OBJECT
 public:
-    SpectrogramData(QString uavObject, QString uavField, double samplingFrequency, unsigned int windowWidth, double timeHorizon);
+    SpectrogramData(QString uavObject, QString uavField, double samplingFrequency, unsigned int windowWidth, double timeHorizon,
+                    SpectrumAnalyzer::WindowFunction windowFunction, int windowOverlap);
     ~SpectrogramData() {}
 
     /*!
@@ -71,14 +78,21 @@ public:
     virtual void setYMaximum(double val);
     virtual void setZMaximum(double val);
 
-    QwtMatrixRasterData *getRasterData(){return rasterData;}
+    CircularRasterData *getRasterData(){return rasterData;}
     void setSpectrogram(QwtPlotSpectrogram *val){spectrogram = val;}
 
 private:
     void resetAxisRanges();
+    bool appendInstances(UAVObject* multiObj);
+    bool appendSample(UAVObject* obj);
+    void updateAutoscale(const double *values, int count);
 
     QwtPlotSpectrogram *spectrogram;
-    QwtMatrixRasterData *rasterData;
+    CircularRasterData *rasterData;
+
+    bool singleInstance;
+    SpectrumAnalyzer analyzer;
+    QVector<double> row;
 
     double samplingFrequency;
     double timeHorizon;
@@ -41,6 +41,8 @@ SpectrogramScopeConfig::SpectrogramScopeConfig()
     timeHorizon = 60;
     samplingFrequency = 100;
     windowWidth = 64;
+    windowFunction = SpectrumAnalyzer::HANN;
+    windowOverlap = 50;
     zMaximum = 120;
     colorMapType = ColorMap::STANDARD;
 }
@@ -55,6 +57,8 @@ SpectrogramScopeConfig::SpectrogramScopeConfig(QSettings *qSettings)
     timeHorizon = qSettings->value("timeHorizon").toDouble();
     samplingFrequency = qSettings->value("samplingFrequency").toDouble();
     windowWidth       = qSettings->value("windowWidth").toInt();
+    windowFunction = (SpectrumAnalyzer::WindowFunction) qSettings->value("windowFunction", SpectrumAnalyzer::HANN).toInt();
+    windowOverlap = qSettings->value("windowOverlap", 50).toInt();
     zMaximum = qSettings->value("zMaximum").toDouble();
     colorMapType = (ColorMap::ColorMapType) qSettings->value("colorMap").toInt();
 
@@ -92,6 +96,8 @@ SpectrogramScopeConfig::SpectrogramScopeConfig(Ui::ScopeGadgetOptionsPage *optio
     windowWidth = options_page->sbSpectrogramWidth->value();
     samplingFrequency = options_page->sbSpectrogramFrequency->value();
     timeHorizon = options_page->sbSpectrogramTimeHorizon->value();
+    windowFunction = (SpectrumAnalyzer::WindowFunction) options_page->cmbSpectrogramWindow->itemData(options_page->cmbSpectrogramWindow->currentIndex()).toInt();
+    windowOverlap = options_page->sbSpectrogramOverlap->value();
     zMaximum = options_page->spnMaxSpectrogramZ->value();
     colorMapType = (ColorMap::ColorMapType) options_page->cmbColorMapSpectrogram->itemData(options_page->cmbColorMapSpectrogram->currentIndex()).toInt();
 
@@ -130,6 +136,11 @@ ScopeConfig* SpectrogramScopeConfig::cloneScope(ScopeConfig *originalScope)
     SpectrogramScopeConfig *cloneObj = new SpectrogramScopeConfig();
 
     cloneObj->timeHorizon = originalSpectrogramScopeConfig->timeHorizon;
+    cloneObj->samplingFrequency = originalSpectrogramScopeConfig->samplingFrequency;
+    cloneObj->windowWidth = originalSpectrogramScopeConfig->windowWidth;
+    cloneObj->windowFunction = originalSpectrogramScopeConfig->windowFunction;
+    cloneObj->windowOverlap = originalSpectrogramScopeConfig->windowOverlap;
+    cloneObj->zMaximum = originalSpectrogramScopeConfig->zMaximum;
     cloneObj->colorMapType = originalSpectrogramScopeConfig->colorMapType;
 
     int plotCurveCount = originalSpectrogramScopeConfig->m_spectrogramSourceConfigs.size();
@@ -170,6 +181,8 @@ void SpectrogramScopeConfig::saveConfiguration(QSettings* qSettings)
     qSettings->setValue("samplingFrequency", samplingFrequency);
     qSettings->setValue("timeHorizon", timeHorizon);
     qSettings->setValue("windowWidth", windowWidth);
+    qSettings->setValue("windowFunction", windowFunction);
+    qSettings->setValue("windowOverlap", windowOverlap);
     qSettings->setValue("zMaximum",  zMaximum);
 
     for(int i = 0; i < plot3dCurveCount; i++){
@@ -223,7 +236,7 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
     // Get and store the units
     units = getUavObjectFieldUnits(uavObjectName, uavFieldName);
 
-    SpectrogramData* spectrogramData = new SpectrogramData(uavObjectName, uavFieldName, samplingFrequency, windowWidth, timeHorizon);
+    SpectrogramData* spectrogramData = new SpectrogramData(uavObjectName, uavFieldName, samplingFrequency, windowWidth, timeHorizon, windowFunction, windowOverlap);
     spectrogramData->setXMinimum(0);
     spectrogramData->setXMaximum(samplingFrequency/2);
     spectrogramData->setYMinimum(0);
@@ -263,24 +276,6 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
     plotSpectrogram->setRenderHint(QwtPlotItem::RenderAntialiased);
     plotSpectrogram->setColorMap(new ColorMap(colorMapType) );
 
-    // Initial raster data
-
-    QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
-    for ( uint i = 0; i < timeHorizon; i++ ){
-        spectrogramData->timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0 + i);
-    }
-
-    if (((double) windowWidth) * timeHorizon < (double) 10000000.0 * sizeof(spectrogramData->zDataHistory->front())){ //Don't exceed 10MB for memory
-        for ( uint i = 0; i < windowWidth*timeHorizon; i++ ){
-            spectrogramData->zDataHistory->append(0);
-        }
-    }
-    else{
-        qDebug() << "For some reason, we're trying to allocate a gigantic spectrogram. This probably represents a problem in the configuration file. TimeHorizion: "<< timeHorizon << ", windowWidth: "<< windowWidth;
-        Q_ASSERT(0);
-        return;
-    }
-
     //Set up colorbar on right axis
     spectrogramData->rightAxis = scopeGadgetWidget->axisWidget( QwtPlot::yRight );
     spectrogramData->rightAxis->setTitle( "Intensity" );
@@ -322,6 +317,8 @@ void SpectrogramScopeConfig::setGuiConfiguration(Ui::ScopeGadgetOptionsPage *opt
     options_page->sbSpectrogramTimeHorizon->setValue(timeHorizon);
     options_page->sbSpectrogramFrequency->setValue(samplingFrequency);
     options_page->spnMaxSpectrogramZ->setValue(zMaximum);
+    options_page->cmbSpectrogramWindow->setCurrentIndex(options_page->cmbSpectrogramWindow->findData(windowFunction));
+    options_page->sbSpectrogramOverlap->setValue(windowOverlap);
     options_page->cmbColorMapSpectrogram->setCurrentIndex(options_page->cmbColorMapSpectrogram->findData(colorMapType));
 
     foreach (Plot3dCurveConfiguration* plot3dData,  m_spectrogramSourceConfigs) {
@@ -29,6 +29,7 @@
 #define SPECTROGRAMSCOPECONFIG_H
 
 #include "scopes3d/scopes3dconfig.h"
+#include "scopes3d/spectrumanalyzer.h"
 
 
 /**
@@ -63,6 +64,8 @@ public:
     double getZMaximum(){return zMaximum;}
     unsigned int getWindowWidth(){return windowWidth;}
     double getTimeHorizon(){return timeHorizon;}
+    SpectrumAnalyzer::WindowFunction getWindowFunction(){return windowFunction;}
+    int getWindowOverlap(){return windowOverlap;}
     virtual QList<Plot3dCurveConfiguration*> getDataSourceConfigs(){return m_spectrogramSourceConfigs;}
     virtual int getScopeType(){return SPECTROGRAM;}
 
@@ -71,6 +74,8 @@ public:
     void setZMaximum(double val){zMaximum = val;}
     void setWindowWidth(unsigned int val){windowWidth = val;}
     void setTimeHorizon(double val){timeHorizon = val;}
+    void setWindowFunction(SpectrumAnalyzer::WindowFunction val){windowFunction = val;}
+    void setWindowOverlap(int val){windowOverlap = val;}
     virtual void setGuiConfiguration(Ui::ScopeGadgetOptionsPage *options_page);
     virtual ScopeConfig* cloneScope(ScopeConfig*);
 
@@ -92,6 +97,8 @@ private:
 
     double samplingFrequency;
     unsigned int windowWidth;
+    SpectrumAnalyzer::WindowFunction windowFunction;
+    int windowOverlap; //Percent of a window shared with the next one
     QString yAxisUnits;
     double zMaximum;
 
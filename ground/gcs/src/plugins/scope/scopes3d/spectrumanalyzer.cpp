@@ -0,0 +1,299 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrumanalyzer.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Sliding window spectrum of a sampled signal
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopes3d/spectrumanalyzer.h"
+
+#include <math.h>
+
+#ifdef USE_FFTW
+#include <fftw3.h>
+#endif
+
+
+SpectrumAnalyzer::SpectrumAnalyzer():
+    size(0),
+    hop(1),
+    amplitudeScale(0),
+    next(0),
+    received(0),
+    sinceFrame(0)
+#ifdef USE_FFTW
+    ,plan(0),
+    fftIn(0),
+    fftOut(0)
+#endif
+{
+}
+
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+#ifdef USE_FFTW
+    if (plan)
+        fftw_destroy_plan((fftw_plan) plan);
+    fftw_free(fftIn);
+    fftw_free(fftOut);
+#endif
+}
+
+
+/**
+ * @brief SpectrumAnalyzer::roundToPowerOfTwo Round up to the next window size the FFT supports
+ */
+int SpectrumAnalyzer::roundToPowerOfTwo(int value)
+{
+    int power = MIN_WINDOW_SIZE;
+    while (power < value && power < MAX_WINDOW_SIZE)
+        power *= 2;
+    return power;
+}
+
+
+/**
+ * @brief SpectrumAnalyzer::setup Prepare the window and the transform
+ * @param windowSize Number of samples per transform, rounded up to a power of two
+ * @param windowFunction Window applied to the samples
+ * @param overlapPercent Part of the window shared by consecutive transforms
+ */
+void SpectrumAnalyzer::setup(int windowSize, WindowFunction windowFunction, int overlapPercent)
+{
+    size = roundToPowerOfTwo(windowSize);
+    overlapPercent = qBound(0, overlapPercent, 99);
+    hop = qMax(size * (100 - overlapPercent) / 100, 1);
+
+    // Periodic windows, so that overlapping windows add up evenly
+    window.resize(size);
+    double windowSum = 0;
+    for (int n = 0; n < size; n++) {
+        double phase = 2 * M_PI * n / size;
+        switch (windowFunction) {
+        case HANN:
+            window[n] = 0.5 - 0.5 * cos(phase);
+            break;
+        case HAMMING:
+            window[n] = 0.54 - 0.46 * cos(phase);
+            break;
+        case BLACKMAN:
+            window[n] = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2 * phase);
+            break;
+        case RECTANGULAR:
+        default:
+            window[n] = 1;
+            break;
+        }
+        windowSum += window[n];
+    }
+
+    // A sine of amplitude A shows up as A in its bin
+    amplitudeScale = 2 / windowSum;
+
+    history.fill(0, size);
+    frame.fill(0, size);
+    amplitudes.fill(0, size / 2);
+
+#ifdef USE_FFTW
+    if (plan)
+        fftw_destroy_plan((fftw_plan) plan);
+    fftw_free(fftIn);
+    fftw_free(fftOut);
+    fftIn = (double *) fftw_malloc(sizeof(double) * size);
+    fftOut = (double *) fftw_malloc(sizeof(fftw_complex) * (size / 2 + 1));
+    plan = fftw_plan_dft_r2c_1d(size, fftIn, (fftw_complex *) fftOut, FFTW_MEASURE);
+#else
+    int half = size / 2;
+    re.fill(0, half);
+    im.fill(0, half);
+
+    int bits = 0;
+    while ((1 << bits) < half)
+        bits++;
+    bitReversed.resize(half);
+    for (int i = 0; i < half; i++) {
+        int reversed = 0;
+        for (int bit = 0; bit < bits; bit++)
+            if (i & (1 << bit))
+                reversed |= 1 << (bits - 1 - bit);
+        bitReversed[i] = reversed;
+    }
+
+    cosTable.resize(half / 2);
+    sinTable.resize(half / 2);
+    for (int i = 0; i < half / 2; i++) {
+        cosTable[i] = cos(2 * M_PI * i / half);
+        sinTable[i] = sin(2 * M_PI * i / half);
+    }
+
+    cosSplit.resize(half);
+    sinSplit.resize(half);
+    for (int k = 0; k < half; k++) {
+        cosSplit[k] = cos(2 * M_PI * k / size);
+        sinSplit[k] = sin(2 * M_PI * k / size);
+    }
+#endif
+
+    reset();
+}
+
+
+/**
+ * @brief SpectrumAnalyzer::reset Forget the received samples
+ */
+void SpectrumAnalyzer::reset()
+{
+    history.fill(0);
+    next = 0;
+    received = 0;
+    sinceFrame = 0;
+}
+
+
+/**
+ * @brief SpectrumAnalyzer::append Add a sample
+ * @return true if a new spectrum was computed
+ */
+bool SpectrumAnalyzer::append(double sample)
+{
+    if (size == 0)
+        return false;
+
+    history[next] = sample;
+    if (++next == size)
+        next = 0;
+    if (received < size)
+        received++;
+
+    // The first spectrum needs a full window
+    if (++sinceFrame < hop || received < size)
+        return false;
+
+    sinceFrame = 0;
+    computeFrame();
+    return true;
+}
+
+
+/**
+ * @brief SpectrumAnalyzer::computeFrame Window the history and transform it
+ */
+void SpectrumAnalyzer::computeFrame()
+{
+    const double *samples = history.constData();
+    const double *coefficients = window.constData();
+#ifdef USE_FFTW
+    double *windowed = fftIn;
+#else
+    double *windowed = frame.data();
+#endif
+
+    // The oldest sample is at next, unroll the ring while windowing
+    int tail = size - next;
+    for (int n = 0; n < tail; n++)
+        windowed[n] = samples[next + n] * coefficients[n];
+    for (int n = tail; n < size; n++)
+        windowed[n] = samples[n - tail] * coefficients[n];
+
+    transform();
+}
+
+
+#ifdef USE_FFTW
+
+void SpectrumAnalyzer::transform()
+{
+    fftw_execute((fftw_plan) plan);
+
+    double *out = amplitudes.data();
+    for (int k = 0; k < size / 2; k++)
+        out[k] = sqrt(fftOut[2 * k] * fftOut[2 * k] + fftOut[2 * k + 1] * fftOut[2 * k + 1]) * amplitudeScale;
+    out[0] *= 0.5;
+}
+
+#else
+
+/**
+ * @brief SpectrumAnalyzer::transform Real FFT of the frame. The even samples
+ * go into the real parts and the odd samples into the imaginary parts of a
+ * complex FFT of half the size, whose result is then split into the spectrum
+ * of the real signal.
+ */
+void SpectrumAnalyzer::transform()
+{
+    const int half = size / 2;
+    const double *in = frame.constData();
+    double *zr = re.data();
+    double *zi = im.data();
+
+    for (int i = 0; i < half; i++) {
+        int j = bitReversed[i];
+        zr[j] = in[2 * i];
+        zi[j] = in[2 * i + 1];
+    }
+
+    // Radix-2 decimation in time butterflies
+    for (int span = 2; span <= half; span *= 2) {
+        int step = half / span;
+        int middle = span / 2;
+        for (int start = 0; start < half; start += span) {
+            for (int k = 0; k < middle; k++) {
+                double wr = cosTable[k * step];
+                double wi = -sinTable[k * step];
+                int a = start + k;
+                int b = a + middle;
+                double tr = wr * zr[b] - wi * zi[b];
+                double ti = wr * zi[b] + wi * zr[b];
+                zr[b] = zr[a] - tr;
+                zi[b] = zi[a] - ti;
+                zr[a] += tr;
+                zi[a] += ti;
+            }
+        }
+    }
+
+    // X[k] = E[k] + exp(-2 pi i k / size) O[k], with E and O the spectra of
+    // the even and odd samples, recovered from Z[k] and conj(Z[half - k])
+    double *out = amplitudes.data();
+    out[0] = fabs(zr[0] + zi[0]) * amplitudeScale * 0.5;
+    for (int k = 1; k < half; k++) {
+        double a = zr[k];
+        double b = zi[k];
+        double c = zr[half - k];
+        double d = zi[half - k];
+
+        double er = 0.5 * (a + c);
+        double ei = 0.5 * (b - d);
+        double orr = 0.5 * (b + d);
+        double oi = -0.5 * (a - c);
+
+        double wr = cosSplit[k];
+        double wi = -sinSplit[k];
+        double xr = er + wr * orr - wi * oi;
+        double xi = ei + wr * oi + wi * orr;
+        out[k] = sqrt(xr * xr + xi * xi) * amplitudeScale;
+    }
+}
+
+#endif
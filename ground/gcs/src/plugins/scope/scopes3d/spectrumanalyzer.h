@@ -0,0 +1,106 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrumanalyzer.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Sliding window spectrum of a sampled signal
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SPECTRUMANALYZER_H
+#define SPECTRUMANALYZER_H
+
+#include <QVector>
+
+
+/**
+ * @brief The SpectrumAnalyzer class Computes the amplitude spectrum of the
+ * last windowSize() samples of a signal every hopSize() samples.
+ *
+ * The transform is a real FFT, done as a complex FFT of half the size. When
+ * the scope is built with CONFIG+=FFTW the transform is done by FFTW instead,
+ * which uses the SIMD units of the CPU.
+ */
+class SpectrumAnalyzer
+{
+public:
+    /**
+     * @brief The WindowFunction enum Window applied to the samples before the transform
+     */
+    enum WindowFunction {
+        RECTANGULAR,
+        HANN,
+        HAMMING,
+        BLACKMAN
+    };
+
+    static const int MIN_WINDOW_SIZE = 4;
+    static const int MAX_WINDOW_SIZE = 65536;
+
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer();
+
+    void setup(int windowSize, WindowFunction windowFunction, int overlapPercent);
+    void reset();
+
+    int windowSize() const {return size;}
+    int hopSize() const {return hop;}
+    int numBins() const {return size / 2;}
+
+    bool append(double sample);
+    const double *spectrum() const {return amplitudes.constData();}
+
+    static int roundToPowerOfTwo(int value); //Window sizes are powers of two between MIN_WINDOW_SIZE and MAX_WINDOW_SIZE
+
+private:
+    void computeFrame();
+    void transform();
+
+    int size;
+    int hop;
+    QVector<double> window;
+    double amplitudeScale;
+
+    // The last windowSize() samples, oldest at position next
+    QVector<double> history;
+    int next;
+    int received;
+    int sinceFrame;
+
+    QVector<double> frame;
+    QVector<double> amplitudes;
+
+#ifdef USE_FFTW
+    void *plan;
+    double *fftIn;
+    double *fftOut;
+#else
+    QVector<double> re;
+    QVector<double> im;
+    QVector<int> bitReversed;
+    QVector<double> cosTable; //Twiddle factors of the half size complex FFT
+    QVector<double> sinTable;
+    QVector<double> cosSplit; //Twiddle factors that split the result into the real FFT
+    QVector<double> sinSplit;
+#endif
+};
+
+#endif // SPECTRUMANALYZER_H
@@ -0,0 +1,109 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrogrambenchmark.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Measures how many spectrogram rows per second the spectrum analyzer
+ * produces, for each window function and overlap
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <math.h>
+#include "scopes3d/circularrasterdata.h"
+#include "scopes3d/spectrumanalyzer.h"
+
+static const int SIGNAL_SECONDS = 600;
+static const int TIME_HORIZON = 60;
+
+/**
+ * Run SIGNAL_SECONDS of a synthetic signal through the analyzer and into a
+ * raster of TIME_HORIZON seconds, as the spectrogram scope does
+ */
+static void run(QTextStream &out, const QString &name, SpectrumAnalyzer::WindowFunction windowFunction,
+                int overlap, int windowSize, double sampleRate)
+{
+    SpectrumAnalyzer analyzer;
+    analyzer.setup(windowSize, windowFunction, overlap);
+
+    CircularRasterData raster;
+    raster.resize(analyzer.numBins(), qMax((int) ceil(TIME_HORIZON * sampleRate / analyzer.hopSize()), 1));
+
+    qint64 samples = (qint64) (SIGNAL_SECONDS * sampleRate);
+    qint64 frames = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (qint64 i = 0; i < samples; i++) {
+        // A vibration sweeping up to a quarter of the sample rate, over noise
+        double t = i / sampleRate;
+        double sample = sin(2 * M_PI * (10 + 0.25 * sampleRate * t / SIGNAL_SECONDS) * t) + 0.01 * ((i * 7919) % 101 - 50);
+        if (analyzer.append(sample)) {
+            raster.appendRow(analyzer.spectrum());
+            frames++;
+        }
+    }
+    double elapsed = qMax(timer.nsecsElapsed(), (qint64) 1) / 1e9;
+
+    out << QString("%1 %2%  %3 frames/s, %4x real time\n")
+           .arg(name, -12).arg(overlap, 2)
+           .arg(frames / elapsed, 10, 'f', 0)
+           .arg(SIGNAL_SECONDS / elapsed, 8, 'f', 0);
+    out.flush();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QStringList args = app.arguments();
+    int windowSize = args.size() > 1 ? args.at(1).toInt() : 1024;
+    double sampleRate = args.size() > 2 ? args.at(2).toDouble() : 1000;
+    if (windowSize <= 0 || sampleRate <= 0) {
+        out << "Usage: spectrogrambenchmark [window size] [sample rate]\n";
+        return 1;
+    }
+
+#ifdef USE_FFTW
+    out << "FFTW transform, ";
+#else
+    out << "Built-in transform, ";
+#endif
+    out << SpectrumAnalyzer::roundToPowerOfTwo(windowSize) << " point window, "
+        << sampleRate << " Hz input, " << SIGNAL_SECONDS << " s of signal\n";
+
+    const char *names[] = {"Rectangular", "Hann", "Hamming", "Blackman"};
+    const int overlaps[] = {0, 50, 75, 90};
+    for (int w = SpectrumAnalyzer::RECTANGULAR; w <= SpectrumAnalyzer::BLACKMAN; w++)
+        for (unsigned int o = 0; o < sizeof(overlaps) / sizeof(overlaps[0]); o++)
+            run(out, names[w], (SpectrumAnalyzer::WindowFunction) w, overlaps[o], windowSize, sampleRate);
+
+    return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
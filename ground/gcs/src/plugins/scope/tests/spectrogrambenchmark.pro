@@ -0,0 +1,23 @@
+# -------------------------------------------------
+# Spectrogram engine throughput benchmark
+# Usage: spectrogrambenchmark [window size] [sample rate]
+# -------------------------------------------------
+TARGET = spectrogrambenchmark
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+include(../../../../gcs.pri)
+include(../../../libs/qwt/qwt.pri)
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins/scope
+LIBS += -L$$GCS_LIBRARY_PATH
+
+FFTW {
+    DEFINES += USE_FFTW
+    LIBS += -lfftw3
+}
+
+HEADERS += ../scopes3d/spectrumanalyzer.h \
+    ../scopes3d/circularrasterdata.h
+SOURCES += spectrogrambenchmark.cpp \
+    ../scopes3d/spectrumanalyzer.cpp \
+    ../scopes3d/circularrasterdata.cpp
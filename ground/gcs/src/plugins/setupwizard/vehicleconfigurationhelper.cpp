@@ -416,11 +416,12 @@ bool VehicleConfigurationHelper::saveChangesToController(bool save)
     QTimer innerTimeoutTimer;
     innerTimeoutTimer.setSingleShot(true);
 
-    connect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(uAVOTransactionCompleted(int, bool)));
     connect(&innerTimeoutTimer, SIGNAL(timeout()), &m_eventLoop, SLOT(quit()));
     connect(&outerTimeoutTimer, SIGNAL(timeout()), this, SLOT(saveChangesTimeout()));
 
     outerTimeoutTimer.start(OUTER_TIMEOUT);
+    bool allUpdated = true;
+    QList<UAVDataObject *> updatedObjects;
     for (int i = 0; i < m_modifiedObjects.count(); i++) {
         QPair<UAVDataObject *, QString> *objPair = m_modifiedObjects.at(i);
         m_transactionOK = false;
@@ -444,31 +445,13 @@ bool VehicleConfigurationHelper::saveChangesToController(bool save)
                 innerTimeoutTimer.stop();
             }
             disconnect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(uAVOTransactionCompleted(UAVObject *, bool)));
+            m_currentTransactionObjectID = -1;
             if (m_transactionOK) {
                 qDebug() << "Object " << obj->getName() << " was successfully updated.";
-                if (save) {
-                    m_transactionOK = false;
-                    m_currentTransactionObjectID = obj->getObjID();
-                    // Try to save until success or timeout
-                    while (!m_transactionOK && !m_transactionTimeout) {
-                        // Allow the transaction to take some time
-                        innerTimeoutTimer.start(INNER_TIMEOUT);
-
-                        // Persist object in controller
-                        utilMngr->saveObjectToFlash(obj);
-                        if (!m_transactionOK) {
-                            m_eventLoop.exec();
-                        }
-                        innerTimeoutTimer.stop();
-                    }
-                    m_currentTransactionObjectID = -1;
-                }
-            }
-
-            if (!m_transactionOK) {
-                qDebug() << "Transaction timed out when trying to save: " << obj->getName();
+                updatedObjects.append(obj);
             } else {
-                qDebug() << "Object " << obj->getName() << " was successfully saved.";
+                qDebug() << "Transaction timed out when trying to update: " << obj->getName();
+                allUpdated = false;
             }
         } else {
             qDebug() << "Trying to save a UAVDataObject that is read only or is not a settings object.";
@@ -479,10 +462,41 @@ bool VehicleConfigurationHelper::saveChangesToController(bool save)
         }
     }
 
+    // Persist the objects in the controller. They are all queued at once so that
+    // the util manager can send them in batches, objects which failed are queued
+    // again until the outer timeout.
+    if (save && !m_transactionTimeout) {
+        connect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(objectSaveCompleted(int, bool)));
+        while (!updatedObjects.isEmpty() && !m_transactionTimeout) {
+            m_pendingSaves.clear();
+            m_failedSaves.clear();
+            foreach(UAVDataObject * obj, updatedObjects) {
+                if (!m_pendingSaves.contains(obj->getObjID())) {
+                    m_pendingSaves.insert(obj->getObjID());
+                    utilMngr->saveObjectToFlash(obj);
+                }
+            }
+            m_eventLoop.exec();
+
+            QList<UAVDataObject *> failedObjects;
+            foreach(UAVDataObject * obj, updatedObjects) {
+                if (m_pendingSaves.contains(obj->getObjID()) || m_failedSaves.contains(obj->getObjID())) {
+                    qDebug() << "Failed to save: " << obj->getName();
+                    failedObjects.append(obj);
+                } else {
+                    qDebug() << "Object " << obj->getName() << " was successfully saved.";
+                }
+            }
+            updatedObjects = failedObjects;
+        }
+        disconnect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(objectSaveCompleted(int, bool)));
+        m_pendingSaves.clear();
+    }
+    m_transactionOK = allUpdated && !m_transactionTimeout && (!save || updatedObjects.isEmpty());
+
     outerTimeoutTimer.stop();
     disconnect(&outerTimeoutTimer, SIGNAL(timeout()), this, SLOT(saveChangesTimeout()));
     disconnect(&innerTimeoutTimer, SIGNAL(timeout()), &m_eventLoop, SLOT(quit()));
-    disconnect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(uAVOTransactionCompleted(int, bool)));
 
     qDebug() << "Finished saving modified objects to controller. Success = " << m_transactionOK;
 
@@ -497,6 +511,18 @@ void VehicleConfigurationHelper::uAVOTransactionCompleted(int oid, bool success)
     }
 }
 
+void VehicleConfigurationHelper::objectSaveCompleted(int oid, bool success)
+{
+    if (m_pendingSaves.remove(oid)) {
+        if (!success) {
+            m_failedSaves.insert(oid);
+        }
+        if (m_pendingSaves.isEmpty()) {
+            m_eventLoop.quit();
+        }
+    }
+}
+
 void VehicleConfigurationHelper::uAVOTransactionCompleted(UAVObject *object, bool success)
 {
     if (object) {
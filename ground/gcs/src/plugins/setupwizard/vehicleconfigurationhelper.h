@@ -32,6 +32,7 @@
 
 #include <QList>
 #include <QPair>
+#include <QSet>
 #include "vehicleconfigurationsource.h"
 #include "uavobjectmanager.h"
 #include "systemsettings.h"
@@ -106,6 +107,8 @@ private:
     bool m_transactionTimeout;
     int m_currentTransactionObjectID;
     int m_progress;
+    QSet<int> m_pendingSaves;
+    QSet<int> m_failedSaves;
 
     void resetVehicleConfig();
     void resetGUIData();
@@ -118,6 +121,7 @@ private:
 private slots:
     void uAVOTransactionCompleted(UAVObject *object, bool success);
     void uAVOTransactionCompleted(int oid, bool success);
+    void objectSaveCompleted(int oid, bool success);
     void saveChangesTimeout();
 };
 
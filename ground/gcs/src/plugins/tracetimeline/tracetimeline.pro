@@ -0,0 +1,18 @@
+TEMPLATE = lib
+TARGET = TraceTimelineGadget
+QT += widgets
+include(../../taulabsgcsplugin.pri)
+include(../../plugins/coreplugin/coreplugin.pri)
+include(tracetimeline_dependencies.pri)
+
+HEADERS += tracetimelineplugin.h
+HEADERS += tracetimelinegadget.h
+HEADERS += tracetimelinegadgetwidget.h
+HEADERS += tracetimelinegadgetfactory.h
+SOURCES += tracetimelineplugin.cpp
+SOURCES += tracetimelinegadget.cpp
+SOURCES += tracetimelinegadgetfactory.cpp
+SOURCES += tracetimelinegadgetwidget.cpp
+
+OTHER_FILES += TraceTimelineGadget.pluginspec \
+                TraceTimelineGadget.json
@@ -0,0 +1 @@
+include(../../plugins/uavobjects/uavobjects.pri)
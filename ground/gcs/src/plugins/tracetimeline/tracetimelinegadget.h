@@ -0,0 +1,53 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tracetimelinegadget.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup TraceTimelineGadgetPlugin Trace Timeline Gadget Plugin
+ * @{
+ * @brief Shows the latency along the sensor to actuator path
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TRACETIMELINEGADGET_H_
+#define TRACETIMELINEGADGET_H_
+
+#include <coreplugin/iuavgadget.h>
+
+class TraceTimelineGadgetWidget;
+
+using namespace Core;
+
+class TraceTimelineGadget : public Core::IUAVGadget
+{
+    Q_OBJECT
+public:
+    TraceTimelineGadget(QString classId, TraceTimelineGadgetWidget *widget, QWidget *parent = 0);
+    ~TraceTimelineGadget();
+
+    QList<int> context() const { return m_context; }
+    QWidget *widget() { return m_widget; }
+    QString contextHelpId() const { return QString(); }
+
+private:
+    QWidget *m_widget;
+    QList<int> m_context;
+};
+
+#endif // TRACETIMELINEGADGET_H_
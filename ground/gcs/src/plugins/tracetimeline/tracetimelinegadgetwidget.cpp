@@ -0,0 +1,150 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tracetimelinegadgetwidget.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup TraceTimelineGadgetPlugin Trace Timeline Gadget Plugin
+ * @{
+ * @brief Shows the latency along the sensor to actuator path
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "tracetimelinegadgetwidget.h"
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjectmanager.h"
+#include "uavobject.h"
+#include "uavobjectfield.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+
+//! Width of the column with the probe names and statistics
+#define LABEL_WIDTH 260
+
+TraceTimelineGadgetWidget::TraceTimelineGadgetWidget(QWidget *parent) : QWidget(parent)
+{
+    setMinimumSize(400, 120);
+    setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    UAVObject *obj = objManager->getObject(QString("TraceStats"));
+    Q_ASSERT(obj);
+    if (obj != NULL) {
+        m_probes = obj->getField("Rate")->getElementNames();
+        connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(traceStatsUpdated(UAVObject*)));
+    }
+
+    setToolTip(tr("Most recent probe hits along the path from the gyros to the actuators, "
+                  "with the latency of each probe measured from the gyro sample that led to it."));
+}
+
+TraceTimelineGadgetWidget::~TraceTimelineGadgetWidget()
+{
+    // Do nothing
+}
+
+void TraceTimelineGadgetWidget::traceStatsUpdated(UAVObject *obj)
+{
+    UAVObjectField *rate = obj->getField("Rate");
+    UAVObjectField *jitter = obj->getField("Jitter");
+    UAVObjectField *latency = obj->getField("Latency");
+    UAVObjectField *maxLatency = obj->getField("MaxLatency");
+    UAVObjectField *eventAge = obj->getField("EventAge");
+    UAVObjectField *eventProbe = obj->getField("EventProbe");
+    Q_ASSERT(rate && jitter && latency && maxLatency && eventAge && eventProbe);
+    if (!rate || !jitter || !latency || !maxLatency || !eventAge || !eventProbe)
+        return;
+
+    int numProbes = m_probes.size();
+    m_rate.resize(numProbes);
+    m_jitter.resize(numProbes);
+    m_latency.resize(numProbes);
+    m_maxLatency.resize(numProbes);
+    for (int i = 0; i < numProbes; i++) {
+        m_rate[i] = rate->getDouble(i);
+        m_jitter[i] = jitter->getDouble(i);
+        m_latency[i] = latency->getDouble(i);
+        m_maxLatency[i] = maxLatency->getDouble(i);
+    }
+
+    // The event probes share their names with the statistics, plus one
+    // for the slots that hold no event
+    QStringList options = eventProbe->getOptions();
+    m_events.clear();
+    for (uint i = 0; i < eventProbe->getNumElements(); i++) {
+        Event event;
+        event.probe = options.indexOf(eventProbe->getValue(i).toString());
+        event.age = eventAge->getValue(i).toUInt();
+        if (event.probe >= 0 && event.probe < numProbes)
+            m_events.append(event);
+    }
+
+    update();
+}
+
+void TraceTimelineGadgetWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+
+    int numProbes = m_probes.size();
+    if (numProbes == 0)
+        return;
+
+    const int laneHeight = height() / (numProbes + 1);
+    const int timelineWidth = width() - LABEL_WIDTH - 10;
+
+    // Scale the time axis so that the oldest event just fits
+    quint32 span = 1000;
+    foreach (const Event &e, m_events)
+        span = qMax(span, e.age);
+
+    painter.setPen(palette().text().color());
+    for (int i = 0; i < numProbes; i++) {
+        int y = (i + 1) * laneHeight;
+
+        QString label = m_probes[i];
+        if (i < m_rate.size()) {
+            label += tr(": %1 Hz, jitter %2 us, latency %3 us (max %4)")
+                    .arg(m_rate[i], 0, 'f', 0)
+                    .arg(m_jitter[i], 0, 'f', 0)
+                    .arg(m_latency[i], 0, 'f', 0)
+                    .arg(m_maxLatency[i], 0, 'f', 0);
+        }
+        painter.drawText(QRect(0, y - laneHeight / 2, LABEL_WIDTH, laneHeight),
+                         Qt::AlignVCenter | Qt::AlignLeft | Qt::TextWordWrap, label);
+        painter.drawLine(LABEL_WIDTH, y, LABEL_WIDTH + timelineWidth, y);
+    }
+
+    // Newest events on the right
+    painter.setPen(QPen(palette().highlight().color(), 2));
+    foreach (const Event &e, m_events) {
+        int x = LABEL_WIDTH + timelineWidth - (int) ((qint64) e.age * timelineWidth / span);
+        int y = (e.probe + 1) * laneHeight;
+        painter.drawLine(x, y - laneHeight / 3, x, y + laneHeight / 3);
+    }
+
+    painter.setPen(palette().text().color());
+    painter.drawText(QRect(LABEL_WIDTH, numProbes * laneHeight + laneHeight / 2, timelineWidth, laneHeight / 2),
+                     Qt::AlignLeft | Qt::AlignTop, tr("-%1 us").arg(span));
+    painter.drawText(QRect(LABEL_WIDTH, numProbes * laneHeight + laneHeight / 2, timelineWidth, laneHeight / 2),
+                     Qt::AlignRight | Qt::AlignTop, tr("now"));
+}
@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tracetimelinegadgetwidget.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup TraceTimelineGadgetPlugin Trace Timeline Gadget Plugin
+ * @{
+ * @brief Shows the latency along the sensor to actuator path
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TRACETIMELINEGADGETWIDGET_H_
+#define TRACETIMELINEGADGETWIDGET_H_
+
+#include <QWidget>
+#include <QStringList>
+#include <QVector>
+
+class UAVObject;
+
+/**
+ * Draws the most recent probe hits from TraceStats on one lane per probe,
+ * newest on the right, with the rate, jitter and latency of each probe
+ * next to its lane.
+ */
+class TraceTimelineGadgetWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    TraceTimelineGadgetWidget(QWidget *parent = 0);
+    ~TraceTimelineGadgetWidget();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private slots:
+    void traceStatsUpdated(UAVObject *obj);
+
+private:
+    struct Event {
+        int probe;
+        quint32 age;
+    };
+
+    QStringList m_probes;
+    QVector<double> m_rate;
+    QVector<double> m_jitter;
+    QVector<double> m_latency;
+    QVector<double> m_maxLatency;
+    QVector<Event> m_events;
+};
+
+#endif /* TRACETIMELINEGADGETWIDGET_H_ */
@@ -0,0 +1,61 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tracetimelineplugin.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup TraceTimelineGadgetPlugin Trace Timeline Gadget Plugin
+ * @{
+ * @brief Shows the latency along the sensor to actuator path
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "tracetimelineplugin.h"
+#include "tracetimelinegadgetfactory.h"
+#include <QtPlugin>
+#include <QStringList>
+#include <extensionsystem/pluginmanager.h>
+
+TraceTimelinePlugin::TraceTimelinePlugin()
+{
+    // Do nothing
+}
+
+TraceTimelinePlugin::~TraceTimelinePlugin()
+{
+    // Do nothing
+}
+
+bool TraceTimelinePlugin::initialize(const QStringList& args, QString *errMsg)
+{
+    Q_UNUSED(args);
+    Q_UNUSED(errMsg);
+    mf = new TraceTimelineGadgetFactory(this);
+    addAutoReleasedObject(mf);
+
+    return true;
+}
+
+void TraceTimelinePlugin::extensionsInitialized()
+{
+    // Do nothing
+}
+
+void TraceTimelinePlugin::shutdown()
+{
+    // Do nothing
+}
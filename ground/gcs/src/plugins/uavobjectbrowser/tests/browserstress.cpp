@@ -0,0 +1,276 @@
+/**
+ ******************************************************************************
+ * @file       browserstress.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectBrowserPlugin UAVObject Browser Plugin
+ * @{
+ * @brief Replays a telemetry log into the UAV Object Browser faster than
+ * real time and reports the frame time of the user interface
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QApplication>
+#include <QBuffer>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+#include <QTreeView>
+#include <time.h>
+#include "extensionsystem/pluginmanager.h"
+#include "uavtalk/uavtalk.h"
+#include "uavobjects/uavobjectsinit.h"
+#include "logging/logindex.h"
+#include "logging/logdecoder/syntheticlog.h"
+#include "uavobjectbrowserwidget.h"
+
+static const int FRAME_PERIOD = 16;         // ms, one frame at 60Hz
+static const int REPLAY_PERIOD = 5;         // ms
+static const qint64 SYNTHETIC_SIZE = 16;    // MiB
+
+/**
+ * Feeds the packets of a log to UAVTalk as their timestamps come up, sped up
+ * by a factor, while a timer running at the display rate records how long
+ * the event loop actually takes to come around. A frame takes longer than
+ * FRAME_PERIOD when the updates keep the user interface busy.
+ */
+class BrowserStress : public QObject
+{
+    Q_OBJECT
+public:
+    BrowserStress(const LogIndex &index, UAVTalk *talk, double speed, int seconds) :
+        index(index), talk(talk), speed(speed), seconds(seconds),
+        next(0), packets(0), lastFrame(0), cpuStart(0)
+    {
+        connect(&replayTimer, SIGNAL(timeout()), this, SLOT(replay()));
+        connect(&frameTimer, SIGNAL(timeout()), this, SLOT(frame()));
+    }
+
+    void start()
+    {
+        cpuStart = clock();
+        wallClock.start();
+        replayClock.start();
+        replayTimer.start(REPLAY_PERIOD);
+        frameTimer.start(FRAME_PERIOD);
+    }
+
+    void report(QTextStream &out)
+    {
+        double elapsed = wallClock.elapsed() / 1000.0;
+        double cpu = (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+        out << packets << " packets in " << elapsed << " s at " << speed << "x, "
+            << (qint64)(packets / elapsed) << " packets/s, "
+            << (int)(100 * cpu / elapsed) << "% CPU\n";
+
+        if (frames.isEmpty()) {
+            out.flush();
+            return;
+        }
+
+        QVector<qint64> sorted = frames;
+        qSort(sorted);
+        qint64 total = 0;
+        int late = 0;
+        foreach (qint64 frame, sorted) {
+            total += frame;
+            if (frame > 2 * FRAME_PERIOD * 1000)
+                late++;
+        }
+        out << sorted.size() << " frames, frame time (ms) mean " << total / sorted.size() / 1000.0
+            << ", median " << sorted.at(sorted.size() / 2) / 1000.0
+            << ", 99% " << sorted.at(sorted.size() * 99 / 100) / 1000.0
+            << ", max " << sorted.last() / 1000.0
+            << ", " << late << " frames over " << 2 * FRAME_PERIOD << " ms\n";
+        out.flush();
+    }
+
+signals:
+    void finished();
+
+private slots:
+    void replay()
+    {
+        if (wallClock.elapsed() >= seconds * 1000) {
+            replayTimer.stop();
+            frameTimer.stop();
+            emit finished();
+            return;
+        }
+
+        // Start over at the end of the log
+        if (next >= index.numPackets()) {
+            next = 0;
+            replayClock.restart();
+        }
+
+        quint32 logTime = index.packet(0).timestamp + (quint32)(replayClock.elapsed() * speed);
+        while (next < index.numPackets() && index.packet(next).timestamp <= logTime) {
+            const LogIndex::Packet &packet = index.packet(next);
+            if (packet.objId != 0) {
+                talk->processInputBuffer(index.packetData(next), packet.size);
+                packets++;
+            }
+            next++;
+        }
+    }
+
+    void frame()
+    {
+        qint64 now = wallClock.nsecsElapsed() / 1000;
+        if (lastFrame > 0)
+            frames.append(now - lastFrame);
+        lastFrame = now;
+    }
+
+private:
+    const LogIndex &index;
+    UAVTalk *talk;
+    double speed;
+    int seconds;
+
+    quint32 next;
+    quint64 packets;
+    QTimer replayTimer;
+    QTimer frameTimer;
+    QElapsedTimer wallClock;
+    QElapsedTimer replayClock;
+    qint64 lastFrame;
+    QVector<qint64> frames;     // Time between frames in us
+    clock_t cpuStart;
+};
+
+/**
+ * Offset of the first record, after the text header of new format logs
+ */
+static qint64 findDataStart(QFile &file)
+{
+    if (file.readLine().startsWith("Tau Labs git hash")) {
+        int cnt = 0;
+        while (file.readLine() != "##\n" && cnt++ < 10 && !file.atEnd())
+            ;
+        return file.pos();
+    }
+    return 0;
+}
+
+static void usage(QTextStream &out)
+{
+    out << "Usage: browserstress [-s speed] [-t seconds] [-e] [-c] [logfile.tll]\n"
+        << "  -s  replay speed, 10 times real time by default\n"
+        << "  -t  duration of the test in seconds, 30 by default\n"
+        << "  -e  expand all objects\n"
+        << "  -c  only highlight changed values\n"
+        << "Without a log a synthetic log of all data objects is replayed\n";
+    out.flush();
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    ExtensionSystem::PluginManager pm;
+    UAVObjectManager *objMngr = new UAVObjectManager;
+    UAVObjectsInitialize(objMngr);
+    pm.addObject(objMngr);
+
+    double speed = 10;
+    int seconds = 30;
+    bool expand = false;
+    bool onlyChanges = false;
+    QString fileName;
+
+    QStringList args = app.arguments();
+    args.removeFirst();
+    while (!args.isEmpty()) {
+        QString arg = args.takeFirst();
+        if (arg == "-s" && !args.isEmpty()) {
+            speed = qMax(args.takeFirst().toDouble(), 0.1);
+        } else if (arg == "-t" && !args.isEmpty()) {
+            seconds = qMax(args.takeFirst().toInt(), 1);
+        } else if (arg == "-e") {
+            expand = true;
+        } else if (arg == "-c") {
+            onlyChanges = true;
+        } else if (!arg.startsWith("-") && fileName.isEmpty()) {
+            fileName = arg;
+        } else {
+            usage(out);
+            return 1;
+        }
+    }
+
+    bool synthetic = fileName.isEmpty();
+    if (synthetic) {
+        fileName = QDir::tempPath() + "/browserstress.tll";
+        if (!SyntheticLog::generate(fileName, SYNTHETIC_SIZE * 1048576, objMngr)) {
+            out << "Unable to write " << fileName << "\n";
+            return 1;
+        }
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        out << "Unable to open " << fileName << "\n";
+        return 1;
+    }
+    LogIndex index;
+    if (!index.open(&file, findDataStart(file)) || index.numPackets() == 0) {
+        out << "Unable to index " << fileName << "\n";
+        return 1;
+    }
+
+    UAVObjectBrowserWidget browser;
+    browser.setOnlyHighlightChangedValues(onlyChanges);
+    browser.initialize();
+    browser.resize(800, 1000);
+    browser.show();
+    if (expand)
+        browser.findChild<QTreeView*>("treeView")->expandAll();
+
+    QBuffer device;
+    device.open(QIODevice::ReadWrite);
+    UAVTalk talk(&device, objMngr);
+
+    BrowserStress stress(index, &talk, speed, seconds);
+    QObject::connect(&stress, SIGNAL(finished()), &app, SLOT(quit()));
+    stress.start();
+    app.exec();
+
+    out << fileName << ": " << index.numPackets() << " packets, "
+        << (expand ? "expanded" : "collapsed") << " tree\n";
+    stress.report(out);
+
+    if (synthetic) {
+        index.close();
+        file.close();
+        QFile::remove(LogIndex::indexFileName(fileName));
+        QFile::remove(fileName);
+    }
+    return 0;
+}
+
+#include "browserstress.moc"
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,33 @@
+# -------------------------------------------------
+# UAV Object Browser stress test, replays a log into the browser and
+# reports the UI frame time
+# Usage: browserstress [-s speed] [-t seconds] [-e] [-c] [logfile.tll]
+# -------------------------------------------------
+QT += widgets network
+TARGET = browserstress
+CONFIG -= app_bundle
+TEMPLATE = app
+include(../../../../gcs.pri)
+include(../uavobjectbrowser_dependencies.pri)
+include(../../uavtalk/uavtalk.pri)
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins \
+    $$GCS_SOURCE_TREE/src/plugins/uavobjectbrowser
+LIBS += -L$$GCS_PLUGIN_PATH/TauLabs -L$$GCS_LIBRARY_PATH
+HEADERS += ../uavobjectbrowserwidget.h \
+    ../uavobjecttreemodel.h \
+    ../treeitem.h \
+    ../fieldtreeitem.h \
+    ../browseritemdelegate.h \
+    ../../logging/logindex.h \
+    ../../logging/logdecoder/syntheticlog.h
+SOURCES += browserstress.cpp \
+    ../uavobjectbrowserwidget.cpp \
+    ../uavobjecttreemodel.cpp \
+    ../treeitem.cpp \
+    ../fieldtreeitem.cpp \
+    ../browseritemdelegate.cpp \
+    ../../logging/logindex.cpp \
+    ../../logging/logdecoder/syntheticlog.cpp
+FORMS += ../uavobjectbrowser.ui \
+    ../viewoptions.ui
+RESOURCES += ../uavobjectbrowser.qrc
@@ -29,6 +29,7 @@
 #include "treeitem.h"
 #include "fieldtreeitem.h"
 #include <math.h>
+#include <string.h>
 
 QTime* HighLightManager::m_currentTime = NULL;
 
@@ -53,10 +54,10 @@ bool HighLightManager::add(TreeItem *itemToAdd)
     // Lock to ensure thread safety
     QMutexLocker locker(&m_listMutex);
 
-    // Check so that the item isn't already in the list
-    if(!m_itemsList.contains(itemToAdd))
+    // Check so that the item isn't already in the set
+    if(!m_items.contains(itemToAdd))
     {
-        m_itemsList.append(itemToAdd);
+        m_items.insert(itemToAdd);
         return true;
     }
     return false;
@@ -72,7 +73,7 @@ bool HighLightManager::remove(TreeItem *itemToRemove)
     QMutexLocker locker(&m_listMutex);
 
     // Remove item and return result
-    return m_itemsList.removeOne(itemToRemove);
+    return m_items.remove(itemToRemove);
 }
 
 /*
@@ -86,8 +87,8 @@ void HighLightManager::checkItemsExpired()
     // Lock to ensure thread safety
     QMutexLocker locker(&m_listMutex);
 
-    // Get a mutable iterator for the list
-    QMutableLinkedListIterator<TreeItem*> iter(m_itemsList);
+    // Get a mutable iterator for the set
+    QMutableSetIterator<TreeItem*> iter(m_items);
 
     // Loop over all items, check if they expired.
     while(iter.hasNext())
@@ -279,6 +280,85 @@ void TreeItem::setCurrentTime(QTime *currentTime)
     m_currentTime = currentTime;
 }
 
+/*
+ * Called once the field items are added, and whenever the items are set from
+ * the object, to take the current data of the object as the reference of the
+ * next update.
+ */
+void ObjectTreeItem::resetDirtyFields()
+{
+    if (m_obj) {
+        m_lastData.resize(m_obj->getNumBytes());
+        m_obj->pack((quint8*)m_lastData.data());
+    }
+    m_dirtyFields.fill(false, m_fieldItems.size());
+    m_pendingUpdate = false;
+    m_pendingChange = false;
+}
+
+/*
+ * Called with the packed data of the object when it is updated. Fields whose
+ * bytes changed are marked dirty, as are fields the user edited, since the
+ * update overwrites the edited values.
+ */
+void ObjectTreeItem::markUpdated(const QByteArray &data)
+{
+    if (!m_obj)
+        return;
+
+    QList<UAVObjectField*> fields = m_obj->getFields();
+    bool sameSize = (data.size() == m_lastData.size());
+    int count = qMin(fields.size(), m_fieldItems.size());
+    for (int i = 0; i < count; ++i) {
+        UAVObjectField *field = fields.at(i);
+        int offset = field->getDataOffset();
+        int size = field->getNumBytes();
+        if (!sameSize || offset + size > data.size() ||
+                memcmp(data.constData() + offset, m_lastData.constData() + offset, size) != 0) {
+            m_dirtyFields.setBit(i);
+            m_pendingChange = true;
+            continue;
+        }
+
+        TreeItem *item = m_fieldItems.at(i);
+        bool edited = item->changed();
+        foreach (TreeItem *element, item->treeChildren())
+            edited = edited || element->changed();
+        if (edited)
+            m_dirtyFields.setBit(i);
+    }
+
+    m_lastData = data;
+    m_pendingUpdate = true;
+}
+
+/*
+ * Returns true if the row of the object should be highlighted for the updates
+ * since the previous call: for any update, or with onlyChanges only for those
+ * that changed a value.
+ */
+bool ObjectTreeItem::takeUpdate(bool onlyChanges)
+{
+    bool highlight = onlyChanges ? m_pendingChange : m_pendingUpdate;
+    m_pendingUpdate = false;
+    m_pendingChange = false;
+    return highlight;
+}
+
+/*
+ * Returns the items of the dirty fields and marks all fields clean.
+ */
+QList<TreeItem*> ObjectTreeItem::takeDirtyFields()
+{
+    QList<TreeItem*> dirty;
+    for (int i = 0; i < m_dirtyFields.size(); ++i) {
+        if (m_dirtyFields.testBit(i))
+            dirty.append(m_fieldItems.at(i));
+    }
+    m_dirtyFields.fill(false);
+    return dirty;
+}
+
 QList<MetaObjectTreeItem *> TopTreeItem::getMetaObjectItems()
 {
     return m_metaObjectTreeItemsPerObjectIds.values();
@@ -34,8 +34,10 @@
 #include "uavmetaobject.h"
 #include "uavobjectfield.h"
 #include <QtCore/QList>
-#include <QtCore/QLinkedList>
+#include <QtCore/QSet>
 #include <QtCore/QMap>
+#include <QtCore/QBitArray>
+#include <QtCore/QByteArray>
 #include <QtCore/QVariant>
 #include <QtCore/QTime>
 #include <QtCore/QTimer>
@@ -48,7 +50,7 @@ class TreeItem;
 * Small utility class that handles the higlighting of
 * tree grid items.
 * Basicly it maintains all items due to be restored to
-* non highlighted state in a linked list.
+* non highlighted state in a set.
 * A timer traverses this list periodically to find out
 * if any of the items should be restored. All items are
 * updated withan expiration timestamp when they expires.
@@ -81,8 +83,8 @@ private:
     // The timer checking highlight expiration.
     QTimer m_expirationTimer;
 
-    // The list holding all items due to be updated.
-    QLinkedList<TreeItem*> m_itemsList;
+    // The set holding all items due to be updated.
+    QSet<TreeItem*> m_items;
 
     //Mutex to lock when accessing list.
     QMutex m_listMutex;
@@ -229,16 +231,33 @@ class ObjectTreeItem : public TreeItem
 Q_OBJECT
 public:
     ObjectTreeItem(const QList<QVariant> &data, TreeItem *parent = 0) :
-            TreeItem(data, parent), m_obj(0) { }
+            TreeItem(data, parent), m_obj(0), m_pendingUpdate(false), m_pendingChange(false) { }
     ObjectTreeItem(const QVariant &data, TreeItem *parent = 0) :
-            TreeItem(data, parent), m_obj(0) { }
+            TreeItem(data, parent), m_obj(0), m_pendingUpdate(false), m_pendingChange(false) { }
     virtual void setObject(UAVObject *obj) {
         m_obj = obj; setDescription(obj->getDescription());
     }
     inline UAVObject *object() { return m_obj; }
 
+    // Dirty field tracking. The items of the fields are added in the order
+    // of UAVObject::getFields(), each update of the object compares its
+    // packed data field by field with the previous one and marks the fields
+    // that differ. The model only refreshes the dirty fields, and only when
+    // they are visible.
+    void addFieldItem(TreeItem *item) { m_fieldItems.append(item); }
+    void resetDirtyFields();
+    void markUpdated(const QByteArray &data);
+    bool takeUpdate(bool onlyChanges);
+    bool hasDirtyFields() const { return m_dirtyFields.count(true) > 0; }
+    QList<TreeItem*> takeDirtyFields();
+
 private:
     UAVObject *m_obj;
+    QList<TreeItem*> m_fieldItems;
+    QBitArray m_dirtyFields;
+    QByteArray m_lastData;
+    bool m_pendingUpdate;
+    bool m_pendingChange;
 };
 
 class MetaObjectTreeItem : public ObjectTreeItem
@@ -39,6 +39,7 @@
 #include <QComboBox>
 #include <QtCore/QDebug>
 #include <QItemEditorFactory>
+#include <QScrollBar>
 #include "extensionsystem/pluginmanager.h"
 #include <math.h>
 
@@ -559,86 +560,36 @@ void UAVObjectBrowserWidget::enableUAVOBrowserButtons(bool enableState)
  * @brief UAVOBrowserTreeView::UAVOBrowserTreeView Constructor for reimplementation of QTreeView
  */
 UAVOBrowserTreeView::UAVOBrowserTreeView(UAVObjectTreeModel *m_model_new, unsigned int updateTimerPeriod) : QTreeView(),
-    m_model(m_model_new),
-    m_updateTreeViewFlag(false)
+    m_model(m_model_new)
 {
     // Start timer at 100ms
     m_updateViewTimer.start(updateTimerPeriod);
 
     // Connect the timer
     connect(&m_updateViewTimer, SIGNAL(timeout()), this, SLOT(onTimeout_updateView()));
+
+    // Objects that come into view are refreshed right away instead of on the next tick
+    connect(this, SIGNAL(expanded(QModelIndex)), this, SLOT(onTimeout_updateView()));
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(onTimeout_updateView()));
 }
 
 void UAVOBrowserTreeView::updateTimerPeriod(unsigned int val)
 {
-    if (val == 0){
-        // If val == 0, disable throttling by stopping the timer.
-        m_updateViewTimer.stop();
-    }
-    else
+    // If the UAVO has a very fast data rate, then don't go the full speed.
+    if (val < 100)
     {
-        // If the UAVO has a very fast data rate, then don't go the full speed.
-        if (val < 100)
-        {
-            val = 100- powf((100-val),0.914); //This drives the throttled speed exponentially toward 30Hz.
-        }
-        m_updateViewTimer.start(val);
+        val = 100- powf((100-val),0.914); //This drives the throttled speed exponentially toward 30Hz.
     }
+    m_updateViewTimer.start(val);
 }
 
 
 /**
- * @brief UAVOBrowserTreeView::onTimeout_updateView On timeout, emits dataChanged() SIGNAL for
- * all data tree indices that have changed since last timeout.
+ * @brief UAVOBrowserTreeView::onTimeout_updateView On timeout, refreshes the fields
+ * that changed since last timeout, for the objects in view.
  */
 void UAVOBrowserTreeView::onTimeout_updateView()
 {
-    if (m_updateTreeViewFlag == true) {
-        QModelIndex topLeftData = m_model->getIndex(0, 0, m_model->getNonSettingsTree());
-        QModelIndex bottomRightData = m_model->getIndex(1, 1, m_model->getNonSettingsTree());
-
-        QTreeView::dataChanged(topLeftData, bottomRightData);
-    }
-
-    m_updateTreeViewFlag = false;
-}
-
-/**
- * @brief UAVOBrowserTreeView::updateView Determines if a view updates lies outside the
- * range of updates queued for update
- * @param topLeft Top left index from data model update
- * @param bottomRight Bottom right index from data model update
- */
-void UAVOBrowserTreeView::updateView(QModelIndex topLeft, QModelIndex bottomRight)
-{
-    Q_UNUSED(bottomRight);
-
-    // First static_cast from *void to a tree item pointer. This is safe because we know all the indices are tree items
-    TreeItem *treeItemPtr = static_cast<TreeItem*>(topLeft.internalPointer());
-
-    // Second, do a dynamic_cast in order to detect if this tree item is a data object
-    DataObjectTreeItem *dataObjectTreeItemPtr = dynamic_cast<DataObjectTreeItem*>(treeItemPtr);
-
-    if (dataObjectTreeItemPtr == NULL) {
-        // Do nothing. These QModelIndices are generated by the highlight manager for individual
-        // UAVO fields, which are both updated when updating that UAVO's branch of the settings or
-        // dynamic data tree.
-        return;
-    }
-
-    m_updateTreeViewFlag = true;
-}
-
-void UAVOBrowserTreeView::dataChanged(const QModelIndex & topLeft, const QModelIndex & bottomRight,
-                                      const QVector<int> & roles)
-{
-    Q_UNUSED(roles);
-
-    // If the timer is active, then throttle updates...
-    if (m_updateViewTimer.isActive()) {
-        updateView(topLeft, bottomRight);
-    }
-    else { // ... otherwise pass them directly on to the treeview.
-       QTreeView::dataChanged(topLeft, bottomRight);
-    }
+    if (m_model)
+        m_model->refreshDirtyItems(this);
 }
@@ -40,23 +40,18 @@ class ObjectTreeItem;
 class Ui_UAVObjectBrowser;
 class Ui_viewoptions;
 
+/**
+ * @brief The UAVOBrowserTreeView class Tree view that sets the pace of the
+ * model updates. On every tick of its timer the model refreshes the fields
+ * that changed since the previous tick, for the objects the view shows.
+ */
 class UAVOBrowserTreeView : public QTreeView
 {
     Q_OBJECT
 public:
     UAVOBrowserTreeView(UAVObjectTreeModel *m_model, unsigned int updateTimerPeriod);
-    void updateView(QModelIndex topLeft, QModelIndex bottomRight);
     void updateTimerPeriod(unsigned int val);
 
-    /**
-     * @brief dataChanged Reimplements QTreeView::dataChanged signal
-     * @param topLeft
-     * @param bottomRight
-     * @param updateFlag If true, send dataChanged signal. If false, do nothing.
-     */
-    virtual void dataChanged(const QModelIndex & topLeft, const QModelIndex & bottomRight,
-                             const QVector<int> & roles = QVector<int> ());
-
     void setModel(QAbstractItemModel *model) {m_model = dynamic_cast<UAVObjectTreeModel*>(model); QTreeView::setModel(model);}
 
 private slots:
@@ -65,8 +60,6 @@ private slots:
 private:
     UAVObjectTreeModel *m_model;
 
-    bool m_updateTreeViewFlag;
-
     QTimer m_updateViewTimer;
 
 };
@@ -38,6 +38,7 @@
 #include <QtCore/QTimer>
 #include <QtCore/QSignalMapper>
 #include <QtCore/QDebug>
+#include <QTreeView>
 #include <math.h>
 
 #include <QApplication>
@@ -55,11 +56,16 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotati
     m_hideNotPresent(false),
     m_categorize(true),
     m_highlightManager(NULL),
+    m_flushScheduled(false),
     isInitialized(false)
 {
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     objManager = pm->getObject<UAVObjectManager>();
 
+    // Updates are only recorded as they arrive, the view refreshes the items
+    // it shows at its own pace (see refreshDirtyItems())
+    objManager->subscribeBatched(this, SLOT(objectsUpdated(UAVObjectManager::ObjectSnapshots)));
+
     m_currentTime = QTime::currentTime();
     // Create timer that sets the rhythm for all highlight events.
     connect(&m_currentTimeTimer, SIGNAL(timeout()), this, SLOT(updateCurrentTime()));
@@ -70,6 +76,7 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotati
 
 UAVObjectTreeModel::~UAVObjectTreeModel()
 {
+    objManager->unsubscribeBatched(this);
     delete m_highlightManager;
     delete m_rootItem;
 }
@@ -92,6 +99,9 @@ void UAVObjectTreeModel::setupModelData(UAVObjectManager *objManager, bool categ
         disconnect(objManager, SIGNAL(newInstance(UAVObject*)), this, SLOT(newObject(UAVObject*)));
         disconnect(objManager, SIGNAL(instanceRemoved(UAVObject*)), this, SLOT(instanceRemove(UAVObject*)));
         delete m_highlightManager;
+        m_objectItems.clear();
+        m_dirtyItems.clear();
+        m_changedItems.clear();
         int count = m_rootItem->childCount();
         beginRemoveRows(index(m_rootItem), 0, count);
         delete m_rootItem;
@@ -153,6 +163,10 @@ void UAVObjectTreeModel::instanceRemove(UAVObject *obj)
             InstanceTreeItem *inst = dynamic_cast<InstanceTreeItem*>(item);
             if(inst && inst->object() == obj)
             {
+                // Signal the pending changes while the rows are still there
+                flushChanges();
+                m_objectItems.remove(obj);
+                m_dirtyItems.remove(inst);
                 inst->parent()->removeChild(inst);
                 inst->deleteLater();
             }
@@ -210,29 +224,29 @@ TreeItem* UAVObjectTreeModel::createCategoryItems(QStringList categoryPath, Tree
 
 MetaObjectTreeItem* UAVObjectTreeModel::addMetaObject(UAVMetaObject *obj, TreeItem *parent)
 {
-    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(highlightUpdatedObject(UAVObject*)));
     MetaObjectTreeItem *meta = new MetaObjectTreeItem(obj, tr("Meta Data"));
 
     meta->setHighlightManager(m_highlightManager);
     connect(meta, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
     foreach (UAVObjectField *field, obj->getFields()) {
         if (field->getNumElements() > 1) {
-            addArrayField(field, meta);
+            meta->addFieldItem(addArrayField(field, meta));
         } else {
-            addSingleField(0, field, meta);
+            meta->addFieldItem(addSingleField(0, field, meta));
         }
     }
+    meta->resetDirtyFields();
+    m_objectItems.insert(obj, meta);
     parent->appendChild(meta);
     return meta;
 }
 
 void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
 {
-    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(highlightUpdatedObject(UAVObject*)));
-    TreeItem *item;
+    ObjectTreeItem *item;
     DataObjectTreeItem *p = static_cast<DataObjectTreeItem*>(parent);
     if (obj->isSingleInstance()) {
-        item = parent;
+        item = p;
         p->setObject(obj);
     } else {
         p->setObject(NULL);
@@ -252,11 +266,13 @@ void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
     }
     foreach (UAVObjectField *field, obj->getFields()) {
         if (field->getNumElements() > 1) {
-            addArrayField(field, item);
+            item->addFieldItem(addArrayField(field, item));
         } else {
-            addSingleField(0, field, item);
+            item->addFieldItem(addSingleField(0, field, item));
         }
     }
+    item->resetDirtyFields();
+    m_objectItems.insert(obj, item);
     UAVDataObject * dobj = dynamic_cast<UAVDataObject *>(obj);
     if(dobj)
     {
@@ -264,7 +280,7 @@ void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
     }
 }
 
-void UAVObjectTreeModel::addArrayField(UAVObjectField *field, TreeItem *parent)
+TreeItem *UAVObjectTreeModel::addArrayField(UAVObjectField *field, TreeItem *parent)
 {
     TreeItem *item = new ArrayFieldTreeItem(field->getName());
     item->setHighlightManager(m_highlightManager);
@@ -273,9 +289,10 @@ void UAVObjectTreeModel::addArrayField(UAVObjectField *field, TreeItem *parent)
         addSingleField(i, field, item);
     }
     parent->appendChild(item);
+    return item;
 }
 
-void UAVObjectTreeModel::addSingleField(int index, UAVObjectField *field, TreeItem *parent)
+TreeItem *UAVObjectTreeModel::addSingleField(int index, UAVObjectField *field, TreeItem *parent)
 {
     QList<QVariant> data;
     if (field->getNumElements() == 1)
@@ -316,6 +333,7 @@ void UAVObjectTreeModel::addSingleField(int index, UAVObjectField *field, TreeIt
     item->setHighlightManager(m_highlightManager);
     connect(item, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
     parent->appendChild(item);
+    return item;
 }
 
 QModelIndex UAVObjectTreeModel::index(int row, int column, const QModelIndex &parent)
@@ -343,16 +361,9 @@ QModelIndex UAVObjectTreeModel::index(TreeItem *item)
     if (item->parent() == 0)
         return QModelIndex();
 
-    QModelIndex root = index(item->parent());
-
-    for (int i = 0; i < rowCount(root); ++i) {
-        QModelIndex childIndex = index(i, 0, root);
-        TreeItem *child = static_cast<TreeItem*>(childIndex.internalPointer());
-        if (child == item)
-            return childIndex;
-    }
-    Q_ASSERT(false);
-    return QModelIndex();
+    int row = item->row();
+    Q_ASSERT(row >= 0);
+    return createIndex(row, 0, item);
 }
 
 QModelIndex UAVObjectTreeModel::parent(const QModelIndex &index) const
@@ -512,20 +523,94 @@ QVariant UAVObjectTreeModel::headerData(int section, Qt::Orientation orientation
     return QVariant();
 }
 
-void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
+/**
+ * @brief UAVObjectTreeModel::objectsUpdated Records the updated objects and
+ * their dirty fields. Nothing is redrawn until the next refreshDirtyItems().
+ * @param snapshots Objects updated since the previous batch
+ */
+void UAVObjectTreeModel::objectsUpdated(const UAVObjectManager::ObjectSnapshots &snapshots)
+{
+    foreach (const UAVObjectManager::ObjectSnapshot &snapshot, snapshots) {
+        ObjectTreeItem *item = m_objectItems.value(snapshot.object);
+        if (!item)
+            continue;
+        item->markUpdated(snapshot.data);
+        m_dirtyItems.insert(item);
+    }
+}
+
+/**
+ * @brief UAVObjectTreeModel::refreshDirtyItems Refreshes the dirty fields of
+ * the updated objects the view shows. Objects below a collapsed item or out
+ * of the viewport keep their dirty fields until they come into view, of
+ * collapsed objects only the row is highlighted.
+ * @param view View showing the model, NULL to refresh all objects
+ */
+void UAVObjectTreeModel::refreshDirtyItems(const QTreeView *view)
+{
+    QMutableSetIterator<ObjectTreeItem*> iter(m_dirtyItems);
+    while (iter.hasNext()) {
+        ObjectTreeItem *item = iter.next();
+        switch (visibility(item, view)) {
+        case HIDDEN:
+            item->takeUpdate(m_onlyHighlightChangedValues);
+            if (!item->hasDirtyFields())
+                iter.remove();
+            break;
+        case ROW_VISIBLE:
+            if (item->takeUpdate(m_onlyHighlightChangedValues))
+                item->setHighlight(true);
+            if (!item->hasDirtyFields())
+                iter.remove();
+            break;
+        case VISIBLE:
+            foreach (TreeItem *field, item->takeDirtyFields()) {
+                field->update();
+                queueChanged(field);
+                foreach (TreeItem *element, field->treeChildren())
+                    queueChanged(element);
+            }
+            if (item->takeUpdate(m_onlyHighlightChangedValues))
+                item->setHighlight(true);
+            iter.remove();
+            break;
+        }
+    }
+    flushChanges();
+}
+
+/**
+ * @brief UAVObjectTreeModel::visibility Finds how much of an object the view shows
+ */
+UAVObjectTreeModel::Visibility UAVObjectTreeModel::visibility(TreeItem *item, const QTreeView *view)
 {
-    Q_ASSERT(obj);
-    ObjectTreeItem *item = findObjectTreeItem(obj);
-    Q_ASSERT(item);
-    if(!m_onlyHighlightChangedValues){
-        item->setHighlight(true);
+    if (!view)
+        return VISIBLE;
+
+    QModelIndex itemIndex = index(item);
+    for (QModelIndex i = itemIndex; i.isValid(); i = i.parent()) {
+        if (view->isRowHidden(i.row(), i.parent()))
+            return HIDDEN;
+        if (i != itemIndex && !view->isExpanded(i))
+            return HIDDEN;
     }
-    item->update();
-    if(!m_onlyHighlightChangedValues){
-        QModelIndex itemIndex = index(item);
-        Q_ASSERT(itemIndex != QModelIndex());
-        emit dataChanged(itemIndex, itemIndex);
+
+    QRect viewport = view->viewport()->rect();
+    QRect top = view->visualRect(itemIndex);
+    if (!view->isExpanded(itemIndex)) {
+        if (top.bottom() < viewport.top() || top.top() > viewport.bottom())
+            return HIDDEN;
+        return ROW_VISIBLE;
     }
+
+    // The rows of an expanded object end with its last expanded descendant
+    QModelIndex last = itemIndex;
+    while (view->isExpanded(last) && rowCount(last) > 0)
+        last = index(rowCount(last) - 1, 0, last);
+    QRect bottom = view->visualRect(last);
+    if (bottom.bottom() < viewport.top() || top.top() > viewport.bottom())
+        return HIDDEN;
+    return VISIBLE;
 }
 
 ObjectTreeItem* UAVObjectTreeModel::findObjectTreeItem(UAVObject *object)
@@ -560,9 +645,53 @@ MetaObjectTreeItem* UAVObjectTreeModel::findMetaObjectTreeItem(UAVMetaObject *ob
 
 void UAVObjectTreeModel::updateHighlight(TreeItem *item)
 {
-    QModelIndex itemIndex = index(item);
-    Q_ASSERT(itemIndex != QModelIndex());
-    emit dataChanged(itemIndex, itemIndex.sibling(itemIndex.row(), TreeItem::dataColumn));
+    queueChanged(item);
+}
+
+/**
+ * @brief UAVObjectTreeModel::queueChanged Queues an item for the next dataChanged() signals
+ */
+void UAVObjectTreeModel::queueChanged(TreeItem *item)
+{
+    m_changedItems.insert(item);
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        QTimer::singleShot(0, this, SLOT(flushChanges()));
+    }
+}
+
+/**
+ * @brief UAVObjectTreeModel::flushChanges Emits the queued changes as one
+ * dataChanged() per run of consecutive rows with the same parent.
+ */
+void UAVObjectTreeModel::flushChanges()
+{
+    m_flushScheduled = false;
+    if (m_changedItems.isEmpty())
+        return;
+
+    QHash<TreeItem*, QList<int> > rowsPerParent;
+    foreach (TreeItem *item, m_changedItems) {
+        if (item->parent())
+            rowsPerParent[item->parent()].append(item->row());
+    }
+    m_changedItems.clear();
+
+    QHashIterator<TreeItem*, QList<int> > iter(rowsPerParent);
+    while (iter.hasNext()) {
+        iter.next();
+        QModelIndex parentIndex = index(iter.key());
+        QList<int> rows = iter.value();
+        qSort(rows);
+        int first = rows.first();
+        for (int i = 1; i <= rows.size(); ++i) {
+            if (i < rows.size() && rows.at(i) == rows.at(i - 1) + 1)
+                continue;
+            emit dataChanged(index(first, 0, parentIndex), index(rows.at(i - 1), TreeItem::dataColumn, parentIndex));
+            if (i < rows.size())
+                first = rows.at(i);
+        }
+    }
 }
 
 
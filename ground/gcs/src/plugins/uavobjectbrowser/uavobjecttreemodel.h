@@ -30,9 +30,12 @@
 #define UAVOBJECTTREEMODEL_H
 
 #include "treeitem.h"
+#include "uavobjectmanager.h"
 #include <QAbstractItemModel>
 #include <QtCore/QMap>
 #include <QtCore/QList>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
 #include <QColor>
 
 class TopTreeItem;
@@ -45,6 +48,7 @@ class UAVObjectField;
 class UAVObjectManager;
 class QSignalMapper;
 class QTimer;
+class QTreeView;
 
 class UAVObjectTreeModel : public QAbstractItemModel
 {
@@ -81,6 +85,8 @@ public:
 
     QModelIndex getIndex(int indexRow, int indexCol, TopTreeItem *topTreeItem){return createIndex(indexRow, indexCol, topTreeItem);}
 
+    void refreshDirtyItems(const QTreeView *view = 0);
+
 signals:
     void presentOnHardwareChanged();
 public slots:
@@ -88,19 +94,29 @@ public slots:
     void initializeModel(bool categorize = true, bool useScientificFloatNotation = true);
     void instanceRemove(UAVObject*);
 private slots:
-    void highlightUpdatedObject(UAVObject *obj);
+    void objectsUpdated(const UAVObjectManager::ObjectSnapshots &snapshots);
     void updateHighlight(TreeItem*);
+    void flushChanges();
     void updateCurrentTime();
     void presentOnHardwareChangedCB(UAVDataObject*);
 
 private:
+    // How much of an object a view shows
+    enum Visibility {
+        HIDDEN,         // Collapsed parent, hidden row or scrolled out of view
+        ROW_VISIBLE,    // Only the collapsed row of the object
+        VISIBLE         // The row and the fields of the object
+    };
+
     void setupModelData(UAVObjectManager *objManager, bool categorize = true, bool useScientificFloatNotation = true);
     QModelIndex index(TreeItem *item);
     void addDataObject(UAVDataObject *obj, bool categorize = true);
     MetaObjectTreeItem *addMetaObject(UAVMetaObject *obj, TreeItem *parent);
-    void addArrayField(UAVObjectField *field, TreeItem *parent);
-    void addSingleField(int index, UAVObjectField *field, TreeItem *parent);
+    TreeItem *addArrayField(UAVObjectField *field, TreeItem *parent);
+    TreeItem *addSingleField(int index, UAVObjectField *field, TreeItem *parent);
     void addInstance(UAVObject *obj, TreeItem *parent);
+    Visibility visibility(TreeItem *item, const QTreeView *view);
+    void queueChanged(TreeItem *item);
 
     TreeItem *createCategoryItems(QStringList categoryPath, TreeItem *root);
 
@@ -127,6 +143,12 @@ private:
     UAVObjectManager *objManager;
     // Highlight manager to handle highlighting of tree items.
     HighLightManager *m_highlightManager;
+    // Items of the objects, the objects updated since they were last
+    // refreshed and the items waiting for a dataChanged() signal
+    QHash<UAVObject*, ObjectTreeItem*> m_objectItems;
+    QSet<ObjectTreeItem*> m_dirtyItems;
+    QSet<TreeItem*> m_changedItems;
+    bool m_flushScheduled;
     QMutex mutex;
     bool isInitialized;
 };
@@ -0,0 +1,222 @@
+/**
+ ******************************************************************************
+ * @file       uavobjectmanagerbenchmark.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief Compares the cost of object lookups through the lock-free index of
+ * UAVObjectManager with the previous mutex protected map scan
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTextStream>
+#include <QTimer>
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+
+static const int ITERATIONS = 200;
+static const int TELEMETRY_OBJECTS = 20;
+static const int TELEMETRY_PERIOD_MS = 2;
+static const int TELEMETRY_DURATION_MS = 2000;
+
+/**
+ * Stands in for the telemetry link: unpacks a set of objects every period,
+ * as if each of them was received at 500 Hz.
+ */
+class TelemetrySource : public QObject
+{
+    Q_OBJECT
+public:
+    TelemetrySource(const QList<UAVObject*> &objects) : objects(objects), updates(0) {}
+    QList<UAVObject*> objects;
+    int updates;
+public slots:
+    void receive()
+    {
+        foreach (UAVObject *obj, objects) {
+            QByteArray data(obj->getNumBytes(), (char)updates);
+            obj->unpack((const quint8*)data.constData());
+            updates++;
+        }
+    }
+};
+
+/**
+ * Counts the notifications a display gadget would get
+ */
+class Listener : public QObject
+{
+    Q_OBJECT
+public:
+    Listener() : calls(0), snapshots(0) {}
+    int calls;
+    int snapshots;
+public slots:
+    void objectUpdated(UAVObject *) { calls++; }
+    void objectsUpdated(const UAVObjectManager::ObjectSnapshots &batch) { calls++; snapshots += batch.size(); }
+};
+
+/**
+ * The lookup as it was done before the index: a global mutex, a linear
+ * scan comparing names and a by-value copy of the instance map.
+ */
+class LegacyLookup
+{
+public:
+    LegacyLookup(UAVObjectManager *objMngr) :
+        objects(objMngr->getObjects()), mutex(QMutex::Recursive) {}
+
+    UAVObject *getObject(const QString &name, quint32 instId = 0)
+    {
+        QMutexLocker locker(&mutex);
+        foreach (UAVObjectManager::ObjectMap map, objects) {
+            if (map.first()->getName().compare(name) == 0)
+                return map.value(instId, NULL);
+        }
+        return NULL;
+    }
+
+    UAVObject *getObject(quint32 objId, quint32 instId = 0)
+    {
+        QMutexLocker locker(&mutex);
+        if (objects.contains(objId))
+            return objects.value(objId).value(instId);
+        return NULL;
+    }
+
+private:
+    QHash<quint32, UAVObjectManager::ObjectMap> objects;
+    QMutex mutex;
+};
+
+static void report(QTextStream &out, const char *name, qint64 nsecs, int lookups, int found)
+{
+    out << name << ": " << (double)nsecs / lookups << " ns/lookup (" << found << " found)\n";
+    out.flush();
+}
+
+/**
+ * Receive objects at 500 Hz for a while and count the notifications of a
+ * listener, either connected to each object or subscribed to batches
+ */
+static void notifications(QTextStream &out, UAVObjectManager *objMngr, bool batched)
+{
+    QList<UAVObject*> objects;
+    foreach (QVector<UAVDataObject*> instances, objMngr->getDataObjectsVector()) {
+        if (objects.size() < TELEMETRY_OBJECTS)
+            objects.append(instances.first());
+    }
+
+    TelemetrySource source(objects);
+    Listener listener;
+    if (batched) {
+        objMngr->subscribeBatched(&listener, SLOT(objectsUpdated(UAVObjectManager::ObjectSnapshots)));
+    } else {
+        foreach (UAVObject *obj, objects)
+            QObject::connect(obj, SIGNAL(objectUpdated(UAVObject*)), &listener, SLOT(objectUpdated(UAVObject*)), Qt::QueuedConnection);
+    }
+
+    QTimer telemetry;
+    QObject::connect(&telemetry, SIGNAL(timeout()), &source, SLOT(receive()));
+    telemetry.start(TELEMETRY_PERIOD_MS);
+
+    QEventLoop loop;
+    QTimer::singleShot(TELEMETRY_DURATION_MS, &loop, SLOT(quit()));
+    QElapsedTimer timer;
+    timer.start();
+    loop.exec();
+    telemetry.stop();
+    QCoreApplication::processEvents();
+    double seconds = timer.elapsed() / 1000.0;
+
+    if (batched) {
+        objMngr->unsubscribeBatched(&listener);
+        out << "batched: " << source.updates / seconds << " updates/s, " << listener.calls / seconds
+            << " calls/s carrying " << listener.snapshots / seconds << " snapshots/s\n";
+    } else {
+        out << "per sample: " << source.updates / seconds << " updates/s, " << listener.calls / seconds
+            << " calls/s\n";
+    }
+    out.flush();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    UAVObjectManager objMngr;
+    UAVObjectsInitialize(&objMngr);
+
+    QList<quint32> ids;
+    QStringList names;
+    foreach (QVector<UAVObject*> instances, objMngr.getObjectsVector()) {
+        ids.append(instances.first()->getObjID());
+        names.append(instances.first()->getName());
+    }
+    out << "Registered object types: " << ids.size() << "\n";
+
+    LegacyLookup legacy(&objMngr);
+    int lookups = ITERATIONS * ids.size();
+    QElapsedTimer timer;
+    int found;
+
+    found = 0;
+    timer.start();
+    for (int i = 0; i < ITERATIONS; ++i)
+        foreach (quint32 id, ids)
+            found += legacy.getObject(id) != NULL;
+    report(out, "by ID, mutex + map copy", timer.nsecsElapsed(), lookups, found);
+
+    found = 0;
+    timer.start();
+    for (int i = 0; i < ITERATIONS; ++i)
+        foreach (quint32 id, ids)
+            found += objMngr.getObject(id) != NULL;
+    report(out, "by ID, lock-free index", timer.nsecsElapsed(), lookups, found);
+
+    found = 0;
+    timer.start();
+    for (int i = 0; i < ITERATIONS; ++i)
+        foreach (const QString &name, names)
+            found += legacy.getObject(name) != NULL;
+    report(out, "by name, mutex + linear scan", timer.nsecsElapsed(), lookups, found);
+
+    found = 0;
+    timer.start();
+    for (int i = 0; i < ITERATIONS; ++i)
+        foreach (const QString &name, names)
+            found += objMngr.getObject(name) != NULL;
+    report(out, "by name, lock-free index", timer.nsecsElapsed(), lookups, found);
+
+    notifications(out, &objMngr, false);
+    notifications(out, &objMngr, true);
+
+    return 0;
+}
+
+#include "uavobjectmanagerbenchmark.moc"
+
+/**
+ * @}
+ * @}
+ */
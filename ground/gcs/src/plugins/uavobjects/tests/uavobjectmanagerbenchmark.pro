@@ -0,0 +1,12 @@
+# -------------------------------------------------
+# UAVObjectManager lookup and notification benchmark
+# -------------------------------------------------
+QT -= gui
+TARGET = uavobjectmanagerbenchmark
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+include(../../../../gcs.pri)
+include(../uavobjects.pri)
+LIBS += -L$$GCS_PLUGIN_PATH/TauLabs
+SOURCES += uavobjectmanagerbenchmark.cpp
@@ -273,6 +273,30 @@ UAVObjectField* UAVObject::getField(const QString& name)
 qint32 UAVObject::pack(quint8* dataOut)
 {
     QMutexLocker locker(mutex);
+    packData(dataOut);
+    return numBytes;
+}
+
+/**
+ * Unpack the object data from a byte array
+ * @returns The number of bytes copied
+ */
+qint32 UAVObject::unpack(const quint8* dataIn)
+{
+    QMutexLocker locker(mutex);
+    unpackData(dataIn);
+    emit objectUnpacked(this); // trigger object updated event
+    emit objectUpdated(this);
+
+    return numBytes;
+}
+
+/**
+ * Serialize the fields into a byte array, called with the mutex held.
+ * Generated objects override this with code specialized for their layout.
+ */
+void UAVObject::packData(quint8* dataOut)
+{
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
     {
@@ -280,16 +304,14 @@ qint32 UAVObject::pack(quint8* dataOut)
         field->pack(&dataOut[offset]);
         offset += field->getNumBytes();
     }
-    return numBytes;
 }
 
 /**
- * Unpack the object data from a byte array
- * @returns The number of bytes copied
+ * Deserialize the fields from a byte array, called with the mutex held.
+ * Generated objects override this with code specialized for their layout.
  */
-qint32 UAVObject::unpack(const quint8* dataIn)
+void UAVObject::unpackData(const quint8* dataIn)
 {
-    QMutexLocker locker(mutex);
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
     {
@@ -297,10 +319,6 @@ qint32 UAVObject::unpack(const quint8* dataIn)
         field->unpack(&dataIn[offset]);
         offset += field->getNumBytes();
     }
-    emit objectUnpacked(this); // trigger object updated event
-    emit objectUpdated(this);
-
-    return numBytes;
 }
 
 /**
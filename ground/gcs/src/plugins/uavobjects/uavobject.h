@@ -243,6 +243,8 @@ protected:
     void initializeFields(QList<UAVObjectField*>& fields, quint8* data, quint32 numBytes);
     void setDescription(const QString& description);
     void setCategory(const QString& category);
+    virtual void packData(quint8* dataOut);
+    virtual void unpackData(const quint8* dataIn);
 
 };
 
@@ -34,13 +34,51 @@
 UAVObjectManager::UAVObjectManager()
 {
     mutex = new QMutex(QMutex::Recursive);
+    index.store(new ObjectIndex(INITIAL_INDEX_SIZE));
+
+    qRegisterMetaType<UAVObjectManager::ObjectSnapshots>("UAVObjectManager::ObjectSnapshots");
+    batchTimer = new QTimer(this);
+    batchTimer->setInterval(DEFAULT_BATCH_INTERVAL);
+    connect(batchTimer, SIGNAL(timeout()), this, SLOT(emitBatch()));
 }
 
 UAVObjectManager::~UAVObjectManager()
 {
+    delete index.load();
+    qDeleteAll(retiredIndices);
+    qDeleteAll(retiredArrays);
+    foreach (TypeEntry *entry, entries)
+        delete entry->instances.load();
+    qDeleteAll(entries);
     delete mutex;
 }
 
+UAVObjectManager::InstanceArray::InstanceArray(quint32 capacity) :
+    capacity(capacity),
+    count(0),
+    instances(new QAtomicPointer<UAVObject>[capacity])
+{
+}
+
+UAVObjectManager::InstanceArray::~InstanceArray()
+{
+    delete[] instances;
+}
+
+UAVObjectManager::ObjectIndex::ObjectIndex(quint32 size) :
+    mask(size - 1),
+    numTypes(0),
+    byId(new QAtomicPointer<TypeEntry>[size]),
+    byName(new QAtomicPointer<TypeEntry>[size])
+{
+}
+
+UAVObjectManager::ObjectIndex::~ObjectIndex()
+{
+    delete[] byId;
+    delete[] byName;
+}
+
 /**
  * Register an object with the manager. This function must be called for all newly created instances.
  * A new instance can be created directly by instantiating a new object or by calling clone() of
@@ -72,21 +110,23 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
             {
                 UAVDataObject* cobj = obj->clone(instidx);
                 cobj->initialize(instidx,mobj);
-                QMap<quint32,UAVObject*> ppp;
-                ppp.insert(instidx,cobj);
                 objects[objID].insert(instidx,cobj);
+                publishInstances(objID);
+                trackObject(cobj, !batchSubscribers.isEmpty());
                 getObject(cobj->getObjID())->emitNewInstance(cobj);//TODO??
                 emit newInstance(cobj);
             }
         }
         else if (obj->getInstID() == 0)
-            obj->initialize(objects.value(objID).last()->getObjID() + 1, mobj);
+            obj->initialize(objects.value(objID).last()->getInstID() + 1, mobj);
         else
         {
             return false;
         }
         // Add the actual object instance in the list
         objects[objID].insert(obj->getInstID(),obj);
+        publishInstances(objID);
+        trackObject(obj, !batchSubscribers.isEmpty());
         getObject(objID)->emitNewInstance(obj);
         emit newInstance(obj);
         return true;
@@ -127,6 +167,7 @@ bool UAVObjectManager::unRegisterObject(UAVDataObject* obj)
         emit instanceRemoved(objects.value(objID).value(x));
         objects[objID].remove(x);
     }
+    publishInstances(objID);
     return true;
 }
 
@@ -136,9 +177,245 @@ void UAVObjectManager::addObject(UAVObject* obj)
     QMap<quint32,UAVObject*> list;
     list.insert(obj->getInstID(),obj);
     objects.insert(obj->getObjID(),list);
+    addEntry(obj);
+    trackObject(obj, !batchSubscribers.isEmpty());
     emit newObject(obj);
 }
 
+/**
+ * Subscribe to batched change notifications. The member is a slot taking
+ * const UAVObjectManager::ObjectSnapshots&, called once per batch interval
+ * when objects were updated. The snapshots are in the order in which the
+ * objects were first updated, each holding the latest data of its object.
+ * Objects are only tracked while there are subscribers.
+ */
+void UAVObjectManager::subscribeBatched(QObject* receiver, const char* member)
+{
+    QMutexLocker locker(mutex);
+    if (batchSubscribers.contains(receiver))
+        return;
+
+    connect(this, SIGNAL(objectsUpdated(UAVObjectManager::ObjectSnapshots)), receiver, member);
+    connect(receiver, SIGNAL(destroyed(QObject*)), this, SLOT(batchSubscriberDestroyed(QObject*)));
+    batchSubscribers.insert(receiver);
+
+    if (batchSubscribers.size() == 1)
+    {
+        trackAllObjects(true);
+        // The timer runs in the thread of the manager, whichever thread subscribes
+        QMetaObject::invokeMethod(batchTimer, "start");
+    }
+}
+
+/**
+ * Stop the batched change notifications of a receiver
+ */
+void UAVObjectManager::unsubscribeBatched(QObject* receiver)
+{
+    QMutexLocker locker(mutex);
+    if (!batchSubscribers.remove(receiver))
+        return;
+
+    disconnect(this, SIGNAL(objectsUpdated(UAVObjectManager::ObjectSnapshots)), receiver, 0);
+    disconnect(receiver, SIGNAL(destroyed(QObject*)), this, SLOT(batchSubscriberDestroyed(QObject*)));
+
+    if (batchSubscribers.isEmpty())
+    {
+        QMetaObject::invokeMethod(batchTimer, "stop");
+        trackAllObjects(false);
+
+        QMutexLocker batchLocker(&batchMutex);
+        pendingObjects.clear();
+        pendingUpdates.clear();
+    }
+}
+
+void UAVObjectManager::batchSubscriberDestroyed(QObject* receiver)
+{
+    unsubscribeBatched(receiver);
+}
+
+/**
+ * Set the time between two batches of change notifications
+ */
+void UAVObjectManager::setBatchInterval(int ms)
+{
+    batchTimer->setInterval(ms);
+}
+
+int UAVObjectManager::getBatchInterval()
+{
+    return batchTimer->interval();
+}
+
+/**
+ * Start or stop recording the updates of an object. Must be called with the mutex held.
+ */
+void UAVObjectManager::trackObject(UAVObject* obj, bool track)
+{
+    if (track)
+        connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(trackUpdate(UAVObject*)),
+                (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
+    else
+        disconnect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(trackUpdate(UAVObject*)));
+}
+
+void UAVObjectManager::trackAllObjects(bool track)
+{
+    foreach (const ObjectMap& map, objects)
+        foreach (UAVObject* obj, map)
+            trackObject(obj, track);
+}
+
+/**
+ * Record an update of an object for the next batch. Called directly in the
+ * thread which updated the object.
+ */
+void UAVObjectManager::trackUpdate(UAVObject* obj)
+{
+    QMutexLocker locker(&batchMutex);
+    quint32& updates = pendingUpdates[obj];
+    if (updates++ == 0)
+        pendingObjects.append(obj);
+}
+
+/**
+ * Send the objects updated since the previous batch to the subscribers
+ */
+void UAVObjectManager::emitBatch()
+{
+    QList<UAVObject*> changed;
+    QHash<UAVObject*, quint32> updates;
+    {
+        QMutexLocker locker(&batchMutex);
+        changed.swap(pendingObjects);
+        updates.swap(pendingUpdates);
+    }
+    if (changed.isEmpty())
+        return;
+
+    ObjectSnapshots snapshots;
+    snapshots.reserve(changed.size());
+    foreach (UAVObject* obj, changed)
+    {
+        ObjectSnapshot snapshot;
+        snapshot.object = obj;
+        snapshot.updates = updates.value(obj);
+        snapshot.data.resize(obj->getNumBytes());
+        obj->pack((quint8*)snapshot.data.data());
+        snapshots.append(snapshot);
+    }
+
+    emit objectsUpdated(snapshots);
+}
+
+/**
+ * Find an object type in the lookup index by object ID. Does not lock.
+ * @returns The type entry or NULL if the object is not registered
+ */
+UAVObjectManager::TypeEntry* UAVObjectManager::findEntry(quint32 objId) const
+{
+    ObjectIndex* idx = index.loadAcquire();
+    for (quint32 n = objId & idx->mask; ; n = (n + 1) & idx->mask)
+    {
+        TypeEntry* entry = idx->byId[n].loadAcquire();
+        if (entry == NULL || entry->objId == objId)
+            return entry;
+    }
+}
+
+/**
+ * Find an object type in the lookup index by name. Does not lock.
+ * @returns The type entry or NULL if the object is not registered
+ */
+UAVObjectManager::TypeEntry* UAVObjectManager::findEntry(const QString& name) const
+{
+    ObjectIndex* idx = index.loadAcquire();
+    uint hash = qHash(name);
+    for (quint32 n = hash & idx->mask; ; n = (n + 1) & idx->mask)
+    {
+        TypeEntry* entry = idx->byName[n].loadAcquire();
+        if (entry == NULL || (entry->nameHash == hash && entry->name == name))
+            return entry;
+    }
+}
+
+/**
+ * Add a new object type to the lookup index, growing the tables when they
+ * become half full. The instances of the type must already be in the object
+ * map, they are published before the entry so that readers which find it
+ * always see an instance array. Must be called with the mutex held.
+ */
+UAVObjectManager::TypeEntry* UAVObjectManager::addEntry(UAVObject* obj)
+{
+    ObjectIndex* idx = index.load();
+    if ((idx->numTypes + 1) * 2 > idx->mask + 1)
+    {
+        ObjectIndex* grown = new ObjectIndex((idx->mask + 1) * 2);
+        foreach (TypeEntry* entry, entries)
+            insertEntry(grown, entry);
+        index.storeRelease(grown);
+        retiredIndices.append(idx);
+        idx = grown;
+    }
+
+    TypeEntry* entry = new TypeEntry;
+    entry->objId = obj->getObjID();
+    entry->name = obj->getName();
+    entry->nameHash = qHash(entry->name);
+    publishInstances(entry);
+    entries.append(entry);
+    insertEntry(idx, entry);
+    return entry;
+}
+
+void UAVObjectManager::insertEntry(ObjectIndex* idx, TypeEntry* entry)
+{
+    quint32 n = entry->objId & idx->mask;
+    while (idx->byId[n].load() != NULL)
+        n = (n + 1) & idx->mask;
+    idx->byId[n].storeRelease(entry);
+
+    n = entry->nameHash & idx->mask;
+    while (idx->byName[n].load() != NULL)
+        n = (n + 1) & idx->mask;
+    idx->byName[n].storeRelease(entry);
+
+    idx->numTypes++;
+}
+
+/**
+ * Make the instances of an object type visible to lock-free readers after
+ * they changed in the object map. Must be called with the mutex held.
+ */
+void UAVObjectManager::publishInstances(quint32 objId)
+{
+    publishInstances(findEntry(objId));
+}
+
+void UAVObjectManager::publishInstances(TypeEntry* entry)
+{
+    const ObjectMap& map = objects[entry->objId];
+    quint32 count = map.isEmpty() ? 0 : map.lastKey() + 1;
+
+    InstanceArray* array = entry->instances.load();
+    InstanceArray* target = array;
+    if (array == NULL || count > array->capacity)
+        target = new InstanceArray(qMax(count, array ? array->capacity * 2 : 1));
+
+    for (quint32 n = 0; n < count; ++n)
+        target->instances[n].storeRelease(map.value(n, NULL));
+    target->count.storeRelease(count);
+    entry->numInstances.storeRelease(map.count());
+
+    if (target != array)
+    {
+        entry->instances.storeRelease(target);
+        if (array != NULL)
+            retiredArrays.append(array);
+    }
+}
+
 /**
  * Get all objects. A two dimentional QVector is returned. Objects are grouped by
  * instances of the same object type.
@@ -157,6 +434,7 @@ QVector< QVector<UAVObject*> > UAVObjectManager::getObjectsVector()
 
 QHash<quint32, QMap<quint32, UAVObject *> > UAVObjectManager::getObjects()
 {
+    QMutexLocker locker(mutex);
     return objects;
 }
 
@@ -229,22 +507,18 @@ UAVObject* UAVObjectManager::getObject(quint32 objId, quint32 instId)
 }
 
 /**
- * Helper function for the public getObject() functions.
+ * Helper function for the public getObject() functions. Reads the lookup
+ * index only, so it never blocks on concurrent registrations.
  */
 UAVObject* UAVObjectManager::getObject(const QString* name, quint32 objId, quint32 instId)
 {
-    QMutexLocker locker(mutex);
-    if(name != NULL)
-    {
-        foreach(ObjectMap map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.value(instId,NULL);
-        }
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).value(instId);
-    return NULL;
+    TypeEntry* entry = (name != NULL) ? findEntry(*name) : findEntry(objId);
+    if (entry == NULL)
+        return NULL;
+    InstanceArray* array = entry->instances.loadAcquire();
+    if (instId >= (quint32)array->count.loadAcquire())
+        return NULL;
+    return array->instances[instId].loadAcquire();
 }
 
 /**
@@ -268,18 +542,20 @@ QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(quint32 objId)
  */
 QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(const QString* name, quint32 objId)
 {
-    QMutexLocker locker(mutex);
-    if(name != NULL)
+    QVector<UAVObject*> vector;
+    TypeEntry* entry = (name != NULL) ? findEntry(*name) : findEntry(objId);
+    if (entry == NULL)
+        return vector;
+    InstanceArray* array = entry->instances.loadAcquire();
+    quint32 count = array->count.loadAcquire();
+    vector.reserve(count);
+    for (quint32 n = 0; n < count; ++n)
     {
-        foreach(ObjectMap map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.values().toVector();
-        }
+        UAVObject* obj = array->instances[n].loadAcquire();
+        if (obj != NULL)
+            vector.append(obj);
     }
-    else if(objects.contains(objId))
-        return objects.value(objId).values().toVector();
-    return  QVector<UAVObject*>();
+    return vector;
 }
 
 /**
@@ -303,16 +579,8 @@ qint32 UAVObjectManager::getNumInstances(quint32 objId)
  */
 qint32 UAVObjectManager::getNumInstances(const QString* name, quint32 objId)
 {
-    QMutexLocker locker(mutex);
-    if(name != NULL)
-    {
-        foreach(ObjectMap map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.count();
-        }
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).count();
-    return -1;
+    TypeEntry* entry = (name != NULL) ? findEntry(*name) : findEntry(objId);
+    if (entry == NULL)
+        return -1;
+    return entry->numInstances.loadAcquire();
 }
@@ -37,6 +37,11 @@
 #include <QMutexLocker>
 #include <QVector>
 #include <QHash>
+#include <QByteArray>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QSet>
+#include <QTimer>
 
 class UAVOBJECTS_EXPORT UAVObjectManager: public QObject
 {
@@ -46,6 +51,15 @@ public:
     UAVObjectManager();
     ~UAVObjectManager();
     typedef QMap<quint32,UAVObject*> ObjectMap;
+
+    //! State of an object that changed since the previous batch
+    struct ObjectSnapshot {
+        UAVObject* object;
+        quint32 updates;    //!< Number of updates coalesced into this snapshot
+        QByteArray data;    //!< Packed object data at the time of the batch
+    };
+    typedef QList<ObjectSnapshot> ObjectSnapshots;
+
     bool registerObject(UAVDataObject* obj);
     QVector< QVector<UAVObject*> > getObjectsVector();
     QHash<quint32, QMap<quint32,UAVObject*> > getObjects();
@@ -58,20 +72,92 @@ public:
     qint32 getNumInstances(const QString& name);
     qint32 getNumInstances(quint32 objId);    
     bool unRegisterObject(UAVDataObject *obj);
+
+    // Batched change notification. Subscribers get objectsUpdated() once per
+    // batch interval with the objects updated since the previous one, instead
+    // of one objectUpdated() per update of every object. Consumers that need
+    // every sample keep connecting to the signals of the objects.
+    void subscribeBatched(QObject* receiver, const char* member);
+    void unsubscribeBatched(QObject* receiver);
+    void setBatchInterval(int ms);
+    int getBatchInterval();
 signals:
     void newObject(UAVObject* obj);
     void newInstance(UAVObject* obj);
     void instanceRemoved(UAVObject* obj);
+    void objectsUpdated(const UAVObjectManager::ObjectSnapshots& snapshots);
+private slots:
+    void trackUpdate(UAVObject* obj);
+    void emitBatch();
+    void batchSubscriberDestroyed(QObject* receiver);
 private:
     static const quint32 MAX_INSTANCES = 1000;
+    static const quint32 INITIAL_INDEX_SIZE = 1024;
+    static const int DEFAULT_BATCH_INTERVAL = 16; // About one batch per 60Hz display frame
+
+    //! Instances of one object type indexed by instance ID. Slots below
+    //! capacity are filled in place, a larger array replaces it on growth.
+    struct InstanceArray {
+        InstanceArray(quint32 capacity);
+        ~InstanceArray();
+        quint32 capacity;
+        QAtomicInt count;
+        QAtomicPointer<UAVObject> *instances;
+    };
+
+    //! One object type in the lookup index, never freed before the manager
+    struct TypeEntry {
+        quint32 objId;
+        QString name;
+        uint nameHash;
+        QAtomicInt numInstances;
+        QAtomicPointer<InstanceArray> instances;
+    };
+
+    //! Open addressing tables mapping object IDs and names to types
+    struct ObjectIndex {
+        ObjectIndex(quint32 size);
+        ~ObjectIndex();
+        quint32 mask;
+        quint32 numTypes;
+        QAtomicPointer<TypeEntry> *byId;
+        QAtomicPointer<TypeEntry> *byName;
+    };
+
     QHash<quint32, QMap<quint32,UAVObject*> > objects;
     QMutex* mutex;
 
+    // Lookup index read without locking. Writers hold the mutex and replace
+    // grown tables instead of modifying them, so superseded tables are kept
+    // until destruction for readers which may still hold them.
+    QAtomicPointer<ObjectIndex> index;
+    QList<TypeEntry*> entries;
+    QList<InstanceArray*> retiredArrays;
+    QList<ObjectIndex*> retiredIndices;
+
+    // Batched notification state. The subscribers and the tracked objects are
+    // guarded by the mutex, the pending updates by batchMutex as they are
+    // recorded in the thread that updates the object.
+    QSet<QObject*> batchSubscribers;
+    QTimer* batchTimer;
+    QMutex batchMutex;
+    QList<UAVObject*> pendingObjects;
+    QHash<UAVObject*, quint32> pendingUpdates;
+
     void addObject(UAVObject* obj);
+    void trackObject(UAVObject* obj, bool track);
+    void trackAllObjects(bool track);
+    TypeEntry* findEntry(quint32 objId) const;
+    TypeEntry* findEntry(const QString& name) const;
+    TypeEntry* addEntry(UAVObject* obj);
+    void insertEntry(ObjectIndex* idx, TypeEntry* entry);
+    void publishInstances(quint32 objId);
+    void publishInstances(TypeEntry* entry);
     UAVObject* getObject(const QString* name, quint32 objId, quint32 instId);
     QVector<UAVObject*> getObjectInstancesVector(const QString* name, quint32 objId);
     qint32 getNumInstances(const QString* name, quint32 objId);
 };
 
+Q_DECLARE_METATYPE(UAVObjectManager::ObjectSnapshots)
 
 #endif // UAVOBJECTMANAGER_H
@@ -32,6 +32,7 @@
  */
 #include "$(NAMELC).h"
 #include "uavobjectfield.h"
+#include <QtEndian>
 
 const QString $(NAME)::NAME = QString("$(NAME)");
 const QString $(NAME)::DESCRIPTION = QString("$(DESCRIPTION)");
@@ -140,6 +141,47 @@ UAVDataObject* $(NAME)::dirtyClone()
     return obj;
 }
 
+/**
+ * Serialize data fields into the little endian telemetry format. The
+ * packed DataFields structure matches that format on little endian hosts.
+ */
+void $(NAME)::packDataFields(const DataFields& dataIn, quint8* dataOut)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    memcpy(dataOut, &dataIn, NUMBYTES);
+#else
+$(PACKFIELDS)
+#endif
+}
+
+/**
+ * Deserialize data fields from the little endian telemetry format
+ */
+void $(NAME)::unpackDataFields(const quint8* dataIn, DataFields& dataOut)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    memcpy(&dataOut, dataIn, NUMBYTES);
+#else
+$(UNPACKFIELDS)
+#endif
+}
+
+/**
+ * Pack the object data, called by UAVObject::pack() with the mutex held
+ */
+void $(NAME)::packData(quint8* dataOut)
+{
+    packDataFields(data, dataOut);
+}
+
+/**
+ * Unpack the object data, called by UAVObject::unpack() with the mutex held
+ */
+void $(NAME)::unpackData(const quint8* dataIn)
+{
+    unpackDataFields(dataIn, data);
+}
+
 /**
  * Static function to retrieve an instance of the object.
  */
@@ -71,6 +71,8 @@ $(DATAFIELDINFO)
 	
     static $(NAME)* GetInstance(UAVObjectManager* objMngr, quint32 instID = 0);
     static qint32 getNumInstances(UAVObjectManager* objMngr) {return objMngr->getNumInstances(OBJID);}
+    static void packDataFields(const DataFields& dataIn, quint8* dataOut);
+    static void unpackDataFields(const quint8* dataIn, DataFields& dataOut);
 
 $(PROPERTY_GETTERS)
 
@@ -82,6 +84,10 @@ $(PROPERTY_NOTIFICATIONS)
 
 private slots:
     void emitNotifications();
+
+protected:
+    void packData(quint8* dataOut);
+    void unpackData(const quint8* dataIn);
 	
 private:
     DataFields data;
@@ -54,6 +54,8 @@ UAVObjectUtilManager::UAVObjectUtilManager()
 {
     mutex = new QMutex(QMutex::Recursive);
     saveState = IDLE;
+    savingCount = 0;
+    batchRefused = false;
     failureTimer.stop();
     failureTimer.setSingleShot(true);
     failureTimer.setInterval(1000);
@@ -117,6 +119,9 @@ UAVObjectManager* UAVObjectUtilManager::getObjectManager() {
  *  - Once the objectPersistence UAVO is updated, the board will in turn update it again,
  *    once the operation is completed. We need therefore to listen to updates on the objectPersistence
  *    object, and check the "Operation" field, which should be set to "completed", or "error".
+ *
+ * When the board has the objectPersistenceBatch UAVO, the objects waiting in the queue are sent
+ * up to 16 at a time instead and the board saves them in one go, see saveNextBatch().
  */
 void UAVObjectUtilManager::saveObjectToFlash(UAVObject *obj)
 {
@@ -126,8 +131,10 @@ void UAVObjectUtilManager::saveObjectToFlash(UAVObject *obj)
 
     // If queue length is one, then start sending (call sendNextObject)
     // Otherwise, do nothing, because we are already sending.
+    // Sending is left to the event loop so that the objects saved together
+    // by the caller end up in the same batch.
     if (queue.length()==1)
-        saveNextObject();
+        QTimer::singleShot(0, this, SLOT(saveNextObject()));
 }
 
 
@@ -139,10 +146,21 @@ void UAVObjectUtilManager::saveObjectToFlash(UAVObject *obj)
 void UAVObjectUtilManager::saveNextObject()
 {
     if ( queue.isEmpty() ) {
+        batchRefused = false;
         return;
     }
 
-    Q_ASSERT(saveState == IDLE);
+    // A saveCompleted handler may have queued an object and scheduled a call already
+    if (saveState != IDLE) {
+        return;
+    }
+
+    ObjectPersistenceBatch *objectPersistenceBatch = ObjectPersistenceBatch::GetInstance(getObjectManager());
+    Q_ASSERT(objectPersistenceBatch);
+    if (objectPersistenceBatch->getIsPresentOnHardware() && !batchRefused) {
+        saveNextBatch();
+        return;
+    }
 
     // Get next object from the queue (don't dequeue yet)
     UAVObject* obj = queue.head();
@@ -230,7 +248,10 @@ void UAVObjectUtilManager::objectPersistenceTransactionCompleted(UAVObject* obj,
   */
 void UAVObjectUtilManager::objectPersistenceOperationFailed()
 {
-    if (saveState == AWAITING_COMPLETED) {
+    if (saveState == AWAITING_COMPLETED && savingCount > 0) {
+        ObjectPersistenceBatch::GetInstance(getObjectManager())->disconnect(this);
+        finishBatch(NULL);
+    } else if (saveState == AWAITING_COMPLETED) {
 
         ObjectPersistence * objectPersistence = ObjectPersistence::GetInstance(getObjectManager());
         Q_ASSERT(objectPersistence);
@@ -288,6 +309,110 @@ void UAVObjectUtilManager::objectPersistenceUpdated(UAVObject * obj)
 }
 
 
+/**
+ * @brief UAVObjectUtilManager::saveNextBatch
+ *
+ * Asks the board to save the objects at the head of the queue in a single flash session.
+ * They stay in the queue until the board answered with the status of each of them.
+ */
+void UAVObjectUtilManager::saveNextBatch()
+{
+    ObjectPersistenceBatch *objectPersistenceBatch = ObjectPersistenceBatch::GetInstance(getObjectManager());
+    Q_ASSERT(objectPersistenceBatch);
+
+    // Same sequence as for a single object: ACK first, then an update with the results
+    connect(objectPersistenceBatch, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(objectPersistenceBatchTransactionCompleted(UAVObject*,bool)), Qt::UniqueConnection);
+    connect(objectPersistenceBatch, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectPersistenceBatchUpdated(UAVObject *)), Qt::UniqueConnection);
+
+    savingCount = qMin(queue.length(), (int)ObjectPersistenceBatch::OBJECTID_NUMELEM);
+    UAVOBJECTUTIL_QXTLOG_DEBUG(QString("Send batch save request for %0 objects").arg(savingCount));
+
+    ObjectPersistenceBatch::DataFields data;
+    data.Operation = ObjectPersistenceBatch::OPERATION_SAVE;
+    data.NumberOfObjects = savingCount;
+    for (int i = 0; i < (int)ObjectPersistenceBatch::OBJECTID_NUMELEM; i++) {
+        data.ObjectID[i] = i < savingCount ? queue.at(i)->getObjID() : 0;
+        data.InstanceID[i] = i < savingCount ? queue.at(i)->getInstID() : 0;
+        data.Status[i] = ObjectPersistenceBatch::STATUS_PENDING;
+    }
+
+    saveState = AWAITING_ACK;
+    objectPersistenceBatch->setData(data);
+    objectPersistenceBatch->updated();
+}
+
+/**
+  * @brief Process the ACK of a batch save request
+  *
+  * Firmware without batch support NACKs the request, the same objects are then
+  * saved one at a time. A timeout takes that path as well.
+  */
+void UAVObjectUtilManager::objectPersistenceBatchTransactionCompleted(UAVObject* obj, bool success)
+{
+    Q_ASSERT(saveState == AWAITING_ACK);
+    disconnect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(objectPersistenceBatchTransactionCompleted(UAVObject*,bool)));
+
+    if (success) {
+        saveState = AWAITING_COMPLETED;
+        // Leave time for a garbage collection on top of the writes
+        failureTimer.start(5000);
+    } else {
+        obj->disconnect(this);
+        savingCount = 0;
+        saveState = IDLE;
+        batchRefused = true;
+        saveNextObject();
+    }
+}
+
+/**
+  * @brief Process the results of a batch save sent back by the board
+  */
+void UAVObjectUtilManager::objectPersistenceBatchUpdated(UAVObject * obj)
+{
+    Q_ASSERT(obj);
+    Q_ASSERT(obj->getObjID() == ObjectPersistenceBatch::OBJID);
+
+    if (saveState != AWAITING_COMPLETED) {
+        return;
+    }
+
+    ObjectPersistenceBatch::DataFields data = ((ObjectPersistenceBatch *)obj)->getData();
+    if (data.Operation != ObjectPersistenceBatch::OPERATION_COMPLETED &&
+            data.Operation != ObjectPersistenceBatch::OPERATION_ERROR) {
+        // Our own request echoed back
+        return;
+    }
+
+    failureTimer.stop();
+    obj->disconnect(this);
+    finishBatch(&data);
+}
+
+/**
+  * @brief Take the objects of the finished batch off the queue and report on each of them
+  * @param[in] result The answer of the board, NULL if none came
+  */
+void UAVObjectUtilManager::finishBatch(const ObjectPersistenceBatch::DataFields *result)
+{
+    QList<UAVObject *> saved;
+    for (int i = 0; i < savingCount; i++)
+        saved.append(queue.dequeue());
+
+    bool matches = result != NULL && result->NumberOfObjects == savingCount;
+    savingCount = 0;
+    saveState = IDLE;
+
+    for (int i = 0; i < saved.size(); i++) {
+        bool success = matches && result->ObjectID[i] == saved.at(i)->getObjID() &&
+                result->Status[i] == ObjectPersistenceBatch::STATUS_SAVED;
+        emit saveCompleted(saved.at(i)->getObjID(), success);
+    }
+
+    saveNextObject();
+}
+
+
 /**
  * @brief UAVObjectUtilManager::readAllNonSettingsMetadata Convenience function for calling
  * readMetadata
@@ -36,6 +36,7 @@
 #include "uavobjectmanager.h"
 #include "uavobject.h"
 #include "objectpersistence.h"
+#include "objectpersistencebatch.h"
 #include "devicedescriptorstruct.h"
 #include <coreplugin/iboardtype.h>
 #include <QtGlobal>
@@ -88,7 +89,12 @@ private:
     QMutex *mutex;
     QQueue<UAVObject *> queue;
     enum {IDLE, AWAITING_ACK, AWAITING_COMPLETED} saveState;
-    void saveNextObject();
+    //! Number of objects at the head of the queue covered by the batch in flight, 0 for a single save
+    int savingCount;
+    //! Set once the board refused a batch, cleared when the queue drains
+    bool batchRefused;
+    void saveNextBatch();
+    void finishBatch(const ObjectPersistenceBatch::DataFields *result);
     QTimer failureTimer;
     ExtensionSystem::PluginManager *pm;
     UAVObjectManager *obm;
@@ -97,8 +103,11 @@ private:
     bool metadataSendSuccess;
     QErrorMessage *incompatibleMsg;
 private slots:
+    void saveNextObject();
     void objectPersistenceTransactionCompleted(UAVObject* obj, bool success);
     void objectPersistenceUpdated(UAVObject * obj);
+    void objectPersistenceBatchTransactionCompleted(UAVObject* obj, bool success);
+    void objectPersistenceBatchUpdated(UAVObject * obj);
     void objectPersistenceOperationFailed();
     void metadataTransactionCompleted(UAVObject*, bool);
 };
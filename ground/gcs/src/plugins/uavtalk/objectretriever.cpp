@@ -0,0 +1,158 @@
+/**
+ ******************************************************************************
+ * @file       objectretriever.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Fetches a list of objects from the autopilot keeping several
+ * requests outstanding at a time
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "objectretriever.h"
+
+ObjectRetriever::ObjectRetriever(QObject *parent) :
+    QObject(parent),
+    running(false),
+    filling(false),
+    window(DEFAULT_WINDOW_SIZE),
+    completed(0),
+    total(0)
+{
+}
+
+/**
+ * Set the number of requests kept outstanding. A size of one gives
+ * the old stop-and-wait behaviour.
+ */
+void ObjectRetriever::setWindowSize(int size)
+{
+    window = qBound(1, size, (int)MAX_WINDOW_SIZE);
+    if (running)
+        fillWindow();
+}
+
+/**
+ * Drop any previous retrieval and start fetching the given objects
+ */
+void ObjectRetriever::start(const QList<UAVObject *> &objects)
+{
+    abort();
+    foreach (UAVObject *obj, objects)
+        queue.enqueue(obj);
+    total = queue.length();
+    running = true;
+    emit progress(completed, total);
+    fillWindow();
+}
+
+/**
+ * Add an object to a running retrieval, used to ask again for
+ * an object which failed from the objectRetrieved() handler
+ */
+void ObjectRetriever::enqueue(UAVObject *obj)
+{
+    if (!running)
+        return;
+    queue.enqueue(obj);
+    ++total;
+    fillWindow();
+}
+
+/**
+ * Stop issuing requests. The ones in flight still complete and
+ * finished() is emitted once they have.
+ */
+void ObjectRetriever::cancel()
+{
+    if (!running)
+        return;
+    total -= queue.length();
+    queue.clear();
+    fillWindow();
+}
+
+/**
+ * Forget about the retrieval without emitting finished(), used when
+ * the link went away
+ */
+void ObjectRetriever::abort()
+{
+    foreach (UAVObject *obj, inFlight)
+        disconnect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(transactionCompleted(UAVObject*,bool)));
+    inFlight.clear();
+    queue.clear();
+    running = false;
+    completed = 0;
+    total = 0;
+}
+
+/**
+ * Issue requests until the window is full or the queue is empty, and
+ * report the end of the retrieval once nothing is left
+ */
+void ObjectRetriever::fillWindow()
+{
+    // Telemetry completes a request synchronously when it cannot queue
+    // it, the outer call keeps going in that case
+    if (filling)
+        return;
+    filling = true;
+    while (running && inFlight.size() < window && !queue.isEmpty()) {
+        UAVObject *obj = queue.dequeue();
+        if (inFlight.contains(obj)) {
+            // Telemetry ignores a request while one is pending for
+            // the same object, so there is nothing more to wait for
+            ++completed;
+            continue;
+        }
+        inFlight.insert(obj);
+        connect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(transactionCompleted(UAVObject*,bool)));
+        obj->requestUpdateAllInstances();
+    }
+    filling = false;
+
+    if (running && queue.isEmpty() && inFlight.isEmpty()) {
+        running = false;
+        emit finished();
+    }
+}
+
+/**
+ * Called by a requested object once Telemetry got its answer or gave up
+ */
+void ObjectRetriever::transactionCompleted(UAVObject *obj, bool success)
+{
+    if (!inFlight.remove(obj))
+        return;
+    disconnect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(transactionCompleted(UAVObject*,bool)));
+    ++completed;
+
+    emit objectRetrieved(obj, success);
+    // The handler may have aborted the retrieval
+    if (!running)
+        return;
+    emit progress(completed, total);
+    fillWindow();
+}
+
+/**
+ * @}
+ * @}
+ */
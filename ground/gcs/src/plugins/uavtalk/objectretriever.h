@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ * @file       objectretriever.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Fetches a list of objects from the autopilot keeping several
+ * requests outstanding at a time
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef OBJECTRETRIEVER_H
+#define OBJECTRETRIEVER_H
+
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include "uavtalk_global.h"
+#include "uavobject.h"
+
+/**
+ * Requests every object of a list from the remote end, keeping up to
+ * windowSize() requests in flight. Per-request timeouts and retries are
+ * handled by Telemetry, a request counts as done once the object emits
+ * transactionCompleted() whatever the result.
+ */
+class UAVTALK_EXPORT ObjectRetriever : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Telemetry drops update requests beyond its own queue size
+    static const int MAX_WINDOW_SIZE = 16;
+    static const int DEFAULT_WINDOW_SIZE = 8;
+
+    ObjectRetriever(QObject *parent = 0);
+
+    void setWindowSize(int size);
+    int windowSize() const { return window; }
+
+    void start(const QList<UAVObject *> &objects);
+    void enqueue(UAVObject *obj);
+    void cancel();
+    void abort();
+
+    bool isActive() const { return running; }
+    int pendingCount() const { return queue.length(); }
+    int inFlightCount() const { return inFlight.size(); }
+
+signals:
+    //! Emitted for each finished request, before the window is refilled
+    void objectRetrieved(UAVObject *obj, bool success);
+    void progress(int completed, int total);
+    //! Emitted once the queue is drained and no request is outstanding
+    void finished();
+
+private slots:
+    void transactionCompleted(UAVObject *obj, bool success);
+
+private:
+    void fillWindow();
+
+    QQueue<UAVObject *> queue;
+    QSet<UAVObject *> inFlight;
+    bool running;
+    bool filling;
+    int window;
+    int completed;
+    int total;
+};
+
+#endif // OBJECTRETRIEVER_H
+
+/**
+ * @}
+ * @}
+ */
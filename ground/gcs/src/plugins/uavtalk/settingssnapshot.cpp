@@ -0,0 +1,283 @@
+/**
+ ******************************************************************************
+ * @file       settingssnapshot.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Keeps a copy of the settings and metadata of each board between
+ * sessions so that unchanged objects need not be downloaded again
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "settingssnapshot.h"
+#include "uavmetaobject.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QDebug>
+
+SettingsSnapshot::SettingsSnapshot(UAVObjectManager *objMngr, const QString &directory, QObject *parent) :
+    QObject(parent),
+    objMngr(objMngr),
+    directory(directory),
+    page(0),
+    fetching(false),
+    restored(0)
+{
+    iapObj = FirmwareIAPObj::GetInstance(objMngr);
+    digestObj = SettingsDigest::GetInstance(objMngr);
+
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    connect(timer, SIGNAL(timeout()), this, SLOT(pageTimeout()));
+    connect(digestObj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(digestUnpacked(UAVObject*)));
+}
+
+/**
+ * Name of the snapshot of a board, empty if the firmware carries no
+ * description to tell its UAVO definitions apart
+ */
+QString SettingsSnapshot::boardKey(const FirmwareIAPObj::DataFields &iap)
+{
+    QByteArray desc((const char *)iap.Description, FirmwareIAPObj::DESCRIPTION_NUMELEM);
+    if (!desc.startsWith("TlFw") && !desc.startsWith("OpFw"))
+        return QString();
+
+    QByteArray serial((const char *)iap.CPUSerial, FirmwareIAPObj::CPUSERIAL_NUMELEM);
+    // Offset of the SHA1 of the UAVO definitions, see UAVObjectUtilManager::descriptionToStructure
+    QByteArray uavoHash = desc.mid(60, 20);
+    return QString("%1_%2").arg(QString(serial.toHex())).arg(QString(uavoHash.toHex()));
+}
+
+/**
+ * Identify the board and fetch the digest table. Ends with digestsFetched()
+ * in every case, with an empty table if the board does not support it.
+ */
+void SettingsSnapshot::fetchDigests()
+{
+    abort();
+    restored = 0;
+
+    if (!digestObj->getIsPresentOnHardware()) {
+        emit digestsFetched();
+        return;
+    }
+
+    fetching = true;
+    connect(iapObj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(iapCompleted(UAVObject*,bool)));
+    iapObj->requestUpdate();
+}
+
+/**
+ * Stop fetching without emitting digestsFetched(), used when the link went away
+ */
+void SettingsSnapshot::abort()
+{
+    fetching = false;
+    timer->stop();
+    disconnect(iapObj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(iapCompleted(UAVObject*,bool)));
+    disconnect(digestObj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(digestCompleted(UAVObject*,bool)));
+    digests.clear();
+}
+
+void SettingsSnapshot::iapCompleted(UAVObject *obj, bool success)
+{
+    Q_UNUSED(obj);
+    disconnect(iapObj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(iapCompleted(UAVObject*,bool)));
+    if (!fetching)
+        return;
+
+    key = success ? boardKey(iapObj->getData()) : QString();
+    if (key.isEmpty()) {
+        finish();
+        return;
+    }
+
+    load();
+    connect(digestObj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(digestCompleted(UAVObject*,bool)));
+    requestPage(0);
+}
+
+/**
+ * Send the page number to the board, it answers with that page of the table
+ */
+void SettingsSnapshot::requestPage(quint8 number)
+{
+    page = number;
+    digestObj->setPage(page);
+    digestObj->updated();
+    timer->start(PAGE_TIMEOUT_MS);
+}
+
+/**
+ * A NACK means the firmware does not know the object, fetch everything
+ */
+void SettingsSnapshot::digestCompleted(UAVObject *obj, bool success)
+{
+    Q_UNUSED(obj);
+    if (fetching && !success)
+        finish();
+}
+
+void SettingsSnapshot::digestUnpacked(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+    if (!fetching || key.isEmpty())
+        return;
+
+    SettingsDigest::DataFields data = digestObj->getData();
+    if (data.Page != page)
+        return;
+
+    for (quint32 i = 0; i < SettingsDigest::OBJECTID_NUMELEM; ++i) {
+        if (data.ObjectID[i] == 0)
+            continue;
+        UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(objMngr->getObject(data.ObjectID[i]));
+        if (dobj == NULL)
+            continue;
+        digests.insert(dobj->getObjID(), data.Digest[i]);
+        digests.insert(dobj->getMetaObject()->getObjID(), data.MetaDigest[i]);
+    }
+
+    if ((page + 1) * SettingsDigest::OBJECTID_NUMELEM < data.NumberOfObjects)
+        requestPage(page + 1);
+    else
+        finish();
+}
+
+/**
+ * Whatever part of the table arrived is used, the rest is fetched
+ */
+void SettingsSnapshot::pageTimeout()
+{
+    if (fetching)
+        finish();
+}
+
+void SettingsSnapshot::finish()
+{
+    fetching = false;
+    timer->stop();
+    disconnect(digestObj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(digestCompleted(UAVObject*,bool)));
+    emit digestsFetched();
+}
+
+/**
+ * Only settings and metadata are kept, the board state changes too often
+ * to be worth it
+ */
+bool SettingsSnapshot::isCacheable(UAVObject *obj)
+{
+    if (!obj->isSingleInstance())
+        return false;
+    if (dynamic_cast<UAVMetaObject *>(obj) != NULL)
+        return true;
+    UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
+    return dobj != NULL && dobj->isSettings();
+}
+
+/**
+ * Unpack every object the board reported unchanged since the snapshot was
+ * taken and return the ones that still have to be requested
+ */
+QList<UAVObject *> SettingsSnapshot::restore(const QList<UAVObject *> &objects)
+{
+    QList<UAVObject *> remaining;
+    foreach (UAVObject *obj, objects) {
+        QHash<quint32, Entry>::const_iterator entry = cache.constFind(obj->getObjID());
+        if (entry != cache.constEnd() && isCacheable(obj) &&
+                digests.contains(obj->getObjID()) &&
+                digests.value(obj->getObjID()) == entry->digest &&
+                entry->data.size() == (int)obj->getNumBytes()) {
+            obj->unpack((const quint8 *)entry->data.constData());
+            ++restored;
+        } else {
+            remaining.append(obj);
+        }
+    }
+    return remaining;
+}
+
+/**
+ * Keep a retrieved object with the digest the board reported for it. The
+ * table is fetched before the objects, so a change in between only makes
+ * the next connection fetch the object again.
+ */
+void SettingsSnapshot::objectRetrieved(UAVObject *obj, bool success)
+{
+    if (!success || !isCacheable(obj) || !digests.contains(obj->getObjID()))
+        return;
+
+    Entry entry;
+    entry.digest = digests.value(obj->getObjID());
+    entry.data.resize(obj->getNumBytes());
+    obj->pack((quint8 *)entry.data.data());
+    cache.insert(obj->getObjID(), entry);
+}
+
+void SettingsSnapshot::load()
+{
+    cache.clear();
+
+    QFile file(QDir(directory).filePath(key + ".snapshot"));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&file);
+    quint32 version;
+    quint32 count;
+    stream >> version >> count;
+    if (version != FILE_VERSION)
+        return;
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        quint32 id;
+        Entry entry;
+        stream >> id >> entry.digest >> entry.data;
+        cache.insert(id, entry);
+    }
+    if (stream.status() != QDataStream::Ok)
+        cache.clear();
+}
+
+/**
+ * Write the snapshot of the connected board, called once retrieval ended
+ */
+void SettingsSnapshot::save()
+{
+    if (key.isEmpty() || cache.isEmpty())
+        return;
+
+    QDir().mkpath(directory);
+    QFile file(QDir(directory).filePath(key + ".snapshot"));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "SettingsSnapshot: unable to write" << file.fileName();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << (quint32)FILE_VERSION << (quint32)cache.size();
+    for (QHash<quint32, Entry>::const_iterator itr = cache.constBegin(); itr != cache.constEnd(); ++itr)
+        stream << itr.key() << itr->digest << itr->data;
+}
+
+/**
+ * @}
+ * @}
+ */
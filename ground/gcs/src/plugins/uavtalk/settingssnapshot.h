@@ -0,0 +1,106 @@
+/**
+ ******************************************************************************
+ * @file       settingssnapshot.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Keeps a copy of the settings and metadata of each board between
+ * sessions so that unchanged objects need not be downloaded again
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SETTINGSSNAPSHOT_H
+#define SETTINGSSNAPSHOT_H
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include "uavtalk_global.h"
+#include "uavobjectmanager.h"
+#include "firmwareiapobj.h"
+#include "settingsdigest.h"
+
+/**
+ * The snapshot of a board is keyed by its CPU serial and the hash of its
+ * UAVO definitions. On connection the board sends a table of digests of
+ * its objects a page at a time, objects whose digest matches the one
+ * stored with the snapshot are restored from it instead of requested.
+ */
+class UAVTALK_EXPORT SettingsSnapshot : public QObject
+{
+    Q_OBJECT
+
+public:
+    SettingsSnapshot(UAVObjectManager *objMngr, const QString &directory, QObject *parent = 0);
+
+    void fetchDigests();
+    void abort();
+    QList<UAVObject *> restore(const QList<UAVObject *> &objects);
+    void save();
+
+    int restoredCount() const { return restored; }
+    static QString boardKey(const FirmwareIAPObj::DataFields &iap);
+
+signals:
+    //! Emitted once the digest table is known, or failed to be fetched
+    void digestsFetched();
+
+public slots:
+    void objectRetrieved(UAVObject *obj, bool success);
+
+private slots:
+    void iapCompleted(UAVObject *obj, bool success);
+    void digestCompleted(UAVObject *obj, bool success);
+    void digestUnpacked(UAVObject *obj);
+    void pageTimeout();
+
+private:
+    //! Time allowed for the board to answer a page request
+    static const int PAGE_TIMEOUT_MS = 1000;
+    static const quint32 FILE_VERSION = 1;
+
+    struct Entry {
+        quint32 digest;
+        QByteArray data;
+    };
+
+    bool isCacheable(UAVObject *obj);
+    void load();
+    void requestPage(quint8 page);
+    void finish();
+
+    UAVObjectManager *objMngr;
+    FirmwareIAPObj *iapObj;
+    SettingsDigest *digestObj;
+    QString directory;
+    QString key;
+    QHash<quint32, Entry> cache;
+    QHash<quint32, quint32> digests;
+    QTimer *timer;
+    quint8 page;
+    bool fetching;
+    int restored;
+};
+
+#endif // SETTINGSSNAPSHOT_H
+
+/**
+ * @}
+ * @}
+ */
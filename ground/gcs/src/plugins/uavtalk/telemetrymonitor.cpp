@@ -30,6 +30,7 @@
 #include "coreplugin/connectionmanager.h"
 #include "coreplugin/icore.h"
 #include "firmwareiapobj.h"
+#include <QFileInfo>
 
 //Number of retries for initial session object fetching
 //This is needed because sometimes the object is lost when asked right uppon connection
@@ -40,7 +41,7 @@
 #define SESSION_RETRIEVE_TIMEOUT            20000
 //Number of retries for the session object fetching during negotiation
 #define SESSION_OBJ_RETRIEVE_RETRIES        3
-//Timeout for the object fetching fase, the system will stop fetching objects and emit connected after this
+//Timeout for the object fetching fase without any object completing, the system will stop fetching objects and emit connected after this
 #define OBJECT_RETRIEVE_TIMEOUT             5000
 //IAP object is very important, retry if not able to get it the first time
 #define IAP_OBJECT_RETRIES                  3
@@ -89,6 +90,16 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QH
     connect(sessionRetrieveTimeout,SIGNAL(timeout()),this,SLOT(sessionRetrieveTimeoutCB()));
     connect(sessionInitialRetrieveTimeout,SIGNAL(timeout()),this,SLOT(sessionInitialRetrieveTimeoutCB()));
     connect(objectRetrieveTimeout,SIGNAL(timeout()),this,SLOT(objectRetrieveTimeoutCB()));
+    // Objects are fetched a window at a time on connection
+    retriever = new ObjectRetriever(this);
+    connect(retriever,SIGNAL(objectRetrieved(UAVObject*,bool)),this,SLOT(transactionCompleted(UAVObject*,bool)));
+    connect(retriever,SIGNAL(progress(int,int)),this,SIGNAL(objectRetrievalProgress(int,int)));
+    connect(retriever,SIGNAL(finished()),this,SLOT(objectRetrievalFinished()));
+    // Settings unchanged since the last session with the board are not fetched again
+    QString snapshotDir = QFileInfo(Core::ICore::instance()->settings()->fileName()).absolutePath() + "/settingssnapshots";
+    snapshot = new SettingsSnapshot(objMngr, snapshotDir, this);
+    connect(snapshot,SIGNAL(digestsFetched()),this,SLOT(retrieveObjects()));
+    connect(retriever,SIGNAL(objectRetrieved(UAVObject*,bool)),snapshot,SLOT(objectRetrieved(UAVObject*,bool)));
     statsTimer->start(STATS_CONNECT_PERIOD_MS);
 
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
@@ -123,14 +134,24 @@ TelemetryMonitor::~TelemetryMonitor() {
 }
 
 /**
- * Initiate object retrieval, initialize queue with objects to be retrieved.
+ * Initiate object retrieval, first get the digests of the objects on the board.
  */
 void TelemetryMonitor::startRetrievingObjects()
 {
     TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 connectionStatus changed to CON_RETRIEVING_OBJECT").arg(Q_FUNC_INFO));
     connectionStatus = CON_RETRIEVING_OBJECTS;
+    snapshot->fetchDigests();
+}
+
+/**
+ * Initialize queue with objects to be retrieved, skipping those restored from the snapshot.
+ */
+void TelemetryMonitor::retrieveObjects()
+{
+    if (connectionStatus != CON_RETRIEVING_OBJECTS)
+        return;
     // Get all objects, add metaobjects, settings and data objects with OnChange update mode to the queue
-    queue.empty();
+    QQueue<UAVObject*> queue;
     retries = 0;
     objectRetrieveTimeout->start(OBJECT_RETRIEVE_TIMEOUT);
     foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects().values())
@@ -170,9 +191,10 @@ void TelemetryMonitor::startRetrievingObjects()
         }
     }
     // Start retrieving
-    TELEMETRYMONITOR_QXTLOG_DEBUG(QString(tr("Starting to retrieve meta and settings objects from the autopilot (%1 objects)"))
-                                  .arg( queue.length()));
-    retrieveNextObject();
+    QList<UAVObject*> remaining = snapshot->restore(queue);
+    TELEMETRYMONITOR_QXTLOG_DEBUG(QString(tr("Starting to retrieve meta and settings objects from the autopilot (%1 objects, %2 at a time, %3 restored from snapshot)"))
+                                  .arg( remaining.length()).arg(retriever->windowSize()).arg(snapshot->restoredCount()));
+    retriever->start(remaining);
 }
 
 void TelemetryMonitor::changeObjectInstances(quint32 objID, quint32 instID, bool delayed)
@@ -230,75 +252,61 @@ void TelemetryMonitor::changeObjectInstances(quint32 objID, quint32 instID, bool
 }
 
 /**
- * Retrieve the next object in the queue
+ * Called once every queued object has been retrieved or has failed
  */
-void TelemetryMonitor::retrieveNextObject()
+void TelemetryMonitor::objectRetrievalFinished()
 {
-    // If queue is empty return
-    if ( queue.isEmpty() )
+    TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 Object retrieval completed").arg(Q_FUNC_INFO));
+    snapshot->save();
+    if(isManaged)
     {
-        TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 Object retrieval completed").arg(Q_FUNC_INFO));
-        if(isManaged)
-        {
-            TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 connectionStatus set to CON_CONNECTED_MANAGED( %1 )").arg(Q_FUNC_INFO).arg(connectionStatus));
-            connectionStatus = CON_CONNECTED_MANAGED;            
-        }
-        else
-        {
-            TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 connectionStatus set to CON_CONNECTED_MANAGED( %1 )").arg(Q_FUNC_INFO).arg(connectionStatus));
-            connectionStatus = CON_CONNECTED_UNMANAGED;
-        }
-        //restart periodic updates on the FC
-        sessionObj->setObjectOfInterestIndex(0xFF);
-        sessionObj->updated();
-        foreach (UAVDataObject * uavo, delayedUpdate) {
-            uavo->setIsPresentOnHardware(true);
-        }
-        delayedUpdate.clear();
-        emit connected();
-        sessionRetrieveTimeout->stop();
-        sessionInitialRetrieveTimeout->stop();
-        objectRetrieveTimeout->stop();
-        return;
+        TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 connectionStatus set to CON_CONNECTED_MANAGED( %1 )").arg(Q_FUNC_INFO).arg(connectionStatus));
+        connectionStatus = CON_CONNECTED_MANAGED;            
+    }
+    else
+    {
+        TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 connectionStatus set to CON_CONNECTED_MANAGED( %1 )").arg(Q_FUNC_INFO).arg(connectionStatus));
+        connectionStatus = CON_CONNECTED_UNMANAGED;
+    }
+    //restart periodic updates on the FC
+    sessionObj->setObjectOfInterestIndex(0xFF);
+    sessionObj->updated();
+    foreach (UAVDataObject * uavo, delayedUpdate) {
+        uavo->setIsPresentOnHardware(true);
     }
-    // Get next object from the queue
-    UAVObject* obj = queue.dequeue();
-    // Connect to object
-    TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 requestiong %1 from board INSTID:%2").arg(Q_FUNC_INFO).arg(obj->getName()).arg(obj->getInstID()));
-    connect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(transactionCompleted(UAVObject*,bool)));
-    // Request update
-    obj->requestUpdateAllInstances();
+    delayedUpdate.clear();
+    emit connected();
+    sessionRetrieveTimeout->stop();
+    sessionInitialRetrieveTimeout->stop();
+    objectRetrieveTimeout->stop();
 }
 
 /**
- * Called by the retrieved object when a transaction is completed.
+ * Called by the object retriever when a transaction is completed.
  */
 void TelemetryMonitor::transactionCompleted(UAVObject* obj, bool success)
 {
     TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 received %1 OBJID:%2 result:%3").arg(Q_FUNC_INFO).arg(obj->getName()).arg(obj->getObjID()).arg(success));
-    Q_UNUSED(success);
     QMutexLocker locker(mutex);
-    if(obj->getObjID() == FirmwareIAPObj::OBJID)
-    {
-        if(!success && (retries < IAP_OBJECT_RETRIES))
-        {
-            ++retries;
-            obj->requestUpdate();
-        }
-    }
-    // Disconnect from sending object
-    obj->disconnect(this);
     // Process next object if telemetry is still available
     GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
     if ( gcsStats.Status == GCSTelemetryStats::STATUS_CONNECTED )
     {
         connectionStatus = CON_RETRIEVING_OBJECTS;
-        retrieveNextObject();
+        objectRetrieveTimeout->start(OBJECT_RETRIEVE_TIMEOUT);
+        if(obj->getObjID() == FirmwareIAPObj::OBJID)
+        {
+            if(!success && (retries < IAP_OBJECT_RETRIES))
+            {
+                ++retries;
+                retriever->enqueue(obj);
+            }
+        }
     }
     else
     {
         TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 connection lost while retrieving objects, stopped object retrievel").arg(Q_FUNC_INFO));
-        queue.empty();
+        retriever->abort();
         objectRetrieveTimeout->stop();
         sessionRetrieveTimeout->stop();
         sessionInitialRetrieveTimeout->stop();
@@ -411,7 +419,9 @@ void TelemetryMonitor::sessionObjUnpackedCB(UAVObject *obj)
 
 void TelemetryMonitor::objectRetrieveTimeoutCB()
 {
-    queue.empty();
+    // Give up on what is still queued, connected() follows once the
+    // requests in flight are answered or time out in Telemetry
+    retriever->cancel();
 }
 
 void TelemetryMonitor::sessionInitialRetrieveTimeoutCB()
@@ -670,6 +680,8 @@ void TelemetryMonitor::processStatsUpdates()
     {
         statsTimer->setInterval(STATS_CONNECT_PERIOD_MS);
         connectionStatus = CON_DISCONNECTED;
+        retriever->abort();
+        snapshot->abort();
         ExtensionSystem::PluginManager* pm = ExtensionSystem::PluginManager::instance();
         Core::Internal::GeneralSettings * settings=pm->getObject<Core::Internal::GeneralSettings>();
         if (settings->useSessionManaging())
@@ -40,6 +40,8 @@
 #include "flighttelemetrystats.h"
 #include "systemstats.h"
 #include "telemetry.h"
+#include "objectretriever.h"
+#include "settingssnapshot.h"
 #include "sessionmanaging.h"
 #include <coreplugin/generalsettings.h>
 #include <extensionsystem/pluginmanager.h>
@@ -58,10 +60,13 @@ public:
     TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QHash<quint16, QList<objStruc> > sessions);
     ~TelemetryMonitor();
     QHash<quint16, QList<objStruc> > savedSessions() {return sessions;}
+    void setRetrieveWindow(int size) {retriever->setWindowSize(size);}
+    int retrieveWindow() const {return retriever->windowSize();}
 signals:
     void connected();
     void disconnected();
     void telemetryUpdated(double txRate, double rxRate);
+    void objectRetrievalProgress(int completed, int total);
 
 public slots:
     void transactionCompleted(UAVObject* obj, bool success);
@@ -75,6 +80,8 @@ private slots:
     void sessionInitialRetrieveTimeoutCB();
     void saveSession();
     void newInstanceSlot(UAVObject*);
+    void objectRetrievalFinished();
+    void retrieveObjects();
 private:
     QList<UAVDataObject *> delayedUpdate;
     enum connectionStatusEnum {CON_DISCONNECTED, CON_INITIALIZING, CON_SESSION_INITIALIZING, CON_RETRIEVING_OBJECTS, CON_CONNECTED_UNMANAGED,CON_CONNECTED_MANAGED};
@@ -84,7 +91,8 @@ private:
     connectionStatusEnum connectionStatus;
     UAVObjectManager* objMngr;
     Telemetry* tel;
-    QQueue<UAVObject*> queue;
+    ObjectRetriever* retriever;
+    SettingsSnapshot* snapshot;
     GCSTelemetryStats* gcsStatsObj;
     FlightTelemetryStats* flightStatsObj;
     QTimer* statsTimer;
@@ -92,7 +100,6 @@ private:
     QTime* connectionTimer;
     SessionManaging* sessionObj;
     void startRetrievingObjects();
-    void retrieveNextObject();
     quint16 sessionID;
     quint8 numberOfObjects;
     QTimer* objectRetrieveTimeout;
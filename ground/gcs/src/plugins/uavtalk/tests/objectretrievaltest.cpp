@@ -0,0 +1,309 @@
+/**
+ ******************************************************************************
+ * @file       objectretrievaltest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Fetches the settings objects of a second UAVTalk instance over a
+ * link with injected latency and loss, as the GCS does on connection
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QQueue>
+#include "uavtalk/uavtalk.h"
+#include "uavtalk/telemetry.h"
+#include "uavtalk/objectretriever.h"
+#include "uavobjects/uavobjectsinit.h"
+#include "uavobjects/uavdataobject.h"
+#include "uavobjects/gcstelemetrystats.h"
+
+//! One way delay of the loopback link
+static const int LINK_LATENCY_MS = 10;
+//! Number of objects fetched, metadata included
+static const int OBJECT_COUNT = 40;
+
+/**
+ * One end of an in-process link. Bytes written to it show up on the
+ * peer LINK_LATENCY_MS later, every dropEvery'th write is lost.
+ */
+class LoopbackDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    LoopbackDevice() : peer(0), dropEvery(0), writes(0)
+    {
+        clock.start();
+        timer.setSingleShot(true);
+        connect(&timer, SIGNAL(timeout()), this, SLOT(deliver()));
+    }
+
+    void setPeer(LoopbackDevice *dev) { peer = dev; }
+    void setDropEvery(int n) { dropEvery = n; }
+    bool isSequential() const { return true; }
+    qint64 bytesAvailable() const { return rxBuffer.size() + QIODevice::bytesAvailable(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize)
+    {
+        qint64 len = qMin(maxSize, (qint64)rxBuffer.size());
+        memcpy(data, rxBuffer.constData(), len);
+        rxBuffer.remove(0, len);
+        return len;
+    }
+
+    qint64 writeData(const char *data, qint64 len)
+    {
+        ++writes;
+        if (dropEvery > 0 && (writes % dropEvery) == 0)
+            return len;
+        Packet packet;
+        packet.due = clock.elapsed() + LINK_LATENCY_MS;
+        packet.data = QByteArray(data, len);
+        txQueue.enqueue(packet);
+        if (!timer.isActive())
+            timer.start(LINK_LATENCY_MS);
+        return len;
+    }
+
+private slots:
+    void deliver()
+    {
+        while (!txQueue.isEmpty() && txQueue.head().due <= clock.elapsed()) {
+            peer->rxBuffer.append(txQueue.dequeue().data);
+        }
+        if (!txQueue.isEmpty())
+            timer.start(qMax((qint64)1, txQueue.head().due - clock.elapsed()));
+        emit peer->readyRead();
+    }
+
+private:
+    struct Packet {
+        qint64 due;
+        QByteArray data;
+    };
+
+    LoopbackDevice *peer;
+    QByteArray rxBuffer;
+    QQueue<Packet> txQueue;
+    QTimer timer;
+    QElapsedTimer clock;
+    int dropEvery;
+    int writes;
+};
+
+class tst_ObjectRetrieval : public QObject
+{
+    Q_OBJECT
+
+public slots:
+    void objectRetrieved(UAVObject *obj, bool success);
+
+private slots:
+    void init();
+    void cleanup();
+    void stopAndWait();
+    void windowed();
+    void lossyLink();
+    void windowIsFaster();
+
+private:
+    qint64 retrieve(int window, int *failures);
+
+    UAVObjectManager *flightMngr;
+    UAVObjectManager *gcsMngr;
+    LoopbackDevice *flightLink;
+    LoopbackDevice *gcsLink;
+    UAVTalk *flightTalk;
+    UAVTalk *gcsTalk;
+    Telemetry *tel;
+    QList<UAVObject *> objects;
+    int retrievedCount;
+    int failedCount;
+};
+
+/**
+ * Build both ends, give the flight side settings non default contents
+ * and list the GCS objects to fetch
+ */
+void tst_ObjectRetrieval::init()
+{
+    flightMngr = new UAVObjectManager();
+    UAVObjectsInitialize(flightMngr);
+    gcsMngr = new UAVObjectManager();
+    UAVObjectsInitialize(gcsMngr);
+
+    flightLink = new LoopbackDevice();
+    gcsLink = new LoopbackDevice();
+    flightLink->setPeer(gcsLink);
+    gcsLink->setPeer(flightLink);
+    flightLink->open(QIODevice::ReadWrite);
+    gcsLink->open(QIODevice::ReadWrite);
+
+    // The flight side only answers requests, it needs no Telemetry
+    flightTalk = new UAVTalk(flightLink, flightMngr);
+    gcsTalk = new UAVTalk(gcsLink, gcsMngr);
+
+    // Telemetry only sends requests once the link is up
+    GCSTelemetryStats *stats = GCSTelemetryStats::GetInstance(gcsMngr);
+    GCSTelemetryStats::DataFields statsData = stats->getData();
+    statsData.Status = GCSTelemetryStats::STATUS_CONNECTED;
+    stats->setData(statsData);
+    tel = new Telemetry(gcsTalk, gcsMngr);
+
+    objects.clear();
+    quint8 seed = 1;
+    foreach (QVector<UAVDataObject *> instances, gcsMngr->getDataObjectsVector()) {
+        UAVDataObject *dobj = instances.first();
+        if (!dobj->isSettings() || !dobj->isSingleInstance())
+            continue;
+
+        UAVObject *remote = flightMngr->getObject(dobj->getObjID());
+        QByteArray data(remote->getNumBytes(), 0);
+        for (int i = 0; i < data.size(); ++i)
+            data[i] = seed++;
+        remote->unpack((const quint8 *)data.constData());
+
+        objects << dobj->getMetaObject() << dobj;
+        if (objects.size() >= OBJECT_COUNT)
+            break;
+    }
+    QVERIFY(objects.size() >= OBJECT_COUNT);
+}
+
+void tst_ObjectRetrieval::cleanup()
+{
+    delete tel;
+    delete gcsTalk;
+    delete flightTalk;
+    delete gcsLink;
+    delete flightLink;
+    delete gcsMngr;
+    delete flightMngr;
+}
+
+void tst_ObjectRetrieval::objectRetrieved(UAVObject *obj, bool success)
+{
+    Q_UNUSED(obj);
+    ++retrievedCount;
+    if (!success)
+        ++failedCount;
+}
+
+/**
+ * Fetch the object list and check every object arrived intact.
+ * Returns the time it took.
+ */
+qint64 tst_ObjectRetrieval::retrieve(int window, int *failures)
+{
+    ObjectRetriever retriever;
+    retriever.setWindowSize(window);
+    retrievedCount = 0;
+    failedCount = 0;
+    connect(&retriever, SIGNAL(objectRetrieved(UAVObject*,bool)), this, SLOT(objectRetrieved(UAVObject*,bool)));
+    QSignalSpy progress(&retriever, SIGNAL(progress(int,int)));
+    QSignalSpy finished(&retriever, SIGNAL(finished()));
+
+    QElapsedTimer timer;
+    timer.start();
+    retriever.start(objects);
+    while (finished.isEmpty() && timer.elapsed() < 30000) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+        if (retriever.inFlightCount() > window)
+            return -1;
+    }
+    qint64 elapsed = timer.elapsed();
+
+    if (finished.count() != 1 || retrievedCount != objects.size())
+        return -1;
+    QList<QVariant> last = progress.last();
+    if (last.at(0).toInt() != objects.size() || last.at(1).toInt() != objects.size())
+        return -1;
+
+    *failures = failedCount;
+
+    foreach (UAVObject *obj, objects) {
+        UAVObject *remote = flightMngr->getObject(obj->getObjID());
+        QByteArray local(obj->getNumBytes(), 0);
+        QByteArray expected(remote->getNumBytes(), 0);
+        obj->pack((quint8 *)local.data());
+        remote->pack((quint8 *)expected.data());
+        if (local != expected)
+            return -1;
+    }
+
+    return elapsed;
+}
+
+void tst_ObjectRetrieval::stopAndWait()
+{
+    int failures;
+    QVERIFY(retrieve(1, &failures) >= 0);
+    QCOMPARE(failures, 0);
+}
+
+void tst_ObjectRetrieval::windowed()
+{
+    int failures;
+    QVERIFY(retrieve(ObjectRetriever::DEFAULT_WINDOW_SIZE, &failures) >= 0);
+    QCOMPARE(failures, 0);
+}
+
+/**
+ * Lost answers are recovered by the Telemetry retries
+ */
+void tst_ObjectRetrieval::lossyLink()
+{
+    flightLink->setDropEvery(7);
+    int failures;
+    QVERIFY(retrieve(ObjectRetriever::DEFAULT_WINDOW_SIZE, &failures) >= 0);
+    QCOMPARE(failures, 0);
+}
+
+/**
+ * With one request in flight each object costs a round trip, a full
+ * window should cover the list several times faster
+ */
+void tst_ObjectRetrieval::windowIsFaster()
+{
+    int failures;
+    qint64 serial = retrieve(1, &failures);
+    QVERIFY(serial >= 0);
+
+    cleanup();
+    init();
+    qint64 windowed = retrieve(ObjectRetriever::DEFAULT_WINDOW_SIZE, &failures);
+    QVERIFY(windowed >= 0);
+
+    qDebug() << "window 1:" << serial << "ms, window" << ObjectRetriever::DEFAULT_WINDOW_SIZE << ":" << windowed << "ms";
+    QVERIFY(serial >= OBJECT_COUNT * 2 * LINK_LATENCY_MS);
+    QVERIFY(windowed * 3 < serial);
+}
+
+QTEST_MAIN(tst_ObjectRetrieval)
+
+#include "objectretrievaltest.moc"
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,15 @@
+# -------------------------------------------------
+# Windowed object retrieval against a loopback UAVTalk
+# peer with injected latency
+# -------------------------------------------------
+QT -= gui
+QT += network testlib
+TARGET = objectretrievaltest
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+include(../../../../gcs.pri)
+include(../uavtalk.pri)
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins
+LIBS += -L$$GCS_PLUGIN_PATH/TauLabs
+SOURCES += objectretrievaltest.cpp
@@ -0,0 +1,135 @@
+/**
+ ******************************************************************************
+ * @file       uavtalkbenchmark.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Measures the UAVTalk decode rate on a recorded telemetry log, once
+ * feeding the parser byte by byte and once in blocks as readAll() would
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QCoreApplication>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include "uavtalk/uavtalk.h"
+#include "uavobjects/uavobjectsinit.h"
+
+static const int REPEAT = 5;
+
+/**
+ * Read the telemetry stream out of a .tll file, dropping the
+ * per-packet timestamp and size fields.
+ */
+static bool loadLog(const QString &fileName, QByteArray &stream)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    // Skip the text header of new format logs
+    if (file.readLine().startsWith("Tau Labs git hash")) {
+        int cnt = 0;
+        while (file.readLine() != "##\n" && cnt++ < 10 && !file.atEnd())
+            ;
+    } else {
+        file.seek(0);
+    }
+
+    while (file.bytesAvailable() > (qint64)(sizeof(quint32) + sizeof(qint64))) {
+        quint32 timeStamp;
+        qint64 dataSize;
+        file.read((char *) &timeStamp, sizeof(timeStamp));
+        file.read((char *) &dataSize, sizeof(dataSize));
+        if (dataSize < 1 || dataSize > (1024*1024) || file.bytesAvailable() < dataSize)
+            break;
+        stream.append(file.read(dataSize));
+    }
+
+    return stream.size() > 0;
+}
+
+/**
+ * Decode the stream REPEAT times and report the frame rate
+ */
+static void run(QTextStream &out, const char *name, UAVTalk *talk, const QByteArray &stream, int chunk)
+{
+    const quint8 *data = (const quint8 *)stream.constData();
+    QElapsedTimer timer;
+
+    talk->resetStats();
+    timer.start();
+    for (int i = 0; i < REPEAT; ++i) {
+        if (chunk <= 1) {
+            for (int n = 0; n < stream.size(); ++n)
+                talk->processInputByte(data[n]);
+        } else {
+            for (int n = 0; n < stream.size(); n += chunk)
+                talk->processInputBuffer(&data[n], qMin(chunk, stream.size() - n));
+        }
+    }
+    qint64 elapsed = qMax(timer.nsecsElapsed(), (qint64)1);
+
+    UAVTalk::ComStats stats = talk->getStats();
+    out << name << ": " << stats.rxObjects << " frames, " << stats.rxErrors << " errors, "
+        << elapsed / 1000000 << " ms, "
+        << (qint64)(stats.rxObjects * 1e9 / elapsed) << " frames/s, "
+        << (qint64)(stats.rxBytes * 1e9 / 1048576 / elapsed) << " MiB/s\n";
+    out.flush();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QStringList args = app.arguments();
+    if (args.size() < 2) {
+        out << "Usage: uavtalkbenchmark <logfile.tll> [chunk size]\n";
+        return 1;
+    }
+    int chunk = args.size() > 2 ? args.at(2).toInt() : 4096;
+
+    QByteArray stream;
+    if (!loadLog(args.at(1), stream)) {
+        out << "Unable to read telemetry from " << args.at(1) << "\n";
+        return 1;
+    }
+    out << "Loaded " << stream.size() << " bytes of telemetry\n";
+
+    UAVObjectManager objMngr;
+    UAVObjectsInitialize(&objMngr);
+
+    // The parser is fed directly, the device only satisfies the constructor
+    QBuffer device;
+    device.open(QIODevice::ReadWrite);
+    UAVTalk talk(&device, &objMngr);
+
+    run(out, "byte-wise", &talk, stream, 1);
+    run(out, "bulk", &talk, stream, chunk);
+
+    return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
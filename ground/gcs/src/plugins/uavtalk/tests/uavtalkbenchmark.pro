@@ -0,0 +1,15 @@
+# -------------------------------------------------
+# UAVTalk decode throughput benchmark
+# Usage: uavtalkbenchmark <logfile.tll> [chunk size]
+# -------------------------------------------------
+QT -= gui
+QT += network
+TARGET = uavtalkbenchmark
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+include(../../../../gcs.pri)
+include(../uavtalk.pri)
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins
+LIBS += -L$$GCS_PLUGIN_PATH/TauLabs
+SOURCES += uavtalkbenchmark.cpp
@@ -58,6 +58,26 @@ const quint8 UAVTalk::crc_table[256] = {
     0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3
 };
 
+/**
+ * Slice-by-4 tables derived from crc_table. Entry [n][x] is the CRC of the
+ * byte x followed by n zero bytes, so four input bytes can be folded into
+ * the running CRC with four independent lookups instead of a dependent chain.
+ */
+namespace {
+struct CrcSliceTables {
+    quint8 table[4][256];
+
+    CrcSliceTables(const quint8 *base)
+    {
+        for (int i = 0; i < 256; ++i) {
+            table[0][i] = base[i];
+            for (int n = 1; n < 4; ++n)
+                table[n][i] = base[table[n - 1][i]];
+        }
+    }
+};
+}
+
 
 /**
  * Constructor
@@ -76,9 +96,10 @@ UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr)
     memset(&stats, 0, sizeof(ComStats));
 
     connect(io, SIGNAL(readyRead()), this, SLOT(processInputStream()));
+    // The plugin manager is absent when UAVTalk is used from a standalone tool
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    Core::Internal::GeneralSettings * settings=pm->getObject<Core::Internal::GeneralSettings>();
-    useUDPMirror=settings->useUDPMirror();
+    Core::Internal::GeneralSettings * settings = pm ? pm->getObject<Core::Internal::GeneralSettings>() : NULL;
+    useUDPMirror = settings ? settings->useUDPMirror() : false;
     UAVTALK_QXTLOG_DEBUG(QString("[uavtalk.cpp  ] Use UDP:%0").arg(useUDPMirror));
     if(useUDPMirror)
     {
@@ -122,13 +143,11 @@ UAVTalk::ComStats UAVTalk::getStats()
  */
 void UAVTalk::processInputStream()
 {
-    quint8 tmp;
-
     if (io && io->isReadable()) {
         while (io->bytesAvailable() > 0)
         {
-            io->read((char*)&tmp, 1);
-            processInputByte(tmp);
+            QByteArray data = io->readAll();
+            processInputBuffer((const quint8 *)data.constData(), data.size());
         }
     }
 }
@@ -466,6 +485,136 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
     return true;
 }
 
+/**
+ * Process a block of bytes from the telemetry stream.
+ *
+ * Frames that are complete within the block are decoded in place: the sync
+ * byte is located with memchr(), the header is read from contiguous bytes and
+ * the CRC is computed over the whole frame at once. Only a frame that is split
+ * across two blocks goes through the byte-wise state machine.
+ * \param[in] data Received bytes
+ * \param[in] length Number of bytes in data
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::processInputBuffer(const quint8 *data, qint32 length)
+{
+    const quint8 *end = data + length;
+
+    // Finish a frame that was started in a previous block
+    while (data < end && rxState != STATE_SYNC)
+        processInputByte(*data++);
+
+    while (data < end)
+    {
+        const quint8 *sync = (const quint8 *)memchr(data, SYNC_VAL, end - data);
+        if (sync == NULL)
+        {
+            stats.rxBytes += end - data;
+            break;
+        }
+        stats.rxBytes += sync - data;
+        data = sync;
+
+        qint32 frameLength = processFrame(data, end - data);
+        if (frameLength > 0)
+        {
+            stats.rxBytes += frameLength;
+            data += frameLength;
+        }
+        else if (frameLength == 0)
+        {
+            // The frame continues in the next block, let the state machine
+            // carry it over
+            while (data < end)
+                processInputByte(*data++);
+        }
+        else
+        {
+            // Not a valid frame, resume the search after this sync byte
+            stats.rxBytes++;
+            data++;
+        }
+    }
+
+    // Done
+    return true;
+}
+
+/**
+ * Decode one frame from contiguous memory.
+ * \param[in] frame Pointer to the sync byte of the frame
+ * \param[in] available Number of bytes available from frame onwards
+ * \return Length of the decoded frame, 0 if the frame is not complete in
+ * the buffer, -1 if the bytes do not form a valid frame
+ */
+qint32 UAVTalk::processFrame(const quint8 *frame, qint32 available)
+{
+    if (available < MIN_HEADER_LENGTH)
+        return 0;
+
+    quint8 type = frame[1];
+    if ((type & TYPE_MASK) != TYPE_VER)
+        return -1;
+
+    qint32 size = qFromLittleEndian<quint16>(&frame[2]);
+    if (size < MIN_HEADER_LENGTH || size > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH)
+        return -1;
+
+    quint32 objId = qFromLittleEndian<quint32>(&frame[4]);
+    UAVObject *obj = objMngr->getObject(objId);
+    qint32 headerLength = MIN_HEADER_LENGTH;
+    qint32 length = 0;
+
+    if (obj == NULL)
+    {
+        // Requests for unknown objects are still answered with a NACK
+        if (type != TYPE_OBJ_REQ || size != MIN_HEADER_LENGTH)
+        {
+            stats.rxErrors++;
+            return -1;
+        }
+    }
+    else
+    {
+        if (type != TYPE_OBJ_REQ && type != TYPE_ACK && type != TYPE_NACK)
+            length = obj->getNumBytes();
+
+        if (!obj->isSingleInstance())
+            headerLength = MAX_HEADER_LENGTH;
+
+        if (length >= MAX_PAYLOAD_LENGTH || headerLength + length != size)
+        {
+            stats.rxErrors++;
+            return -1;
+        }
+    }
+
+    if (available < size + CHECKSUM_LENGTH)
+        return 0;
+
+    if (updateCRC(0, frame, size) != frame[size])
+    {
+        stats.rxErrors++;
+        return -1;
+    }
+
+    quint16 instId = 0;
+    if (headerLength == MAX_HEADER_LENGTH)
+        instId = qFromLittleEndian<quint16>(&frame[MIN_HEADER_LENGTH]);
+
+    mutex->lock();
+        receiveObject(type, objId, instId, &frame[headerLength], length);
+        if(useUDPMirror)
+        {
+            udpSocketTx->writeDatagram((const char*)frame, size + CHECKSUM_LENGTH, QHostAddress::LocalHost, udpSocketRx->localPort());
+        }
+        stats.rxObjectBytes += length;
+        stats.rxObjects++;
+    mutex->unlock();
+
+    return size + CHECKSUM_LENGTH;
+}
+
 /**
  * Receive an object. This function process objects received through the telemetry stream.
  * \param[in] type Type of received message (TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK, TYPE_NACK)
@@ -475,7 +624,7 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
  * \param[in] length Buffer length
  * \return Success (true), Failure (false)
  */
-bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length)
+bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, const quint8* data, qint32 length)
 {
     Q_UNUSED(length);
     UAVObject* obj = NULL;
@@ -600,7 +749,7 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8*
  * If the object instance could not be found in the list, then a
  * new one is created.
  */
-UAVObject* UAVTalk::updateObject(quint32 objId, quint16 instId, quint8* data)
+UAVObject* UAVTalk::updateObject(quint32 objId, quint16 instId, const quint8* data)
 {
     // Get object
     UAVObject* obj = objMngr->getObject(objId, instId);
@@ -854,6 +1003,14 @@ quint8 UAVTalk::updateCRC(quint8 crc, const quint8 data)
 }
 quint8 UAVTalk::updateCRC(quint8 crc, const quint8* data, qint32 length)
 {
+    static const CrcSliceTables slice(crc_table);
+
+    while (length >= 4) {
+        crc = slice.table[3][crc ^ data[0]] ^ slice.table[2][data[1]] ^
+              slice.table[1][data[2]] ^ slice.table[0][data[3]];
+        data += 4;
+        length -= 4;
+    }
     while (length--)
         crc = crc_table[crc ^ *data++];
     return crc;
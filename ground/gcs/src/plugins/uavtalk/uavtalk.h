@@ -62,6 +62,7 @@ public:
     void resetStats();
 
     bool processInputByte(quint8 rxbyte);
+    bool processInputBuffer(const quint8 *data, qint32 length);
 
 signals:
     // The only signals we send to the upper level are when we
@@ -129,8 +130,9 @@ protected:
 
     // Methods
     bool objectTransaction(UAVObject* obj, quint8 type, bool allInstances);
-    virtual bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length);
-    UAVObject* updateObject(quint32 objId, quint16 instId, quint8* data);
+    qint32 processFrame(const quint8 *frame, qint32 available);
+    virtual bool receiveObject(quint8 type, quint32 objId, quint16 instId, const quint8* data, qint32 length);
+    UAVObject* updateObject(quint32 objId, quint16 instId, const quint8* data);
     bool transmitNack(quint32 objId);
     bool transmitObject(UAVObject* obj, quint8 type, bool allInstances);
     bool transmitSingleObject(UAVObject* obj, quint8 type, bool allInstances);
@@ -7,12 +7,16 @@ include(uavtalk_dependencies.pri)
 HEADERS += uavtalk.h \
     uavtalkplugin.h \
     telemetrymonitor.h \
+    objectretriever.h \
+    settingssnapshot.h \
     telemetrymanager.h \
     uavtalk_global.h \
     telemetry.h
 SOURCES += uavtalk.cpp \
     uavtalkplugin.cpp \
     telemetrymonitor.cpp \
+    objectretriever.cpp \
+    settingssnapshot.cpp \
     telemetrymanager.cpp \
     telemetry.cpp
 DEFINES += UAVTALK_LIBRARY
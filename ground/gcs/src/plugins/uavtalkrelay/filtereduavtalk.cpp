@@ -60,7 +60,7 @@ void FilteredUavTalk::sendObjectSlot(UAVObject *obj)
  * @param length The length of the data received
  * @return True if the object passed the flitering, false otherwise
  */
-bool FilteredUavTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8 *data, qint32 length)
+bool FilteredUavTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, const quint8 *data, qint32 length)
 {
     Q_UNUSED(length);
     UAVObject* obj = NULL;
@@ -43,7 +43,7 @@ public:
     FilteredUavTalk(QIODevice* iodev, UAVObjectManager* objMngr,QHash<quint32,UavTalkRelayComon::accessType> rules,UavTalkRelayComon::accessType defaultRule);
 
     //! Called when an uavtalk packet is received from the slave.  Updates master based on filtering rules
-    bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length);
+    bool receiveObject(quint8 type, quint32 objId, quint16 instId, const quint8* data, qint32 length);
 
 public slots:
     //! Called whenever an object is updated either locally in the master GCS or from the main
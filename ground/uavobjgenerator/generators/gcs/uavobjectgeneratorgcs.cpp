@@ -398,6 +398,46 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
 
     outCode.replace(QString("$(INITFIELDS)"), initfields);
 
+    // Replace the $(PACKFIELDS) and $(UNPACKFIELDS) tags with straight-line
+    // little endian conversion code, used on big endian hosts only
+    QString packfields;
+    QString unpackfields;
+    int offset = 0;
+    for (int n = 0; n < info->fields.length(); ++n)
+    {
+        FieldInfo *field = info->fields[n];
+        type = fieldTypeStrCPP[field->type];
+        for (int idx = 0; idx < field->numElements; ++idx)
+        {
+            QString member = (field->numElements > 1) ?
+                        QString("%1[%2]").arg(field->name).arg(idx) : field->name;
+            if (field->numBytes == 1)
+            {
+                packfields.append( QString("    dataOut[%1] = (quint8)dataIn.%2;\n")
+                            .arg(offset).arg(member) );
+                unpackfields.append( QString("    dataOut.%1 = (%2)dataIn[%3];\n")
+                            .arg(member).arg(type).arg(offset) );
+            }
+            else if (field->type == FIELDTYPE_FLOAT32)
+            {
+                packfields.append( QString("    { quint32 value; memcpy(&value, &dataIn.%1, 4); qToLittleEndian<quint32>(value, &dataOut[%2]); }\n")
+                            .arg(member).arg(offset) );
+                unpackfields.append( QString("    { quint32 value = qFromLittleEndian<quint32>(&dataIn[%1]); memcpy(&dataOut.%2, &value, 4); }\n")
+                            .arg(offset).arg(member) );
+            }
+            else
+            {
+                packfields.append( QString("    qToLittleEndian<%1>(dataIn.%2, &dataOut[%3]);\n")
+                            .arg(type).arg(member).arg(offset) );
+                unpackfields.append( QString("    dataOut.%1 = qFromLittleEndian<%2>(&dataIn[%3]);\n")
+                            .arg(member).arg(type).arg(offset) );
+            }
+            offset += field->numBytes;
+        }
+    }
+    outCode.replace(QString("$(PACKFIELDS)"), packfields);
+    outCode.replace(QString("$(UNPACKFIELDS)"), unpackfields);
+
     // Write the GCS code
     bool res = writeFileIfDiffrent( gcsOutputPath.absolutePath() + "/" + info->namelc + ".cpp", outCode );
     if (!res) {